@@ -0,0 +1,614 @@
+// Carch runtime: archetype chunk storage
+// Ships with code generated by the Carch IDL compiler with --archetypes
+
+#pragma once
+
+#include "carch/component_pool.h"
+#include "carch/entity.h"
+#include "carch/enum_containers.h"
+#include "carch/traits.h"
+#include "carch/type_list.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace carch {
+
+// Query filters: Changed<T> matches entities whose T was written, Added<T>
+// those that gained T, after the tick a query passes as since. Either
+// hands the query T& (or const T& for Changed<const T>) like a plain term.
+template <typename T>
+struct Changed {};
+
+template <typename T>
+struct Added {};
+
+namespace detail {
+
+enum class QueryFilter { NONE, CHANGED, ADDED };
+
+// A query term: the component it names, the reference the query passes,
+// and its filter
+template <typename C>
+struct query_term {
+    using type = C;
+    static constexpr QueryFilter filter = QueryFilter::NONE;
+};
+
+template <typename T>
+struct query_term<Changed<T>> {
+    using type = T;
+    static constexpr QueryFilter filter = QueryFilter::CHANGED;
+};
+
+template <typename T>
+struct query_term<Added<T>> {
+    using type = T;
+    static constexpr QueryFilter filter = QueryFilter::ADDED;
+};
+
+template <typename C>
+using query_type = typename query_term<C>::type;
+
+template <typename C>
+using query_component = std::remove_const_t<query_type<C>>;
+
+// Type-erased operations on one component type. Rows of trivially
+// relocatable components move with memcpy rather than through relocate.
+struct ComponentInfo {
+    size_t size;
+    size_t align;
+    bool trivially_relocatable;
+    // Moves source to uninitialized destination and destroys source
+    void (*relocate)(void* destination, void* source);
+    void (*destroy)(void* value);
+};
+
+template <typename T>
+constexpr ComponentInfo component_info() noexcept {
+    return {sizeof(T), alignof(T), is_trivially_relocatable_v<T>,
+            [](void* destination, void* source) {
+                ::new (destination) T(std::move(*static_cast<T*>(source)));
+                static_cast<T*>(source)->~T();
+            },
+            [](void* value) { static_cast<T*>(value)->~T(); }};
+}
+
+} // namespace detail
+
+// Entities with the same set of components (an archetype) share fixed-size
+// chunks, each holding one array per component (structure of arrays) plus
+// the entities' handles. A query visits every archetype whose set contains
+// its components and streams their arrays chunk by chunk, with no lookup
+// per entity. Adding or removing a component moves the entity's row to
+// another archetype, so it is far costlier than in a sparse set; this
+// storage suits components that are iterated together and change rarely.
+// Components with @indexed or @pooled fields need the reverse index links
+// and arenas a ComponentPool keeps, so the generator leaves them out of the
+// world and they cannot be stored here.
+//
+// Id is an enum with one value per component, in the order of
+// Components...; component sets are carch::EnumSet<Id>. Handles are
+// generational, so a destroyed entity's handle no longer resolves.
+//
+// Every component of every row carries two ticks, when it was added and
+// when it was last written, and every chunk the newest of each per
+// component. Writes are stamped with tick(): create(), add(), the mutable
+// get(), and queries over non-const terms, which stamp the rows they hand
+// out. A system keeps the value advance_tick() returned after it last ran
+// and passes it as since to queries with Changed<T> or Added<T>, which
+// skip whole chunks whose newest tick is older. Ticks wrap around, so a
+// since tick must be less than 2^31 ticks old.
+template <typename E, typename Id, typename... Components>
+class ArchetypeWorld {
+    static_assert(sizeof...(Components) > 0, "ArchetypeWorld needs at least one component type");
+    static_assert(std::is_enum_v<Id>, "ArchetypeWorld needs an enum of component ids");
+    static_assert(((!detail::has_indexed_refs<Components>::value && !detail::span_arenas<Components>::value) && ...),
+                  "ArchetypeWorld: @indexed and @pooled fields need a ComponentPool");
+
+public:
+    using entity_type = E;
+    using component_id = Id;
+    static constexpr uint32_t component_count = sizeof...(Components);
+    using ComponentSet = EnumSet<Id, component_count>;
+
+    // Bytes of component data and handles per chunk; a row larger than a
+    // chunk gets a chunk of its own
+    static constexpr size_t chunk_bytes = 16 * 1024;
+
+    template <typename T>
+    static constexpr Id id_of = static_cast<Id>(detail::type_index<T, Components...>::value);
+
+    // The set a query over Cs... matches, fixed at compile time
+    template <typename... Cs>
+    static constexpr ComponentSet signature = ComponentSet{id_of<Cs>...};
+
+    ArchetypeWorld() { archetype_index(ComponentSet()); }
+    ~ArchetypeWorld() {
+        for (auto& archetype : archetypes_) {
+            for (uint32_t row = 0; row < archetype->count; ++row) {
+                destroy_components(*archetype, row);
+            }
+        }
+    }
+
+    ArchetypeWorld(const ArchetypeWorld&) = delete;
+    ArchetypeWorld& operator=(const ArchetypeWorld&) = delete;
+
+    // New entity with the given components, placed directly in its archetype
+    template <typename... Cs>
+    E create(Cs... components) {
+        static_assert(signature<Cs...>.count() == sizeof...(Cs), "ArchetypeWorld::create: repeated component type");
+        E entity = allocator_.create();
+        uint32_t archetype = archetype_index(signature<Cs...>);
+        Archetype& target = *archetypes_[archetype];
+        uint32_t row = append_row(target, entity);
+        (::new (column<Cs>(target, row)) Cs(std::move(components)), ...);
+        (write_ticks(target, static_cast<uint32_t>(id_of<Cs>), row, tick_, tick_), ...);
+        place(entity, archetype, row);
+        return entity;
+    }
+
+    bool destroy(E entity) {
+        if (!alive(entity)) {
+            return false;
+        }
+        const Location& location = locations_[entity.index()];
+        remove_row(*archetypes_[location.archetype], location.row);
+        allocator_.destroy(entity);
+        return true;
+    }
+
+    bool alive(E entity) const noexcept { return allocator_.alive(entity); }
+
+    template <typename T>
+    bool has(E entity) const noexcept {
+        return alive(entity) && archetypes_[locations_[entity.index()].archetype]->components.test(id_of<T>);
+    }
+
+    // Stamps T as changed; read through a const world to leave it be
+    template <typename T>
+    T* get(E entity) noexcept {
+        if (!has<T>(entity)) {
+            return nullptr;
+        }
+        const Location& location = locations_[entity.index()];
+        Archetype& archetype = *archetypes_[location.archetype];
+        touch(archetype, static_cast<uint32_t>(id_of<T>), location.row);
+        return column<T>(archetype, location.row);
+    }
+
+    // Adds T, or replaces it if the entity already has one; throws
+    // std::invalid_argument for a destroyed or unknown entity
+    template <typename T>
+    T& add(E entity, T value) {
+        if (!alive(entity)) {
+            throw std::invalid_argument("ArchetypeWorld::add: entity is not alive");
+        }
+        if (T* existing = get<T>(entity)) {
+            *existing = std::move(value);
+            return *existing;
+        }
+        Location location = locations_[entity.index()];
+        uint32_t target = edge(location.archetype, static_cast<uint32_t>(id_of<T>), true);
+        uint32_t row = move_row(entity, location, target);
+        write_ticks(*archetypes_[target], static_cast<uint32_t>(id_of<T>), row, tick_, tick_);
+        return *::new (column<T>(*archetypes_[target], row)) T(std::move(value));
+    }
+
+    template <typename T>
+    bool remove(E entity) {
+        if (!has<T>(entity)) {
+            return false;
+        }
+        Location location = locations_[entity.index()];
+        move_row(entity, location, edge(location.archetype, static_cast<uint32_t>(id_of<T>), false));
+        return true;
+    }
+
+    template <typename T>
+    const T* get(E entity) const noexcept {
+        if (!has<T>(entity)) {
+            return nullptr;
+        }
+        const Location& location = locations_[entity.index()];
+        return column<T>(*archetypes_[location.archetype], location.row);
+    }
+
+    // Calls f(Cs&...), or f(entity, Cs&...), for every entity with all of
+    // Cs; a term can be const T, Changed<T> or Added<T> (see each(since, f))
+    template <typename... Cs, typename F>
+    void each(F&& f) {
+        static_assert(!has_filters<Cs...>, "ArchetypeWorld::each: Changed<T> and Added<T> need a since tick");
+        each_row<Cs...>(false, 0, f);
+    }
+
+    // each() over the entities that pass every Changed<T> and Added<T>
+    // term since the given tick
+    template <typename... Cs, typename F>
+    void each(uint32_t since, F&& f) {
+        each_row<Cs...>(true, since, f);
+    }
+
+    // Calls f(count, entities, Cs*...) once per matching chunk with its
+    // contiguous arrays, for loops the compiler can vectorize
+    template <typename... Cs, typename F>
+    void each_chunk(F&& f) {
+        static_assert(!has_filters<Cs...>, "ArchetypeWorld::each_chunk: Changed<T> and Added<T> need a since tick");
+        visit_chunks<Cs...>(false, 0, f);
+    }
+
+    // each_chunk() over the chunks that may hold rows passing the filters:
+    // those whose newest ticks are newer than since. Rows in them may not.
+    template <typename... Cs, typename F>
+    void each_chunk(uint32_t since, F&& f) {
+        visit_chunks<Cs...>(true, since, f);
+    }
+
+    // The tick writes are stamped with
+    uint32_t tick() const noexcept { return tick_; }
+
+    // Ends the current tick and returns it: a system that keeps it sees
+    // every write after it as newer
+    uint32_t advance_tick() noexcept { return tick_++; }
+
+    // Ticks of an entity's T, 0 when it has none
+    template <typename T>
+    uint32_t added_tick(E entity) const noexcept {
+        return has<T>(entity) ? ticks_of<T>(entity).added[locations_[entity.index()].row] : 0;
+    }
+    template <typename T>
+    uint32_t changed_tick(E entity) const noexcept {
+        return has<T>(entity) ? ticks_of<T>(entity).changed[locations_[entity.index()].row] : 0;
+    }
+
+    // Entities with all of Cs
+    template <typename... Cs>
+    size_t count() const noexcept {
+        constexpr ComponentSet query = signature<detail::query_component<Cs>...>;
+        size_t total = 0;
+        for (const auto& archetype : archetypes_) {
+            if ((archetype->components & query) == query) {
+                total += archetype->count;
+            }
+        }
+        return total;
+    }
+
+    size_t size() const noexcept { return allocator_.size(); }
+    size_t archetype_count() const noexcept { return archetypes_.size(); }
+
+    // Rows per chunk of the archetype holding exactly Cs
+    template <typename... Cs>
+    size_t chunk_capacity() {
+        return archetypes_[archetype_index(signature<Cs...>)]->capacity;
+    }
+
+private:
+    static constexpr std::array<detail::ComponentInfo, component_count> infos_ = {
+        detail::component_info<Components>()...};
+    static constexpr uint32_t none = UINT32_MAX;
+
+    struct ChunkDeleter {
+        size_t align;
+        void operator()(std::byte* data) const noexcept { ::operator delete(data, std::align_val_t(align)); }
+    };
+    using Chunk = std::unique_ptr<std::byte[], ChunkDeleter>;
+
+    // Ticks of one component column: per row, and the newest per chunk
+    struct ColumnTicks {
+        std::vector<uint32_t> added;
+        std::vector<uint32_t> changed;
+        std::vector<uint32_t> chunk_added;
+        std::vector<uint32_t> chunk_changed;
+    };
+
+    struct Archetype {
+        ComponentSet components;
+        std::vector<uint32_t> ids;                      // Components present, ascending
+        std::array<size_t, component_count> columns{};  // Byte offset of each column in a chunk
+        std::array<uint32_t, component_count> add_edges;
+        std::array<uint32_t, component_count> remove_edges;
+        uint32_t capacity = 0;                          // Rows per chunk
+        size_t chunk_size = 0;
+        size_t chunk_align = 64;
+        std::vector<Chunk> chunks;
+        std::array<ColumnTicks, component_count> ticks;  // By component id, for the components present
+        uint32_t count = 0;
+    };
+
+    struct Location {
+        uint32_t archetype;
+        uint32_t row;
+    };
+
+    EntityAllocator<E> allocator_;
+    std::vector<Location> locations_;                   // By entity index
+    std::vector<std::unique_ptr<Archetype>> archetypes_;
+    uint32_t tick_ = 1;
+
+    template <typename... Cs>
+    static constexpr bool has_filters = ((detail::query_term<Cs>::filter != detail::QueryFilter::NONE) || ...);
+
+    static size_t align_up(size_t offset, size_t align) noexcept { return (offset + align - 1) / align * align; }
+
+    // Lays out capacity rows: handles first, then one column per component
+    static size_t layout(Archetype& archetype, uint32_t capacity) noexcept {
+        size_t offset = sizeof(E) * capacity;
+        for (uint32_t id : archetype.ids) {
+            offset = align_up(offset, infos_[id].align);
+            archetype.columns[id] = offset;
+            offset += infos_[id].size * capacity;
+        }
+        return offset;
+    }
+
+    uint32_t archetype_index(const ComponentSet& components) {
+        for (uint32_t i = 0; i < archetypes_.size(); ++i) {
+            if (archetypes_[i]->components == components) {
+                return i;
+            }
+        }
+        auto archetype = std::make_unique<Archetype>();
+        archetype->components = components;
+        archetype->add_edges.fill(none);
+        archetype->remove_edges.fill(none);
+        size_t row_size = sizeof(E);
+        for (Id id : components) {
+            uint32_t index = static_cast<uint32_t>(id);
+            archetype->ids.push_back(index);
+            row_size += infos_[index].size;
+            archetype->chunk_align = std::max(archetype->chunk_align, infos_[index].align);
+        }
+        // Padding between columns can push the layout past the chunk
+        uint32_t capacity = static_cast<uint32_t>(std::max<size_t>(1, chunk_bytes / row_size));
+        while (capacity > 1 && layout(*archetype, capacity) > chunk_bytes) {
+            --capacity;
+        }
+        archetype->capacity = capacity;
+        archetype->chunk_size = std::max(chunk_bytes, layout(*archetype, capacity));
+        archetypes_.push_back(std::move(archetype));
+        return static_cast<uint32_t>(archetypes_.size() - 1);
+    }
+
+    // Archetype reached by adding or removing one component, cached per archetype
+    uint32_t edge(uint32_t from, uint32_t id, bool add) {
+        uint32_t& cached = add ? archetypes_[from]->add_edges[id] : archetypes_[from]->remove_edges[id];
+        if (cached == none) {
+            ComponentSet components = archetypes_[from]->components;
+            components.set(static_cast<Id>(id), add);
+            uint32_t target = archetype_index(components);
+            // archetype_index() may have grown archetypes_, so index it again
+            (add ? archetypes_[from]->add_edges[id] : archetypes_[from]->remove_edges[id]) = target;
+            return target;
+        }
+        return cached;
+    }
+
+    static void* cell(Archetype& archetype, uint32_t id, uint32_t row) noexcept {
+        return archetype.chunks[row / archetype.capacity].get() + archetype.columns[id] +
+               infos_[id].size * (row % archetype.capacity);
+    }
+
+    template <typename T>
+    static T* column(Archetype& archetype, uint32_t row) noexcept {
+        return static_cast<T*>(cell(archetype, static_cast<uint32_t>(id_of<T>), row));
+    }
+
+    static E& entity_at(Archetype& archetype, uint32_t row) noexcept {
+        return reinterpret_cast<E*>(archetype.chunks[row / archetype.capacity].get())[row % archetype.capacity];
+    }
+
+    void place(E entity, uint32_t archetype, uint32_t row) {
+        if (entity.index() >= locations_.size()) {
+            locations_.resize(entity.index() + 1);
+        }
+        locations_[entity.index()] = {archetype, row};
+    }
+
+    uint32_t append_row(Archetype& archetype, E entity) {
+        if (archetype.count == archetype.chunks.size() * archetype.capacity) {
+            auto* data = static_cast<std::byte*>(
+                ::operator new(archetype.chunk_size, std::align_val_t(archetype.chunk_align)));
+            archetype.chunks.emplace_back(data, ChunkDeleter{archetype.chunk_align});
+            for (uint32_t id : archetype.ids) {
+                archetype.ticks[id].chunk_added.push_back(0);
+                archetype.ticks[id].chunk_changed.push_back(0);
+            }
+        }
+        // The caller writes the new row's ticks
+        for (uint32_t id : archetype.ids) {
+            archetype.ticks[id].added.push_back(0);
+            archetype.ticks[id].changed.push_back(0);
+        }
+        uint32_t row = archetype.count++;
+        ::new (&entity_at(archetype, row)) E(entity);
+        return row;
+    }
+
+    // Whether tick is after since, across wraparound
+    static bool newer(uint32_t tick, uint32_t since) noexcept { return static_cast<int32_t>(tick - since) > 0; }
+
+    // Stores a row's ticks and raises its chunk's; the first row of a new
+    // chunk sets them
+    static void write_ticks(Archetype& archetype, uint32_t id, uint32_t row, uint32_t added, uint32_t changed) {
+        ColumnTicks& ticks = archetype.ticks[id];
+        ticks.added[row] = added;
+        ticks.changed[row] = changed;
+        uint32_t chunk = row / archetype.capacity;
+        bool fresh = row % archetype.capacity == 0 && row + 1 == archetype.count;
+        if (fresh || newer(added, ticks.chunk_added[chunk])) {
+            ticks.chunk_added[chunk] = added;
+        }
+        if (fresh || newer(changed, ticks.chunk_changed[chunk])) {
+            ticks.chunk_changed[chunk] = changed;
+        }
+    }
+
+    // Stamps a row's component as changed now, which is the newest tick
+    void touch(Archetype& archetype, uint32_t id, uint32_t row) noexcept {
+        archetype.ticks[id].changed[row] = tick_;
+        archetype.ticks[id].chunk_changed[row / archetype.capacity] = tick_;
+    }
+
+    template <typename T>
+    const ColumnTicks& ticks_of(E entity) const noexcept {
+        return archetypes_[locations_[entity.index()].archetype]->ticks[static_cast<uint32_t>(id_of<T>)];
+    }
+
+    // Whether a row, or with in_chunk a chunk, passes term C's filter
+    template <typename C>
+    static bool passes(const Archetype& archetype, size_t at, bool in_chunk, uint32_t since) noexcept {
+        constexpr detail::QueryFilter filter = detail::query_term<C>::filter;
+        if constexpr (filter == detail::QueryFilter::NONE) {
+            return true;
+        } else {
+            const ColumnTicks& ticks = archetype.ticks[static_cast<uint32_t>(id_of<detail::query_component<C>>)];
+            const std::vector<uint32_t>& newest =
+                filter == detail::QueryFilter::CHANGED ? (in_chunk ? ticks.chunk_changed : ticks.changed)
+                                                       : (in_chunk ? ticks.chunk_added : ticks.added);
+            return newer(newest[at], since);
+        }
+    }
+
+    // Stamps rows handed out through a non-const term
+    template <typename C>
+    void touch_rows(Archetype& archetype, uint32_t first, size_t count) noexcept {
+        if constexpr (!std::is_const_v<detail::query_type<C>>) {
+            uint32_t id = static_cast<uint32_t>(id_of<detail::query_component<C>>);
+            std::fill_n(archetype.ticks[id].changed.begin() + first, count, tick_);
+            archetype.ticks[id].chunk_changed[first / archetype.capacity] = tick_;
+        }
+    }
+
+    template <typename C>
+    static detail::query_type<C>* column_data(const Archetype& archetype, std::byte* data) noexcept {
+        return reinterpret_cast<detail::query_type<C>*>(
+            data + archetype.columns[static_cast<uint32_t>(id_of<detail::query_component<C>>)]);
+    }
+
+    // Calls visit(archetype, chunk, first, count, data) for every chunk of
+    // an archetype with all of Cs that, when filtered, passes their filters
+    template <typename... Cs, typename Visit>
+    void for_each_chunk(bool filtered, uint32_t since, Visit&& visit) {
+        constexpr ComponentSet query = signature<detail::query_component<Cs>...>;
+        for (auto& archetype : archetypes_) {
+            if ((archetype->components & query) != query) continue;
+            for (size_t chunk = 0; chunk * archetype->capacity < archetype->count; ++chunk) {
+                if (filtered && !(passes<Cs>(*archetype, chunk, true, since) && ...)) continue;
+                uint32_t first = static_cast<uint32_t>(chunk * archetype->capacity);
+                size_t count = std::min<size_t>(archetype->capacity, archetype->count - first);
+                visit(*archetype, first, count, archetype->chunks[chunk].get());
+            }
+        }
+    }
+
+    template <typename... Cs, typename F>
+    void visit_chunks(bool filtered, uint32_t since, F& f) {
+        for_each_chunk<Cs...>(filtered, since, [&](Archetype& archetype, uint32_t first, size_t count, std::byte* data) {
+            (touch_rows<Cs>(archetype, first, count), ...);
+            f(count, reinterpret_cast<const E*>(data), column_data<Cs>(archetype, data)...);
+        });
+    }
+
+    template <typename... Cs, typename F>
+    void each_row(bool filtered, uint32_t since, F& f) {
+        for_each_chunk<Cs...>(filtered, since, [&](Archetype& archetype, uint32_t first, size_t count, std::byte* data) {
+            const E* entities = reinterpret_cast<const E*>(data);
+            auto rows = [&](detail::query_type<Cs>*... columns) {
+                if (!filtered) {
+                    (touch_rows<Cs>(archetype, first, count), ...);
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    if (filtered) {
+                        if (!(passes<Cs>(archetype, first + i, false, since) && ...)) continue;
+                        (touch_rows<Cs>(archetype, static_cast<uint32_t>(first + i), 1), ...);
+                    }
+                    if constexpr (std::is_invocable_v<F&, E, detail::query_type<Cs>&...>) {
+                        f(entities[i], columns[i]...);
+                    } else {
+                        f(columns[i]...);
+                    }
+                }
+            };
+            rows(column_data<Cs>(archetype, data)...);
+        });
+    }
+
+    void destroy_components(Archetype& archetype, uint32_t row) noexcept {
+        for (uint32_t id : archetype.ids) {
+            infos_[id].destroy(cell(archetype, id, row));
+        }
+    }
+
+    void relocate(uint32_t id, void* destination, void* source) {
+        if (infos_[id].trivially_relocatable) {
+            std::memcpy(destination, source, infos_[id].size);
+        } else {
+            infos_[id].relocate(destination, source);
+        }
+    }
+
+    // Destroys a row's components and fills the hole with the last row
+    void remove_row(Archetype& archetype, uint32_t row) {
+        destroy_components(archetype, row);
+        close_row(archetype, row);
+    }
+
+    // Fills a row whose components are gone with the last row
+    void close_row(Archetype& archetype, uint32_t row) {
+        uint32_t last = archetype.count - 1;
+        if (row != last) {
+            for (uint32_t id : archetype.ids) {
+                relocate(id, cell(archetype, id, row), cell(archetype, id, last));
+                write_ticks(archetype, id, row, archetype.ticks[id].added[last], archetype.ticks[id].changed[last]);
+            }
+            E moved = entity_at(archetype, last);
+            entity_at(archetype, row) = moved;
+            locations_[moved.index()].row = row;
+        }
+        for (uint32_t id : archetype.ids) {
+            archetype.ticks[id].added.pop_back();
+            archetype.ticks[id].changed.pop_back();
+        }
+        --archetype.count;
+        if (archetype.count <= (archetype.chunks.size() - 1) * archetype.capacity) {
+            archetype.chunks.pop_back();
+            for (uint32_t id : archetype.ids) {
+                archetype.ticks[id].chunk_added.pop_back();
+                archetype.ticks[id].chunk_changed.pop_back();
+            }
+        }
+    }
+
+    // Moves an entity's shared components to a row of another archetype;
+    // components the target lacks are destroyed, ones it adds are left for
+    // the caller to construct
+    uint32_t move_row(E entity, Location location, uint32_t target) {
+        Archetype& source = *archetypes_[location.archetype];
+        Archetype& destination = *archetypes_[target];
+        uint32_t row = append_row(destination, entity);
+        for (uint32_t id : source.ids) {
+            if (destination.components.test(static_cast<Id>(id))) {
+                relocate(id, cell(destination, id, row), cell(source, id, location.row));
+                write_ticks(destination, id, row, source.ticks[id].added[location.row],
+                            source.ticks[id].changed[location.row]);
+            } else {
+                infos_[id].destroy(cell(source, id, location.row));
+            }
+        }
+        close_row(source, location.row);
+        locations_[entity.index()] = {target, row};
+        return row;
+    }
+};
+
+} // namespace carch
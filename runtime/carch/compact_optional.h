@@ -0,0 +1,160 @@
+// Carch runtime: CompactOptional
+// Ships with code generated by the Carch IDL compiler for optional<T> with the compact backend
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace carch {
+
+// Niches name the value of T a CompactOptional stores for "none": none()
+// makes it and is_none() recognizes it. The value can no longer be held.
+
+// Largest value: unused entity ids and unsigned integers
+template <typename T>
+struct MaxNiche {
+    static constexpr T none() noexcept { return std::numeric_limits<T>::max(); }
+    static constexpr bool is_none(const T& value) noexcept { return value == none(); }
+};
+
+// Smallest value: signed integers
+template <typename T>
+struct MinNiche {
+    static constexpr T none() noexcept { return std::numeric_limits<T>::min(); }
+    static constexpr bool is_none(const T& value) noexcept { return value == none(); }
+};
+
+// Largest value of the underlying type, which no declared enumerator uses
+template <typename E>
+struct EnumNiche {
+    using Underlying = std::underlying_type_t<E>;
+    static constexpr E none() noexcept { return static_cast<E>(std::numeric_limits<Underlying>::max()); }
+    static constexpr bool is_none(const E& value) noexcept { return value == none(); }
+};
+
+// One quiet NaN with every payload bit set. Arithmetic produces other NaN
+// patterns, so a computed NaN is still a value; only the exact bits are none.
+template <typename T>
+struct NanNiche {
+    static_assert(std::is_floating_point_v<T>, "NanNiche requires float or double");
+    using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+    static constexpr Bits none_bits = std::numeric_limits<Bits>::max() >> 1;
+
+    static T none() noexcept {
+        T value;
+        std::memcpy(&value, &none_bits, sizeof(T));
+        return value;
+    }
+    static bool is_none(const T& value) noexcept {
+        Bits bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        return bits == none_bits;
+    }
+};
+
+// The empty string: str, str<N> and istr
+template <typename T>
+struct EmptyNiche {
+    static T none() { return T(); }
+    static bool is_none(const T& value) noexcept { return value.empty(); }
+};
+
+// std::optional without the engaged flag: "none" is stored as the value
+// Niche reserves, so the optional is exactly as large as T and is
+// trivially copyable whenever T is. Storing that value asserts.
+template <typename T, typename Niche>
+class CompactOptional {
+public:
+    using value_type = T;
+
+    CompactOptional() noexcept(std::is_nothrow_default_constructible_v<T>) : value_(Niche::none()) {}
+    CompactOptional(std::nullopt_t) noexcept(std::is_nothrow_default_constructible_v<T>) : value_(Niche::none()) {}
+    CompactOptional(const T& value) : value_(value) { assert(!Niche::is_none(value_)); }
+    CompactOptional(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>) : value_(std::move(value)) {
+        assert(!Niche::is_none(value_));
+    }
+    CompactOptional(const std::optional<T>& other) : value_(other ? *other : Niche::none()) {
+        assert(!other || !Niche::is_none(value_));
+    }
+
+    CompactOptional& operator=(std::nullopt_t) {
+        reset();
+        return *this;
+    }
+    CompactOptional& operator=(const T& value) {
+        value_ = value;
+        assert(!Niche::is_none(value_));
+        return *this;
+    }
+    CompactOptional& operator=(T&& value) {
+        value_ = std::move(value);
+        assert(!Niche::is_none(value_));
+        return *this;
+    }
+
+    bool has_value() const noexcept { return !Niche::is_none(value_); }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    T& value() & {
+        if (!has_value()) throw std::bad_optional_access();
+        return value_;
+    }
+    const T& value() const& {
+        if (!has_value()) throw std::bad_optional_access();
+        return value_;
+    }
+    T&& value() && {
+        if (!has_value()) throw std::bad_optional_access();
+        return std::move(value_);
+    }
+
+    template <typename U>
+    T value_or(U&& fallback) const& {
+        return has_value() ? value_ : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    T& operator*() & noexcept { assert(has_value()); return value_; }
+    const T& operator*() const& noexcept { assert(has_value()); return value_; }
+    T* operator->() noexcept { assert(has_value()); return &value_; }
+    const T* operator->() const noexcept { assert(has_value()); return &value_; }
+
+    template <typename... Args>
+    T& emplace(Args&&... args) {
+        value_ = T(std::forward<Args>(args)...);
+        assert(!Niche::is_none(value_));
+        return value_;
+    }
+    void reset() { value_ = Niche::none(); }
+    void swap(CompactOptional& other) noexcept(std::is_nothrow_swappable_v<T>) {
+        using std::swap;
+        swap(value_, other.value_);
+    }
+
+    std::optional<T> to_optional() const { return has_value() ? std::optional<T>(value_) : std::nullopt; }
+
+    // Equal when both are none or both hold equal values
+    friend bool operator==(const CompactOptional& a, const CompactOptional& b) {
+        return a.has_value() == b.has_value() && (!a.has_value() || a.value_ == b.value_);
+    }
+    friend bool operator!=(const CompactOptional& a, const CompactOptional& b) { return !(a == b); }
+    friend bool operator==(const CompactOptional& a, std::nullopt_t) noexcept { return !a.has_value(); }
+    friend bool operator!=(const CompactOptional& a, std::nullopt_t) noexcept { return a.has_value(); }
+    friend bool operator==(const CompactOptional& a, const T& b) { return a.has_value() && a.value_ == b; }
+    friend bool operator!=(const CompactOptional& a, const T& b) { return !(a == b); }
+
+private:
+    T value_;
+};
+
+template <typename T, typename Niche>
+void swap(CompactOptional<T, Niche>& a, CompactOptional<T, Niche>& b) noexcept(noexcept(a.swap(b))) {
+    a.swap(b);
+}
+
+} // namespace carch
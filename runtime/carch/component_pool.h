@@ -0,0 +1,401 @@
+// Carch runtime: ComponentPool
+// Ships with code generated by the Carch IDL compiler for @indexed ref<entity>, @pooled array and @cold fields
+
+#pragma once
+
+#include "carch/reverse_index.h"
+#include "carch/traits.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace carch {
+
+namespace detail {
+
+struct RefProbe {
+    template <typename Field, typename E>
+    void operator()(Field, E&) const noexcept {}
+};
+
+// Whether the generator emitted carch_visit_refs(T&, visit) for T, found by
+// argument-dependent lookup next to the type
+template <typename T, typename = void>
+struct has_indexed_refs : std::false_type {};
+
+template <typename T>
+struct has_indexed_refs<T, std::void_t<decltype(carch_visit_refs(std::declval<T&>(), RefProbe{}))>>
+    : std::true_type {};
+
+// The generated <Type>_Arenas for a type with @pooled fields, named by the
+// carch_span_arenas(T*) declaration next to it; NoArenas for other types
+struct NoArenas {};
+
+template <typename T, typename = void>
+struct span_arenas {
+    using type = NoArenas;
+    static constexpr bool value = false;
+};
+
+template <typename T>
+struct span_arenas<T, std::void_t<decltype(carch_span_arenas(static_cast<T*>(nullptr)))>> {
+    using type = decltype(carch_span_arenas(static_cast<T*>(nullptr)));
+    static constexpr bool value = true;
+};
+
+// The generated <Type>_Cold for a type with @cold fields, named by the
+// carch_cold_fields(T*) declaration next to it
+struct NoColdFields {};
+
+template <typename T, typename = void>
+struct cold_fields {
+    using type = NoColdFields;
+    static constexpr bool value = false;
+};
+
+template <typename T>
+struct cold_fields<T, std::void_t<decltype(carch_cold_fields(static_cast<T*>(nullptr)))>> {
+    using type = decltype(carch_cold_fields(static_cast<T*>(nullptr)));
+    static constexpr bool value = true;
+};
+
+} // namespace detail
+
+// Sparse set of components of type T: a dense array of components and of
+// their entities, and a sparse array from entity index to dense position.
+// Lookups check the whole handle, so a stale handle finds nothing.
+//
+// Built with a ReverseIndex, the pool links every @indexed ref<entity>
+// field of the components it stores, and ReverseIndex::release() nulls
+// those fields through it. References must then change through set() or
+// modify(), which relink them; writing them through get() leaves the index
+// stale.
+//
+// For components with @pooled array fields the pool owns the arenas their
+// spans point into (arenas()). Spans are allocated there before set(); the
+// pool releases a component's spans when it is removed or replaced by one
+// with other spans, and compact() drops the garbage this leaves.
+//
+// For components with @cold fields T holds the other fields, and the pool
+// keeps each component's <Type>_Cold in a second dense array in the same
+// order, so iterating the components never loads the cold ones. view()
+// joins the two behind the generated <Type>_View accessors.
+template <typename T, typename E = Entity64>
+class ComponentPool {
+public:
+    using value_type = T;
+    using entity_type = E;
+    using Referrer = typename ReverseIndex<E>::Referrer;
+    using arenas_type = typename detail::span_arenas<T>::type;
+    using cold_type = typename detail::cold_fields<T>::type;
+
+    ComponentPool() = default;
+    explicit ComponentPool(ReverseIndex<E>& index) : index_(&index) {
+        static_assert(detail::has_indexed_refs<T>::value, "ComponentPool: T has no @indexed ref<entity> fields");
+        component_ = index.add_component(this, &ComponentPool::clear_ref);
+    }
+    ~ComponentPool() {
+        if (index_) {
+            for (size_t i = 0; i < dense_.size(); ++i) {
+                unlink(entities_[i], dense_[i]);
+            }
+            index_->remove_component(component_);
+        }
+    }
+
+    // The index keeps a pointer to the pool
+    ComponentPool(const ComponentPool&) = delete;
+    ComponentPool& operator=(const ComponentPool&) = delete;
+
+    // Adds or replaces entity's component; a replaced component keeps its
+    // cold fields, and a new one starts with value-initialized ones
+    T& set(E entity, T value) {
+        size_t index = entity_traits<E>::index(entity);
+        if (index >= sparse_.size()) {
+            sparse_.resize(index + 1, npos);
+        }
+        uint32_t position = sparse_[index];
+        if (position != npos && entities_[position] == entity) {
+            unlink(entity, dense_[position]);
+            release_replaced_spans(dense_[position], value);
+            dense_[position] = std::move(value);
+        } else {
+            if (position != npos) {
+                // A stale entity with the same index still has a component
+                remove_at(position);
+            }
+            position = static_cast<uint32_t>(dense_.size());
+            sparse_[index] = position;
+            entities_.push_back(entity);
+            dense_.push_back(std::move(value));
+            if constexpr (detail::cold_fields<T>::value) {
+                cold_.emplace_back();
+            }
+        }
+        link(entity, dense_[position]);
+        return dense_[position];
+    }
+
+    // Adds or replaces entity's component with both parts of it
+    template <typename C = cold_type, typename = std::enable_if_t<detail::cold_fields<T>::value, C>>
+    T& set(E entity, T value, C cold) {
+        T& result = set(entity, std::move(value));
+        cold_[find(entity)] = std::move(cold);
+        return result;
+    }
+
+    T* get(E entity) noexcept {
+        uint32_t position = find(entity);
+        return position != npos ? &dense_[position] : nullptr;
+    }
+    const T* get(E entity) const noexcept {
+        uint32_t position = find(entity);
+        return position != npos ? &dense_[position] : nullptr;
+    }
+    bool contains(E entity) const noexcept { return find(entity) != npos; }
+
+    // The @cold fields of entity's component, and both parts behind its
+    // accessors; null without a component
+    template <typename C = cold_type>
+    std::enable_if_t<detail::cold_fields<T>::value, C*> cold(E entity) noexcept {
+        uint32_t position = find(entity);
+        return position != npos ? &cold_[position] : nullptr;
+    }
+    template <typename C = cold_type>
+    std::enable_if_t<detail::cold_fields<T>::value, const C*> cold(E entity) const noexcept {
+        uint32_t position = find(entity);
+        return position != npos ? &cold_[position] : nullptr;
+    }
+    template <typename C = cold_type, typename = std::enable_if_t<detail::cold_fields<T>::value, C>>
+    auto view(E entity) noexcept {
+        uint32_t position = find(entity);
+        return position != npos ? carch_cold_view(&dense_[position], &cold_[position])
+                                : carch_cold_view(static_cast<T*>(nullptr), static_cast<C*>(nullptr));
+    }
+
+    // Calls f(component) and relinks its references; false without a component
+    template <typename F>
+    bool modify(E entity, F&& f) {
+        uint32_t position = find(entity);
+        if (position == npos) {
+            return false;
+        }
+        unlink(entity, dense_[position]);
+        f(dense_[position]);
+        link(entity, dense_[position]);
+        return true;
+    }
+
+    bool remove(E entity) {
+        uint32_t position = find(entity);
+        if (position == npos) {
+            return false;
+        }
+        remove_at(position);
+        return true;
+    }
+
+    size_t size() const noexcept { return dense_.size(); }
+    bool empty() const noexcept { return dense_.empty(); }
+
+    void clear() noexcept {
+        for (size_t i = 0; i < dense_.size(); ++i) {
+            unlink(entities_[i], dense_[i]);
+            release_spans(dense_[i]);
+        }
+        sparse_.clear();
+        entities_.clear();
+        dense_.clear();
+        cold_.clear();
+    }
+
+    // Replaces every component with count saved from entities() and data(),
+    // for example written to a file and read back. The components' bytes
+    // are copied with one memcpy, so T must be POD wire-safe.
+    void load(const E* entities, const void* components, size_t count) {
+        static_assert(is_pod_wire_safe_v<T>, "ComponentPool::load: T is not POD wire-safe");
+        clear();
+        entities_.assign(entities, entities + count);
+        dense_.resize(count);
+        std::memcpy(static_cast<void*>(dense_.data()), components, count * sizeof(T));
+        if constexpr (detail::cold_fields<T>::value) {
+            cold_.assign(count, cold_type());
+        }
+        for (size_t i = 0; i < count; ++i) {
+            size_t index = entity_traits<E>::index(entities_[i]);
+            if (index >= sparse_.size()) {
+                sparse_.resize(index + 1, npos);
+            }
+            sparse_[index] = static_cast<uint32_t>(i);
+            link(entities_[i], dense_[i]);
+        }
+    }
+
+    // Arenas of the @pooled fields, one per field
+    arenas_type& arenas() noexcept { return arenas_; }
+    const arenas_type& arenas() const noexcept { return arenas_; }
+
+    // Copies every component's spans into fresh arenas, in dense order,
+    // dropping released elements; views into the arenas are invalidated
+    void compact() {
+        if constexpr (detail::span_arenas<T>::value) {
+            arenas_.each([](auto& arena) { arena.begin_compaction(); });
+            for (T& value : dense_) {
+                carch_visit_spans(value, arenas_, [](auto& span, auto& arena) { span = arena.keep(span); });
+            }
+            arenas_.each([](auto& arena) { arena.end_compaction(); });
+        }
+    }
+
+    // Dense arrays, in the same order
+    const std::vector<E>& entities() const noexcept { return entities_; }
+    T* data() noexcept { return dense_.data(); }
+    const T* data() const noexcept { return dense_.data(); }
+    template <typename C = cold_type>
+    std::enable_if_t<detail::cold_fields<T>::value, C*> cold_data() noexcept {
+        return cold_.data();
+    }
+
+    // Calls f(entity, component) for every component, in dense order
+    template <typename F>
+    void each(F&& f) {
+        for (size_t i = 0; i < dense_.size(); ++i) {
+            f(entities_[i], dense_[i]);
+        }
+    }
+
+private:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    std::vector<uint32_t> sparse_;
+    std::vector<E> entities_;
+    std::vector<T> dense_;
+    std::vector<cold_type> cold_;   // Parallel to dense_ for types with @cold fields, else empty
+    ReverseIndex<E>* index_ = nullptr;
+    uint32_t component_ = 0;
+    arenas_type arenas_;
+
+    uint32_t find(E entity) const noexcept {
+        size_t index = entity_traits<E>::index(entity);
+        if (index >= sparse_.size()) {
+            return npos;
+        }
+        uint32_t position = sparse_[index];
+        return position != npos && entities_[position] == entity ? position : npos;
+    }
+
+    // Swaps the last component into the hole
+    void remove_at(uint32_t position) {
+        unlink(entities_[position], dense_[position]);
+        release_spans(dense_[position]);
+        sparse_[entity_traits<E>::index(entities_[position])] = npos;
+        uint32_t last = static_cast<uint32_t>(dense_.size() - 1);
+        if (position != last) {
+            entities_[position] = entities_[last];
+            dense_[position] = std::move(dense_[last]);
+            if constexpr (detail::cold_fields<T>::value) {
+                cold_[position] = std::move(cold_[last]);
+            }
+            sparse_[entity_traits<E>::index(entities_[position])] = position;
+        }
+        entities_.pop_back();
+        dense_.pop_back();
+        if constexpr (detail::cold_fields<T>::value) {
+            cold_.pop_back();
+        }
+    }
+
+    void link(E entity, T& value) {
+        if constexpr (detail::has_indexed_refs<T>::value) {
+            if (!index_) return;
+            carch_visit_refs(value, [&](auto field, E& target) {
+                if (!entity_traits<E>::is_null(target)) {
+                    index_->link(target, Referrer{entity, component_, static_cast<uint32_t>(field)});
+                }
+            });
+        }
+    }
+
+    void unlink(E entity, T& value) noexcept {
+        if constexpr (detail::has_indexed_refs<T>::value) {
+            if (!index_) return;
+            carch_visit_refs(value, [&](auto field, E& target) {
+                if (!entity_traits<E>::is_null(target)) {
+                    index_->unlink(target, Referrer{entity, component_, static_cast<uint32_t>(field)});
+                }
+            });
+        }
+    }
+
+    void release_spans(T& value) noexcept {
+        if constexpr (detail::span_arenas<T>::value) {
+            carch_visit_spans(value, arenas_, [](auto& span, auto& arena) { arena.release(span); });
+        }
+    }
+
+    // Releases the parts of old's spans that replacement does not keep in
+    // the same arena; variants may hold spans of different fields. A span
+    // the caller grew or shrank on a copy overlaps the old one, and the
+    // buffer beyond it may already belong to another span, so only its
+    // uncovered elements count as garbage and the buffer is left alone.
+    void release_replaced_spans(T& old, T& replacement) {
+        if constexpr (detail::span_arenas<T>::value) {
+            struct Kept {
+                const void* arena;
+                uint32_t begin;
+                uint32_t end;
+            };
+            std::vector<Kept> kept;
+            carch_visit_spans(replacement, arenas_, [&](auto& span, auto& arena) {
+                kept.push_back({&arena, span.offset, span.offset + span.length});
+            });
+            std::vector<std::pair<uint32_t, uint32_t>> covered;
+            carch_visit_spans(old, arenas_, [&](auto& span, auto& arena) {
+                uint32_t begin = span.offset;
+                uint32_t end = span.offset + span.length;
+                bool overlaps = false;
+                covered.clear();
+                for (const Kept& k : kept) {
+                    if (k.arena != &arena || (k.begin != begin && (k.end <= begin || k.begin >= end))) {
+                        continue;
+                    }
+                    overlaps = true;
+                    if (k.begin < end && k.end > begin) {
+                        covered.emplace_back(std::max(k.begin, begin), std::min(k.end, end));
+                    }
+                }
+                if (!overlaps) {
+                    arena.release(span);
+                    return;
+                }
+                std::sort(covered.begin(), covered.end());
+                uint32_t uncovered = 0;
+                uint32_t next = begin;
+                for (const auto& range : covered) {
+                    if (range.first > next) {
+                        uncovered += range.first - next;
+                    }
+                    next = std::max(next, range.second);
+                }
+                arena.discard(uncovered + (end - next));
+            });
+        }
+    }
+
+    static void clear_ref(void* pool, E referrer, uint32_t field, E target) {
+        auto* self = static_cast<ComponentPool*>(pool);
+        if (T* value = self->get(referrer)) {
+            carch_visit_refs(*value, [&](auto visited, E& ref) {
+                if (static_cast<uint32_t>(visited) == field && ref == target) {
+                    ref = entity_traits<E>::null();
+                }
+            });
+        }
+    }
+};
+
+} // namespace carch
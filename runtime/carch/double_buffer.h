@@ -0,0 +1,210 @@
+// Carch runtime: double-buffered component storage
+// Ships with code generated by the Carch IDL compiler for @double_buffered types
+
+#pragma once
+
+#include "carch/component_pool.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace carch {
+
+// Components of type T in two sparse sets: readers on other threads iterate
+// the front one while a single writer thread changes the back one, and
+// swap() publishes the back set at a frame boundary by flipping an atomic
+// index. Neither side locks or waits for the other.
+//
+// After the flip the new back set is the previous front, one frame behind.
+// swap() brings it up to date by copying only the components written since
+// the last swap, so a frame costs O(writes), not a copy of the pool.
+//
+// The writer thread calls every member but front(). Readers call front()
+// at most once per frame and must be done with the set it returns before
+// the next swap(), which starts writing to it.
+template <typename T, typename E = Entity64>
+class DoubleBufferedPool {
+    static_assert(std::is_copy_assignable_v<T>, "DoubleBufferedPool: components are copied between the buffers");
+    static_assert(!detail::has_indexed_refs<T>::value && !detail::span_arenas<T>::value &&
+                      !detail::cold_fields<T>::value,
+                  "DoubleBufferedPool: @indexed, @pooled and @cold fields need a ComponentPool");
+
+public:
+    using value_type = T;
+    using entity_type = E;
+
+    // One frame of components: read-only to readers
+    class Buffer {
+    public:
+        size_t size() const noexcept { return dense_.size(); }
+        bool empty() const noexcept { return dense_.empty(); }
+        bool contains(E entity) const noexcept { return find(entity) != npos; }
+
+        const T* get(E entity) const noexcept {
+            uint32_t position = find(entity);
+            return position != npos ? &dense_[position] : nullptr;
+        }
+
+        // Dense arrays, in the same order
+        const T* data() const noexcept { return dense_.data(); }
+        const E* entities() const noexcept { return entities_.data(); }
+
+        // Calls f(entity, component) for every component, in dense order
+        template <typename F>
+        void each(F&& f) const {
+            for (size_t i = 0; i < dense_.size(); ++i) {
+                f(entities_[i], dense_[i]);
+            }
+        }
+
+    private:
+        friend class DoubleBufferedPool;
+
+        std::vector<uint32_t> sparse_;
+        std::vector<E> entities_;
+        std::vector<T> dense_;
+
+        uint32_t find(E entity) const noexcept {
+            size_t index = entity_traits<E>::index(entity);
+            if (index >= sparse_.size()) {
+                return npos;
+            }
+            uint32_t position = sparse_[index];
+            return position != npos && entities_[position] == entity ? position : npos;
+        }
+
+        // An entity index holds one entity at a time, so storing a newer
+        // version of an entity replaces the older one
+        T& put(E entity, T value) {
+            size_t index = entity_traits<E>::index(entity);
+            if (index >= sparse_.size()) {
+                sparse_.resize(index + 1, npos);
+            }
+            uint32_t position = sparse_[index];
+            if (position != npos) {
+                entities_[position] = entity;
+                dense_[position] = std::move(value);
+                return dense_[position];
+            }
+            sparse_[index] = static_cast<uint32_t>(dense_.size());
+            entities_.push_back(entity);
+            dense_.push_back(std::move(value));
+            return dense_.back();
+        }
+
+        // Swaps the last component into the hole
+        void erase(size_t index) {
+            uint32_t position = index < sparse_.size() ? sparse_[index] : npos;
+            if (position == npos) {
+                return;
+            }
+            sparse_[index] = npos;
+            uint32_t last = static_cast<uint32_t>(dense_.size() - 1);
+            if (position != last) {
+                entities_[position] = entities_[last];
+                dense_[position] = std::move(dense_[last]);
+                sparse_[entity_traits<E>::index(entities_[position])] = position;
+            }
+            entities_.pop_back();
+            dense_.pop_back();
+        }
+    };
+
+    DoubleBufferedPool() = default;
+    DoubleBufferedPool(const DoubleBufferedPool&) = delete;
+    DoubleBufferedPool& operator=(const DoubleBufferedPool&) = delete;
+
+    // Writes go to the back buffer and show in front() after the next swap()
+    T& set(E entity, T value) {
+        written(entity);
+        return back_buffer().put(entity, std::move(value));
+    }
+
+    T* get(E entity) noexcept {
+        Buffer& back = back_buffer();
+        uint32_t position = back.find(entity);
+        if (position == npos) {
+            return nullptr;
+        }
+        written(entity);
+        return &back.dense_[position];
+    }
+
+    // Calls f(component) on entity's component in the back buffer
+    template <typename F>
+    bool modify(E entity, F&& f) {
+        T* value = get(entity);
+        if (!value) {
+            return false;
+        }
+        f(*value);
+        return true;
+    }
+
+    bool remove(E entity) {
+        Buffer& back = back_buffer();
+        if (back.find(entity) == npos) {
+            return false;
+        }
+        written(entity);
+        back.erase(entity_traits<E>::index(entity));
+        return true;
+    }
+
+    // The components as the writer sees them, including unpublished writes
+    const Buffer& back() const noexcept { return buffers_[1 - front_.load(std::memory_order_relaxed)]; }
+    bool contains(E entity) const noexcept { return back().contains(entity); }
+    size_t size() const noexcept { return back().size(); }
+
+    // Publishes the back buffer to readers, then copies the components
+    // written this frame into the buffer that becomes the back one
+    void swap() {
+        uint32_t published = 1 - front_.load(std::memory_order_relaxed);
+        front_.store(published, std::memory_order_release);
+        const Buffer& source = buffers_[published];
+        Buffer& target = buffers_[1 - published];
+        for (uint32_t index : written_) {
+            uint32_t position = index < source.sparse_.size() ? source.sparse_[index] : npos;
+            if (position != npos) {
+                target.put(source.entities_[position], source.dense_[position]);
+            } else {
+                target.erase(index);
+            }
+            journaled_[index] = 0;
+        }
+        written_.clear();
+    }
+
+    // The last published frame; safe to read from any thread until the
+    // swap() after the one that published it
+    const Buffer& front() const noexcept { return buffers_[front_.load(std::memory_order_acquire)]; }
+
+    // Entities written since the last swap()
+    size_t pending() const noexcept { return written_.size(); }
+
+private:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    Buffer buffers_[2];
+    std::atomic<uint32_t> front_{0};
+    std::vector<uint32_t> written_;     // Entity indices written this frame, once each
+    std::vector<uint8_t> journaled_;    // Per entity index: listed in written_
+
+    Buffer& back_buffer() noexcept { return buffers_[1 - front_.load(std::memory_order_relaxed)]; }
+
+    void written(E entity) {
+        size_t index = entity_traits<E>::index(entity);
+        if (index >= journaled_.size()) {
+            journaled_.resize(index + 1, 0);
+        }
+        if (!journaled_[index]) {
+            journaled_[index] = 1;
+            written_.push_back(static_cast<uint32_t>(index));
+        }
+    }
+};
+
+} // namespace carch
@@ -0,0 +1,172 @@
+// Carch runtime: generational entity handles and their allocator
+// Ships with code generated by the Carch IDL compiler for ref<entity>
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace carch {
+
+// Entity handle packing a dense index and a version into one word: the low
+// IndexBits bits are the index, the rest the version. Destroying an entity
+// bumps its slot's version, so a stale handle no longer matches the slot and
+// EntityAllocator::alive() rejects it with one array load.
+// Default-constructed handles are null; the largest index is reserved for it.
+template <typename Word, uint32_t IndexBits>
+class BasicEntity {
+    static_assert(std::is_unsigned_v<Word>, "BasicEntity packs into an unsigned word");
+    static_assert(IndexBits > 0 && IndexBits < sizeof(Word) * 8, "BasicEntity needs index and version bits");
+
+public:
+    using word_type = Word;
+    static constexpr uint32_t index_bits = IndexBits;
+    static constexpr uint32_t version_bits = sizeof(Word) * 8 - IndexBits;
+    static constexpr Word index_mask = static_cast<Word>((Word(1) << IndexBits) - 1);
+    static constexpr Word version_mask = static_cast<Word>(~Word(0) >> IndexBits);
+    // Indices available to live entities: every one but the null index
+    static constexpr Word max_entities = index_mask;
+
+    constexpr BasicEntity() noexcept = default;
+    constexpr BasicEntity(Word index, Word version) noexcept
+        : bits_(static_cast<Word>((index & index_mask) | ((version & version_mask) << IndexBits))) {}
+
+    static constexpr BasicEntity null() noexcept { return BasicEntity(); }
+
+    static constexpr BasicEntity from_bits(Word bits) noexcept {
+        BasicEntity result;
+        result.bits_ = bits;
+        return result;
+    }
+    constexpr Word bits() const noexcept { return bits_; }
+
+    constexpr Word index() const noexcept { return static_cast<Word>(bits_ & index_mask); }
+    constexpr Word version() const noexcept { return static_cast<Word>(bits_ >> IndexBits); }
+
+    constexpr bool is_null() const noexcept { return index() == index_mask; }
+    constexpr explicit operator bool() const noexcept { return !is_null(); }
+
+    friend constexpr bool operator==(BasicEntity a, BasicEntity b) noexcept { return a.bits_ == b.bits_; }
+    friend constexpr bool operator!=(BasicEntity a, BasicEntity b) noexcept { return a.bits_ != b.bits_; }
+    friend constexpr bool operator<(BasicEntity a, BasicEntity b) noexcept { return a.bits_ < b.bits_; }
+
+private:
+    Word bits_ = static_cast<Word>(~Word(0));
+};
+
+// 32-bit index and 32-bit version
+using Entity64 = BasicEntity<uint64_t, 32>;
+// About a million entities with 4096 versions each
+using Entity32 = BasicEntity<uint32_t, 20>;
+
+// The null handle, for CompactOptional<entity_id, ...>
+template <typename E>
+struct EntityNiche {
+    static constexpr E none() noexcept { return E::null(); }
+    static constexpr bool is_none(const E& value) noexcept { return value.is_null(); }
+};
+
+// Hands out entity handles, reusing destroyed indices through a freelist
+// threaded through the slots themselves. A live slot holds its entity's
+// handle; a free slot holds the next free index and the version the slot's
+// next entity will get. create(), destroy() and alive() are O(1) and never
+// search. Versions wrap, so a handle kept across 2^version_bits reuses of
+// one index matches again.
+template <typename E = Entity64>
+class EntityAllocator {
+public:
+    using entity_type = E;
+    using word_type = typename E::word_type;
+
+    EntityAllocator() = default;
+
+    // A new live entity; throws std::length_error once every index is live
+    E create() {
+        if (free_head_ != E::index_mask) {
+            word_type index = free_head_;
+            E& slot = slots_[index];
+            free_head_ = slot.index();
+            slot = E(index, slot.version());
+            ++alive_count_;
+            return slot;
+        }
+        if (slots_.size() >= E::max_entities) {
+            throw std::length_error("EntityAllocator: out of entity indices");
+        }
+        E entity(static_cast<word_type>(slots_.size()), 0);
+        slots_.push_back(entity);
+        ++alive_count_;
+        return entity;
+    }
+
+    // Destroys a live entity and invalidates every handle to it; returns
+    // false, changing nothing, for a stale or null handle
+    bool destroy(E entity) noexcept {
+        if (!alive(entity)) {
+            return false;
+        }
+        word_type index = entity.index();
+        slots_[index] = E(free_head_, static_cast<word_type>(entity.version() + 1));
+        free_head_ = index;
+        --alive_count_;
+        return true;
+    }
+
+    // A free slot stores another index (or the null index), never its own,
+    // so it cannot compare equal to a handle that names it
+    bool alive(E entity) const noexcept {
+        word_type index = entity.index();
+        return index < slots_.size() && slots_[index] == entity;
+    }
+
+    // The live handle at an index, or null if the index is free
+    E current(word_type index) const noexcept {
+        return index < slots_.size() && slots_[index].index() == index ? slots_[index] : E::null();
+    }
+
+    // Live entities
+    size_t size() const noexcept { return alive_count_; }
+    bool empty() const noexcept { return alive_count_ == 0; }
+    // Indices handed out so far, live or free; dense per-entity arrays need this many elements
+    size_t capacity() const noexcept { return slots_.size(); }
+    void reserve(size_t count) { slots_.reserve(count); }
+
+    // Destroys every live entity, keeping the versions so old handles stay stale
+    void clear() noexcept {
+        for (size_t i = slots_.size(); i-- > 0;) {
+            destroy(slots_[i]);
+        }
+    }
+
+    // Calls f(entity) for every live entity in index order
+    template <typename F>
+    void each(F&& f) const {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            if (slots_[i].index() == i) {
+                f(slots_[i]);
+            }
+        }
+    }
+
+private:
+    std::vector<E> slots_;
+    word_type free_head_ = E::index_mask;
+    size_t alive_count_ = 0;
+};
+
+} // namespace carch
+
+namespace std {
+
+template <typename Word, uint32_t IndexBits>
+struct hash<carch::BasicEntity<Word, IndexBits>> {
+    size_t operator()(carch::BasicEntity<Word, IndexBits> entity) const noexcept {
+        return std::hash<Word>()(entity.bits());
+    }
+};
+
+} // namespace std
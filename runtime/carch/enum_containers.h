@@ -0,0 +1,253 @@
+// Carch runtime: EnumSet and EnumArray
+// Ships with code generated by the Carch IDL compiler for flags { ... } types; also usable with any generated enum
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+namespace carch {
+
+// Number of values of an enum, found by argument-dependent lookup of the
+// carch_enum_count(E) the generator emits next to every enum
+template <typename E>
+constexpr uint32_t enum_count() noexcept {
+    return carch_enum_count(E{});
+}
+
+namespace detail {
+
+// Smallest unsigned type with a bit per value, or 64-bit words past 64
+template <uint32_t N>
+using EnumSetWord = std::conditional_t<N <= 8, uint8_t,
+                    std::conditional_t<N <= 16, uint16_t,
+                    std::conditional_t<N <= 32, uint32_t, uint64_t>>>;
+
+constexpr uint32_t popcount(uint64_t x) noexcept {
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<uint32_t>((x * 0x0101010101010101ull) >> 56);
+}
+
+// Index of the lowest set bit; x must not be zero
+constexpr uint32_t lowest_bit(uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctzll(x));
+#else
+    uint32_t index = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+} // namespace detail
+
+// Set of the values of an enum with N values, one bit per value in the
+// smallest unsigned type that fits them (64-bit words past 64 values).
+// Every operation is constexpr, and iteration visits the values in
+// declaration order. Generated flags { ... } types are EnumSets.
+template <typename E, uint32_t N = enum_count<E>()>
+class EnumSet {
+    static_assert(std::is_enum_v<E>, "EnumSet requires an enum");
+    static_assert(N > 0, "EnumSet requires at least one value");
+
+public:
+    using Word = detail::EnumSetWord<N>;
+    static constexpr uint32_t word_bits = sizeof(Word) * 8;
+    static constexpr uint32_t word_count = (N + word_bits - 1) / word_bits;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const E*;
+        using reference = E;
+
+        constexpr iterator() noexcept = default;
+        constexpr E operator*() const noexcept { return static_cast<E>(index_); }
+        constexpr iterator& operator++() noexcept {
+            index_ = set_->next(index_ + 1);
+            return *this;
+        }
+        constexpr iterator operator++(int) noexcept {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+        friend constexpr bool operator==(const iterator& a, const iterator& b) noexcept { return a.index_ == b.index_; }
+        friend constexpr bool operator!=(const iterator& a, const iterator& b) noexcept { return a.index_ != b.index_; }
+
+    private:
+        friend class EnumSet;
+        constexpr iterator(const EnumSet* set, uint32_t index) noexcept : set_(set), index_(index) {}
+        const EnumSet* set_ = nullptr;
+        uint32_t index_ = N;
+    };
+    using const_iterator = iterator;
+
+    constexpr EnumSet() noexcept : words_{} {}
+    constexpr EnumSet(E value) noexcept : words_{} { set(value); }
+    constexpr EnumSet(std::initializer_list<E> values) noexcept : words_{} {
+        for (E value : values) {
+            set(value);
+        }
+    }
+
+    // Every value set
+    static constexpr EnumSet full() noexcept { return ~EnumSet(); }
+
+    // The bits as one integer; bits past the last value are dropped
+    template <uint32_t M = N, typename = std::enable_if_t<(M <= 64)>>
+    static constexpr EnumSet from_bits(Word bits) noexcept {
+        EnumSet result;
+        result.words_[0] = static_cast<Word>(bits & last_word_mask());
+        return result;
+    }
+    template <uint32_t M = N, typename = std::enable_if_t<(M <= 64)>>
+    constexpr Word bits() const noexcept {
+        return words_[0];
+    }
+
+    static constexpr uint32_t size() noexcept { return N; }
+
+    constexpr bool test(E value) const noexcept {
+        uint32_t index = static_cast<uint32_t>(value);
+        return (words_[index / word_bits] >> (index % word_bits)) & 1;
+    }
+    constexpr bool contains(E value) const noexcept { return test(value); }
+
+    constexpr EnumSet& set(E value, bool on = true) noexcept {
+        uint32_t index = static_cast<uint32_t>(value);
+        Word bit = static_cast<Word>(Word(1) << (index % word_bits));
+        Word& word = words_[index / word_bits];
+        word = static_cast<Word>(on ? word | bit : word & ~bit);
+        return *this;
+    }
+    constexpr EnumSet& reset(E value) noexcept { return set(value, false); }
+    constexpr EnumSet& flip(E value) noexcept { return set(value, !test(value)); }
+    constexpr void clear() noexcept {
+        for (Word& word : words_) {
+            word = 0;
+        }
+    }
+
+    // Number of values in the set
+    constexpr uint32_t count() const noexcept {
+        uint32_t total = 0;
+        for (Word word : words_) {
+            total += detail::popcount(word);
+        }
+        return total;
+    }
+    constexpr bool any() const noexcept {
+        for (Word word : words_) {
+            if (word != 0) return true;
+        }
+        return false;
+    }
+    constexpr bool none() const noexcept { return !any(); }
+    constexpr bool all() const noexcept { return count() == N; }
+
+    constexpr iterator begin() const noexcept { return iterator(this, next(0)); }
+    constexpr iterator end() const noexcept { return iterator(this, N); }
+
+    constexpr EnumSet& operator|=(const EnumSet& other) noexcept {
+        for (uint32_t i = 0; i < word_count; ++i) words_[i] |= other.words_[i];
+        return *this;
+    }
+    constexpr EnumSet& operator&=(const EnumSet& other) noexcept {
+        for (uint32_t i = 0; i < word_count; ++i) words_[i] &= other.words_[i];
+        return *this;
+    }
+    constexpr EnumSet& operator^=(const EnumSet& other) noexcept {
+        for (uint32_t i = 0; i < word_count; ++i) words_[i] ^= other.words_[i];
+        return *this;
+    }
+
+    // Complement within the N values
+    constexpr EnumSet operator~() const noexcept {
+        EnumSet result;
+        for (uint32_t i = 0; i < word_count; ++i) {
+            result.words_[i] = static_cast<Word>(~words_[i]);
+        }
+        result.words_[word_count - 1] &= last_word_mask();
+        return result;
+    }
+
+    friend constexpr EnumSet operator|(EnumSet a, const EnumSet& b) noexcept { return a |= b; }
+    friend constexpr EnumSet operator&(EnumSet a, const EnumSet& b) noexcept { return a &= b; }
+    friend constexpr EnumSet operator^(EnumSet a, const EnumSet& b) noexcept { return a ^= b; }
+    friend constexpr bool operator==(const EnumSet& a, const EnumSet& b) noexcept {
+        for (uint32_t i = 0; i < word_count; ++i) {
+            if (a.words_[i] != b.words_[i]) return false;
+        }
+        return true;
+    }
+    friend constexpr bool operator!=(const EnumSet& a, const EnumSet& b) noexcept { return !(a == b); }
+
+private:
+    std::array<Word, word_count> words_;
+
+    static constexpr Word last_word_mask() noexcept {
+        constexpr uint32_t used = N - (word_count - 1) * word_bits;
+        return used == word_bits ? static_cast<Word>(~Word(0)) : static_cast<Word>((Word(1) << used) - 1);
+    }
+
+    // First value at or after index that is in the set, or N
+    constexpr uint32_t next(uint32_t index) const noexcept {
+        while (index < N) {
+            uint64_t word = static_cast<uint64_t>(words_[index / word_bits]) >> (index % word_bits);
+            if (word != 0) {
+                return index + detail::lowest_bit(word);
+            }
+            index = (index / word_bits + 1) * word_bits;
+        }
+        return N;
+    }
+};
+
+// Fixed array with one element per value of an enum, indexed by the enum
+// itself. An aggregate like std::array: EnumArray<Team, int> scores{};
+template <typename E, typename T, uint32_t N = enum_count<E>()>
+struct EnumArray {
+    static_assert(std::is_enum_v<E>, "EnumArray requires an enum");
+
+    std::array<T, N> values;
+
+    using value_type = T;
+    using iterator = typename std::array<T, N>::iterator;
+    using const_iterator = typename std::array<T, N>::const_iterator;
+
+    static constexpr uint32_t size() noexcept { return N; }
+
+    // Enum value stored at an index, for walking keys and values together
+    static constexpr E key(uint32_t index) noexcept { return static_cast<E>(index); }
+
+    constexpr T& operator[](E key) noexcept { return values[static_cast<size_t>(key)]; }
+    constexpr const T& operator[](E key) const noexcept { return values[static_cast<size_t>(key)]; }
+    constexpr T& at(E key) { return values.at(static_cast<size_t>(key)); }
+    constexpr const T& at(E key) const { return values.at(static_cast<size_t>(key)); }
+
+    constexpr T* data() noexcept { return values.data(); }
+    constexpr const T* data() const noexcept { return values.data(); }
+    constexpr iterator begin() noexcept { return values.begin(); }
+    constexpr iterator end() noexcept { return values.end(); }
+    constexpr const_iterator begin() const noexcept { return values.begin(); }
+    constexpr const_iterator end() const noexcept { return values.end(); }
+
+    void fill(const T& value) { values.fill(value); }
+
+    friend bool operator==(const EnumArray& a, const EnumArray& b) { return a.values == b.values; }
+    friend bool operator!=(const EnumArray& a, const EnumArray& b) { return a.values != b.values; }
+};
+
+} // namespace carch
@@ -0,0 +1,105 @@
+// Carch runtime: FixedString
+// Ships with code generated by the Carch IDL compiler for str<N>
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace carch {
+
+// UTF-8 text of up to N bytes stored inside the object, with no heap
+// allocation. Text longer than N is truncated at a code point boundary.
+template <uint32_t N>
+class FixedString {
+    static_assert(N > 0, "FixedString needs a capacity of at least one byte");
+
+public:
+    // Smallest integer that can hold every length up to N
+    using size_type = std::conditional_t<(N <= UINT8_MAX), uint8_t,
+                      std::conditional_t<(N <= UINT16_MAX), uint16_t, uint32_t>>;
+
+    static constexpr uint32_t max_size = N;
+
+    FixedString() noexcept = default;
+    FixedString(std::string_view text) noexcept { assign(text); }
+    FixedString(const char* text) noexcept { assign(text); }
+    FixedString(const std::string& text) noexcept { assign(text); }
+
+    // Replaces the contents; returns false if the text had to be truncated
+    bool assign(std::string_view text) noexcept {
+        size_t length = text.size();
+        if (length > N) {
+            length = N;
+            // Do not split a multi-byte sequence: back up over continuation bytes
+            while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+                --length;
+            }
+        }
+        std::memcpy(data_, text.data(), length);
+        size_ = static_cast<size_type>(length);
+        return length == text.size();
+    }
+
+    FixedString& operator=(std::string_view text) noexcept {
+        assign(text);
+        return *this;
+    }
+    FixedString& operator=(const char* text) noexcept {
+        assign(text);
+        return *this;
+    }
+    FixedString& operator=(const std::string& text) noexcept {
+        assign(text);
+        return *this;
+    }
+
+    const char* data() const noexcept { return data_; }
+    uint32_t size() const noexcept { return size_; }
+    uint32_t length() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    static constexpr uint32_t capacity() noexcept { return N; }
+    void clear() noexcept { size_ = 0; }
+
+    std::string_view view() const noexcept { return std::string_view(data_, size_); }
+    operator std::string_view() const noexcept { return view(); }
+    std::string str() const { return std::string(data_, size_); }
+
+    const char* begin() const noexcept { return data_; }
+    const char* end() const noexcept { return data_ + size_; }
+    char operator[](uint32_t index) const noexcept { return data_[index]; }
+
+    // One overload per text type, so comparisons never have to choose
+    // between two implicit conversions
+    friend bool operator==(const FixedString& a, const FixedString& b) noexcept { return a.view() == b.view(); }
+    friend bool operator==(const FixedString& a, std::string_view b) noexcept { return a.view() == b; }
+    friend bool operator==(const FixedString& a, const std::string& b) noexcept { return a.view() == b; }
+    friend bool operator==(const FixedString& a, const char* b) noexcept { return a.view() == b; }
+    friend bool operator!=(const FixedString& a, const FixedString& b) noexcept { return !(a == b); }
+    friend bool operator!=(const FixedString& a, std::string_view b) noexcept { return !(a == b); }
+    friend bool operator!=(const FixedString& a, const std::string& b) noexcept { return !(a == b); }
+    friend bool operator!=(const FixedString& a, const char* b) noexcept { return !(a == b); }
+    friend bool operator<(const FixedString& a, const FixedString& b) noexcept { return a.view() < b.view(); }
+
+private:
+    size_type size_ = 0;
+    char data_[N] = {};
+};
+
+} // namespace carch
+
+namespace std {
+
+template <uint32_t N>
+struct hash<carch::FixedString<N>> {
+    size_t operator()(const carch::FixedString<N>& text) const noexcept {
+        return hash<string_view>()(text.view());
+    }
+};
+
+} // namespace std
@@ -0,0 +1,469 @@
+// Carch runtime: FlatHashMap
+// Ships with code generated by the Carch IDL compiler for map<K, V> with the flat backend
+
+#pragma once
+
+#include "carch/traits.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace carch {
+
+// Hash map that keeps every entry in one open-addressed array instead of a
+// heap node per entry. A parallel array of control bytes holds 7 bits of
+// each entry's hash, so most probes that miss never touch the entries.
+// Inserting may move entries and invalidates iterators and references.
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class FlatHashMap {
+    template <bool Const>
+    class Iterator;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using size_type = uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() noexcept {}
+
+    FlatHashMap(std::initializer_list<value_type> values) {
+        reserve(static_cast<uint32_t>(values.size()));
+        for (const value_type& value : values) {
+            insert(value);
+        }
+    }
+
+    FlatHashMap(const FlatHashMap& other) {
+        reserve(other.size_);
+        for (const value_type& value : other) {
+            ::new (static_cast<void*>(slots_ + claim_free(hash_of(value.first)))) value_type(value);
+        }
+    }
+
+    FlatHashMap(FlatHashMap&& other) noexcept { take(other); }
+
+    ~FlatHashMap() { release(); }
+
+    FlatHashMap& operator=(const FlatHashMap& other) {
+        if (this != &other) {
+            FlatHashMap copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    FlatHashMap& operator=(FlatHashMap&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    // Iterators visit entries in table order, which is unspecified
+    iterator begin() noexcept { return iterator(ctrl_, slots_, ctrl_ + capacity_); }
+    iterator end() noexcept { return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_); }
+    const_iterator begin() const noexcept { return const_iterator(ctrl_, slots_, ctrl_ + capacity_); }
+    const_iterator end() const noexcept {
+        return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+    }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Capacity
+    bool empty() const noexcept { return size_ == 0; }
+    uint32_t size() const noexcept { return size_; }
+    // Number of slots; at most 7/8 of them are filled before the table grows
+    uint32_t capacity() const noexcept { return capacity_; }
+
+    // Makes room for count entries in total without further rehashing
+    void reserve(uint32_t count) {
+        if (count > size_ + growth_left_) {
+            rehash(capacity_for(count > size_ ? count : size_));
+        }
+    }
+
+    void clear() noexcept {
+        destroy_entries();
+        if (capacity_ > 0) {
+            std::memset(ctrl_, EMPTY, capacity_);
+        }
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    // Lookup
+    iterator find(const K& key) noexcept {
+        uint32_t index = find_index(key);
+        return index == capacity_ ? end() : iterator_at(index);
+    }
+    const_iterator find(const K& key) const noexcept {
+        uint32_t index = find_index(key);
+        return index == capacity_ ? end() : const_iterator_at(index);
+    }
+    bool contains(const K& key) const noexcept { return find_index(key) != capacity_; }
+    uint32_t count(const K& key) const noexcept { return contains(key) ? 1 : 0; }
+
+    V& at(const K& key) {
+        uint32_t index = find_index(key);
+        if (index == capacity_) throw std::out_of_range("carch::FlatHashMap::at");
+        return slots_[index].second;
+    }
+    const V& at(const K& key) const {
+        uint32_t index = find_index(key);
+        if (index == capacity_) throw std::out_of_range("carch::FlatHashMap::at");
+        return slots_[index].second;
+    }
+
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+    V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+    // Modifiers
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+        return emplace_key(key, std::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        return emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type value(std::forward<Args>(args)...);
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& value) {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    uint32_t erase(const K& key) {
+        uint32_t index = find_index(key);
+        if (index == capacity_) {
+            return 0;
+        }
+        erase_at(index);
+        return 1;
+    }
+
+    // Returns the iterator following the erased entry
+    iterator erase(const_iterator position) {
+        uint32_t index = static_cast<uint32_t>(position.slot_ - slots_);
+        erase_at(index);
+        return iterator_at(index);
+    }
+
+    void swap(FlatHashMap& other) noexcept {
+        std::swap(slots_, other.slots_);
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(growth_left_, other.growth_left_);
+    }
+
+    friend bool operator==(const FlatHashMap& a, const FlatHashMap& b) {
+        if (a.size_ != b.size_) {
+            return false;
+        }
+        for (const value_type& value : a) {
+            auto it = b.find(value.first);
+            if (it == b.end() || !(it->second == value.second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    friend bool operator!=(const FlatHashMap& a, const FlatHashMap& b) { return !(a == b); }
+
+private:
+    // Control byte values; full slots hold the low 7 bits of the hash
+    static constexpr uint8_t EMPTY = 0x80;
+    static constexpr uint8_t DELETED = 0x81;
+    static constexpr uint32_t MIN_CAPACITY = 8;
+
+    value_type* slots_ = nullptr;
+    uint8_t* ctrl_ = nullptr;
+    uint32_t size_ = 0;
+    uint32_t capacity_ = 0;         // Zero or a power of two
+    uint32_t growth_left_ = 0;      // Empty slots that may still be filled before growing
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        Iterator() noexcept = default;
+        operator Iterator<true>() const noexcept { return Iterator<true>(ctrl_, slot_, end_); }
+
+        reference operator*() const noexcept { return *slot_; }
+        pointer operator->() const noexcept { return slot_; }
+
+        Iterator& operator++() noexcept {
+            ++ctrl_;
+            ++slot_;
+            skip_free();
+            return *this;
+        }
+        Iterator operator++(int) noexcept {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) noexcept { return a.ctrl_ == b.ctrl_; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) noexcept { return a.ctrl_ != b.ctrl_; }
+
+    private:
+        friend class FlatHashMap;
+        template <bool>
+        friend class Iterator;
+
+        Iterator(const uint8_t* ctrl, pointer slot, const uint8_t* end) noexcept
+            : ctrl_(ctrl), slot_(slot), end_(end) {
+            skip_free();
+        }
+
+        void skip_free() noexcept {
+            while (ctrl_ != end_ && !is_full(*ctrl_)) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const uint8_t* ctrl_ = nullptr;
+        pointer slot_ = nullptr;
+        const uint8_t* end_ = nullptr;
+    };
+
+    template <typename Key, typename... Args>
+    std::pair<iterator, bool> emplace_key(Key&& key, Args&&... args) {
+        size_t hash = hash_of(key);
+        uint32_t index = probe(key, hash);
+        if (index < capacity_ && is_full(ctrl_[index])) {
+            return {iterator_at(index), false};
+        }
+        if (index == capacity_ || (ctrl_[index] == EMPTY && growth_left_ == 0)) {
+            grow();
+            index = find_free(hash);
+        }
+        ::new (static_cast<void*>(slots_ + index)) value_type(
+            std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        occupy(index, hash);
+        return {iterator_at(index), true};
+    }
+
+    static bool is_full(uint8_t ctrl) noexcept { return (ctrl & 0x80) == 0; }
+    static uint32_t max_load(uint32_t capacity) noexcept { return capacity - capacity / 8; }
+
+    static uint32_t capacity_for(uint32_t count) {
+        uint32_t capacity = MIN_CAPACITY;
+        while (max_load(capacity) < count) {
+            if (capacity > UINT32_MAX / 2) throw std::length_error("carch::FlatHashMap too large");
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    // std::hash is the identity for integers, so spread the bits before
+    // splitting the hash into a start position and a control byte
+    static size_t hash_of(const K& key) noexcept {
+        uint64_t hash = static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+    static uint8_t control_of(size_t hash) noexcept { return static_cast<uint8_t>(hash & 0x7F); }
+    uint32_t start_of(size_t hash) const noexcept { return static_cast<uint32_t>(hash >> 7) & (capacity_ - 1); }
+
+    iterator iterator_at(uint32_t index) noexcept {
+        return iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+    }
+    const_iterator const_iterator_at(uint32_t index) const noexcept {
+        return const_iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+    }
+
+    // Slot holding key, or the first free slot on its probe sequence where
+    // it would go; capacity_ when the table has no slots
+    uint32_t probe(const K& key, size_t hash) const noexcept {
+        if (capacity_ == 0) {
+            return capacity_;
+        }
+        uint8_t control = control_of(hash);
+        uint32_t mask = capacity_ - 1;
+        uint32_t first_free = capacity_;
+        for (uint32_t index = start_of(hash);; index = (index + 1) & mask) {
+            uint8_t ctrl = ctrl_[index];
+            if (ctrl == control && KeyEqual()(slots_[index].first, key)) {
+                return index;
+            }
+            if (ctrl == DELETED && first_free == capacity_) {
+                first_free = index;
+            } else if (ctrl == EMPTY) {
+                // Growth stops before the last empty slot fills, so every probe ends
+                return first_free != capacity_ ? first_free : index;
+            }
+        }
+    }
+
+    uint32_t find_index(const K& key) const noexcept {
+        uint32_t index = probe(key, hash_of(key));
+        return index < capacity_ && is_full(ctrl_[index]) ? index : capacity_;
+    }
+
+    uint32_t find_free(size_t hash) const noexcept {
+        uint32_t mask = capacity_ - 1;
+        uint32_t index = start_of(hash);
+        while (is_full(ctrl_[index])) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void occupy(uint32_t index, size_t hash) noexcept {
+        if (ctrl_[index] == EMPTY) {
+            --growth_left_;
+        }
+        ctrl_[index] = control_of(hash);
+        ++size_;
+    }
+
+    // Free slot for a key known to be absent, growing first if needed
+    uint32_t claim_free(size_t hash) {
+        uint32_t index = find_free(hash);
+        if (ctrl_[index] == EMPTY && growth_left_ == 0) {
+            grow();
+            index = find_free(hash);
+        }
+        occupy(index, hash);
+        return index;
+    }
+
+    void erase_at(uint32_t index) noexcept {
+        slots_[index].~value_type();
+        --size_;
+        // A probe that reaches this slot stops at the next one anyway when
+        // it is empty, so no tombstone is needed
+        if (ctrl_[(index + 1) & (capacity_ - 1)] == EMPTY) {
+            ctrl_[index] = EMPTY;
+            ++growth_left_;
+        } else {
+            ctrl_[index] = DELETED;
+        }
+    }
+
+    // Doubles the table, or only clears tombstones when at most half of
+    // the usable slots hold live entries
+    void grow() {
+        if (capacity_ == 0) {
+            rehash(MIN_CAPACITY);
+        } else if (size_ <= max_load(capacity_) / 2) {
+            rehash(capacity_);
+        } else {
+            if (capacity_ > UINT32_MAX / 2) throw std::length_error("carch::FlatHashMap too large");
+            rehash(capacity_ * 2);
+        }
+    }
+
+    void rehash(uint32_t capacity) {
+        value_type* slots = std::allocator<value_type>().allocate(capacity);
+        uint8_t* ctrl = std::allocator<uint8_t>().allocate(capacity);
+        std::memset(ctrl, EMPTY, capacity);
+
+        FlatHashMap next;
+        next.slots_ = slots;
+        next.ctrl_ = ctrl;
+        next.capacity_ = capacity;
+        next.growth_left_ = max_load(capacity);
+        // Entries are moved over before any is destroyed; if a move throws,
+        // next frees what it holds and this map keeps its own entries
+        for (uint32_t index = 0; index < capacity_; ++index) {
+            if (is_full(ctrl_[index])) {
+                size_t hash = hash_of(slots_[index].first);
+                uint32_t target = next.find_free(hash);
+                ::new (static_cast<void*>(slots + target)) value_type(std::move(slots_[index]));
+                next.occupy(target, hash);
+            }
+        }
+        swap(next);
+    }
+
+    void destroy_entries() noexcept {
+        if (!std::is_trivially_destructible<value_type>::value) {
+            for (uint32_t index = 0; index < capacity_; ++index) {
+                if (is_full(ctrl_[index])) {
+                    slots_[index].~value_type();
+                }
+            }
+        }
+    }
+
+    void release() noexcept {
+        if (capacity_ > 0) {
+            destroy_entries();
+            std::allocator<value_type>().deallocate(slots_, capacity_);
+            std::allocator<uint8_t>().deallocate(ctrl_, capacity_);
+            slots_ = nullptr;
+            ctrl_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+            growth_left_ = 0;
+        }
+    }
+
+    void take(FlatHashMap& other) noexcept {
+        slots_ = other.slots_;
+        ctrl_ = other.ctrl_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        growth_left_ = other.growth_left_;
+        other.slots_ = nullptr;
+        other.ctrl_ = nullptr;
+        other.size_ = 0;
+        other.capacity_ = 0;
+        other.growth_left_ = 0;
+    }
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void swap(FlatHashMap<K, V, Hash, KeyEqual>& a, FlatHashMap<K, V, Hash, KeyEqual>& b) noexcept {
+    a.swap(b);
+}
+
+// The entries and control bytes live behind pointers, so the map moves as
+// bytes whatever it holds
+template <typename K, typename V, typename Hash, typename KeyEqual>
+struct is_trivially_relocatable<FlatHashMap<K, V, Hash, KeyEqual>>
+    : std::bool_constant<is_trivially_relocatable_v<Hash> && is_trivially_relocatable_v<KeyEqual>> {};
+
+} // namespace carch
@@ -0,0 +1,112 @@
+// Carch runtime: InternedString
+// Ships with code generated by the Carch IDL compiler for istr
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace carch {
+
+// Process-wide table of unique strings. Entries are never removed, so a
+// handle stays valid for the life of the program.
+class StringTable {
+public:
+    struct Entry {
+        size_t hash;
+        std::string text;
+    };
+
+    static StringTable& global() {
+        static StringTable table;
+        return table;
+    }
+
+    // Returns the unique entry for text, adding it on first use.
+    // Lookups of existing strings only take a shared lock.
+    const Entry* intern(std::string_view text) {
+        if (text.empty()) {
+            return empty_entry();
+        }
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = index_.find(text);
+            if (it != index_.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_.find(text);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        // deque::push_back never moves existing entries, so the
+        // string_view keys into them stay valid
+        entries_.push_back(Entry{std::hash<std::string_view>()(text), std::string(text)});
+        const Entry* entry = &entries_.back();
+        index_.emplace(std::string_view(entry->text), entry);
+        return entry;
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return entries_.size() + 1;
+    }
+
+    // Shared by every empty handle, including default-constructed ones
+    static const Entry* empty_entry() noexcept {
+        static const Entry entry{std::hash<std::string_view>()(std::string_view()), std::string()};
+        return &entry;
+    }
+
+private:
+    StringTable() = default;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string_view, const Entry*> index_;
+    std::deque<Entry> entries_;
+};
+
+// Pointer-sized handle to a string in the global StringTable. Equal strings
+// share one entry, so comparing and hashing handles never touches the text.
+class InternedString {
+public:
+    InternedString() noexcept : entry_(StringTable::empty_entry()) {}
+    InternedString(std::string_view text) : entry_(StringTable::global().intern(text)) {}
+    InternedString(const char* text) : InternedString(std::string_view(text)) {}
+    InternedString(const std::string& text) : InternedString(std::string_view(text)) {}
+
+    std::string_view view() const noexcept { return entry_->text; }
+    operator std::string_view() const noexcept { return view(); }
+    const std::string& str() const noexcept { return entry_->text; }
+    const char* c_str() const noexcept { return entry_->text.c_str(); }
+    size_t size() const noexcept { return entry_->text.size(); }
+    bool empty() const noexcept { return entry_->text.empty(); }
+    size_t hash() const noexcept { return entry_->hash; }
+
+    // Identity comparison; equal text always means the same entry
+    friend bool operator==(InternedString a, InternedString b) noexcept { return a.entry_ == b.entry_; }
+    friend bool operator!=(InternedString a, InternedString b) noexcept { return a.entry_ != b.entry_; }
+    // Orders by text so sorted output does not depend on interning order
+    friend bool operator<(InternedString a, InternedString b) noexcept { return a.view() < b.view(); }
+
+private:
+    const StringTable::Entry* entry_;
+};
+
+} // namespace carch
+
+namespace std {
+
+template <>
+struct hash<carch::InternedString> {
+    size_t operator()(carch::InternedString text) const noexcept { return text.hash(); }
+};
+
+} // namespace std
@@ -0,0 +1,219 @@
+// Carch runtime: reduced-precision numbers
+// Ships with code generated by the Carch IDL compiler for f16, unorm8/16, snorm8/16 and quant<min, max, bits>
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace carch {
+
+// Each type stores only its encoded bits, converts implicitly to and from
+// float, and exposes the bits through bits() and from_bits() for
+// serializers. Values outside the range clamp to it; NaN encodes as the
+// lowest value, except in Half, which keeps it.
+
+namespace detail {
+
+inline uint32_t float_bits(float value) noexcept {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bits_float(uint32_t bits) noexcept {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// IEEE binary16 conversions with round-to-nearest-even. With F16C they are
+// one instruction; otherwise a few integer operations, with no table and
+// only the subnormal range taking a floating-point add.
+inline uint16_t float_to_half(float value) noexcept {
+#if defined(__F16C__)
+    return static_cast<uint16_t>(_cvtss_sh(value, 0));
+#else
+    uint32_t bits = float_bits(value);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    uint16_t result;
+    if (bits >= 0x47800000u) {
+        // 65536 and above, infinity or NaN; NaN stays a quiet NaN
+        result = bits > 0x7F800000u ? 0x7E00 : 0x7C00;
+    } else if (bits < 0x38800000u) {
+        // Below the smallest normal half: adding 0.5 lines the half mantissa
+        // up with the bottom of the float's, and the addition rounds
+        const uint32_t magic = 0x3F000000u;
+        result = static_cast<uint16_t>(float_bits(bits_float(bits) + bits_float(magic)) - magic);
+    } else {
+        uint32_t odd = (bits >> 13) & 1;
+        bits += 0xC8000FFFu + odd;     // Rebias the exponent, round half to even
+        result = static_cast<uint16_t>(bits >> 13);
+    }
+    return static_cast<uint16_t>(result | (sign >> 16));
+#endif
+}
+
+inline float half_to_float(uint16_t half) noexcept {
+#if defined(__F16C__)
+    return _cvtsh_ss(half);
+#else
+    const uint32_t exponent_mask = 0x7C00u << 13;
+    uint32_t bits = (half & 0x7FFFu) << 13;
+    uint32_t exponent = bits & exponent_mask;
+    bits += (127 - 15) << 23;
+    if (exponent == exponent_mask) {
+        bits += (128 - 16) << 23;       // Infinity or NaN
+    } else if (exponent == 0) {
+        bits += 1 << 23;                // Zero or subnormal: renormalize
+        bits = float_bits(bits_float(bits) - bits_float(113u << 23));
+    }
+    return bits_float(bits | (static_cast<uint32_t>(half & 0x8000u) << 16));
+#endif
+}
+
+} // namespace detail
+
+// IEEE 754 half-precision float: 11 significant bits, up to 65504
+class Half {
+public:
+    Half() noexcept = default;
+    Half(float value) noexcept : bits_(detail::float_to_half(value)) {}
+
+    operator float() const noexcept { return detail::half_to_float(bits_); }
+
+    static Half from_bits(uint16_t bits) noexcept {
+        Half result;
+        result.bits_ = bits;
+        return result;
+    }
+    uint16_t bits() const noexcept { return bits_; }
+
+private:
+    uint16_t bits_ = 0;
+};
+
+// [0, 1] in the full range of an unsigned integer: 0 is 0.0, the maximum 1.0
+template <typename T>
+class Unorm {
+    static_assert(std::is_unsigned_v<T>, "Unorm stores an unsigned integer");
+
+public:
+    static constexpr T max_code = static_cast<T>(~T(0));
+
+    constexpr Unorm() noexcept = default;
+    constexpr Unorm(float value) noexcept
+        : bits_(!(value > 0.0f) ? T(0) : value >= 1.0f ? max_code : static_cast<T>(value * max_code + 0.5f)) {}
+
+    constexpr operator float() const noexcept { return bits_ * (1.0f / max_code); }
+
+    static constexpr Unorm from_bits(T bits) noexcept {
+        Unorm result;
+        result.bits_ = bits;
+        return result;
+    }
+    constexpr T bits() const noexcept { return bits_; }
+
+private:
+    T bits_ = 0;
+};
+
+// [-1, 1] in a signed integer, symmetric around zero: -max and max are -1.0
+// and 1.0, and the extra lowest code also decodes to -1.0
+template <typename T>
+class Snorm {
+    static_assert(std::is_signed_v<T> && std::is_integral_v<T>, "Snorm stores a signed integer");
+
+public:
+    static constexpr T max_code = std::numeric_limits<T>::max();
+
+    constexpr Snorm() noexcept = default;
+    constexpr Snorm(float value) noexcept
+        : bits_(!(value > -1.0f) ? T(-max_code)
+                : value >= 1.0f  ? max_code
+                                 : static_cast<T>(value * max_code + (value < 0.0f ? -0.5f : 0.5f))) {}
+
+    constexpr operator float() const noexcept {
+        float value = bits_ * (1.0f / max_code);
+        return value < -1.0f ? -1.0f : value;
+    }
+
+    static constexpr Snorm from_bits(T bits) noexcept {
+        Snorm result;
+        result.bits_ = bits;
+        return result;
+    }
+    constexpr T bits() const noexcept { return bits_; }
+
+private:
+    T bits_ = 0;
+};
+
+using Unorm8 = Unorm<uint8_t>;
+using Unorm16 = Unorm<uint16_t>;
+using Snorm8 = Snorm<int8_t>;
+using Snorm16 = Snorm<int16_t>;
+
+namespace detail {
+
+constexpr double pow10(uint32_t exponent) noexcept {
+    double result = 1.0;
+    for (uint32_t i = 0; i < exponent; ++i) {
+        result *= 10.0;
+    }
+    return result;
+}
+
+} // namespace detail
+
+// Value in [Min, Max] / 10^Decimals, stored in Bits bits as the nearest of
+// 2^Bits evenly spaced steps: quant<-1.5, 1.5, 10> is Quantized<-15, 15, 10, 1>.
+// A default-constructed value holds the minimum.
+template <int64_t Min, int64_t Max, uint32_t Bits, uint32_t Decimals = 0>
+class Quantized {
+    static_assert(Bits >= 1 && Bits <= 32, "Quantized needs between 1 and 32 bits");
+    static_assert(Min < Max, "Quantized needs a minimum below its maximum");
+
+public:
+    using storage_type = std::conditional_t<(Bits <= 8), uint8_t,
+                         std::conditional_t<(Bits <= 16), uint16_t, uint32_t>>;
+    // float represents every code of up to 24 bits exactly
+    using value_type = std::conditional_t<(Bits <= 24), float, double>;
+
+    static constexpr storage_type max_code =
+        static_cast<storage_type>(Bits == 32 ? UINT32_MAX : (uint64_t(1) << Bits) - 1);
+    static constexpr value_type min_value = static_cast<value_type>(Min / detail::pow10(Decimals));
+    static constexpr value_type max_value = static_cast<value_type>(Max / detail::pow10(Decimals));
+    static constexpr value_type step =
+        static_cast<value_type>((Max - Min) / detail::pow10(Decimals) / static_cast<double>(max_code));
+
+    constexpr Quantized() noexcept = default;
+    constexpr Quantized(value_type value) noexcept
+        : bits_(!(value > min_value) ? storage_type(0)
+                : value >= max_value ? max_code
+                                     : static_cast<storage_type>((value - min_value) * (value_type(1) / step) +
+                                                                 value_type(0.5))) {}
+
+    constexpr operator value_type() const noexcept {
+        return bits_ == max_code ? max_value : min_value + bits_ * step;
+    }
+
+    static constexpr Quantized from_bits(storage_type bits) noexcept {
+        Quantized result;
+        result.bits_ = bits > max_code ? max_code : bits;
+        return result;
+    }
+    constexpr storage_type bits() const noexcept { return bits_; }
+
+private:
+    storage_type bits_ = 0;
+};
+
+} // namespace carch
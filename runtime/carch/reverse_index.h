@@ -0,0 +1,125 @@
+// Carch runtime: reverse index of entity references
+// Ships with code generated by the Carch IDL compiler for @indexed ref<entity> fields
+
+#pragma once
+
+#include "carch/entity.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace carch {
+
+// Null handle and dense index of an entity id, for generational handles and
+// plain integer ids alike
+template <typename E>
+struct entity_traits {
+    static constexpr E null() noexcept { return std::numeric_limits<E>::max(); }
+    static constexpr bool is_null(E entity) noexcept { return entity == null(); }
+    static constexpr size_t index(E entity) noexcept { return static_cast<size_t>(entity); }
+};
+
+template <typename Word, uint32_t IndexBits>
+struct entity_traits<BasicEntity<Word, IndexBits>> {
+    using E = BasicEntity<Word, IndexBits>;
+    static constexpr E null() noexcept { return E::null(); }
+    static constexpr bool is_null(E entity) noexcept { return entity.is_null(); }
+    static constexpr size_t index(E entity) noexcept { return static_cast<size_t>(entity.index()); }
+};
+
+// For every referenced entity, the (entity, component, field) triples that
+// reference it. Component pools register themselves and keep their links
+// current as components are set and removed, so destroying an entity
+// visits only the components that point at it rather than every
+// component in the world.
+template <typename E = Entity64>
+class ReverseIndex {
+public:
+    struct Referrer {
+        E entity;               // Entity whose component holds the reference
+        uint32_t component;     // Id the pool got from add_component()
+        uint32_t field;         // The generated <Type>_Ref value
+
+        friend bool operator==(const Referrer& a, const Referrer& b) noexcept {
+            return a.entity == b.entity && a.component == b.component && a.field == b.field;
+        }
+    };
+
+    // Nulls field of referrer's component if it still holds target
+    using ClearFn = void (*)(void* pool, E referrer, uint32_t field, E target);
+
+    ReverseIndex() = default;
+    ReverseIndex(const ReverseIndex&) = delete;
+    ReverseIndex& operator=(const ReverseIndex&) = delete;
+
+    uint32_t add_component(void* pool, ClearFn clear) {
+        components_.push_back({pool, clear});
+        return static_cast<uint32_t>(components_.size() - 1);
+    }
+    void remove_component(uint32_t component) noexcept { components_[component] = {nullptr, nullptr}; }
+
+    void link(E target, const Referrer& referrer) { links_[target].push_back(referrer); }
+
+    // O(referrers of target)
+    bool unlink(E target, const Referrer& referrer) noexcept {
+        auto it = links_.find(target);
+        if (it == links_.end()) {
+            return false;
+        }
+        std::vector<Referrer>& referrers = it->second;
+        for (size_t i = 0; i < referrers.size(); ++i) {
+            if (referrers[i] == referrer) {
+                referrers[i] = referrers.back();
+                referrers.pop_back();
+                if (referrers.empty()) {
+                    links_.erase(it);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Components referencing target, in no particular order
+    const std::vector<Referrer>& referrers(E target) const noexcept {
+        static const std::vector<Referrer> none;
+        auto it = links_.find(target);
+        return it != links_.end() ? it->second : none;
+    }
+    size_t referrer_count(E target) const noexcept { return referrers(target).size(); }
+
+    // Nulls every reference to target and forgets them; returns how many
+    // there were. Call it when target is destroyed, after notifying
+    // referrers() if they need to react.
+    size_t release(E target) {
+        auto it = links_.find(target);
+        if (it == links_.end()) {
+            return 0;
+        }
+        std::vector<Referrer> referrers = std::move(it->second);
+        links_.erase(it);
+        for (const Referrer& referrer : referrers) {
+            const Component& component = components_[referrer.component];
+            if (component.clear) {
+                component.clear(component.pool, referrer.entity, referrer.field, target);
+            }
+        }
+        return referrers.size();
+    }
+
+    // Referenced entities
+    size_t size() const noexcept { return links_.size(); }
+
+private:
+    struct Component {
+        void* pool;
+        ClearFn clear;
+    };
+    std::vector<Component> components_;
+    std::unordered_map<E, std::vector<Referrer>> links_;
+};
+
+} // namespace carch
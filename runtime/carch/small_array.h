@@ -0,0 +1,256 @@
+// Carch runtime: SmallArray
+// Ships with code generated by the Carch IDL compiler for small_array<T, N>
+
+#pragma once
+
+#include "carch/traits.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace carch {
+
+// Sequence that keeps up to N elements inside the object and moves them to
+// a heap buffer only when it grows past N. Short lists cost no allocation
+// and no pointer chase. Trivially relocatable elements move to a new buffer
+// with one memcpy.
+template <typename T, uint32_t N>
+class SmallArray {
+    static_assert(N > 0, "SmallArray needs an inline capacity of at least one element");
+
+public:
+    using value_type = T;
+    using size_type = uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr uint32_t inline_capacity = N;
+
+    SmallArray() noexcept {}
+
+    SmallArray(std::initializer_list<T> values) {
+        reserve(static_cast<uint32_t>(values.size()));
+        for (const T& value : values) {
+            push_back_unchecked(value);
+        }
+    }
+
+    SmallArray(const SmallArray& other) {
+        reserve(other.size_);
+        for (const T& value : other) {
+            push_back_unchecked(value);
+        }
+    }
+
+    SmallArray(SmallArray&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+        take(std::move(other));
+    }
+
+    ~SmallArray() {
+        clear();
+        release();
+    }
+
+    SmallArray& operator=(const SmallArray& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.size_);
+            for (const T& value : other) {
+                push_back_unchecked(value);
+            }
+        }
+        return *this;
+    }
+
+    SmallArray& operator=(SmallArray&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+        if (this != &other) {
+            clear();
+            release();
+            take(std::move(other));
+        }
+        return *this;
+    }
+
+    SmallArray& operator=(std::initializer_list<T> values) {
+        clear();
+        reserve(static_cast<uint32_t>(values.size()));
+        for (const T& value : values) {
+            push_back_unchecked(value);
+        }
+        return *this;
+    }
+
+    // Element access
+    T* data() noexcept { return is_inline() ? inline_data() : heap_; }
+    const T* data() const noexcept { return is_inline() ? inline_data() : heap_; }
+    T& operator[](uint32_t index) noexcept { return data()[index]; }
+    const T& operator[](uint32_t index) const noexcept { return data()[index]; }
+    T& at(uint32_t index) {
+        if (index >= size_) throw std::out_of_range("carch::SmallArray::at");
+        return data()[index];
+    }
+    const T& at(uint32_t index) const {
+        if (index >= size_) throw std::out_of_range("carch::SmallArray::at");
+        return data()[index];
+    }
+    T& front() noexcept { return data()[0]; }
+    const T& front() const noexcept { return data()[0]; }
+    T& back() noexcept { return data()[size_ - 1]; }
+    const T& back() const noexcept { return data()[size_ - 1]; }
+
+    // Iterators
+    iterator begin() noexcept { return data(); }
+    iterator end() noexcept { return data() + size_; }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator end() const noexcept { return data() + size_; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Capacity
+    bool empty() const noexcept { return size_ == 0; }
+    uint32_t size() const noexcept { return size_; }
+    uint32_t capacity() const noexcept { return capacity_; }
+    // Whether the elements are stored inside the object
+    bool is_inline() const noexcept { return capacity_ == N; }
+
+    void reserve(uint32_t capacity) {
+        if (capacity > capacity_) {
+            grow(capacity);
+        }
+    }
+
+    // Modifiers
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            // Construct first: args may refer to an element that grow() moves
+            T value(std::forward<Args>(args)...);
+            grow(next_capacity());
+            return push_back_unchecked(std::move(value));
+        }
+        return push_back_unchecked(std::forward<Args>(args)...);
+    }
+
+    void pop_back() noexcept {
+        --size_;
+        data()[size_].~T();
+    }
+
+    iterator erase(const_iterator position) {
+        T* first = data();
+        T* target = first + (position - first);
+        std::move(target + 1, first + size_, target);
+        pop_back();
+        return target;
+    }
+
+    void resize(uint32_t count) {
+        reserve(count);
+        while (size_ > count) {
+            pop_back();
+        }
+        while (size_ < count) {
+            push_back_unchecked();
+        }
+    }
+
+    void clear() noexcept {
+        std::destroy_n(data(), size_);
+        size_ = 0;
+    }
+
+    friend bool operator==(const SmallArray& a, const SmallArray& b) {
+        return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const SmallArray& a, const SmallArray& b) { return !(a == b); }
+
+private:
+    uint32_t size_ = 0;
+    uint32_t capacity_ = N;     // N while inline, the heap buffer's size once spilled
+    union {
+        T* heap_;
+        alignas(T) unsigned char inline_[N * sizeof(T)];
+    };
+
+    T* inline_data() noexcept { return std::launder(reinterpret_cast<T*>(inline_)); }
+    const T* inline_data() const noexcept { return std::launder(reinterpret_cast<const T*>(inline_)); }
+
+    uint32_t next_capacity() const noexcept {
+        return capacity_ > UINT32_MAX / 2 ? UINT32_MAX : capacity_ * 2;
+    }
+
+    template <typename... Args>
+    T& push_back_unchecked(Args&&... args) {
+        T* slot = ::new (static_cast<void*>(data() + size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void grow(uint32_t capacity) {
+        T* buffer = std::allocator<T>().allocate(capacity);
+        T* old = data();
+        if constexpr (is_trivially_relocatable_v<T>) {
+            relocate_n(old, size_, buffer);
+        } else {
+            try {
+                std::uninitialized_move_n(old, size_, buffer);
+            } catch (...) {
+                std::allocator<T>().deallocate(buffer, capacity);
+                throw;
+            }
+            std::destroy_n(old, size_);
+        }
+        release();
+        heap_ = buffer;
+        capacity_ = capacity;
+    }
+
+    // Frees the heap buffer, if any, leaving the (empty) array inline
+    void release() noexcept {
+        if (!is_inline()) {
+            std::allocator<T>().deallocate(heap_, capacity_);
+            capacity_ = N;
+        }
+    }
+
+    // Takes other's elements; a heap buffer changes owner without copying
+    void take(SmallArray&& other) {
+        if (other.is_inline()) {
+            if constexpr (is_trivially_relocatable_v<T>) {
+                relocate_n(other.inline_data(), other.size_, inline_data());
+                size_ = other.size_;
+                other.size_ = 0;
+            } else {
+                std::uninitialized_move_n(other.inline_data(), other.size_, inline_data());
+                size_ = other.size_;
+                other.clear();
+            }
+        } else {
+            heap_ = other.heap_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            other.size_ = 0;
+            other.capacity_ = N;
+        }
+    }
+};
+
+// Inline elements move with the array and a heap buffer only changes owner
+template <typename T, uint32_t N>
+struct is_trivially_relocatable<SmallArray<T, N>> : is_trivially_relocatable<T> {};
+
+} // namespace carch
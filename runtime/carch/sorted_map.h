@@ -0,0 +1,160 @@
+// Carch runtime: SortedFlatMap
+// Ships with code generated by the Carch IDL compiler for map<K, V> with the sorted backend
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace carch {
+
+// Map stored as one vector of entries sorted by key. Lookups are a binary
+// search over contiguous memory and iteration is a linear scan in key
+// order; inserting or erasing shifts the entries after the position, so it
+// suits small maps that are read far more often than they change.
+// Keys must not be modified through iterators.
+template <typename K, typename V, typename Compare = std::less<K>>
+class SortedFlatMap {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = uint32_t;
+    using key_compare = Compare;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    SortedFlatMap() noexcept {}
+
+    // Later duplicates of a key are ignored, as with std::map
+    SortedFlatMap(std::initializer_list<value_type> values) : entries_(values) {
+        std::stable_sort(entries_.begin(), entries_.end(), [](const value_type& a, const value_type& b) {
+            return Compare()(a.first, b.first);
+        });
+        entries_.erase(std::unique(entries_.begin(), entries_.end(),
+                                   [](const value_type& a, const value_type& b) { return equal(a.first, b.first); }),
+                       entries_.end());
+    }
+
+    iterator begin() noexcept { return entries_.begin(); }
+    iterator end() noexcept { return entries_.end(); }
+    const_iterator begin() const noexcept { return entries_.begin(); }
+    const_iterator end() const noexcept { return entries_.end(); }
+    const_iterator cbegin() const noexcept { return entries_.begin(); }
+    const_iterator cend() const noexcept { return entries_.end(); }
+
+    bool empty() const noexcept { return entries_.empty(); }
+    uint32_t size() const noexcept { return static_cast<uint32_t>(entries_.size()); }
+    uint32_t capacity() const noexcept { return static_cast<uint32_t>(entries_.capacity()); }
+    void reserve(uint32_t count) { entries_.reserve(count); }
+    void clear() noexcept { entries_.clear(); }
+
+    // First entry whose key is not less than key
+    iterator lower_bound(const K& key) {
+        return std::lower_bound(entries_.begin(), entries_.end(), key,
+                                [](const value_type& entry, const K& k) { return Compare()(entry.first, k); });
+    }
+    const_iterator lower_bound(const K& key) const {
+        return std::lower_bound(entries_.begin(), entries_.end(), key,
+                                [](const value_type& entry, const K& k) { return Compare()(entry.first, k); });
+    }
+
+    iterator find(const K& key) {
+        iterator it = lower_bound(key);
+        return it != entries_.end() && equal(it->first, key) ? it : entries_.end();
+    }
+    const_iterator find(const K& key) const {
+        const_iterator it = lower_bound(key);
+        return it != entries_.end() && equal(it->first, key) ? it : entries_.end();
+    }
+    bool contains(const K& key) const { return find(key) != entries_.end(); }
+    uint32_t count(const K& key) const { return contains(key) ? 1 : 0; }
+
+    V& at(const K& key) {
+        iterator it = find(key);
+        if (it == entries_.end()) throw std::out_of_range("carch::SortedFlatMap::at");
+        return it->second;
+    }
+    const V& at(const K& key) const {
+        const_iterator it = find(key);
+        if (it == entries_.end()) throw std::out_of_range("carch::SortedFlatMap::at");
+        return it->second;
+    }
+
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+    V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+        return emplace_key(key, std::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        return emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type value(std::forward<Args>(args)...);
+        return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& value) {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    uint32_t erase(const K& key) {
+        iterator it = find(key);
+        if (it == entries_.end()) {
+            return 0;
+        }
+        entries_.erase(it);
+        return 1;
+    }
+    iterator erase(const_iterator position) { return entries_.erase(position); }
+
+    void swap(SortedFlatMap& other) noexcept { entries_.swap(other.entries_); }
+
+    friend bool operator==(const SortedFlatMap& a, const SortedFlatMap& b) { return a.entries_ == b.entries_; }
+    friend bool operator!=(const SortedFlatMap& a, const SortedFlatMap& b) { return a.entries_ != b.entries_; }
+
+private:
+    std::vector<value_type> entries_;
+
+    static bool equal(const K& a, const K& b) { return !Compare()(a, b) && !Compare()(b, a); }
+
+    template <typename Key, typename... Args>
+    std::pair<iterator, bool> emplace_key(Key&& key, Args&&... args) {
+        iterator it = lower_bound(key);
+        if (it != entries_.end() && equal(it->first, key)) {
+            return {it, false};
+        }
+        it = entries_.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        return {it, true};
+    }
+};
+
+template <typename K, typename V, typename Compare>
+void swap(SortedFlatMap<K, V, Compare>& a, SortedFlatMap<K, V, Compare>& b) noexcept {
+    a.swap(b);
+}
+
+} // namespace carch
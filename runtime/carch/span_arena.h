@@ -0,0 +1,224 @@
+// Carch runtime: pooled storage for variable-length fields
+// Ships with code generated by the Carch IDL compiler for @pooled array fields
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace carch {
+
+// A @pooled array<T> field: a range of a SpanArena<T>. It owns nothing, so a
+// component made of spans and plain values is trivially copyable, and
+// copying it shares the elements rather than copying them.
+template <typename T>
+struct PoolSpan {
+    using value_type = T;
+
+    uint32_t offset = 0;
+    uint32_t length = 0;
+
+    constexpr bool empty() const noexcept { return length == 0; }
+
+    friend constexpr bool operator==(PoolSpan a, PoolSpan b) noexcept {
+        return a.offset == b.offset && a.length == b.length;
+    }
+    friend constexpr bool operator!=(PoolSpan a, PoolSpan b) noexcept { return !(a == b); }
+};
+
+// Pointer and length of the elements a span names; valid until the arena
+// next allocates, grows or compacts
+template <typename T>
+class SpanRef {
+public:
+    constexpr SpanRef() noexcept = default;
+    constexpr SpanRef(T* data, size_t size) noexcept : data_(data), size_(size) {}
+
+    constexpr T* data() const noexcept { return data_; }
+    constexpr size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T* begin() const noexcept { return data_; }
+    constexpr T* end() const noexcept { return data_ + size_; }
+    constexpr T& operator[](size_t index) const noexcept { return data_[index]; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// One growing buffer holding the elements of every span of one field.
+// Spans are appended at the end; a span at the end grows and shrinks in
+// place, any other span that grows moves to the end. Released and moved
+// ranges stay in the buffer as garbage until compact() copies the live
+// spans into a fresh buffer, so the buffer never has holes to search.
+//
+// Elements must be trivially copyable: the buffer is moved with memcpy and
+// can be saved and restored with data()/size() and load().
+template <typename T>
+class SpanArena {
+    static_assert(std::is_trivially_copyable_v<T>, "SpanArena: @pooled elements must be trivially copyable");
+
+public:
+    using value_type = T;
+    using span_type = PoolSpan<T>;
+
+    SpanArena() = default;
+
+    // New span of count value-initialized elements
+    span_type allocate(size_t count) {
+        span_type span{offset_at_end(count), static_cast<uint32_t>(count)};
+        buffer_.resize(buffer_.size() + count);
+        return span;
+    }
+
+    span_type assign(const T* data, size_t count) {
+        span_type span{offset_at_end(count), static_cast<uint32_t>(count)};
+        buffer_.insert(buffer_.end(), data, data + count);
+        return span;
+    }
+    span_type assign(std::initializer_list<T> values) { return assign(values.begin(), values.size()); }
+
+    // Replaces span's elements, in place if they fit
+    void assign(span_type& span, const T* data, size_t count) {
+        if (count <= span.length) {
+            std::memmove(buffer_.data() + span.offset, data, count * sizeof(T));
+            shrink(span, count);
+        } else {
+            release(span);
+            span = assign(data, count);
+        }
+    }
+
+    // Copy of span's elements in a new span
+    span_type clone(span_type span) {
+        span_type copy = allocate(span.length);
+        std::memcpy(buffer_.data() + copy.offset, buffer_.data() + span.offset, span.length * sizeof(T));
+        return copy;
+    }
+
+    void resize(span_type& span, size_t count) {
+        if (count <= span.length) {
+            shrink(span, count);
+        } else if (at_end(span)) {
+            buffer_.resize(buffer_.size() + (count - span.length));
+            span.length = static_cast<uint32_t>(count);
+        } else {
+            span_type moved = allocate(count);
+            std::memcpy(buffer_.data() + moved.offset, buffer_.data() + span.offset, span.length * sizeof(T));
+            release(span);
+            span = moved;
+        }
+    }
+
+    void push_back(span_type& span, T value) {
+        resize(span, span.length + size_t(1));
+        buffer_[span.offset + span.length - 1] = value;
+    }
+
+    // Returns span's elements to the arena and empties it
+    void release(span_type& span) noexcept {
+        if (at_end(span)) {
+            truncate(span.offset);
+        } else {
+            discard(span.length);
+        }
+        span = span_type();
+    }
+
+    // Counts count elements as garbage without touching the buffer, for
+    // owners that know a range is dead but not whether a span still ends it
+    void discard(size_t count) noexcept { garbage_ = std::min(garbage_ + count, buffer_.size()); }
+
+    SpanRef<T> view(span_type span) noexcept { return {buffer_.data() + span.offset, span.length}; }
+    SpanRef<const T> view(span_type span) const noexcept { return {buffer_.data() + span.offset, span.length}; }
+    SpanRef<T> operator[](span_type span) noexcept { return view(span); }
+    SpanRef<const T> operator[](span_type span) const noexcept { return view(span); }
+
+    // Elements in the buffer, live or garbage, and the garbage among them
+    size_t size() const noexcept { return buffer_.size(); }
+    size_t garbage() const noexcept { return garbage_; }
+    size_t capacity() const noexcept { return buffer_.capacity(); }
+    void reserve(size_t count) { buffer_.reserve(count); }
+
+    // The whole buffer, for snapshots: spans stay valid against a buffer
+    // restored with load()
+    T* data() noexcept { return buffer_.data(); }
+    const T* data() const noexcept { return buffer_.data(); }
+    void load(const T* data, size_t count) {
+        buffer_.assign(data, data + count);
+        garbage_ = 0;
+    }
+
+    void clear() noexcept {
+        buffer_.clear();
+        garbage_ = 0;
+    }
+
+    // Copies the live spans into a fresh buffer in the order they are
+    // visited, dropping the garbage. for_each_span(keep) must call keep(span)
+    // on every live span, which updates it; spans it misses are lost.
+    template <typename ForEachSpan>
+    void compact(ForEachSpan&& for_each_span) {
+        begin_compaction();
+        for_each_span([this](span_type& span) { span = keep(span); });
+        end_compaction();
+    }
+
+    // compact() in steps, for owners that visit several arenas in one pass
+    void begin_compaction() {
+        compacted_.clear();
+        compacted_.reserve(buffer_.size() - std::min(garbage_, buffer_.size()));
+    }
+    span_type keep(span_type span) {
+        span_type kept{static_cast<uint32_t>(compacted_.size()), span.length};
+        compacted_.insert(compacted_.end(), buffer_.begin() + span.offset,
+                          buffer_.begin() + span.offset + span.length);
+        return kept;
+    }
+    void end_compaction() noexcept {
+        buffer_.swap(compacted_);
+        compacted_.clear();
+        compacted_.shrink_to_fit();
+        garbage_ = 0;
+    }
+
+private:
+    std::vector<T> buffer_;
+    std::vector<T> compacted_;
+    size_t garbage_ = 0;
+
+    bool at_end(span_type span) const noexcept { return size_t(span.offset) + span.length == buffer_.size(); }
+
+    uint32_t offset_at_end(size_t count) const {
+        if (count > UINT32_MAX - buffer_.size()) {
+            throw std::length_error("SpanArena: more than 2^32 elements");
+        }
+        return static_cast<uint32_t>(buffer_.size());
+    }
+
+    void truncate(size_t size) noexcept {
+        buffer_.resize(size);
+        garbage_ = std::min(garbage_, size);
+    }
+
+    void shrink(span_type& span, size_t count) noexcept {
+        if (at_end(span)) {
+            truncate(span.offset + count);
+        } else {
+            discard(span.length - count);
+        }
+        span.length = static_cast<uint32_t>(count);
+    }
+};
+
+// The arena of a generated PoolSpan<T> field: SpanArenaOf<decltype(Type::field)>
+template <typename Span>
+using SpanArenaOf = SpanArena<typename Span::value_type>;
+
+} // namespace carch
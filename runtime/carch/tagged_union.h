@@ -0,0 +1,20 @@
+// Carch runtime: helpers for tagged unions
+// Ships with code generated by the Carch IDL compiler for variants with the tagged backend
+
+#pragma once
+
+namespace carch {
+
+// Combines lambdas into one visitor, so a tagged union can be matched with
+// one handler per alternative:
+//
+//     shape.match([](const Shape_Circle& c) { ... }, [](const Shape_Rect& r) { ... });
+template <typename... Handlers>
+struct Overloaded : Handlers... {
+    using Handlers::operator()...;
+};
+
+template <typename... Handlers>
+Overloaded(Handlers...) -> Overloaded<Handlers...>;
+
+} // namespace carch
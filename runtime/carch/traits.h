@@ -0,0 +1,68 @@
+// Carch runtime: copy and relocation traits
+// Ships with code generated by the Carch IDL compiler; the runtime containers use it for memcpy paths
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace carch {
+
+namespace detail {
+
+// The generator declares carch_trivially_relocatable(const T*) and
+// carch_pod_wire_safe(const T*) next to the types for which they hold,
+// found by argument-dependent lookup
+template <typename T, typename = void>
+struct declared_relocatable : std::false_type {};
+
+template <typename T>
+struct declared_relocatable<T, std::void_t<decltype(carch_trivially_relocatable(static_cast<const T*>(nullptr)))>>
+    : std::bool_constant<carch_trivially_relocatable(static_cast<const T*>(nullptr))> {};
+
+template <typename T, typename = void>
+struct declared_wire_safe : std::false_type {};
+
+template <typename T>
+struct declared_wire_safe<T, std::void_t<decltype(carch_pod_wire_safe(static_cast<const T*>(nullptr)))>>
+    : std::bool_constant<carch_pod_wire_safe(static_cast<const T*>(nullptr))> {};
+
+} // namespace detail
+
+// A value can move to another address by copying its bytes, without running
+// its move constructor and destructor: trivially copyable types, and
+// generated types whose members own heap memory only through pointers that
+// do not point back into the value (std::vector, SmallArray, FlatHashMap)
+template <typename T>
+struct is_trivially_relocatable
+    : std::bool_constant<std::is_trivially_copyable_v<T> || detail::declared_relocatable<T>::value> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+// A value's bytes are all of it: trivially copyable, and holding no handle
+// into process-local state (istr) or other storage (@pooled spans), so
+// bytes written to a file or socket read back as the same value on the
+// same ABI
+template <typename T>
+struct is_pod_wire_safe
+    : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T> || detail::declared_wire_safe<T>::value> {};
+
+template <typename T>
+inline constexpr bool is_pod_wire_safe_v = is_pod_wire_safe<T>::value;
+
+// Moves count values from source to uninitialized, non-overlapping storage
+// at destination and ends the sources' lifetimes
+template <typename T>
+void relocate_n(T* source, size_t count, T* destination) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        std::memcpy(static_cast<void*>(destination), static_cast<const void*>(source), count * sizeof(T));
+    } else {
+        std::uninitialized_move_n(source, count, destination);
+        std::destroy_n(source, count);
+    }
+}
+
+} // namespace carch
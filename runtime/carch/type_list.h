@@ -0,0 +1,33 @@
+// Carch runtime: compile-time helpers over type lists
+// Used by the runtime headers that are parameterized on a list of generated types
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+namespace carch {
+
+namespace detail {
+
+// Position of the first T in Ts...
+template <typename T, typename... Ts>
+struct type_index;
+
+template <typename T, typename... Ts>
+struct type_index<T, T, Ts...> : std::integral_constant<uint32_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct type_index<T, U, Ts...> : std::integral_constant<uint32_t, 1 + type_index<T, Ts...>::value> {};
+
+template <typename T>
+struct type_index<T> {
+    static_assert(sizeof(T) == 0, "Type is not in the type list");
+};
+
+template <typename T, typename... Ts>
+inline constexpr bool contains_type = (std::is_same_v<T, Ts> || ...);
+
+} // namespace detail
+
+} // namespace carch
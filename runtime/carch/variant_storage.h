@@ -0,0 +1,323 @@
+// Carch runtime: per-alternative storage for variants
+// Ships with code generated by the Carch IDL compiler for @partitioned variants
+
+#pragma once
+
+#include "carch/type_list.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace carch {
+
+// Names a value in a VariantStorage: the alternative in the high 8 bits and
+// a slot of that alternative in the low 24. Default-constructed handles are
+// null.
+class VariantHandle {
+public:
+    static constexpr uint32_t slot_bits = 24;
+    static constexpr uint32_t slot_mask = (uint32_t(1) << slot_bits) - 1;
+    // Slots available per alternative; the largest is reserved for null
+    static constexpr uint32_t max_slots = slot_mask;
+    static constexpr uint32_t max_alternatives = (UINT32_MAX >> slot_bits);
+
+    constexpr VariantHandle() noexcept = default;
+    constexpr VariantHandle(uint32_t alternative, uint32_t slot) noexcept
+        : bits_((alternative << slot_bits) | (slot & slot_mask)) {}
+
+    static constexpr VariantHandle null() noexcept { return VariantHandle(); }
+
+    constexpr uint32_t alternative() const noexcept { return bits_ >> slot_bits; }
+    constexpr uint32_t slot() const noexcept { return bits_ & slot_mask; }
+    constexpr uint32_t bits() const noexcept { return bits_; }
+
+    constexpr bool is_null() const noexcept { return bits_ == UINT32_MAX; }
+    constexpr explicit operator bool() const noexcept { return !is_null(); }
+
+    friend constexpr bool operator==(VariantHandle a, VariantHandle b) noexcept { return a.bits_ == b.bits_; }
+    friend constexpr bool operator!=(VariantHandle a, VariantHandle b) noexcept { return a.bits_ != b.bits_; }
+
+private:
+    uint32_t bits_ = UINT32_MAX;
+};
+
+namespace detail {
+
+// Tagged variants expose tag(); std::variant exposes index()
+template <typename V, typename = void>
+struct is_tagged_variant : std::false_type {};
+
+template <typename V>
+struct is_tagged_variant<V, std::void_t<decltype(std::declval<const V&>().tag())>> : std::true_type {};
+
+} // namespace detail
+
+// Stores the values of a variant split by alternative: each alternative has
+// its own dense array, so a system can process every circle, then every box,
+// without a branch per element and with the stride of the alternative rather
+// than of the largest one. Values are addressed by a 32-bit VariantHandle
+// through a per-alternative slot table, and removal swaps the last value of
+// the alternative into the hole, keeping the arrays dense.
+//
+// Alternatives... are the variant's alternatives in declaration order.
+// insert() takes either an alternative or the variant itself (a
+// std::variant, or a tagged variant with tag() and get<T>()). Type-based
+// accessors name an alternative by its type, so where several unit
+// alternatives share std::monostate they refer to the first; use the
+// index-based ones to tell them apart.
+//
+// A removed handle's slot is reused by later inserts of the same
+// alternative, so handles must not outlive their values.
+template <typename... Alternatives>
+class VariantStorage {
+    static_assert(sizeof...(Alternatives) > 0, "VariantStorage needs at least one alternative");
+    static_assert(sizeof...(Alternatives) < VariantHandle::max_alternatives,
+                  "VariantStorage: too many alternatives for VariantHandle");
+
+public:
+    using handle = VariantHandle;
+    static constexpr uint32_t alternative_count = sizeof...(Alternatives);
+
+    template <uint32_t I>
+    using alternative_type = std::tuple_element_t<I, std::tuple<Alternatives...>>;
+    template <typename T>
+    static constexpr uint32_t index_of = detail::type_index<T, Alternatives...>::value;
+
+    VariantStorage() = default;
+
+    // Stores an alternative, or the active alternative of a variant; a
+    // valueless std::variant gives a null handle
+    template <typename T>
+    handle insert(T value) {
+        if constexpr (detail::contains_type<T, Alternatives...>) {
+            return emplace<index_of<T>>(std::move(value));
+        } else {
+            uint32_t index;
+            if constexpr (detail::is_tagged_variant<T>::value) {
+                index = static_cast<uint32_t>(value.tag());
+            } else {
+                index = static_cast<uint32_t>(value.index());
+            }
+            handle result;
+            insert_variant(index, value, result, std::index_sequence_for<Alternatives...>{});
+            return result;
+        }
+    }
+
+    template <uint32_t I, typename... Args>
+    handle emplace(Args&&... args) {
+        Column<I>& column = std::get<I>(columns_);
+        uint32_t slot;
+        if (column.free_head != no_slot) {
+            slot = column.free_head;
+            column.free_head = column.positions[slot] & ~free_bit;
+        } else {
+            if (column.positions.size() >= handle::max_slots) {
+                throw std::length_error("VariantStorage: out of slots");
+            }
+            slot = static_cast<uint32_t>(column.positions.size());
+            column.positions.push_back(0);
+        }
+        column.positions[slot] = static_cast<uint32_t>(column.values.size());
+        column.values.emplace_back(std::forward<Args>(args)...);
+        column.slots.push_back(slot);
+        return handle(I, slot);
+    }
+
+    bool contains(handle h) const noexcept {
+        return h.alternative() < alternative_count && position_of(h) != npos;
+    }
+
+    template <typename T>
+    T* get(handle h) noexcept {
+        return get<index_of<T>>(h);
+    }
+    template <typename T>
+    const T* get(handle h) const noexcept {
+        return get<index_of<T>>(h);
+    }
+    template <uint32_t I>
+    alternative_type<I>* get(handle h) noexcept {
+        uint32_t position = h.alternative() == I ? position_of(h) : npos;
+        return position != npos ? &std::get<I>(columns_).values[position] : nullptr;
+    }
+    template <uint32_t I>
+    const alternative_type<I>* get(handle h) const noexcept {
+        uint32_t position = h.alternative() == I ? position_of(h) : npos;
+        return position != npos ? &std::get<I>(columns_).values[position] : nullptr;
+    }
+
+    // Calls f on the value h names, dispatching through a table rather than a
+    // chain of branches; h must be contained
+    template <typename F>
+    decltype(auto) visit(handle h, F&& f) {
+        using Result = std::invoke_result_t<F&&, alternative_type<0>&>;
+        return visit_table<Result, F>(std::index_sequence_for<Alternatives...>{})[h.alternative()](
+            *this, position_of(h), f);
+    }
+
+    bool remove(handle h) {
+        if (!contains(h)) {
+            return false;
+        }
+        remove_at(h, std::index_sequence_for<Alternatives...>{});
+        return true;
+    }
+
+    // Values of all alternatives
+    size_t size() const noexcept {
+        return size_all(std::index_sequence_for<Alternatives...>{});
+    }
+    bool empty() const noexcept { return size() == 0; }
+
+    template <typename T>
+    size_t size() const noexcept {
+        return std::get<index_of<T>>(columns_).values.size();
+    }
+    template <typename T>
+    void reserve(size_t count) {
+        Column<index_of<T>>& column = std::get<index_of<T>>(columns_);
+        column.values.reserve(count);
+        column.slots.reserve(count);
+    }
+
+    // Dense array of one alternative, and the handle of each element
+    template <typename T>
+    T* data() noexcept {
+        return std::get<index_of<T>>(columns_).values.data();
+    }
+    template <typename T>
+    const T* data() const noexcept {
+        return std::get<index_of<T>>(columns_).values.data();
+    }
+    template <typename T>
+    handle handle_at(size_t position) const noexcept {
+        return handle(index_of<T>, std::get<index_of<T>>(columns_).slots[position]);
+    }
+
+    // Calls f(T&), or f(handle, T&), for every value of alternative T
+    template <typename T, typename F>
+    void each(F&& f) {
+        each_of<index_of<T>>(f);
+    }
+
+    // Visits every alternative in turn, all of its values before the next:
+    // f is called with each value, or with its handle and the value
+    template <typename F>
+    void each_alternative(F&& f) {
+        each_all(f, std::index_sequence_for<Alternatives...>{});
+    }
+
+    void clear() noexcept {
+        clear_all(std::index_sequence_for<Alternatives...>{});
+    }
+
+private:
+    static constexpr uint32_t npos = UINT32_MAX;
+    // Marks a free slot; the rest of its entry is the next free slot
+    static constexpr uint32_t free_bit = uint32_t(1) << 31;
+    static constexpr uint32_t no_slot = handle::max_slots;
+
+    template <typename T>
+    struct Slots {
+        std::vector<T> values;              // Dense
+        std::vector<uint32_t> slots;        // Slot of each value
+        std::vector<uint32_t> positions;    // Value position of each slot, or free_bit | next free slot
+        uint32_t free_head = no_slot;
+    };
+    template <uint32_t I>
+    using Column = Slots<alternative_type<I>>;
+
+    std::tuple<Slots<Alternatives>...> columns_;
+
+    uint32_t position_of(handle h) const noexcept {
+        uint32_t position = npos;
+        position_of(h, position, std::index_sequence_for<Alternatives...>{});
+        return position;
+    }
+    template <size_t... Is>
+    void position_of(handle h, uint32_t& position, std::index_sequence<Is...>) const noexcept {
+        (void)((h.alternative() == Is && (position = position_in<Is>(h.slot()), true)) || ...);
+    }
+    template <size_t I>
+    uint32_t position_in(uint32_t slot) const noexcept {
+        const auto& positions = std::get<I>(columns_).positions;
+        return slot < positions.size() && (positions[slot] & free_bit) == 0 ? positions[slot] : npos;
+    }
+
+    template <typename V, size_t... Is>
+    void insert_variant(uint32_t index, V& value, handle& result, std::index_sequence<Is...>) {
+        (void)((index == Is && (result = emplace<Is>(std::move(alternative<Is>(value))), true)) || ...);
+    }
+    template <size_t I, typename V>
+    static auto& alternative(V& value) {
+        if constexpr (detail::is_tagged_variant<V>::value) {
+            return value.template get<alternative_type<I>>();
+        } else {
+            return std::get<I>(value);
+        }
+    }
+
+    template <typename Result, typename F, size_t... Is>
+    static auto visit_table(std::index_sequence<Is...>) {
+        using Fn = Result (*)(VariantStorage&, uint32_t, F&);
+        static constexpr Fn table[] = {&visit_at<Result, F, Is>...};
+        return table;
+    }
+    template <typename Result, typename F, size_t I>
+    static Result visit_at(VariantStorage& self, uint32_t position, F& f) {
+        return f(std::get<I>(self.columns_).values[position]);
+    }
+
+    template <size_t... Is>
+    void remove_at(handle h, std::index_sequence<Is...>) {
+        (void)((h.alternative() == Is && (remove_from<Is>(h.slot()), true)) || ...);
+    }
+    template <size_t I>
+    void remove_from(uint32_t slot) {
+        Column<I>& column = std::get<I>(columns_);
+        uint32_t position = column.positions[slot];
+        uint32_t last = static_cast<uint32_t>(column.values.size() - 1);
+        if (position != last) {
+            column.values[position] = std::move(column.values[last]);
+            column.slots[position] = column.slots[last];
+            column.positions[column.slots[position]] = position;
+        }
+        column.values.pop_back();
+        column.slots.pop_back();
+        column.positions[slot] = free_bit | column.free_head;
+        column.free_head = slot;
+    }
+
+    template <size_t I, typename F>
+    void each_of(F& f) {
+        Column<I>& column = std::get<I>(columns_);
+        for (size_t i = 0; i < column.values.size(); ++i) {
+            if constexpr (std::is_invocable_v<F&, handle, alternative_type<I>&>) {
+                f(handle(I, column.slots[i]), column.values[i]);
+            } else {
+                f(column.values[i]);
+            }
+        }
+    }
+    template <typename F, size_t... Is>
+    void each_all(F& f, std::index_sequence<Is...>) {
+        (each_of<Is>(f), ...);
+    }
+
+    template <size_t... Is>
+    size_t size_all(std::index_sequence<Is...>) const noexcept {
+        return (std::get<Is>(columns_).values.size() + ...);
+    }
+    template <size_t... Is>
+    void clear_all(std::index_sequence<Is...>) noexcept {
+        ((std::get<Is>(columns_) = Column<Is>()), ...);
+    }
+};
+
+} // namespace carch
@@ -0,0 +1,299 @@
+// Carch runtime: small vectors and quaternions
+// Ships with code generated by the Carch IDL compiler for vec2, vec3, vec4, quat and ivec2..ivec4
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+namespace carch {
+
+// Lanes are stored in order with no gaps, so a Vec4 or Quat loads into one
+// SSE/NEON register and a Vec3 does too, its fourth lane being padding.
+// 3- and 4-lane types are 16-byte aligned; 2-lane types are 8-byte aligned,
+// since padding them to 16 would double their size. Every type is an
+// aggregate and trivially copyable: Vec3{1.0f, 2.0f, 3.0f}.
+
+template <typename T>
+struct alignas(8) Vec2T {
+    using value_type = T;
+    static constexpr uint32_t lanes = 2;
+
+    T x = 0;
+    T y = 0;
+
+    constexpr T& operator[](uint32_t i) noexcept { return i == 0 ? x : y; }
+    constexpr const T& operator[](uint32_t i) const noexcept { return i == 0 ? x : y; }
+};
+
+template <typename T>
+struct alignas(16) Vec3T {
+    using value_type = T;
+    static constexpr uint32_t lanes = 3;
+
+    T x = 0;
+    T y = 0;
+    T z = 0;
+
+    constexpr T& operator[](uint32_t i) noexcept { return i == 0 ? x : i == 1 ? y : z; }
+    constexpr const T& operator[](uint32_t i) const noexcept { return i == 0 ? x : i == 1 ? y : z; }
+};
+
+template <typename T>
+struct alignas(16) Vec4T {
+    using value_type = T;
+    static constexpr uint32_t lanes = 4;
+
+    T x = 0;
+    T y = 0;
+    T z = 0;
+    T w = 0;
+
+    constexpr T& operator[](uint32_t i) noexcept { return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+    constexpr const T& operator[](uint32_t i) const noexcept { return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+};
+
+// Rotation quaternion, x y z the vector part and w the scalar part.
+// Default-constructed to the identity rotation.
+struct alignas(16) Quat {
+    using value_type = float;
+    static constexpr uint32_t lanes = 4;
+
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 1.0f;
+
+    constexpr float& operator[](uint32_t i) noexcept { return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+    constexpr const float& operator[](uint32_t i) const noexcept { return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+
+    static constexpr Quat identity() noexcept { return Quat{}; }
+
+    // Rotation of angle radians about a unit-length axis
+    static Quat from_axis_angle(const Vec3T<float>& axis, float angle) noexcept {
+        float s = std::sin(angle * 0.5f);
+        return Quat{axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f)};
+    }
+};
+
+using Vec2 = Vec2T<float>;
+using Vec3 = Vec3T<float>;
+using Vec4 = Vec4T<float>;
+using IVec2 = Vec2T<int32_t>;
+using IVec3 = Vec3T<int32_t>;
+using IVec4 = Vec4T<int32_t>;
+
+// Lane count and lane type of the vector and quaternion types, so SoA and
+// serialization code can split them into their components
+template <typename T>
+struct vector_traits {
+    static constexpr bool is_vector = false;
+};
+
+template <typename T>
+struct vector_traits<Vec2T<T>> {
+    static constexpr bool is_vector = true;
+    using component_type = T;
+    static constexpr uint32_t lanes = 2;
+};
+
+template <typename T>
+struct vector_traits<Vec3T<T>> {
+    static constexpr bool is_vector = true;
+    using component_type = T;
+    static constexpr uint32_t lanes = 3;
+};
+
+template <typename T>
+struct vector_traits<Vec4T<T>> {
+    static constexpr bool is_vector = true;
+    using component_type = T;
+    static constexpr uint32_t lanes = 4;
+};
+
+template <>
+struct vector_traits<Quat> {
+    static constexpr bool is_vector = true;
+    using component_type = float;
+    static constexpr uint32_t lanes = 4;
+};
+
+template <typename T>
+inline constexpr bool is_vector_v = vector_traits<T>::is_vector;
+
+namespace detail {
+
+// Lane-wise arithmetic applies to vectors but not to quaternions
+template <typename V>
+using EnableVectorMath = std::enable_if_t<is_vector_v<V> && !std::is_same_v<V, Quat>, int>;
+
+template <typename V>
+size_t hash_lanes(const V& v) noexcept {
+    size_t seed = 0;
+    for (uint32_t i = 0; i < V::lanes; ++i) {
+        seed ^= std::hash<typename V::value_type>()(v[i]) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+} // namespace detail
+
+// Lane-wise arithmetic; each loop has a constant trip count and unrolls
+
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V& operator+=(V& a, const V& b) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] += b[i];
+    return a;
+}
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V& operator-=(V& a, const V& b) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] -= b[i];
+    return a;
+}
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V& operator*=(V& a, const V& b) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] *= b[i];
+    return a;
+}
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V& operator/=(V& a, const V& b) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] /= b[i];
+    return a;
+}
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V& operator*=(V& a, typename V::value_type s) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] *= s;
+    return a;
+}
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V& operator/=(V& a, typename V::value_type s) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] /= s;
+    return a;
+}
+
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator+(V a, const V& b) noexcept { return a += b; }
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator-(V a, const V& b) noexcept { return a -= b; }
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator*(V a, const V& b) noexcept { return a *= b; }
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator/(V a, const V& b) noexcept { return a /= b; }
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator*(V a, typename V::value_type s) noexcept { return a *= s; }
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator*(typename V::value_type s, V a) noexcept { return a *= s; }
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator/(V a, typename V::value_type s) noexcept { return a /= s; }
+
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V operator-(V a) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] = -a[i];
+    return a;
+}
+
+// Exact lane-wise comparison, for vectors and quaternions alike
+template <typename V, std::enable_if_t<is_vector_v<V>, int> = 0>
+constexpr bool operator==(const V& a, const V& b) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+template <typename V, std::enable_if_t<is_vector_v<V>, int> = 0>
+constexpr bool operator!=(const V& a, const V& b) noexcept { return !(a == b); }
+
+template <typename V, std::enable_if_t<is_vector_v<V>, int> = 0>
+constexpr typename V::value_type dot(const V& a, const V& b) noexcept {
+    typename V::value_type sum = 0;
+    for (uint32_t i = 0; i < V::lanes; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+template <typename T>
+constexpr Vec3T<T> cross(const Vec3T<T>& a, const Vec3T<T>& b) noexcept {
+    return Vec3T<T>{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+template <typename V, std::enable_if_t<is_vector_v<V>, int> = 0>
+constexpr typename V::value_type length_squared(const V& v) noexcept { return dot(v, v); }
+
+template <typename V, std::enable_if_t<is_vector_v<V> && std::is_floating_point_v<typename V::value_type>, int> = 0>
+typename V::value_type length(const V& v) noexcept { return std::sqrt(dot(v, v)); }
+
+// Unit-length copy; a zero vector is returned unchanged
+template <typename V, std::enable_if_t<is_vector_v<V> && std::is_floating_point_v<typename V::value_type>, int> = 0>
+V normalize(V v) noexcept {
+    typename V::value_type len = length(v);
+    if (len > 0) {
+        for (uint32_t i = 0; i < V::lanes; ++i) v[i] /= len;
+    }
+    return v;
+}
+
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V min(V a, const V& b) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] = b[i] < a[i] ? b[i] : a[i];
+    return a;
+}
+template <typename V, detail::EnableVectorMath<V> = 0>
+constexpr V max(V a, const V& b) noexcept {
+    for (uint32_t i = 0; i < V::lanes; ++i) a[i] = a[i] < b[i] ? b[i] : a[i];
+    return a;
+}
+
+template <typename V, std::enable_if_t<is_vector_v<V> && std::is_floating_point_v<typename V::value_type> &&
+                                           !std::is_same_v<V, Quat>, int> = 0>
+constexpr V lerp(const V& a, const V& b, typename V::value_type t) noexcept {
+    return a + (b - a) * t;
+}
+
+// Hamilton product: applying b, then a
+constexpr Quat operator*(const Quat& a, const Quat& b) noexcept {
+    return Quat{a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+constexpr Quat& operator*=(Quat& a, const Quat& b) noexcept { return a = a * b; }
+
+// Inverse of a unit quaternion
+constexpr Quat conjugate(const Quat& q) noexcept { return Quat{-q.x, -q.y, -q.z, q.w}; }
+
+// Rotates v by the unit quaternion q
+constexpr Vec3 rotate(const Quat& q, const Vec3& v) noexcept {
+    Vec3 u{q.x, q.y, q.z};
+    Vec3 t = cross(u, v) * 2.0f;
+    return v + t * q.w + cross(u, t);
+}
+
+} // namespace carch
+
+namespace std {
+
+// Lets vectors key map<K, V>, e.g. ivec2 grid cells
+template <typename T>
+struct hash<carch::Vec2T<T>> {
+    size_t operator()(const carch::Vec2T<T>& v) const noexcept {
+        return carch::detail::hash_lanes(v);
+    }
+};
+
+template <typename T>
+struct hash<carch::Vec3T<T>> {
+    size_t operator()(const carch::Vec3T<T>& v) const noexcept {
+        return carch::detail::hash_lanes(v);
+    }
+};
+
+template <typename T>
+struct hash<carch::Vec4T<T>> {
+    size_t operator()(const carch::Vec4T<T>& v) const noexcept {
+        return carch::detail::hash_lanes(v);
+    }
+};
+
+} // namespace std
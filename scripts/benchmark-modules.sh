@@ -0,0 +1,101 @@
+#!/bin/bash
+# Compare downstream build times of generated headers vs C++20 modules
+#
+# Usage: bash scripts/benchmark-modules.sh [carch-binary] [consumers-per-schema]
+#
+# For every example schema, generates both the header and the module
+# output, then builds N consumer translation units against each and reports
+# wall-clock times. Runs once per available compiler (g++, clang++).
+
+set -e
+
+CARCH=${1:-"build/carch"}
+CONSUMERS=${2:-20}
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+if [ ! -x "$CARCH" ]; then
+    echo "Carch compiler not found at $CARCH"
+    echo "Build it first: cmake -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build"
+    exit 1
+fi
+
+now_ms() {
+    date +%s%3N
+}
+
+# Compile the module interface and the consumers; prints elapsed ms
+build_modules() {
+    local compiler=$1 dir=$2 stem=$3
+    local start end
+    start=$(now_ms)
+    (
+        cd "$dir"
+        if [[ "$compiler" == clang* ]]; then
+            "$compiler" -std=c++20 --precompile "$stem.cppm" -o "game.$stem.pcm"
+            "$compiler" -std=c++20 -c "game.$stem.pcm" -o "$stem.o"
+            for i in $(seq 1 "$CONSUMERS"); do
+                "$compiler" -std=c++20 -fprebuilt-module-path=. -c "use_module_$i.cpp" -o "use_module_$i.o"
+            done
+        else
+            "$compiler" -std=c++20 -fmodules-ts -c -x c++ "$stem.cppm" -o "$stem.o"
+            for i in $(seq 1 "$CONSUMERS"); do
+                "$compiler" -std=c++20 -fmodules-ts -c "use_module_$i.cpp" -o "use_module_$i.o"
+            done
+        fi
+    ) > /dev/null 2>&1 || { echo "failed"; return; }
+    end=$(now_ms)
+    echo $((end - start))
+}
+
+# Compile the consumers against the textual header; prints elapsed ms
+build_headers() {
+    local compiler=$1 dir=$2
+    local start end
+    start=$(now_ms)
+    (
+        cd "$dir"
+        for i in $(seq 1 "$CONSUMERS"); do
+            "$compiler" -std=c++20 -I. -c "use_header_$i.cpp" -o "use_header_$i.o"
+        done
+    ) > /dev/null 2>&1 || { echo "failed"; return; }
+    end=$(now_ms)
+    echo $((end - start))
+}
+
+COMPILERS=()
+for compiler in g++ clang++; do
+    if command -v "$compiler" > /dev/null 2>&1; then
+        COMPILERS+=("$compiler")
+    fi
+done
+
+echo "=== Carch Header vs Module Build Benchmark ==="
+echo "Consumers per schema: $CONSUMERS"
+echo "Platform: $(uname -sm)"
+echo ""
+printf "%-12s %-24s %12s %12s\n" "Compiler" "Schema" "Header (ms)" "Module (ms)"
+
+for schema in examples/*.carch examples/real-world/*/*.carch; do
+    stem=$(basename "$schema" .carch)
+    out="$WORK_DIR/$stem"
+    mkdir -p "$out"
+
+    if ! "$CARCH" -o "$out" "$schema" > /dev/null 2>&1 ||
+       ! "$CARCH" --emit=module -o "$out" "$schema" > /dev/null 2>&1; then
+        printf "%-12s %-24s %12s %12s\n" "-" "$stem" "carch failed" ""
+        continue
+    fi
+
+    for i in $(seq 1 "$CONSUMERS"); do
+        printf '#include "%s.h"\nint consumer_%d() { return 0; }\n' "$stem" "$i" > "$out/use_header_$i.cpp"
+        printf 'import game.%s;\nint consumer_%d() { return 0; }\n' "$stem" "$i" > "$out/use_module_$i.cpp"
+    done
+
+    for compiler in "${COMPILERS[@]}"; do
+        header_ms=$(build_headers "$compiler" "$out")
+        module_ms=$(build_modules "$compiler" "$out" "$stem")
+        printf "%-12s %-24s %12s %12s\n" "$compiler" "$stem" "$header_ms" "$module_ms"
+        rm -rf "$out"/*.o "$out"/*.pcm "$out/gcm.cache"
+    done
+done
@@ -1,12 +1,20 @@
 #include "cpp_generator.h"
+#include "runtime_headers.h"
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 
 namespace carch {
 namespace codegen {
 
-CppGenerator::CppGenerator(parser::SchemaNode* schema, const GenerationOptions& options)
-    : schema_(schema), options_(options), current_indent_(0) {}
+CppGenerator::CppGenerator(parser::SchemaNode* schema, const GenerationOptions& options,
+                           const semantic::SchemaIR* ir)
+    : schema_(schema), options_(options), ir_(ir), current_indent_(0) {
+    if (!ir_) {
+        owned_ir_ = std::make_unique<semantic::SchemaIR>(semantic::build_schema_ir(*schema_));
+        ir_ = owned_ir_.get();
+    }
+}
 
 std::string CppGenerator::generate_header() {
     std::ostringstream oss;
@@ -17,57 +25,365 @@ std::string CppGenerator::generate_header() {
     oss << "#ifndef " << guard << "\n";
     oss << "#define " << guard << "\n\n";
     
+    // Generate the types first so the includes they need are known
+    std::string types = generate_types();
+    
     // Includes
     oss << generate_includes() << "\n";
     
     // Namespace open
     oss << generate_namespace_open() << "\n";
     
+    // Entity ID typedef, hoisted anonymous types and type definitions
+    oss << types;
+    
+    // Namespace close
+    oss << generate_namespace_close() << "\n";
+    
+    // Header guard close
+    oss << "#endif // " << guard << "\n";
+    
+    return oss.str();
+}
+
+std::string CppGenerator::generate_module() {
+    std::ostringstream oss;
+    
+    std::string types = generate_types();
+    
+    // Standard headers go in the global module fragment
+    oss << "module;\n\n";
+    oss << generate_includes() << "\n";
+    oss << "export module " << module_name() << ";\n\n";
+    
+    oss << generate_export_open() << "\n";
+    oss << types;
+    oss << generate_export_close() << "\n";
+    
+    return oss.str();
+}
+
+std::vector<GeneratedFile> CppGenerator::generate_split_modules() {
+    std::vector<GeneratedFile> files;
+    
+    // Shared declarations (entity_id) live in their own module so every
+    // definition module can import them without depending on each other
+    {
+        std::ostringstream oss;
+        oss << "module;\n\n";
+        oss << "// Generated by Carch IDL Compiler\n";
+        oss << "// Do not edit manually\n\n";
+        oss << "#include <cstdint>\n";
+        if (options_.use_strong_entity_id && has_component_pools()) {
+            oss << "#include \"carch/component_pool.h\"\n";
+        } else if (generational_entity_ids()) {
+            oss << "#include \"carch/entity.h\"\n";
+        }
+        oss << "\n";
+        oss << "export module " << module_name("base") << ";\n\n";
+        oss << generate_export_open() << "\n";
+        if (options_.use_strong_entity_id) {
+            oss << generate_entity_declarations();
+        }
+        oss << "\n" << generate_export_close() << "\n";
+        files.push_back({options_.output_basename + "/base.cppm", oss.str()});
+    }
+    
+    for (const auto& unit : generate_units()) {
+        files.push_back({unit_path(unit.name, ".cppm"), generate_unit_module(unit)});
+    }
+    
+    // Umbrella module re-exports every definition
+    std::string archetypes = generate_archetype_declarations();
+    std::ostringstream umbrella;
+    if (!archetypes.empty()) {
+        umbrella << "module;\n\n";
+    }
+    umbrella << "// Generated by Carch IDL Compiler\n";
+    umbrella << "// Do not edit manually\n\n";
+    if (!archetypes.empty()) {
+        umbrella << "#include <cstdint>\n";
+        umbrella << "#include \"carch/archetype.h\"\n\n";
+    }
+    umbrella << "export module " << module_name() << ";\n\n";
+    umbrella << "export import " << module_name("base") << ";\n";
+    for (auto& def : schema_->definitions) {
+        umbrella << "export import " << module_name(to_pascal_case(def->name)) << ";\n";
+    }
+    if (!archetypes.empty()) {
+        umbrella << "\n" << generate_export_open() << "\n" << archetypes << generate_export_close() << "\n";
+    }
+    files.push_back({options_.output_basename + ".cppm", umbrella.str()});
+    
+    return files;
+}
+
+std::string CppGenerator::generate_types() {
+    std::ostringstream oss;
+    
+    reset_generation_state(false);
+    
+    // Generate each definition after the anonymous types it hoisted, so
+    // hoisted types only ever name definitions that precede them
+    std::ostringstream defs;
+    for (auto& def : schema_->definitions) {
+        hoisted_types_.str("");
+        hoisted_types_.clear();
+        std::string def_str = generate_type_definition(def.get());
+        if (!hoisted_types_.str().empty()) {
+            defs << hoisted_types_.str() << "\n";
+        }
+        defs << def_str << "\n";
+    }
+    defs << generate_layout_checks();
+    defs << generate_archetype_declarations();
+    
     // Entity ID typedef (if using strong entity ID)
+    std::string entity_declarations;
     if (options_.use_strong_entity_id && !options_.namespace_name.empty()) {
-        oss << indent() << "using entity_id = " << options_.entity_id_typedef << ";\n\n";
+        entity_declarations = generate_entity_declarations();
+    }
+    if (!entity_declarations.empty()) {
+        oss << entity_declarations << "\n";
     }
     
-    // First pass: generate all type definitions to populate hoisted types
-    std::vector<std::string> type_defs;
+    oss << defs.str();
+    
+    return oss.str();
+}
+
+std::vector<CppGenerator::GeneratedUnit> CppGenerator::generate_units() {
+    reset_generation_state(true);
+    
+    std::vector<GeneratedUnit> units;
     for (auto& def : schema_->definitions) {
-        type_defs.push_back(generate_type_definition(def.get()));
+        // Hoisted types are emitted next to the definition that produced them,
+        // and only the standard headers this definition needs are included
+        hoisted_types_.str("");
+        hoisted_types_.clear();
+        generated_includes_.clear();
+        used_shapes_.clear();
+        layout_checks_.clear();
+        std::string body = generate_type_definition(def.get());
+        
+        GeneratedUnit unit;
+        unit.name = to_pascal_case(def->name);
+        unit.text = hoisted_types_.str().empty() ? body : hoisted_types_.str() + "\n" + body;
+        unit.text += generate_layout_checks();
+        unit.includes = generated_includes_;
+        unit.dependencies = used_shapes_;
+        
+        // Only the definitions this type actually names are dependencies
+        semantic::DefinitionId id = ir_->find_definition(def->name);
+        if (id != semantic::INVALID_ID) {
+            for (semantic::DefinitionId dep : ir_->definitions[id].dependencies) {
+                unit.dependencies.insert(to_pascal_case(ir_->definitions[dep].name));
+            }
+        }
+        
+        units.push_back(std::move(unit));
+    }
+    
+    // Anonymous shapes shared between definitions get a unit of their own
+    for (auto& shape : shape_units_) {
+        units.push_back(shape);
+    }
+    
+    return units;
+}
+
+std::string CppGenerator::generate_source() {
+    // For now, implementations are inline in header
+    // Future: generate .cpp file for complex methods
+    return "";
+}
+
+std::string CppGenerator::generate_forward_header() {
+    std::ostringstream oss;
+    
+    std::string guard = generate_header_guard_name("fwd");
+    oss << "#pragma once\n";
+    oss << "#ifndef " << guard << "\n";
+    oss << "#define " << guard << "\n\n";
+    
+    oss << "// Generated by Carch IDL Compiler\n";
+    oss << "// Do not edit manually\n\n";
+    
+    bool has_variants = false;
+    bool has_flags = false;
+    for (const auto& def : ir_->definitions) {
+        has_flags = has_flags || ir_->type(def.type).kind == semantic::TypeKind::FLAGS;
+        if (ir_->type(def.type).kind == semantic::TypeKind::VARIANT &&
+            variant_backend_of(def.type) != semantic::VariantBackend::TAGGED) {
+            has_variants = true;
+        }
+    }
+    if (has_flags) {
+        oss << "#include \"carch/enum_containers.h\"\n";
+    }
+    if (options_.use_strong_entity_id && has_component_pools()) {
+        oss << "#include \"carch/component_pool.h\"\n";
     }
+    if (generational_entity_ids()) {
+        oss << "#include \"carch/entity.h\"\n";
+    }
+    oss << "#include <cstdint>\n";
+    if (has_variants) {
+        oss << "#include <variant>\n";
+    }
+    oss << "\n";
+    
+    oss << generate_namespace_open() << "\n";
     
-    // Generate hoisted anonymous types
-    if (!hoisted_types_.str().empty()) {
-        oss << hoisted_types_.str() << "\n";
+    std::string entity_declarations;
+    if (options_.use_strong_entity_id && !options_.namespace_name.empty()) {
+        entity_declarations = generate_entity_declarations();
+    }
+    if (!entity_declarations.empty()) {
+        oss << entity_declarations << "\n";
     }
     
-    // Output the type definitions
-    for (const auto& def_str : type_defs) {
-        oss << def_str << "\n";
+    for (const auto& def : ir_->definitions) {
+        std::string type_name = to_pascal_case(def.name);
+        const semantic::Type& type = ir_->type(def.type);
+        const semantic::Field* alternatives = ir_->fields_of(def.type);
+        if (type.kind == semantic::TypeKind::STRUCT) {
+            oss << indent() << "struct " << type_name << ";\n";
+        } else if (type.kind == semantic::TypeKind::ENUM) {
+            oss << indent() << "enum class " << type_name << " : "
+                << unsigned_type(semantic::enum_storage_size(type.count)) << ";\n";
+        } else if (type.kind == semantic::TypeKind::FLAGS) {
+            oss << indent() << "enum class " << type_name << "_Flag : "
+                << unsigned_type(semantic::enum_storage_size(type.count)) << ";\n";
+            oss << indent() << "using " << type_name << " = carch::EnumSet<" << type_name << "_Flag, " << type.count
+                << ">;\n";
+        } else if (type.kind == semantic::TypeKind::VARIANT &&
+                   variant_backend_of(def.type) == semantic::VariantBackend::TAGGED) {
+            oss << indent() << "class " << type_name << ";\n";
+        } else if (type.kind == semantic::TypeKind::VARIANT) {
+            // Alternatives only need to be declared for the alias to name them
+            for (uint32_t i = 0; i < type.count; ++i) {
+                if (alternatives[i].type != semantic::INVALID_ID) {
+                    oss << indent() << "struct " << type_name << "_" << to_pascal_case(alternatives[i].name) << ";\n";
+                }
+            }
+            oss << indent() << "using " << type_name << " = std::variant<";
+            for (uint32_t i = 0; i < type.count; ++i) {
+                if (alternatives[i].type != semantic::INVALID_ID) {
+                    oss << type_name << "_" << to_pascal_case(alternatives[i].name);
+                } else {
+                    oss << "std::monostate";
+                }
+                if (i < type.count - 1) {
+                    oss << ", ";
+                }
+            }
+            oss << ">;\n";
+        }
     }
     
-    // Namespace close
+    oss << "\n" << generate_namespace_close() << "\n";
+    oss << "#endif // " << guard << "\n";
+    
+    return oss.str();
+}
+
+std::vector<GeneratedFile> CppGenerator::generate_split_headers() {
+    std::vector<GeneratedFile> files;
+    
+    files.push_back({forward_header_path(), generate_forward_header()});
+    
+    for (const auto& unit : generate_units()) {
+        files.push_back({unit_path(unit.name, ".h"), generate_unit_header(unit)});
+    }
+    
+    files.push_back({options_.output_basename + ".h", generate_umbrella_header()});
+    
+    return files;
+}
+
+std::string CppGenerator::generate_unit_header(const GeneratedUnit& unit) {
+    std::ostringstream oss;
+    
+    std::string guard = generate_header_guard_name(unit.name);
+    oss << "#pragma once\n";
+    oss << "#ifndef " << guard << "\n";
+    oss << "#define " << guard << "\n\n";
+    
+    generated_includes_ = unit.includes;
+    oss << generate_includes();
+    oss << "#include \"" << forward_header_path() << "\"\n";
+    for (const auto& dep : unit.dependencies) {
+        oss << "#include \"" << unit_path(dep, ".h") << "\"\n";
+    }
+    oss << "\n";
+    
+    oss << generate_namespace_open() << "\n";
+    oss << unit.text << "\n";
     oss << generate_namespace_close() << "\n";
     
-    // Header guard close
     oss << "#endif // " << guard << "\n";
     
     return oss.str();
 }
 
-std::string CppGenerator::generate_source() {
-    // For now, implementations are inline in header
-    // Future: generate .cpp file for complex methods
-    return "";
+std::string CppGenerator::generate_unit_module(const GeneratedUnit& unit) {
+    std::ostringstream oss;
+    
+    generated_includes_ = unit.includes;
+    oss << "module;\n\n";
+    oss << generate_includes() << "\n";
+    oss << "export module " << module_name(unit.name) << ";\n\n";
+    
+    // Re-export dependencies so consumers can name the field types
+    oss << "export import " << module_name("base") << ";\n";
+    for (const auto& dep : unit.dependencies) {
+        oss << "export import " << module_name(dep) << ";\n";
+    }
+    oss << "\n";
+    
+    oss << generate_export_open() << "\n";
+    oss << unit.text << "\n";
+    oss << generate_export_close() << "\n";
+    
+    return oss.str();
 }
 
-std::string CppGenerator::generate_includes() {
-    // Determine required includes based on types used
-    add_include("<cstdint>");
-    add_include("<string>");
-    add_include("<variant>");
-    add_include("<optional>");
-    add_include("<vector>");
-    add_include("<unordered_map>");
+std::string CppGenerator::generate_umbrella_header() {
+    std::ostringstream oss;
+    
+    std::string guard = generate_header_guard_name();
+    oss << "#pragma once\n";
+    oss << "#ifndef " << guard << "\n";
+    oss << "#define " << guard << "\n\n";
+    
+    oss << "// Generated by Carch IDL Compiler\n";
+    oss << "// Do not edit manually\n\n";
+    
+    std::string archetypes = generate_archetype_declarations();
+    if (!archetypes.empty()) {
+        oss << "#include \"carch/archetype.h\"\n";
+    }
+    oss << "#include \"" << forward_header_path() << "\"\n";
+    for (auto& def : schema_->definitions) {
+        oss << "#include \"" << definition_header_path(def.get()) << "\"\n";
+    }
+    oss << "\n";
+    
+    // The world names every component, so it is declared once all are
+    if (!archetypes.empty()) {
+        oss << generate_namespace_open() << "\n";
+        oss << archetypes;
+        oss << generate_namespace_close() << "\n";
+    }
+    
+    oss << "#endif // " << guard << "\n";
     
+    return oss.str();
+}
+
+std::string CppGenerator::generate_includes() {
+    // Includes are recorded by the map_* methods as types are generated
     std::ostringstream oss;
     oss << "// Generated by Carch IDL Compiler\n";
     oss << "// Do not edit manually\n\n";
@@ -93,11 +409,29 @@ std::string CppGenerator::generate_namespace_close() {
     return "} // namespace " + options_.namespace_name + "\n";
 }
 
+std::string CppGenerator::generate_export_open() {
+    if (options_.namespace_name.empty()) {
+        return "export {\n";
+    }
+    return "export namespace " + options_.namespace_name + " {\n";
+}
+
+std::string CppGenerator::generate_export_close() {
+    if (options_.namespace_name.empty()) {
+        return "} // export\n";
+    }
+    return "} // namespace " + options_.namespace_name + "\n";
+}
+
 std::string CppGenerator::generate_type_definition(parser::TypeDefinitionNode* def) {
     if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(def->type.get())) {
-        return generate_struct(def->name, struct_type);
+        // The side table follows the struct, in output and in layout checks
+        std::string code = generate_struct(def->name, struct_type);
+        code += generate_cold_fields(def, struct_type);
+        return code + generate_ref_visitor(def) + generate_span_visitor(def) + generate_double_buffer(def);
     } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(def->type.get())) {
-        return generate_variant(def->name, variant_type);
+        return generate_variant(def->name, variant_type) + generate_variant_storage(def, variant_type) +
+               generate_ref_visitor(def) + generate_span_visitor(def) + generate_double_buffer(def);
     } else if (auto* enum_type = dynamic_cast<parser::EnumTypeNode*>(def->type.get())) {
         return generate_enum(def->name, enum_type);
     }
@@ -105,18 +439,43 @@ std::string CppGenerator::generate_type_definition(parser::TypeDefinitionNode* d
 }
 
 std::string CppGenerator::generate_struct(const std::string& name, parser::StructTypeNode* node) {
+    return generate_named_struct(to_pascal_case(name), node);
+}
+
+std::string CppGenerator::generate_named_struct(const std::string& type_name, parser::StructTypeNode* node) {
     std::ostringstream oss;
+    semantic::TypeId type_id = ir_->type_of(node);
+    semantic::LayoutAttributes attributes;
+    if (type_id != semantic::INVALID_ID) {
+        attributes = ir_->layout_of(type_id);
+    }
     
-    oss << indent() << "struct " << to_pascal_case(name) << " {\n";
+    if (attributes.packed) {
+        oss << "#pragma pack(push, 1)\n";
+    }
+    oss << indent() << "struct ";
+    if (attributes.cacheline) {
+        oss << "alignas(" << layout_->abi().cache_line_size << ") ";
+    } else if (attributes.align != 0) {
+        oss << "alignas(" << attributes.align << ") ";
+    }
+    oss << type_name << " {\n";
     increase_indent();
     
-    for (auto& field : node->fields) {
-        std::string context = to_pascal_case(name) + "_" + to_pascal_case(field->name);
-        oss << indent() << map_type(field->type.get(), context) << " " << field->name << ";\n";
+    for (uint32_t index : field_order(node)) {
+        auto& field = node->fields[index];
+        std::string context = type_name + "_" + to_pascal_case(field->name);
+        oss << indent() << field_declaration(node, index, map_type(field->type.get(), context), "\n" + indent()) << "\n";
     }
+    oss << generate_field_visitor(node);
     
     decrease_indent();
     oss << indent() << "};\n";
+    if (attributes.packed) {
+        oss << "#pragma pack(pop)\n";
+    }
+    
+    layout_checks_.push_back({type_name, ir_->type_of(node)});
     
     return oss.str();
 }
@@ -126,27 +485,30 @@ std::string CppGenerator::generate_variant(const std::string& name, parser::Vari
     
     // First, generate named structs for each alternative with data
     for (auto& alt : node->alternatives) {
-        if (alt->type) {
+        if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(alt->type.get())) {
+            std::string alt_type_name = to_pascal_case(name) + "_" + to_pascal_case(alt->name);
+            oss << generate_named_struct(alt_type_name, struct_type) << "\n";
+        } else if (alt->type) {
+            // Other types are wrapped so every alternative is a distinct type
             std::string alt_type_name = to_pascal_case(name) + "_" + to_pascal_case(alt->name);
             oss << indent() << "struct " << alt_type_name << " {\n";
             increase_indent();
-            
-            if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(alt->type.get())) {
-                for (auto& field : struct_type->fields) {
-                    std::string context = alt_type_name + "_" + field->name;
-                    oss << indent() << map_type(field->type.get(), context) << " " << field->name << ";\n";
-                }
-            } else {
-                std::string context = alt_type_name + "_value";
-                oss << indent() << map_type(alt->type.get(), context) << " value;\n";
-            }
-            
+            std::string context = alt_type_name + "_value";
+            oss << indent() << map_type(alt->type.get(), context) << " value;\n";
             decrease_indent();
             oss << indent() << "};\n\n";
+            layout_checks_.push_back({alt_type_name, ir_->type_of(alt->type.get())});
         }
     }
     
+    if (variant_backend_of(ir_->type_of(node)) == semantic::VariantBackend::TAGGED) {
+        oss << generate_tagged_variant(to_pascal_case(name), node);
+        layout_checks_.push_back({to_pascal_case(name), ir_->type_of(node)});
+        return oss.str();
+    }
+    
     // Generate variant type using the named structs
+    add_include("<variant>");
     oss << indent() << "using " << to_pascal_case(name) << " = std::variant<\n";
     increase_indent();
     
@@ -171,115 +533,1100 @@ std::string CppGenerator::generate_variant(const std::string& name, parser::Vari
     decrease_indent();
     oss << indent() << ">;\n";
     
-    return oss.str();
-}
-
-std::string CppGenerator::generate_enum(const std::string& name, parser::EnumTypeNode* node) {
-    std::ostringstream oss;
-    
-    oss << indent() << "enum class " << to_pascal_case(name) << " {\n";
-    increase_indent();
-    
-    for (size_t i = 0; i < node->values.size(); ++i) {
-        oss << indent() << node->values[i];
-        if (i < node->values.size() - 1) {
-            oss << ",";
-        }
-        oss << "\n";
-    }
-    
-    decrease_indent();
-    oss << indent() << "};\n";
+    layout_checks_.push_back({to_pascal_case(name), ir_->type_of(node)});
     
     return oss.str();
 }
 
-std::string CppGenerator::generate_field(parser::FieldNode* field) {
-    return map_type(field->type.get(), "") + " " + field->name + ";";
-}
-
-std::string CppGenerator::map_type(parser::TypeExprNode* expr, const std::string& context) {
-    if (auto* prim = dynamic_cast<parser::PrimitiveTypeNode*>(expr)) {
-        return map_primitive_type(prim->primitive);
-    } else if (auto* container = dynamic_cast<parser::ContainerTypeNode*>(expr)) {
-        return map_container_type(container, context);
-    } else if (auto* ref = dynamic_cast<parser::RefTypeNode*>(expr)) {
-        return options_.use_strong_entity_id ? "entity_id" : "uint64_t";
-    } else if (auto* id = dynamic_cast<parser::IdentifierTypeNode*>(expr)) {
-        return to_pascal_case(id->name);
-    } else if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(expr)) {
-        return map_struct_type(struct_type);
-    } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(expr)) {
-        return map_variant_type(variant_type);
-    } else if (auto* enum_type = dynamic_cast<parser::EnumTypeNode*>(expr)) {
-        return map_enum_type(enum_type, context);
-    }
-    return "void";
-}
-
-std::string CppGenerator::map_primitive_type(parser::PrimitiveType type) {
-    switch (type) {
-        case parser::PrimitiveType::STR: return "std::string";
-        case parser::PrimitiveType::INT: return "int32_t";
-        case parser::PrimitiveType::BOOL: return "bool";
-        case parser::PrimitiveType::UNIT: return "std::monostate";
-        case parser::PrimitiveType::U8: return "uint8_t";
-        case parser::PrimitiveType::U16: return "uint16_t";
-        case parser::PrimitiveType::U32: return "uint32_t";
-        case parser::PrimitiveType::U64: return "uint64_t";
-        case parser::PrimitiveType::I8: return "int8_t";
-        case parser::PrimitiveType::I16: return "int16_t";
-        case parser::PrimitiveType::I32: return "int32_t";
-        case parser::PrimitiveType::I64: return "int64_t";
-        case parser::PrimitiveType::F32: return "float";
-        case parser::PrimitiveType::F64: return "double";
-        default: return "int32_t";
-    }
-}
-
-std::string CppGenerator::map_container_type(parser::ContainerTypeNode* node, const std::string& context) {
-    if (node->kind == parser::ContainerKind::ARRAY) {
-        return "std::vector<" + map_type(node->element_type.get(), context) + ">";
-    } else if (node->kind == parser::ContainerKind::MAP) {
-        return "std::unordered_map<" + map_type(node->key_type.get(), context + "_key") + ", " + 
-               map_type(node->value_type.get(), context + "_value") + ">";
-    } else if (node->kind == parser::ContainerKind::OPTIONAL) {
-        return "std::optional<" + map_type(node->element_type.get(), context) + ">";
+semantic::VariantBackend CppGenerator::variant_backend_of(semantic::TypeId type_id) const {
+    semantic::VariantBackend backend = semantic::VariantBackend::DEFAULT;
+    if (type_id != semantic::INVALID_ID && ir_->type(type_id).definition != semantic::INVALID_ID) {
+        backend = ir_->definitions[ir_->type(type_id).definition].variant_backend;
     }
-    return "void";
+    return backend != semantic::VariantBackend::DEFAULT ? backend : options_.variant_backend;
 }
 
-std::string CppGenerator::map_struct_type(parser::StructTypeNode* node) {
-    // Inline anonymous struct
-    std::ostringstream oss;
-    oss << "struct { ";
-    for (size_t i = 0; i < node->fields.size(); ++i) {
-        oss << map_type(node->fields[i]->type.get(), "") << " " << node->fields[i]->name;
-        if (i < node->fields.size() - 1) oss << "; ";
+std::string CppGenerator::generate_variant_storage(parser::TypeDefinitionNode* def, parser::VariantTypeNode* node) {
+    semantic::TypeId type_id = ir_->type_of(node);
+    if (type_id == semantic::INVALID_ID || ir_->type(type_id).definition == semantic::INVALID_ID ||
+        !ir_->definitions[ir_->type(type_id).definition].partitioned) {
+        return "";
     }
-    oss << "; }";
-    return oss.str();
-}
-
-std::string CppGenerator::map_variant_type(parser::VariantTypeNode* node) {
-    // Inline anonymous variant - simplified
+    
+    add_include("\"carch/variant_storage.h\"");
+    std::string type_name = to_pascal_case(def->name);
+    bool tagged = variant_backend_of(type_id) == semantic::VariantBackend::TAGGED;
     std::ostringstream oss;
-    oss << "std::variant<";
+    oss << "\n" << indent() << "// " << type_name << " values in one dense array per alternative\n";
+    oss << indent() << "using " << type_name << "_Storage = carch::VariantStorage<";
     for (size_t i = 0; i < node->alternatives.size(); ++i) {
         auto& alt = node->alternatives[i];
-        if (alt->type) {
-            oss << map_type(alt->type.get(), "");
+        oss << (i > 0 ? ", " : "");
+        if (alt->type || tagged) {
+            oss << type_name << "_" << to_pascal_case(alt->name);
         } else {
             oss << "std::monostate";
         }
-        if (i < node->alternatives.size() - 1) oss << ", ";
     }
-    oss << ">";
+    oss << ">;\n";
     return oss.str();
 }
 
-std::string CppGenerator::indent() {
-    return std::string(current_indent_ * options_.indentation_size, ' ');
+std::string CppGenerator::generate_double_buffer(parser::TypeDefinitionNode* def) {
+    semantic::TypeId type_id = ir_->type_of(def->type.get());
+    if (type_id == semantic::INVALID_ID || ir_->type(type_id).definition == semantic::INVALID_ID ||
+        !ir_->definitions[ir_->type(type_id).definition].double_buffered) {
+        return "";
+    }
+    
+    add_include("\"carch/double_buffer.h\"");
+    std::string type_name = to_pascal_case(def->name);
+    std::ostringstream oss;
+    oss << "\n" << indent() << "// " << type_name << " components in front and back buffers, swapped once a frame\n";
+    oss << indent() << "using " << type_name << "_Buffers = carch::DoubleBufferedPool<" << type_name << ", "
+        << (options_.use_strong_entity_id ? "entity_id" : "uint64_t") << ">;\n";
+    return oss.str();
+}
+
+std::string CppGenerator::generate_tagged_variant(const std::string& type_name, parser::VariantTypeNode* node) {
+    std::ostringstream oss;
+    add_include("<cassert>");
+    add_include("<cstdint>");
+    add_include("<new>");
+    add_include("<type_traits>");
+    add_include("<utility>");
+    add_include("\"carch/tagged_union.h\"");
+    
+    // Unit alternatives become empty structs so every alternative has a
+    // type to switch to and a union member to store
+    for (auto& alt : node->alternatives) {
+        if (!alt->type) {
+            oss << indent() << "struct " << type_name << "_" << to_pascal_case(alt->name) << " {};\n\n";
+        }
+    }
+    
+    semantic::TypeId type_id = ir_->type_of(node);
+    bool trivial = type_id != semantic::INVALID_ID && ir_->is_trivially_copyable(type_id);
+    auto alt_type = [&](size_t i) { return type_name + "_" + to_pascal_case(node->alternatives[i]->name); };
+    auto tag = [&](size_t i) { return "Tag::" + to_pascal_case(node->alternatives[i]->name); };
+    
+    // One case per alternative; in statement, $ stands for the
+    // alternative's union member and @ for its type
+    auto switch_on = [&](const std::string& subject, const std::string& statement) {
+        std::ostringstream body;
+        body << indent() << "switch (" << subject << ") {\n";
+        increase_indent();
+        for (size_t i = 0; i < node->alternatives.size(); ++i) {
+            std::string text;
+            for (char c : statement) {
+                if (c == '$') {
+                    text += node->alternatives[i]->name;
+                } else if (c == '@') {
+                    text += alt_type(i);
+                } else {
+                    text += c;
+                }
+            }
+            // The last alternative is the default so every path returns
+            body << indent() << (i + 1 < node->alternatives.size() ? "case " + tag(i) : std::string("default")) << ": "
+                 << text << "\n";
+        }
+        decrease_indent();
+        body << indent() << "}\n";
+        return body.str();
+    };
+    
+    // Same tag width as std::variant, so both backends share one layout
+    oss << indent() << "class " << type_name << " {\n";
+    oss << indent() << "public:\n";
+    increase_indent();
+    
+    oss << indent() << "enum class Tag : " << (node->alternatives.size() < 255 ? "uint8_t" : "uint16_t") << " {\n";
+    increase_indent();
+    for (size_t i = 0; i < node->alternatives.size(); ++i) {
+        oss << indent() << to_pascal_case(node->alternatives[i]->name)
+            << (i + 1 < node->alternatives.size() ? "," : "") << "\n";
+    }
+    decrease_indent();
+    oss << indent() << "};\n\n";
+    
+    // Construction from each alternative
+    const std::string& first = node->alternatives[0]->name;
+    oss << indent() << type_name << "() : tag_(" << tag(0) << ") { ::new (&storage_." << first << ") " << alt_type(0)
+        << "(); }\n";
+    for (size_t i = 0; i < node->alternatives.size(); ++i) {
+        const std::string& member = node->alternatives[i]->name;
+        oss << indent() << type_name << "(const " << alt_type(i) << "& value) : tag_(" << tag(i) << ") { ::new (&storage_."
+            << member << ") " << alt_type(i) << "(value); }\n";
+        if (!trivial) {
+            oss << indent() << type_name << "(" << alt_type(i) << "&& value) noexcept : tag_(" << tag(i)
+                << ") { ::new (&storage_." << member << ") " << alt_type(i) << "(std::move(value)); }\n";
+        }
+    }
+    oss << "\n";
+    
+    if (trivial) {
+        // Trivially copyable alternatives keep the whole type trivially copyable
+        oss << indent() << type_name << "(const " << type_name << "&) = default;\n";
+        oss << indent() << type_name << "& operator=(const " << type_name << "&) = default;\n\n";
+    } else {
+        // Alternatives that cannot throw while moving mean the tag always
+        // names a live alternative, even after a throwing copy
+        oss << indent() << type_name << "(const " << type_name << "& other) : tag_(other.tag_) {\n";
+        increase_indent();
+        oss << switch_on("tag_", "::new (&storage_.$) @(other.storage_.$); break;");
+        decrease_indent();
+        oss << indent() << "}\n";
+        oss << indent() << type_name << "(" << type_name << "&& other) noexcept : tag_(other.tag_) {\n";
+        increase_indent();
+        oss << switch_on("tag_", "::new (&storage_.$) @(std::move(other.storage_.$)); break;");
+        decrease_indent();
+        oss << indent() << "}\n";
+        oss << indent() << type_name << "& operator=(const " << type_name << "& other) {\n";
+        increase_indent();
+        oss << indent() << "if (this != &other) {\n";
+        oss << indent() << "    " << type_name << " copy(other);\n";
+        oss << indent() << "    *this = std::move(copy);\n";
+        oss << indent() << "}\n";
+        oss << indent() << "return *this;\n";
+        decrease_indent();
+        oss << indent() << "}\n";
+        oss << indent() << type_name << "& operator=(" << type_name << "&& other) noexcept {\n";
+        increase_indent();
+        oss << indent() << "if (this != &other) {\n";
+        increase_indent();
+        oss << indent() << "destroy();\n";
+        oss << indent() << "tag_ = other.tag_;\n";
+        oss << switch_on("tag_", "::new (&storage_.$) @(std::move(other.storage_.$)); break;");
+        decrease_indent();
+        oss << indent() << "}\n";
+        oss << indent() << "return *this;\n";
+        decrease_indent();
+        oss << indent() << "}\n";
+        oss << indent() << "~" << type_name << "() { destroy(); }\n\n";
+    }
+    
+    // Queries and checked access by alternative type
+    oss << indent() << "Tag tag() const noexcept { return tag_; }\n";
+    oss << indent() << "template <typename T> bool is() const noexcept { return tag_ == tag_of(static_cast<T*>(nullptr)); }\n";
+    oss << indent() << "template <typename T> T& get() noexcept { assert(is<T>()); return *slot(static_cast<T*>(nullptr)); }\n";
+    oss << indent() << "template <typename T> const T& get() const noexcept { assert(is<T>()); return *slot(static_cast<T*>(nullptr)); }\n";
+    oss << indent() << "template <typename T> T* get_if() noexcept { return is<T>() ? slot(static_cast<T*>(nullptr)) : nullptr; }\n";
+    oss << indent() << "template <typename T> const T* get_if() const noexcept { return is<T>() ? slot(static_cast<T*>(nullptr)) : nullptr; }\n\n";
+    
+    // Visiting is a switch on the tag, which compilers turn into a jump table
+    for (const char* qualifier : {"", " const"}) {
+        oss << indent() << "template <typename Visitor>\n";
+        oss << indent() << "decltype(auto) visit(Visitor&& visitor)" << qualifier << " {\n";
+        increase_indent();
+        oss << switch_on("tag_", "return std::forward<Visitor>(visitor)(storage_.$);");
+        decrease_indent();
+        oss << indent() << "}\n";
+    }
+    oss << indent() << "template <typename... Handlers>\n";
+    oss << indent() << "decltype(auto) match(Handlers&&... handlers) { return visit(carch::Overloaded<std::decay_t<Handlers>...>{std::forward<Handlers>(handlers)...}); }\n";
+    oss << indent() << "template <typename... Handlers>\n";
+    oss << indent() << "decltype(auto) match(Handlers&&... handlers) const { return visit(carch::Overloaded<std::decay_t<Handlers>...>{std::forward<Handlers>(handlers)...}); }\n\n";
+    
+    decrease_indent();
+    oss << indent() << "private:\n";
+    increase_indent();
+    
+    oss << indent() << "union Storage {\n";
+    increase_indent();
+    for (size_t i = 0; i < node->alternatives.size(); ++i) {
+        oss << indent() << alt_type(i) << " " << node->alternatives[i]->name << ";\n";
+    }
+    oss << indent() << "Storage() noexcept {}\n";
+    if (!trivial) {
+        oss << indent() << "~Storage() {}\n";
+    }
+    decrease_indent();
+    oss << indent() << "} storage_;\n";
+    oss << indent() << "Tag tag_;\n\n";
+    
+    for (size_t i = 0; i < node->alternatives.size(); ++i) {
+        oss << indent() << "static constexpr Tag tag_of(" << alt_type(i) << "*) noexcept { return " << tag(i) << "; }\n";
+    }
+    for (size_t i = 0; i < node->alternatives.size(); ++i) {
+        const std::string& member = node->alternatives[i]->name;
+        oss << indent() << alt_type(i) << "* slot(" << alt_type(i) << "*) noexcept { return &storage_." << member << "; }\n";
+        oss << indent() << "const " << alt_type(i) << "* slot(" << alt_type(i) << "*) const noexcept { return &storage_."
+            << member << "; }\n";
+    }
+    if (!trivial) {
+        oss << indent() << "void destroy() noexcept {\n";
+        increase_indent();
+        oss << switch_on("tag_", "storage_.$.~@(); break;");
+        decrease_indent();
+        oss << indent() << "}\n";
+    }
+    
+    decrease_indent();
+    oss << indent() << "};\n";
+    
+    if (!trivial) {
+        oss << indent() << "static_assert(";
+        for (size_t i = 0; i < node->alternatives.size(); ++i) {
+            oss << (i > 0 ? " &&\n" + indent() + "              " : std::string()) << "std::is_nothrow_move_constructible_v<"
+                << alt_type(i) << ">";
+        }
+        oss << ",\n" << indent() << "              \"" << type_name << ": alternatives must be nothrow move constructible\");\n";
+    }
+    
+    return oss.str();
+}
+
+std::string CppGenerator::generate_enum(const std::string& name, parser::EnumTypeNode* node) {
+    if (node->flags) {
+        return generate_flags(to_pascal_case(name), to_pascal_case(name) + "_Flag", node);
+    }
+    return generate_enum_class(to_pascal_case(name), node);
+}
+
+std::string CppGenerator::generate_enum_class(const std::string& enum_name, parser::EnumTypeNode* node) {
+    std::ostringstream oss;
+    add_include("<cstdint>");
+    
+    // The smallest underlying type that leaves a spare value for compact optionals
+    uint32_t size = semantic::enum_storage_size(static_cast<uint32_t>(node->values.size()));
+    oss << indent() << "enum class " << enum_name << " : " << unsigned_type(size) << " {\n";
+    increase_indent();
+    
+    for (size_t i = 0; i < node->values.size(); ++i) {
+        oss << indent() << node->values[i];
+        if (i < node->values.size() - 1) {
+            oss << ",";
+        }
+        oss << "\n";
+    }
+    
+    decrease_indent();
+    oss << indent() << "};\n";
+    
+    // Found by carch::enum_count, which sizes EnumSet and EnumArray
+    oss << indent() << "constexpr uint32_t carch_enum_count(" << enum_name << ") noexcept { return "
+        << node->values.size() << "; }\n";
+    
+    return oss.str();
+}
+
+std::string CppGenerator::generate_flags(const std::string& set_name, const std::string& enum_name,
+                                         parser::EnumTypeNode* node) {
+    std::ostringstream oss;
+    add_include("\"carch/enum_containers.h\"");
+    
+    // One enumerator per bit, numbered from 0, and the set of them
+    oss << generate_enum_class(enum_name, node);
+    oss << indent() << "using " << set_name << " = carch::EnumSet<" << enum_name << ", " << node->values.size()
+        << ">;\n";
+    oss << indent() << "constexpr " << set_name << " operator|(" << enum_name << " a, " << enum_name
+        << " b) noexcept { return " << set_name << "(a) | b; }\n";
+    
+    return oss.str();
+}
+
+std::string CppGenerator::unsigned_type(uint32_t size) {
+    switch (size) {
+        case 1: return "uint8_t";
+        case 2: return "uint16_t";
+        case 4: return "uint32_t";
+        default: return "uint64_t";
+    }
+}
+
+std::string CppGenerator::generate_field(parser::FieldNode* field) {
+    return map_type(field->type.get(), "") + " " + field->name + ";";
+}
+
+std::string CppGenerator::map_type(parser::TypeExprNode* expr, const std::string& context) {
+    if (auto* prim = dynamic_cast<parser::PrimitiveTypeNode*>(expr)) {
+        return map_primitive_type(prim);
+    } else if (auto* container = dynamic_cast<parser::ContainerTypeNode*>(expr)) {
+        return map_container_type(container, context);
+    } else if (dynamic_cast<parser::RefTypeNode*>(expr)) {
+        add_include("<cstdint>");
+        return options_.use_strong_entity_id ? "entity_id" : "uint64_t";
+    } else if (auto* id = dynamic_cast<parser::IdentifierTypeNode*>(expr)) {
+        semantic::TypeId type_id = ir_->type_of(id);
+        if (type_id != semantic::INVALID_ID) {
+            return to_pascal_case(ir_->definitions[ir_->type(type_id).definition].name);
+        }
+        return to_pascal_case(id->name);
+    } else if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(expr)) {
+        return map_struct_type(struct_type, context);
+    } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(expr)) {
+        return map_variant_type(variant_type, context);
+    } else if (auto* enum_type = dynamic_cast<parser::EnumTypeNode*>(expr)) {
+        return map_enum_type(enum_type, context);
+    }
+    return "void";
+}
+
+std::string CppGenerator::map_primitive_type(const parser::PrimitiveTypeNode* node) {
+    parser::PrimitiveType type = node->primitive;
+    uint32_t length = node->length;
+    if (type == parser::PrimitiveType::STR && length > 0) {
+        add_include("\"carch/fixed_string.h\"");
+        return "carch::FixedString<" + std::to_string(length) + ">";
+    }
+    if (type == parser::PrimitiveType::ISTR) {
+        add_include("\"carch/interned_string.h\"");
+        return "carch::InternedString";
+    }
+    if (semantic::vector_lanes(type) > 0) {
+        add_include("\"carch/vector.h\"");
+        switch (type) {
+            case parser::PrimitiveType::VEC2: return "carch::Vec2";
+            case parser::PrimitiveType::VEC3: return "carch::Vec3";
+            case parser::PrimitiveType::VEC4: return "carch::Vec4";
+            case parser::PrimitiveType::QUAT: return "carch::Quat";
+            case parser::PrimitiveType::IVEC2: return "carch::IVec2";
+            case parser::PrimitiveType::IVEC3: return "carch::IVec3";
+            default: return "carch::IVec4";
+        }
+    }
+    if (semantic::storage_primitive(type, length) != type) {
+        add_include("\"carch/quantized.h\"");
+        switch (type) {
+            case parser::PrimitiveType::F16: return "carch::Half";
+            case parser::PrimitiveType::UNORM8: return "carch::Unorm8";
+            case parser::PrimitiveType::UNORM16: return "carch::Unorm16";
+            case parser::PrimitiveType::SNORM8: return "carch::Snorm8";
+            case parser::PrimitiveType::SNORM16: return "carch::Snorm16";
+            default: break;
+        }
+        // Bounds share one decimal scale, so quant<0.5, 2, 8> is Quantized<5, 20, 8, 1>
+        semantic::QuantRange range;
+        semantic::parse_quant_range(node->quant_min, node->quant_max, range);
+        std::string result = "carch::Quantized<" + std::to_string(range.min) + ", " + std::to_string(range.max) +
+                             ", " + std::to_string(length);
+        if (range.decimals > 0) {
+            result += ", " + std::to_string(range.decimals);
+        }
+        return result + ">";
+    }
+    
+    switch (type) {
+        case parser::PrimitiveType::STR: add_include("<string>"); break;
+        case parser::PrimitiveType::UNIT: add_include("<variant>"); break;
+        case parser::PrimitiveType::BOOL:
+        case parser::PrimitiveType::F32:
+        case parser::PrimitiveType::F64: break;
+        default: add_include("<cstdint>"); break;
+    }
+    
+    switch (type) {
+        case parser::PrimitiveType::STR: return "std::string";
+        case parser::PrimitiveType::INT: return "int32_t";
+        case parser::PrimitiveType::BOOL: return "bool";
+        case parser::PrimitiveType::UNIT: return "std::monostate";
+        case parser::PrimitiveType::U8: return "uint8_t";
+        case parser::PrimitiveType::U16: return "uint16_t";
+        case parser::PrimitiveType::U32: return "uint32_t";
+        case parser::PrimitiveType::U64: return "uint64_t";
+        case parser::PrimitiveType::I8: return "int8_t";
+        case parser::PrimitiveType::I16: return "int16_t";
+        case parser::PrimitiveType::I32: return "int32_t";
+        case parser::PrimitiveType::I64: return "int64_t";
+        case parser::PrimitiveType::F32: return "float";
+        case parser::PrimitiveType::F64: return "double";
+        default: return "int32_t";
+    }
+}
+
+std::string CppGenerator::map_container_type(parser::ContainerTypeNode* node, const std::string& context) {
+    // Anything spelled inside a template argument has to be a named type
+    ++template_depth_;
+    std::string result = "void";
+    if (node->kind == parser::ContainerKind::ARRAY && node->length > 0) {
+        add_include("<array>");
+        result = "std::array<" + map_type(node->element_type.get(), context) + ", " +
+                 std::to_string(node->length) + ">";
+    } else if (node->kind == parser::ContainerKind::ARRAY) {
+        semantic::TypeId type_id = ir_->type_of(node);
+        if (type_id != semantic::INVALID_ID && ir_->type(type_id).pooled) {
+            add_include("\"carch/span_arena.h\"");
+            result = "carch::PoolSpan<" + map_type(node->element_type.get(), context) + ">";
+        } else {
+            add_include("<vector>");
+            result = "std::vector<" + map_type(node->element_type.get(), context) + ">";
+        }
+    } else if (node->kind == parser::ContainerKind::SMALL_ARRAY) {
+        add_include("\"carch/small_array.h\"");
+        result = "carch::SmallArray<" + map_type(node->element_type.get(), context) + ", " +
+                 std::to_string(node->length) + ">";
+    } else if (node->kind == parser::ContainerKind::MAP) {
+        semantic::TypeId type_id = ir_->type_of(node);
+        semantic::MapBackend backend = type_id != semantic::INVALID_ID ? ir_->type(type_id).map_backend
+                                                                       : semantic::MapBackend::DEFAULT;
+        if (backend == semantic::MapBackend::DEFAULT) {
+            backend = options_.map_backend;
+        }
+        std::string arguments = map_type(node->key_type.get(), context + "_key") + ", " +
+                                map_type(node->value_type.get(), context + "_value") + ">";
+        if (backend == semantic::MapBackend::FLAT) {
+            add_include("\"carch/flat_map.h\"");
+            result = "carch::FlatHashMap<" + arguments;
+        } else if (backend == semantic::MapBackend::SORTED) {
+            add_include("\"carch/sorted_map.h\"");
+            result = "carch::SortedFlatMap<" + arguments;
+        } else {
+            add_include("<unordered_map>");
+            result = "std::unordered_map<" + arguments;
+        }
+    } else if (node->kind == parser::ContainerKind::OPTIONAL) {
+        semantic::TypeId type_id = ir_->type_of(node);
+        std::string element = map_type(node->element_type.get(), context);
+        if (type_id != semantic::INVALID_ID && ir_->is_compact_optional(type_id, options_.optional_backend)) {
+            add_include("\"carch/compact_optional.h\"");
+            result = "carch::CompactOptional<" + element + ", " +
+                     niche_type(ir_->type(type_id).element, element) + ">";
+        } else {
+            add_include("<optional>");
+            result = "std::optional<" + element + ">";
+        }
+    }
+    --template_depth_;
+    return result;
+}
+
+std::string CppGenerator::niche_type(semantic::TypeId element, const std::string& element_type) {
+    const semantic::Type& type = ir_->type(element);
+    switch (ir_->niche_of(element)) {
+        case semantic::Niche::REF:
+            if (generational_entity_ids()) {
+                return "carch::EntityNiche<" + element_type + ">";
+            }
+            return "carch::MaxNiche<" + element_type + ">";
+        case semantic::Niche::ENUM: return "carch::EnumNiche<" + element_type + ">";
+        case semantic::Niche::FLOAT: return "carch::NanNiche<" + element_type + ">";
+        case semantic::Niche::STRING: return "carch::EmptyNiche<" + element_type + ">";
+        default: break;
+    }
+    // Signed integers give up their minimum, unsigned ones their maximum
+    switch (type.primitive) {
+        case parser::PrimitiveType::INT:
+        case parser::PrimitiveType::I8:
+        case parser::PrimitiveType::I16:
+        case parser::PrimitiveType::I32:
+        case parser::PrimitiveType::I64: return "carch::MinNiche<" + element_type + ">";
+        default: return "carch::MaxNiche<" + element_type + ">";
+    }
+}
+
+std::string CppGenerator::map_struct_type(parser::StructTypeNode* node, const std::string& context) {
+    // Structurally identical anonymous structs share a single named type
+    semantic::TypeId type_id = ir_->type_of(node);
+    auto known = anonymous_struct_names_.find(type_id);
+    if (known != anonymous_struct_names_.end()) {
+        if (shape_unit_names_.count(known->second) > 0) {
+            used_shapes_.insert(known->second);
+        }
+        return known->second;
+    }
+    
+    bool shared = type_id != semantic::INVALID_ID && ir_->type(type_id).uses > 1;
+    if (!shared && template_depth_ == 0) {
+        // Inline anonymous struct
+        std::ostringstream oss;
+        oss << "struct { ";
+        for (uint32_t index : field_order(node)) {
+            oss << field_declaration(node, index, map_type(node->fields[index]->type.get(), ""), " ") << " ";
+        }
+        if (options_.optimize_layout) {
+            oss << "template <typename Self, typename Visitor> static void carch_visit_fields(Self& self, Visitor&& visit) { ";
+            for (auto& field : node->fields) {
+                oss << "visit(\"" << field->name << "\", self." << field->name << "); ";
+            }
+            oss << "} ";
+        }
+        oss << "}";
+        return oss.str();
+    }
+    
+    std::string struct_name;
+    if (shared) {
+        std::string field_names;
+        for (auto& field : node->fields) {
+            field_names += "_" + field->name;
+        }
+        struct_name = unique_type_name(to_pascal_case(field_names) + "_Struct");
+    } else if (!context.empty()) {
+        struct_name = unique_type_name(to_pascal_case(context) + "_Struct");
+    } else {
+        struct_name = unique_type_name("AnonymousStruct" + std::to_string(anonymous_type_counter_++));
+    }
+    anonymous_struct_names_[type_id] = struct_name;
+    
+    // Hoisted types are generated at namespace scope, outside any template
+    int saved_indent = current_indent_;
+    int saved_template_depth = template_depth_;
+    current_indent_ = 0;
+    template_depth_ = 0;
+    
+    if (shared && split_units_) {
+        // Generate into a unit of its own, with its own hoisted types and includes
+        std::ostringstream outer_hoisted;
+        std::set<std::string> outer_includes;
+        std::set<std::string> outer_shapes;
+        std::vector<LayoutCheck> outer_checks;
+        outer_hoisted.swap(hoisted_types_);
+        outer_includes.swap(generated_includes_);
+        outer_shapes.swap(used_shapes_);
+        outer_checks.swap(layout_checks_);
+        
+        std::string body = generate_named_struct(struct_name, node);
+        
+        GeneratedUnit unit;
+        unit.name = struct_name;
+        unit.text = hoisted_types_.str() + body + generate_layout_checks();
+        unit.includes = generated_includes_;
+        unit.dependencies = used_shapes_;
+        collect_dependencies(type_id, unit.dependencies);
+        shape_units_.push_back(std::move(unit));
+        shape_unit_names_.insert(struct_name);
+        
+        hoisted_types_.swap(outer_hoisted);
+        generated_includes_.swap(outer_includes);
+        used_shapes_.swap(outer_shapes);
+        layout_checks_.swap(outer_checks);
+        used_shapes_.insert(struct_name);
+    } else {
+        std::string body = generate_named_struct(struct_name, node);
+        hoisted_types_ << body << "\n";
+    }
+    
+    current_indent_ = saved_indent;
+    template_depth_ = saved_template_depth;
+    
+    return struct_name;
+}
+
+std::string CppGenerator::map_variant_type(parser::VariantTypeNode* node, const std::string& context) {
+    // Inline anonymous variant - simplified
+    add_include("<variant>");
+    ++template_depth_;
+    std::ostringstream oss;
+    oss << "std::variant<";
+    for (size_t i = 0; i < node->alternatives.size(); ++i) {
+        auto& alt = node->alternatives[i];
+        if (alt->type) {
+            oss << map_type(alt->type.get(), context.empty() ? "" : context + "_" + alt->name);
+        } else {
+            oss << "std::monostate";
+        }
+        if (i < node->alternatives.size() - 1) oss << ", ";
+    }
+    oss << ">";
+    --template_depth_;
+    return oss.str();
+}
+
+std::vector<uint32_t> CppGenerator::field_order(parser::StructTypeNode* node) {
+    semantic::TypeId type_id = ir_->type_of(node);
+    if (type_id != semantic::INVALID_ID) {
+        return layout_->field_order(type_id);
+    }
+    std::vector<uint32_t> order(node->fields.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    return order;
+}
+
+std::string CppGenerator::field_declaration(parser::StructTypeNode* node, uint32_t index, const std::string& type,
+                                            const std::string& separator) {
+    auto& field = node->fields[index];
+    semantic::TypeId type_id = ir_->type_of(node);
+    if (type_id == semantic::INVALID_ID) {
+        return type + " " + field->name + ";";
+    }
+    
+    // A @cacheline field starts a line and is padded so the next field
+    // starts another one
+    uint32_t ir_field = ir_->type(type_id).first + index;
+    const semantic::LayoutAttributes& attributes = ir_->fields[ir_field].layout;
+    std::string result;
+    if (attributes.cacheline) {
+        result += "alignas(" + std::to_string(layout_->abi().cache_line_size) + ") ";
+    } else if (attributes.align != 0) {
+        result += "alignas(" + std::to_string(attributes.align) + ") ";
+    }
+    result += type + " " + field->name + ";";
+    
+    uint32_t size = layout_->layout(ir_->fields[ir_field].type).size;
+    uint32_t padding = layout_->field_storage(ir_field) - size;
+    if (padding > 0) {
+        result += separator + "char carch_padding_" + field->name + "[" + std::to_string(padding) + "];";
+    }
+    return result;
+}
+
+std::string CppGenerator::generate_field_visitor(parser::StructTypeNode* node, bool cold) {
+    if (!options_.optimize_layout) {
+        return "";
+    }
+    semantic::TypeId type_id = ir_->type_of(node);
+    
+    // Storage order is an implementation detail once fields are reordered;
+    // serializers visit fields in the order the schema declares them
+    std::ostringstream oss;
+    oss << "\n";
+    oss << indent() << "// Fields in schema declaration order\n";
+    oss << indent() << "template <typename Self, typename Visitor>\n";
+    oss << indent() << "static void carch_visit_fields(Self& self, Visitor&& visit) {\n";
+    increase_indent();
+    for (size_t i = 0; i < node->fields.size(); ++i) {
+        auto& field = node->fields[i];
+        bool cold_field = type_id != semantic::INVALID_ID && ir_->fields[ir_->type(type_id).first + i].cold;
+        if (cold_field == cold) {
+            oss << indent() << "visit(\"" << field->name << "\", self." << field->name << ");\n";
+        }
+    }
+    decrease_indent();
+    oss << indent() << "}\n";
+    return oss.str();
+}
+
+std::string CppGenerator::generate_layout_checks() {
+    if (layout_checks_.empty()) {
+        return "";
+    }
+    
+    std::ostringstream oss;
+    if (options_.layout_asserts) {
+        // Sizes are computed for one ABI, so the checks only apply there.
+        // __GLIBCXX__ comes from any libstdc++ header, <cstddef> included.
+        add_include("<cstddef>");
+        oss << indent() << "// Layout computed by carch for " << layout_->abi().name << "\n";
+        oss << "#if defined(__x86_64__) && defined(__GLIBCXX__)\n";
+        for (const auto& check : layout_checks_) {
+            if (check.type == semantic::INVALID_ID) continue;
+            const semantic::TypeLayout& layout = check.cold ? layout_->cold_layout(check.type)
+                                                            : layout_->layout(check.type);
+            oss << indent() << "static_assert(sizeof(" << check.name << ") == " << layout.size
+                << ", \"" << check.name << ": size changed\");\n";
+            oss << indent() << "static_assert(alignof(" << check.name << ") == " << layout.align
+                << ", \"" << check.name << ": alignment changed\");\n";
+        }
+        oss << "#endif\n\n";
+    }
+    oss << generate_type_traits();
+    layout_checks_.clear();
+    return oss.str();
+}
+
+std::string CppGenerator::generate_type_traits() {
+    // carch/traits.h finds these by argument-dependent lookup. Trivially
+    // copyable types are relocatable without saying so, and types that own
+    // heap memory are only relocatable where std::vector is.
+    std::ostringstream copyable;
+    std::ostringstream relocatable;
+    for (const auto& check : layout_checks_) {
+        if (check.type == semantic::INVALID_ID) continue;
+        const semantic::Type& type = ir_->type(check.type);
+        if (type.kind == semantic::TypeKind::ENUM) continue;
+        uint8_t flags = check.cold ? ir_->cold_flags(check.type) : type.flags;
+        bool pod = type.definition != semantic::INVALID_ID && ir_->definitions[type.definition].pod;
+        // A std::variant alias names a library type; it is only ours, and
+        // found by lookup in this namespace, through an alternative struct
+        bool hooks = true;
+        if (type.kind == semantic::TypeKind::VARIANT &&
+            variant_backend_of(check.type) != semantic::VariantBackend::TAGGED) {
+            hooks = false;
+            for (uint32_t i = 0; i < type.count; ++i) {
+                hooks = hooks || ir_->fields[type.first + i].type != semantic::INVALID_ID;
+            }
+        }
+        if (flags & semantic::TYPE_TRIVIALLY_COPYABLE) {
+            if (options_.layout_asserts || pod) {
+                copyable << indent() << "static_assert(std::is_trivially_copyable_v<" << check.name << ">, \""
+                         << check.name << ": no longer trivially copyable\");\n";
+            }
+            if (hooks && (flags & semantic::TYPE_WIRE_SAFE)) {
+                copyable << indent() << "constexpr bool carch_pod_wire_safe(const " << check.name
+                         << "*) noexcept { return true; }\n";
+            }
+        } else if (hooks && (flags & semantic::TYPE_TRIVIALLY_RELOCATABLE)) {
+            relocatable << indent() << "constexpr bool carch_trivially_relocatable(const " << check.name
+                        << "*) noexcept { return true; }\n";
+        }
+    }
+    if (copyable.tellp() == 0 && relocatable.tellp() == 0) {
+        return "";
+    }
+    
+    add_include("<type_traits>");
+    std::ostringstream oss;
+    oss << indent() << "// Copy traits computed by carch, for the runtime's memcpy paths\n";
+    oss << copyable.str();
+    if (relocatable.tellp() != 0) {
+        oss << "#if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)\n";
+        oss << relocatable.str();
+        oss << "#endif\n";
+    }
+    oss << "\n";
+    return oss.str();
+}
+
+void CppGenerator::collect_annotated_fields(parser::StructTypeNode* node, const char* annotation,
+                                            const std::string& access, const std::string& prefix,
+                                            AnnotatedFields& fields) const {
+    for (auto& field : node->fields) {
+        if (parser::find_annotation(field->annotations, annotation)) {
+            fields.push_back({prefix + field->name, access + field->name});
+        } else if (auto* inner = dynamic_cast<parser::StructTypeNode*>(field->type.get())) {
+            collect_annotated_fields(inner, annotation, access + field->name + ".", prefix + field->name + "_", fields);
+        }
+    }
+}
+
+std::vector<std::pair<std::string, CppGenerator::AnnotatedFields>> CppGenerator::annotated_fields(
+    parser::TypeDefinitionNode* def, const char* annotation) const {
+    std::vector<std::pair<std::string, AnnotatedFields>> groups;
+    if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(def->type.get())) {
+        AnnotatedFields fields;
+        collect_annotated_fields(struct_type, annotation, "", "", fields);
+        if (!fields.empty()) {
+            groups.push_back({"", fields});
+        }
+    } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(def->type.get())) {
+        for (auto& alt : variant_type->alternatives) {
+            AnnotatedFields fields;
+            if (auto* alt_struct = dynamic_cast<parser::StructTypeNode*>(alt->type.get())) {
+                collect_annotated_fields(alt_struct, annotation, "", alt->name + "_", fields);
+            }
+            if (!fields.empty()) {
+                groups.push_back({to_pascal_case(def->name) + "_" + to_pascal_case(alt->name), fields});
+            }
+        }
+    }
+    return groups;
+}
+
+bool CppGenerator::has_annotated_fields(const char* annotation) const {
+    for (auto& def : schema_->definitions) {
+        if (!annotated_fields(def.get(), annotation).empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CppGenerator::has_component_pools() {
+    return has_annotated_fields("indexed") || has_annotated_fields("pooled") || has_annotated_fields("cold");
+}
+
+std::string CppGenerator::generate_alternative_guard(parser::TypeDefinitionNode* def,
+                                                     const std::string& alt_type_name) {
+    bool tagged = variant_backend_of(ir_->type_of(def->type.get())) == semantic::VariantBackend::TAGGED;
+    return "if (auto* alt = " +
+           (tagged ? "value.get_if<" + alt_type_name + ">()" : "std::get_if<" + alt_type_name + ">(&value)") +
+           ") {\n";
+}
+
+std::string CppGenerator::generate_ref_visitor(parser::TypeDefinitionNode* def) {
+    auto groups = annotated_fields(def, "indexed");
+    if (groups.empty()) {
+        return "";
+    }
+    std::string type_name = to_pascal_case(def->name);
+    std::string ref_enum = type_name + "_Ref";
+    
+    add_include("<cstdint>");
+    std::ostringstream oss;
+    oss << "\n";
+    oss << indent() << "// @indexed references, kept in a carch::ReverseIndex by carch::ComponentPool\n";
+    oss << indent() << "enum class " << ref_enum << " : uint32_t {\n";
+    increase_indent();
+    for (const auto& group : groups) {
+        for (const auto& ref : group.second) {
+            oss << indent() << ref.first << ",\n";
+        }
+    }
+    decrease_indent();
+    oss << indent() << "};\n\n";
+    
+    // Each block is guarded by the alternative it reads, if any
+    oss << indent() << "template <typename Visitor>\n";
+    oss << indent() << "void carch_visit_refs(" << type_name << "& value, Visitor&& visit) {\n";
+    increase_indent();
+    for (const auto& group : groups) {
+        std::string object = "value.";
+        if (!group.first.empty()) {
+            oss << indent() << generate_alternative_guard(def, group.first);
+            increase_indent();
+            object = "alt->";
+        }
+        for (const auto& ref : group.second) {
+            oss << indent() << "visit(" << ref_enum << "::" << ref.first << ", " << object << ref.second << ");\n";
+        }
+        if (!group.first.empty()) {
+            decrease_indent();
+            oss << indent() << "}\n";
+        }
+    }
+    decrease_indent();
+    oss << indent() << "}\n";
+    return oss.str();
+}
+
+std::string CppGenerator::generate_cold_fields(parser::TypeDefinitionNode* def, parser::StructTypeNode* node) {
+    semantic::TypeId type_id = ir_->type_of(node);
+    if (type_id == semantic::INVALID_ID || !ir_->has_cold_fields(type_id)) {
+        return "";
+    }
+    std::string type_name = to_pascal_case(def->name);
+    std::string cold = type_name + "_Cold";
+    std::string view = type_name + "_View";
+    
+    std::ostringstream oss;
+    oss << "\n";
+    oss << indent() << "// @cold fields of " << type_name << ", kept apart by carch::ComponentPool\n";
+    oss << indent() << "struct " << cold << " {\n";
+    increase_indent();
+    for (uint32_t index : layout_->cold_field_order(type_id)) {
+        auto& field = node->fields[index];
+        std::string context = type_name + "_" + to_pascal_case(field->name);
+        oss << indent() << field_declaration(node, index, map_type(field->type.get(), context), "\n" + indent()) << "\n";
+    }
+    oss << generate_field_visitor(node, true);
+    decrease_indent();
+    oss << indent() << "};\n";
+    oss << indent() << cold << " carch_cold_fields(" << type_name << "*);\n\n";
+    layout_checks_.push_back({cold, type_id, true});
+    
+    // Call sites read every field the same way, wherever it is stored
+    const semantic::Field* fields = ir_->fields_of(type_id);
+    oss << indent() << "// " << type_name << " and its cold fields, with an accessor per field\n";
+    oss << indent() << "struct " << view << " {\n";
+    increase_indent();
+    oss << indent() << type_name << "* carch_hot = nullptr;\n";
+    oss << indent() << cold << "* carch_cold = nullptr;\n\n";
+    oss << indent() << "explicit operator bool() const noexcept { return carch_hot != nullptr; }\n";
+    for (size_t i = 0; i < node->fields.size(); ++i) {
+        const std::string& name = node->fields[i]->name;
+        oss << indent() << "auto& " << name << "() const noexcept { return "
+            << (fields[i].cold ? "carch_cold->" : "carch_hot->") << name << "; }\n";
+    }
+    decrease_indent();
+    oss << indent() << "};\n";
+    oss << indent() << "inline " << view << " carch_cold_view(" << type_name << "* hot, " << cold
+        << "* cold) noexcept { return {hot, cold}; }\n";
+    return oss.str();
+}
+
+std::string CppGenerator::generate_span_visitor(parser::TypeDefinitionNode* def) {
+    auto groups = annotated_fields(def, "pooled");
+    if (groups.empty()) {
+        return "";
+    }
+    std::string type_name = to_pascal_case(def->name);
+    std::string arenas = type_name + "_Arenas";
+    
+    // Arena element types are spelled through the span members, so anonymous
+    // element types are not named twice
+    add_include("\"carch/span_arena.h\"");
+    std::ostringstream oss;
+    oss << "\n";
+    oss << indent() << "// Arenas holding the elements of @pooled fields, owned by carch::ComponentPool\n";
+    oss << indent() << "struct " << arenas << " {\n";
+    increase_indent();
+    for (const auto& group : groups) {
+        std::string owner = group.first.empty() ? type_name : group.first;
+        for (const auto& span : group.second) {
+            oss << indent() << "carch::SpanArenaOf<decltype(" << owner << "::" << span.second << ")> " << span.first
+                << ";\n";
+        }
+    }
+    oss << "\n";
+    oss << indent() << "template <typename F>\n";
+    oss << indent() << "void each(F&& f) {\n";
+    increase_indent();
+    for (const auto& group : groups) {
+        for (const auto& span : group.second) {
+            oss << indent() << "f(" << span.first << ");\n";
+        }
+    }
+    decrease_indent();
+    oss << indent() << "}\n";
+    decrease_indent();
+    oss << indent() << "};\n";
+    oss << indent() << arenas << " carch_span_arenas(" << type_name << "*);\n\n";
+    
+    oss << indent() << "template <typename Visitor>\n";
+    oss << indent() << "void carch_visit_spans(" << type_name << "& value, " << arenas
+        << "& arenas, Visitor&& visit) {\n";
+    increase_indent();
+    for (const auto& group : groups) {
+        std::string object = "value.";
+        if (!group.first.empty()) {
+            oss << indent() << generate_alternative_guard(def, group.first);
+            increase_indent();
+            object = "alt->";
+        }
+        for (const auto& span : group.second) {
+            oss << indent() << "visit(" << object << span.second << ", arenas." << span.first << ");\n";
+        }
+        if (!group.first.empty()) {
+            decrease_indent();
+            oss << indent() << "}\n";
+        }
+    }
+    decrease_indent();
+    oss << indent() << "}\n";
+    return oss.str();
+}
+
+std::string CppGenerator::generate_archetype_declarations() {
+    if (!options_.archetypes || !generational_entity_ids() || options_.namespace_name.empty()) {
+        return "";
+    }
+    std::vector<std::string> components;
+    for (auto& node : schema_->definitions) {
+        semantic::DefinitionId id = ir_->find_definition(node->name);
+        if (id == semantic::INVALID_ID) continue;
+        const semantic::Definition& def = ir_->definitions[id];
+        // @indexed references are linked into a reverse_index and @pooled
+        // spans point into arenas, both kept by component_pool only
+        if (!annotated_fields(node.get(), "indexed").empty() || !annotated_fields(node.get(), "pooled").empty()) {
+            continue;
+        }
+        semantic::TypeKind kind = ir_->type(def.type).kind;
+        if (kind == semantic::TypeKind::STRUCT || kind == semantic::TypeKind::VARIANT) {
+            components.push_back(to_pascal_case(def.name));
+        }
+        // The side table of @cold fields is a component of its own
+        if (ir_->has_cold_fields(def.type)) {
+            components.push_back(to_pascal_case(def.name) + "_Cold");
+        }
+    }
+    if (components.empty()) {
+        return "";
+    }
+    
+    add_include("\"carch/archetype.h\"");
+    add_include("<cstdint>");
+    std::ostringstream oss;
+    oss << indent() << "// Archetype storage: component ids and sets follow the definition order\n";
+    oss << indent() << "enum class component_id : uint32_t {\n";
+    increase_indent();
+    for (const auto& component : components) {
+        oss << indent() << component << ",\n";
+    }
+    decrease_indent();
+    oss << indent() << "};\n";
+    oss << indent() << "constexpr uint32_t carch_enum_count(component_id) noexcept { return " << components.size()
+        << "; }\n";
+    oss << indent() << "using component_set = carch::EnumSet<component_id, " << components.size() << ">;\n";
+    oss << indent() << "using archetype_world = carch::ArchetypeWorld<entity_id, component_id";
+    for (const auto& component : components) {
+        oss << ", " << component;
+    }
+    oss << ">;\n\n";
+    return oss.str();
+}
+
+bool CppGenerator::generational_entity_ids() const {
+    if (!options_.use_strong_entity_id || options_.entity_id_typedef.rfind("carch::Entity", 0) != 0) {
+        return false;
+    }
+    // Schemas without ref<entity> need neither the handle nor its runtime
+    // header, unless the archetype storage, component pools or double
+    // buffers key by it
+    if (options_.archetypes || has_annotated_fields("pooled") || has_annotated_fields("cold")) {
+        return true;
+    }
+    for (const auto& def : ir_->definitions) {
+        if (def.double_buffered) {
+            return true;
+        }
+    }
+    for (const auto& type : ir_->types) {
+        if (type.kind == semantic::TypeKind::REF) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string CppGenerator::generate_entity_declarations() {
+    // Generational handles come with an allocator whose alive() check
+    // validates a ref<entity> with one array load
+    std::ostringstream oss;
+    if (generational_entity_ids()) {
+        add_include("\"carch/entity.h\"");
+        oss << indent() << "using entity_id = " << options_.entity_id_typedef << ";\n";
+        oss << indent() << "using entity_allocator = carch::EntityAllocator<entity_id>;\n";
+    } else if (options_.entity_id_typedef.rfind("carch::Entity", 0) != 0) {
+        add_include("<cstdint>");
+        oss << indent() << "using entity_id = " << options_.entity_id_typedef << ";\n";
+    }
+    if (has_component_pools()) {
+        add_include("\"carch/component_pool.h\"");
+        if (has_annotated_fields("indexed")) {
+            oss << indent() << "using reverse_index = carch::ReverseIndex<entity_id>;\n";
+        }
+        oss << indent() << "template <typename T>\n";
+        oss << indent() << "using component_pool = carch::ComponentPool<T, entity_id>;\n";
+    }
+    return oss.str();
+}
+
+void CppGenerator::reset_generation_state(bool split_units) {
+    hoisted_types_.str("");
+    hoisted_types_.clear();
+    generated_includes_.clear();
+    anonymous_type_counter_ = 0;
+    template_depth_ = 0;
+    split_units_ = split_units;
+    anonymous_struct_names_.clear();
+    shape_units_.clear();
+    shape_unit_names_.clear();
+    used_shapes_.clear();
+    layout_checks_.clear();
+    
+    if (!layout_) {
+        semantic::TargetAbi abi = semantic::TargetAbi::x86_64_sysv();
+        const std::string& id_type = options_.entity_id_typedef;
+        if (id_type == "uint32_t" || id_type == "int32_t" || id_type == "carch::Entity32") {
+            abi.entity_id_size = 4;
+        } else if (id_type == "uint16_t" || id_type == "int16_t") {
+            abi.entity_id_size = 2;
+        }
+        layout_ = std::make_unique<semantic::LayoutEngine>(*ir_, abi, options_.optimize_layout,
+                                                           options_.map_backend, options_.optional_backend);
+    }
+    
+    // Reserve the names of everything the schema itself defines
+    reserved_names_.clear();
+    for (const auto& def : ir_->definitions) {
+        std::string type_name = to_pascal_case(def.name);
+        reserved_names_.insert(type_name);
+        const semantic::Type& type = ir_->type(def.type);
+        if (type.kind == semantic::TypeKind::VARIANT) {
+            for (uint32_t i = 0; i < type.count; ++i) {
+                reserved_names_.insert(type_name + "_" + to_pascal_case(ir_->fields_of(def.type)[i].name));
+            }
+        } else if (type.kind == semantic::TypeKind::FLAGS) {
+            reserved_names_.insert(type_name + "_Flag");
+        }
+    }
+}
+
+std::string CppGenerator::unique_type_name(const std::string& base) {
+    std::string name = base;
+    int suffix = 2;
+    while (reserved_names_.count(name) > 0) {
+        name = base + std::to_string(suffix++);
+    }
+    reserved_names_.insert(name);
+    return name;
+}
+
+std::string CppGenerator::indent() {
+    return std::string(current_indent_ * options_.indentation_size, ' ');
 }
 
 void CppGenerator::increase_indent() {
@@ -324,12 +1671,16 @@ std::string CppGenerator::to_screaming_snake_case(const std::string& name) {
     return result;
 }
 
-std::string CppGenerator::generate_header_guard_name() {
+std::string CppGenerator::generate_header_guard_name(const std::string& suffix) {
     std::string guard = "CARCH_";
     if (!options_.namespace_name.empty()) {
         guard += to_screaming_snake_case(options_.namespace_name) + "_";
     }
-    guard += to_screaming_snake_case(options_.output_basename) + "_H";
+    guard += to_screaming_snake_case(options_.output_basename);
+    if (!suffix.empty()) {
+        guard += "_" + to_screaming_snake_case(suffix);
+    }
+    guard += "_H";
     
     // Replace non-alphanumerics with underscore
     for (char& c : guard) {
@@ -342,31 +1693,107 @@ std::string CppGenerator::generate_header_guard_name() {
 
 std::string CppGenerator::map_enum_type(parser::EnumTypeNode* node, const std::string& context) {
     // Generate a unique name for this anonymous enum
-    std::string enum_name;
+    std::string base_name;
     if (!context.empty()) {
-        enum_name = to_pascal_case(context) + "_Enum";
+        base_name = to_pascal_case(context);
     } else {
-        enum_name = "AnonymousEnum" + std::to_string(anonymous_type_counter_++);
+        base_name = (node->flags ? "AnonymousFlags" : "AnonymousEnum") + std::to_string(anonymous_type_counter_++);
     }
     
-    // Hoist the enum definition
-    hoisted_types_ << indent() << "enum class " << enum_name << " {\n";
-    increase_indent();
-    for (size_t i = 0; i < node->values.size(); ++i) {
-        hoisted_types_ << indent() << node->values[i];
-        if (i < node->values.size() - 1) {
-            hoisted_types_ << ",";
-        }
-        hoisted_types_ << "\n";
+    // Hoist the enum definition at namespace scope
+    int saved_indent = current_indent_;
+    current_indent_ = 0;
+    std::string type_name;
+    if (node->flags) {
+        type_name = context.empty() ? base_name : base_name + "_Flags";
+        hoisted_types_ << generate_flags(type_name, base_name + "_Flag", node) << "\n";
+    } else {
+        type_name = context.empty() ? base_name : base_name + "_Enum";
+        hoisted_types_ << generate_enum_class(type_name, node) << "\n";
     }
-    decrease_indent();
-    hoisted_types_ << indent() << "};\n\n";
+    current_indent_ = saved_indent;
     
-    return enum_name;
+    return type_name;
+}
+
+std::string CppGenerator::module_name(const std::string& partition) {
+    std::string name;
+    if (!options_.namespace_name.empty()) {
+        name += options_.namespace_name + ".";
+    }
+    name += options_.output_basename;
+    if (!partition.empty()) {
+        name += "." + partition;
+    }
+    
+    // Module names are dotted identifiers
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.') {
+            c = '_';
+        }
+    }
+    return name;
+}
+
+std::string CppGenerator::forward_header_path() {
+    return options_.output_basename + "_fwd.h";
+}
+
+std::string CppGenerator::definition_header_path(parser::TypeDefinitionNode* def) {
+    return unit_path(to_pascal_case(def->name), ".h");
+}
+
+std::string CppGenerator::unit_path(const std::string& name, const std::string& extension) {
+    return options_.output_basename + "/" + name + extension;
+}
+
+void CppGenerator::collect_dependencies(semantic::TypeId type, std::set<std::string>& deps) {
+    if (type == semantic::INVALID_ID) {
+        return;
+    }
+    std::set<semantic::DefinitionId> ids;
+    ir_->collect_dependencies(type, ids);
+    for (semantic::DefinitionId id : ids) {
+        deps.insert(to_pascal_case(ir_->definitions[id].name));
+    }
 }
 
 void CppGenerator::add_include(const std::string& include) {
     generated_includes_.insert(include);
+    if (include.rfind("\"carch/", 0) == 0) {
+        runtime_headers_.insert(include.substr(1, include.size() - 2));
+    }
+}
+
+std::vector<GeneratedFile> CppGenerator::generate_runtime_headers() {
+    // Runtime headers may include each other, so follow their includes
+    std::set<std::string> pending = runtime_headers_;
+    std::set<std::string> done;
+    std::vector<GeneratedFile> files;
+    while (!pending.empty()) {
+        std::string path = *pending.begin();
+        pending.erase(pending.begin());
+        if (!done.insert(path).second) {
+            continue;
+        }
+        for (size_t i = 0; i < RUNTIME_HEADER_COUNT; ++i) {
+            if (path != RUNTIME_HEADERS[i].path) continue;
+            std::string content = RUNTIME_HEADERS[i].content;
+            files.push_back({path, content});
+            
+            const std::string directive = "#include \"carch/";
+            for (size_t pos = content.find(directive); pos != std::string::npos;
+                 pos = content.find(directive, pos + 1)) {
+                size_t start = pos + directive.size() - std::strlen("carch/");
+                size_t end = content.find('"', start);
+                pending.insert(content.substr(start, end - start));
+            }
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const GeneratedFile& a, const GeneratedFile& b) {
+        return a.path < b.path;
+    });
+    return files;
 }
 
 } // namespace codegen
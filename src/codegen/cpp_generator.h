@@ -1,70 +1,207 @@
 #pragma once
 
 #include "../parser/ast.h"
+#include "../semantic/schema_ir.h"
+#include "../semantic/layout.h"
 #include <string>
 #include <sstream>
 #include <unordered_set>
+#include <unordered_map>
 #include <memory>
+#include <set>
+#include <vector>
 
 namespace carch {
 namespace codegen {
 
+enum class OutputKind {
+    HEADER,     // Textual headers (.h)
+    MODULE      // C++20 module interface units (.cppm)
+};
+
 struct GenerationOptions {
     std::string namespace_name = "game";
     std::string output_basename = "generated";
     bool generate_serialization = false;
     bool generate_reflection = false;
     bool use_strong_entity_id = true;
-    std::string entity_id_typedef = "uint64_t";
+    // carch::Entity64 or carch::Entity32 for generational handles, or a plain integer type
+    std::string entity_id_typedef = "carch::Entity64";
     int indentation_size = 4;
+    bool split_output = false;          // One header per definition plus fwd/umbrella headers
+    OutputKind output_kind = OutputKind::HEADER;
+    bool optimize_layout = false;       // Reorder struct fields to minimize padding
+    bool layout_asserts = true;         // static_assert the size and alignment of generated types
+    semantic::MapBackend map_backend = semantic::MapBackend::STD;   // For maps without @map
+    semantic::OptionalBackend optional_backend = semantic::OptionalBackend::STD;    // For optionals without @optional
+    semantic::VariantBackend variant_backend = semantic::VariantBackend::STD;   // For variants without @variant
+    bool archetypes = false;            // Declare a carch::ArchetypeWorld over every struct and variant definition
+};
+
+// A generated file, with its path relative to the output directory
+struct GeneratedFile {
+    std::string path;
+    std::string content;
 };
 
 class CppGenerator {
 public:
-    explicit CppGenerator(parser::SchemaNode* schema, const GenerationOptions& options = GenerationOptions{});
+    // Uses the checker's IR when given one, otherwise lowers the schema itself
+    explicit CppGenerator(parser::SchemaNode* schema, const GenerationOptions& options = GenerationOptions{},
+                          const semantic::SchemaIR* ir = nullptr);
     
     // Generate C++ header file
     std::string generate_header();
     
     // Generate C++ source file (if needed for implementations)
     std::string generate_source();
+    
+    // Generate forward declarations for every definition (<stem>_fwd.h)
+    std::string generate_forward_header();
+    
+    // Generate one header per top-level definition, a forward-declaration
+    // header and an umbrella header that includes everything
+    std::vector<GeneratedFile> generate_split_headers();
+    
+    // Generate a C++20 module interface unit exporting every type
+    // (export module <namespace>.<stem>;)
+    std::string generate_module();
+    
+    // Generate one module per definition, importing its dependencies,
+    // plus an umbrella module that re-exports all of them
+    std::vector<GeneratedFile> generate_split_modules();
+    
+    // Runtime headers (carch/*.h) included by everything generated so far,
+    // to be written to the output directory alongside it
+    std::vector<GeneratedFile> generate_runtime_headers();
 
 private:
     parser::SchemaNode* schema_;
     GenerationOptions options_;
+    std::unique_ptr<semantic::SchemaIR> owned_ir_;
+    const semantic::SchemaIR* ir_;
     int current_indent_;
-    std::unordered_set<std::string> generated_includes_;
+    std::set<std::string> generated_includes_;  // Filled while mapping types
+    std::set<std::string> runtime_headers_;     // Runtime headers used by any generated file
     
     // Generation methods
     std::string generate_includes();
     std::string generate_namespace_open();
     std::string generate_namespace_close();
+    std::string generate_export_open();
+    std::string generate_export_close();
+    std::string generate_types();
     std::string generate_type_definition(parser::TypeDefinitionNode* def);
     std::string generate_struct(const std::string& name, parser::StructTypeNode* node);
     std::string generate_variant(const std::string& name, parser::VariantTypeNode* node);
+    std::string generate_variant_storage(parser::TypeDefinitionNode* def, parser::VariantTypeNode* node);
+    std::string generate_double_buffer(parser::TypeDefinitionNode* def);
+    std::string generate_tagged_variant(const std::string& type_name, parser::VariantTypeNode* node);
+    semantic::VariantBackend variant_backend_of(semantic::TypeId type_id) const;
     std::string generate_enum(const std::string& name, parser::EnumTypeNode* node);
+    std::string generate_enum_class(const std::string& enum_name, parser::EnumTypeNode* node);
+    std::string generate_flags(const std::string& set_name, const std::string& enum_name, parser::EnumTypeNode* node);
     std::string generate_field(parser::FieldNode* field);
+    std::string generate_named_struct(const std::string& type_name, parser::StructTypeNode* node);
+    std::string generate_umbrella_header();
+    std::string generate_field_visitor(parser::StructTypeNode* node, bool cold = false);
+    std::string generate_layout_checks();
+    std::string generate_type_traits();
+    std::string generate_entity_declarations();
+    bool generational_entity_ids() const;
+    
+    // @indexed ref<entity> and @pooled array fields: (enumerator, member
+    // access) pairs, and the carch_visit_refs and carch_visit_spans
+    // functions the component pools use to walk them
+    using AnnotatedFields = std::vector<std::pair<std::string, std::string>>;
+    void collect_annotated_fields(parser::StructTypeNode* node, const char* annotation, const std::string& access,
+                                  const std::string& prefix, AnnotatedFields& fields) const;
+    // Fields of a definition grouped by the variant alternative holding
+    // them; the alternative type is empty for struct definitions
+    std::vector<std::pair<std::string, AnnotatedFields>> annotated_fields(parser::TypeDefinitionNode* def,
+                                                                          const char* annotation) const;
+    bool has_annotated_fields(const char* annotation) const;
+    bool has_component_pools();
+    std::string generate_alternative_guard(parser::TypeDefinitionNode* def, const std::string& alt_type_name);
+    std::string generate_ref_visitor(parser::TypeDefinitionNode* def);
+    std::string generate_span_visitor(parser::TypeDefinitionNode* def);
+    // <Type>_Cold side table and <Type>_View facade for @cold fields
+    std::string generate_cold_fields(parser::TypeDefinitionNode* def, parser::StructTypeNode* node);
+    
+    // component_id enum and archetype_world alias (--archetypes)
+    std::string generate_archetype_declarations();
+    
+    // A unit of split output: one definition, or one shared anonymous shape
+    struct GeneratedUnit {
+        std::string name;                       // C++ type name, also the file stem
+        std::string text;                       // Hoisted types followed by the type itself
+        std::set<std::string> includes;         // Standard headers it needs
+        std::set<std::string> dependencies;     // Other units it names
+    };
+    std::vector<GeneratedUnit> generate_units();
+    std::string generate_unit_header(const GeneratedUnit& unit);
+    std::string generate_unit_module(const GeneratedUnit& unit);
     
     std::string map_type(parser::TypeExprNode* expr, const std::string& context = "");
-    std::string map_primitive_type(parser::PrimitiveType type);
+    std::string map_primitive_type(const parser::PrimitiveTypeNode* node);
     std::string map_container_type(parser::ContainerTypeNode* node, const std::string& context = "");
-    std::string map_struct_type(parser::StructTypeNode* node);
-    std::string map_variant_type(parser::VariantTypeNode* node);
+    std::string map_struct_type(parser::StructTypeNode* node, const std::string& context = "");
+    std::string map_variant_type(parser::VariantTypeNode* node, const std::string& context = "");
     std::string map_enum_type(parser::EnumTypeNode* node, const std::string& context);
+    static std::string unsigned_type(uint32_t size);     // uint8_t for 1, ..., uint64_t for 8
+    
+    // Niche policy a carch::CompactOptional of element uses for "none"
+    std::string niche_type(semantic::TypeId element, const std::string& element_type);
     
     // Track and emit anonymous enums as named types
     std::ostringstream hoisted_types_;
     int anonymous_type_counter_ = 0;
     
+    // Structural hash-consing of anonymous structs: a shape that occurs more
+    // than once, or inside a template argument, is hoisted once as a named
+    // type keyed by its IR type and reused by every occurrence
+    std::unordered_map<semantic::TypeId, std::string> anonymous_struct_names_;
+    std::unordered_set<std::string> reserved_names_;
+    int template_depth_ = 0;
+    
+    // Split output: shared shapes become units of their own
+    bool split_units_ = false;
+    std::vector<GeneratedUnit> shape_units_;
+    std::unordered_set<std::string> shape_unit_names_;
+    std::set<std::string> used_shapes_;     // Shape units named by the unit being generated
+    
+    // Layout of every IR type, and the types generated so far whose layout
+    // is checked with static_assert
+    struct LayoutCheck {
+        std::string name;
+        semantic::TypeId type;
+        bool cold = false;      // The side table of the type's @cold fields
+    };
+    std::unique_ptr<semantic::LayoutEngine> layout_;
+    std::vector<LayoutCheck> layout_checks_;
+    std::vector<uint32_t> field_order(parser::StructTypeNode* node);
+    std::string field_declaration(parser::StructTypeNode* node, uint32_t index, const std::string& type,
+                                  const std::string& separator);
+    
+    void reset_generation_state(bool split_units);
+    std::string unique_type_name(const std::string& base);
+    
     // Utilities
     std::string indent();
     void increase_indent();
     void decrease_indent();
     void add_include(const std::string& include);
     std::string sanitize_name(const std::string& name);
-    std::string to_pascal_case(const std::string& name);
+    static std::string to_pascal_case(const std::string& name);
     std::string to_screaming_snake_case(const std::string& name);
-    std::string generate_header_guard_name();
+    std::string generate_header_guard_name(const std::string& suffix = "");
+    
+    // Split output helpers
+    std::string module_name(const std::string& partition = "");
+    std::string forward_header_path();
+    std::string definition_header_path(parser::TypeDefinitionNode* def);
+    std::string unit_path(const std::string& name, const std::string& extension);
+    void collect_dependencies(semantic::TypeId type, std::set<std::string>& deps);
 };
 
 } // namespace codegen
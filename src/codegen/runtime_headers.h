@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+namespace carch {
+namespace codegen {
+
+// A header of the Carch runtime (runtime/carch), embedded in the compiler
+// at build time so it can be written out next to generated code
+struct RuntimeHeader {
+    const char* path;       // Include path, e.g. "carch/small_array.h"
+    const char* content;
+};
+
+extern const RuntimeHeader RUNTIME_HEADERS[];
+extern const size_t RUNTIME_HEADER_COUNT;
+
+} // namespace codegen
+} // namespace carch
@@ -96,6 +96,7 @@ Token Lexer::scan_token() {
     if (c == '>') { advance(); return Token(TokenType::RANGLE, ">", token_line, token_column); }
     if (c == '(') { advance(); return Token(TokenType::LPAREN, "(", token_line, token_column); }
     if (c == ')') { advance(); return Token(TokenType::RPAREN, ")", token_line, token_column); }
+    if (c == '@') { advance(); return Token(TokenType::AT, "@", token_line, token_column); }
     
     // String literals
     if (c == '"') {
@@ -339,11 +340,13 @@ TokenType Lexer::identify_keyword(const std::string& word) const {
         {"enum", TokenType::ENUM},
         {"unit", TokenType::UNIT},
         {"array", TokenType::ARRAY},
+        {"small_array", TokenType::SMALL_ARRAY},
         {"map", TokenType::MAP},
         {"optional", TokenType::OPTIONAL},
         {"ref", TokenType::REF},
         {"entity", TokenType::ENTITY},
         {"str", TokenType::STR},
+        {"istr", TokenType::ISTR},
         {"int", TokenType::INT},
         {"u8", TokenType::U8},
         {"u16", TokenType::U16},
@@ -356,6 +359,19 @@ TokenType Lexer::identify_keyword(const std::string& word) const {
         {"f32", TokenType::F32},
         {"f64", TokenType::F64},
         {"bool", TokenType::BOOL},
+        {"vec2", TokenType::VEC2},
+        {"vec3", TokenType::VEC3},
+        {"vec4", TokenType::VEC4},
+        {"quat", TokenType::QUAT},
+        {"ivec2", TokenType::IVEC2},
+        {"ivec3", TokenType::IVEC3},
+        {"ivec4", TokenType::IVEC4},
+        {"f16", TokenType::F16},
+        {"unorm8", TokenType::UNORM8},
+        {"unorm16", TokenType::UNORM16},
+        {"snorm8", TokenType::SNORM8},
+        {"snorm16", TokenType::SNORM16},
+        {"quant", TokenType::QUANT},
         {"true", TokenType::TRUE},
         {"false", TokenType::FALSE}
     };
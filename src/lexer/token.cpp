@@ -9,6 +9,7 @@ bool Token::is_keyword() const {
            type == TokenType::ENUM ||
            type == TokenType::UNIT ||
            type == TokenType::ARRAY ||
+           type == TokenType::SMALL_ARRAY ||
            type == TokenType::MAP ||
            type == TokenType::OPTIONAL ||
            type == TokenType::REF ||
@@ -17,13 +18,22 @@ bool Token::is_keyword() const {
 
 bool Token::is_primitive_type() const {
     return type == TokenType::STR ||
+           type == TokenType::ISTR ||
            type == TokenType::INT ||
            type == TokenType::BOOL ||
            type == TokenType::U8 || type == TokenType::U16 ||
            type == TokenType::U32 || type == TokenType::U64 ||
            type == TokenType::I8 || type == TokenType::I16 ||
            type == TokenType::I32 || type == TokenType::I64 ||
-           type == TokenType::F32 || type == TokenType::F64;
+           type == TokenType::F32 || type == TokenType::F64 ||
+           type == TokenType::VEC2 || type == TokenType::VEC3 ||
+           type == TokenType::VEC4 || type == TokenType::QUAT ||
+           type == TokenType::IVEC2 || type == TokenType::IVEC3 ||
+           type == TokenType::IVEC4 ||
+           type == TokenType::F16 ||
+           type == TokenType::UNORM8 || type == TokenType::UNORM16 ||
+           type == TokenType::SNORM8 || type == TokenType::SNORM16 ||
+           type == TokenType::QUANT;
 }
 
 bool Token::is_symbol() const {
@@ -34,7 +44,8 @@ bool Token::is_symbol() const {
            type == TokenType::LANGLE ||
            type == TokenType::RANGLE ||
            type == TokenType::LPAREN ||
-           type == TokenType::RPAREN;
+           type == TokenType::RPAREN ||
+           type == TokenType::AT;
 }
 
 bool Token::is_literal() const {
@@ -60,11 +71,13 @@ const char* token_type_to_string(TokenType type) {
         case TokenType::ENUM: return "ENUM";
         case TokenType::UNIT: return "UNIT";
         case TokenType::ARRAY: return "ARRAY";
+        case TokenType::SMALL_ARRAY: return "SMALL_ARRAY";
         case TokenType::MAP: return "MAP";
         case TokenType::OPTIONAL: return "OPTIONAL";
         case TokenType::REF: return "REF";
         case TokenType::ENTITY: return "ENTITY";
         case TokenType::STR: return "STR";
+        case TokenType::ISTR: return "ISTR";
         case TokenType::INT: return "INT";
         case TokenType::U8: return "U8";
         case TokenType::U16: return "U16";
@@ -77,6 +90,19 @@ const char* token_type_to_string(TokenType type) {
         case TokenType::F32: return "F32";
         case TokenType::F64: return "F64";
         case TokenType::BOOL: return "BOOL";
+        case TokenType::VEC2: return "VEC2";
+        case TokenType::VEC3: return "VEC3";
+        case TokenType::VEC4: return "VEC4";
+        case TokenType::QUAT: return "QUAT";
+        case TokenType::IVEC2: return "IVEC2";
+        case TokenType::IVEC3: return "IVEC3";
+        case TokenType::IVEC4: return "IVEC4";
+        case TokenType::F16: return "F16";
+        case TokenType::UNORM8: return "UNORM8";
+        case TokenType::UNORM16: return "UNORM16";
+        case TokenType::SNORM8: return "SNORM8";
+        case TokenType::SNORM16: return "SNORM16";
+        case TokenType::QUANT: return "QUANT";
         case TokenType::COLON: return "COLON";
         case TokenType::COMMA: return "COMMA";
         case TokenType::LBRACE: return "LBRACE";
@@ -85,6 +111,7 @@ const char* token_type_to_string(TokenType type) {
         case TokenType::RANGLE: return "RANGLE";
         case TokenType::LPAREN: return "LPAREN";
         case TokenType::RPAREN: return "RPAREN";
+        case TokenType::AT: return "AT";
         case TokenType::IDENTIFIER: return "IDENTIFIER";
         case TokenType::STRING_LITERAL: return "STRING_LITERAL";
         case TokenType::NUMBER_LITERAL: return "NUMBER_LITERAL";
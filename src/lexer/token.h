@@ -15,6 +15,7 @@ enum class TokenType {
     
     // Container types
     ARRAY,
+    SMALL_ARRAY,
     MAP,
     OPTIONAL,
     REF,
@@ -22,11 +23,17 @@ enum class TokenType {
     
     // Primitive types
     STR,
+    ISTR,
     INT,
     U8, U16, U32, U64,
     I8, I16, I32, I64,
     F32, F64,
     BOOL,
+    VEC2, VEC3, VEC4, QUAT,
+    IVEC2, IVEC3, IVEC4,
+    F16,
+    UNORM8, UNORM16, SNORM8, SNORM16,
+    QUANT,
     
     // Symbols
     COLON,          // :
@@ -37,6 +44,7 @@ enum class TokenType {
     RANGLE,         // >
     LPAREN,         // (
     RPAREN,         // )
+    AT,             // @
     
     // Identifiers and literals
     IDENTIFIER,
@@ -1,6 +1,7 @@
 #include "lexer/lexer.h"
 #include "parser/parser.h"
 #include "semantic/type_checker.h"
+#include "semantic/layout.h"
 #include "codegen/cpp_generator.h"
 #include <iostream>
 #include <fstream>
@@ -15,6 +16,18 @@ struct CommandLineArgs {
     std::string output_dir = "generated";
     std::string namespace_name = "game";
     bool verbose = false;
+    bool split_output = false;
+    bool emit_module = false;
+    bool optimize_layout = false;
+    bool layout_asserts = true;
+    carch::semantic::MapBackend map_backend = carch::semantic::MapBackend::STD;
+    carch::semantic::OptionalBackend optional_backend = carch::semantic::OptionalBackend::STD;
+    carch::semantic::VariantBackend variant_backend = carch::semantic::VariantBackend::STD;
+    std::string entity_id_typedef = "carch::Entity64";
+    uint32_t entity_id_size = 8;
+    bool archetypes = false;
+    bool layout_report = false;
+    carch::semantic::ReportFormat report_format = carch::semantic::ReportFormat::TABLE;
     bool help = false;
     bool version = false;
 };
@@ -25,12 +38,25 @@ void print_help() {
     std::cout << "Options:\n";
     std::cout << "  -o, --output <dir>      Output directory (default: generated)\n";
     std::cout << "  -n, --namespace <name>  C++ namespace (default: game)\n";
+    std::cout << "  --split                 Emit one header per definition plus fwd/umbrella headers\n";
+    std::cout << "  --emit=<kind>           Output kind: header (default) or module (C++20 .cppm)\n";
+    std::cout << "  --optimize-layout       Reorder struct fields to minimize padding\n";
+    std::cout << "  --no-layout-asserts     Do not static_assert generated type sizes\n";
+    std::cout << "  --map=<backend>         Container for map<K, V>: std (default), flat or sorted\n";
+    std::cout << "  --optional=<backend>    Type for optional<T>: std (default) or compact where T has a spare value\n";
+    std::cout << "  --variant=<backend>     Type for variant definitions: std (default) or tagged\n";
+    std::cout << "  --entity=<handle>       Type of ref<entity>: entity64 (default) or entity32 generational handles, u64 or u32\n";
+    std::cout << "  --archetypes            Declare archetype_world, chunked SoA storage over every struct and variant\n";
+    std::cout << "  --layout-report[=json]  Print type sizes, padding and heap members instead of generating code\n";
     std::cout << "  -v, --verbose           Verbose output\n";
     std::cout << "  -h, --help              Show this help message\n";
     std::cout << "  --version               Show version information\n\n";
     std::cout << "Examples:\n";
     std::cout << "  carch schema.carch\n";
     std::cout << "  carch -o output/ -n mygame schema.carch\n";
+    std::cout << "  carch --split -o output/ schema.carch\n";
+    std::cout << "  carch --emit=module -o output/ schema.carch\n";
+    std::cout << "  carch --layout-report schema.carch\n";
     std::cout << "  carch *.carch\n";
 }
 
@@ -52,6 +78,67 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
             args.version = true;
         } else if (arg == "-v" || arg == "--verbose") {
             args.verbose = true;
+        } else if (arg == "--split") {
+            args.split_output = true;
+        } else if (arg == "--optimize-layout") {
+            args.optimize_layout = true;
+        } else if (arg == "--archetypes") {
+            args.archetypes = true;
+        } else if (arg == "--no-layout-asserts") {
+            args.layout_asserts = false;
+        } else if (arg == "--layout-report" || arg == "--layout-report=table") {
+            args.layout_report = true;
+            args.report_format = carch::semantic::ReportFormat::TABLE;
+        } else if (arg == "--layout-report=json") {
+            args.layout_report = true;
+            args.report_format = carch::semantic::ReportFormat::JSON;
+        } else if (arg.rfind("--emit=", 0) == 0) {
+            std::string kind = arg.substr(7);
+            if (kind == "module") {
+                args.emit_module = true;
+            } else if (kind == "header") {
+                args.emit_module = false;
+            } else {
+                std::cerr << "Error: unknown output kind '" << kind << "' (expected header or module)\n";
+                args.help = true;
+            }
+        } else if (arg.rfind("--map=", 0) == 0) {
+            std::string backend = arg.substr(6);
+            if (!carch::semantic::parse_map_backend(backend, args.map_backend)) {
+                std::cerr << "Error: unknown map backend '" << backend << "' (expected std, flat or sorted)\n";
+                args.help = true;
+            }
+        } else if (arg.rfind("--optional=", 0) == 0) {
+            std::string backend = arg.substr(11);
+            if (!carch::semantic::parse_optional_backend(backend, args.optional_backend)) {
+                std::cerr << "Error: unknown optional backend '" << backend << "' (expected std or compact)\n";
+                args.help = true;
+            }
+        } else if (arg.rfind("--variant=", 0) == 0) {
+            std::string backend = arg.substr(10);
+            if (!carch::semantic::parse_variant_backend(backend, args.variant_backend)) {
+                std::cerr << "Error: unknown variant backend '" << backend << "' (expected std or tagged)\n";
+                args.help = true;
+            }
+        } else if (arg.rfind("--entity=", 0) == 0) {
+            std::string handle = arg.substr(9);
+            if (handle == "entity64") {
+                args.entity_id_typedef = "carch::Entity64";
+                args.entity_id_size = 8;
+            } else if (handle == "entity32") {
+                args.entity_id_typedef = "carch::Entity32";
+                args.entity_id_size = 4;
+            } else if (handle == "u64") {
+                args.entity_id_typedef = "uint64_t";
+                args.entity_id_size = 8;
+            } else if (handle == "u32") {
+                args.entity_id_typedef = "uint32_t";
+                args.entity_id_size = 4;
+            } else {
+                std::cerr << "Error: unknown entity handle '" << handle
+                          << "' (expected entity64, entity32, u64 or u32)\n";
+                args.help = true;
+            }
         } else if (arg == "-o" || arg == "--output") {
             if (i + 1 < argc) {
                 args.output_dir = argv[++i];
@@ -74,6 +161,11 @@ CommandLineArgs parse_args(int argc, char* argv[]) {
         }
     }
     
+    if (args.archetypes && args.entity_id_typedef.rfind("carch::Entity", 0) != 0) {
+        std::cerr << "Error: --archetypes needs generational entity handles (--entity=entity64 or entity32)\n";
+        args.help = true;
+    }
+    
     return args;
 }
 
@@ -104,7 +196,8 @@ void write_file(const std::string& path, const std::string& content) {
     file << content;
 }
 
-bool compile_file(const std::string& input_path, const CommandLineArgs& args) {
+bool compile_file(const std::string& input_path, const CommandLineArgs& args,
+                  std::vector<std::string>& reports) {
     if (args.verbose) {
         std::cout << "Compiling: " << input_path << "\n";
     }
@@ -147,6 +240,17 @@ bool compile_file(const std::string& input_path, const CommandLineArgs& args) {
             return false;
         }
         
+        // The layout report is computed from the IR and replaces code generation
+        if (args.layout_report) {
+            carch::semantic::TargetAbi abi = carch::semantic::TargetAbi::x86_64_sysv();
+            abi.entity_id_size = args.entity_id_size;
+            carch::semantic::LayoutEngine layout(checker.ir(), abi, args.optimize_layout, args.map_backend,
+                                                 args.optional_backend);
+            reports.push_back(carch::semantic::format_layout_report(checker.ir(), layout, input_path,
+                                                                    args.report_format));
+            return true;
+        }
+        
         // Code generation
         if (args.verbose) {
             std::cout << "  [4/4] Code generation...\n";
@@ -158,19 +262,47 @@ bool compile_file(const std::string& input_path, const CommandLineArgs& args) {
         carch::codegen::GenerationOptions gen_opts;
         gen_opts.namespace_name = args.namespace_name;
         gen_opts.output_basename = base_name;
-        carch::codegen::CppGenerator generator(schema.get(), gen_opts);
-        std::string header = generator.generate_header();
+        gen_opts.split_output = args.split_output;
+        gen_opts.optimize_layout = args.optimize_layout;
+        gen_opts.layout_asserts = args.layout_asserts;
+        gen_opts.map_backend = args.map_backend;
+        gen_opts.optional_backend = args.optional_backend;
+        gen_opts.variant_backend = args.variant_backend;
+        gen_opts.entity_id_typedef = args.entity_id_typedef;
+        gen_opts.archetypes = args.archetypes;
+        gen_opts.output_kind = args.emit_module ? carch::codegen::OutputKind::MODULE
+                                                : carch::codegen::OutputKind::HEADER;
+        carch::codegen::CppGenerator generator(schema.get(), gen_opts, &checker.ir());
         
-        // Determine output file name
-        std::string output_path = args.output_dir + "/" + base_name + ".h";
+        std::vector<carch::codegen::GeneratedFile> outputs;
+        if (gen_opts.output_kind == carch::codegen::OutputKind::MODULE) {
+            if (gen_opts.split_output) {
+                outputs = generator.generate_split_modules();
+            } else {
+                outputs.push_back({base_name + ".cppm", generator.generate_module()});
+            }
+        } else if (gen_opts.split_output) {
+            outputs = generator.generate_split_headers();
+        } else {
+            outputs.push_back({base_name + ".h", generator.generate_header()});
+            outputs.push_back({base_name + "_fwd.h", generator.generate_forward_header()});
+        }
         
-        // Write output
-        write_file(output_path, header);
+        // Runtime support the generated types need, such as carch/small_array.h
+        for (auto& runtime_header : generator.generate_runtime_headers()) {
+            outputs.push_back(std::move(runtime_header));
+        }
         
-        if (args.verbose) {
-            std::cout << "  Generated: " << output_path << "\n";
-        } else {
-            std::cout << "Generated: " << output_path << "\n";
+        // Write output
+        for (const auto& output : outputs) {
+            std::string output_path = args.output_dir + "/" + output.path;
+            write_file(output_path, output.content);
+            
+            if (args.verbose) {
+                std::cout << "  Generated: " << output_path << "\n";
+            } else {
+                std::cout << "Generated: " << output_path << "\n";
+            }
         }
         
         return true;
@@ -201,11 +333,23 @@ int main(int argc, char* argv[]) {
     }
     
     bool all_success = true;
+    std::vector<std::string> reports;
     for (const auto& input_file : args.input_files) {
-        if (!compile_file(input_file, args)) {
+        if (!compile_file(input_file, args, reports)) {
             all_success = false;
         }
     }
     
+    if (args.layout_report) {
+        // JSON reports form one array so the output stays a single document
+        bool json = args.report_format == carch::semantic::ReportFormat::JSON;
+        if (json) std::cout << "[\n";
+        for (size_t i = 0; i < reports.size(); ++i) {
+            if (i > 0) std::cout << (json ? ",\n" : "\n");
+            std::cout << reports[i];
+        }
+        if (json) std::cout << "\n]\n";
+    }
+    
     return all_success ? 0 : 1;
 }
@@ -9,6 +9,37 @@ static std::string indent_str(int indent) {
     return std::string(indent * 2, ' ');
 }
 
+std::string Annotation::to_string() const {
+    std::ostringstream oss;
+    oss << "@" << name;
+    if (!arguments.empty()) {
+        oss << "(";
+        for (size_t i = 0; i < arguments.size(); ++i) {
+            if (i > 0) oss << ", ";
+            oss << arguments[i];
+        }
+        oss << ")";
+    }
+    return oss.str();
+}
+
+const Annotation* find_annotation(const std::vector<Annotation>& annotations, const std::string& name) {
+    for (const auto& annotation : annotations) {
+        if (annotation.name == name) {
+            return &annotation;
+        }
+    }
+    return nullptr;
+}
+
+static std::string annotations_str(const std::vector<Annotation>& annotations) {
+    std::string result;
+    for (const auto& annotation : annotations) {
+        result += annotation.to_string() + " ";
+    }
+    return result;
+}
+
 std::string SchemaNode::to_string(int indent) const {
     std::ostringstream oss;
     oss << indent_str(indent) << "Schema {\n";
@@ -21,7 +52,7 @@ std::string SchemaNode::to_string(int indent) const {
 
 std::string TypeDefinitionNode::to_string(int indent) const {
     std::ostringstream oss;
-    oss << indent_str(indent) << "TypeDef " << name << " : ";
+    oss << indent_str(indent) << "TypeDef " << annotations_str(annotations) << name << " : ";
     oss << type->to_string(0);
     return oss.str();
 }
@@ -30,7 +61,7 @@ std::string StructTypeNode::to_string(int indent) const {
     std::ostringstream oss;
     oss << "struct {";
     for (size_t i = 0; i < fields.size(); ++i) {
-        oss << " " << fields[i]->name << ": " << fields[i]->type->to_string(0);
+        oss << " " << fields[i]->to_string(0);
         if (i < fields.size() - 1) oss << ",";
     }
     oss << " }";
@@ -53,7 +84,7 @@ std::string VariantTypeNode::to_string(int indent) const {
 
 std::string EnumTypeNode::to_string(int indent) const {
     std::ostringstream oss;
-    oss << "enum {";
+    oss << (flags ? "flags {" : "enum {");
     for (size_t i = 0; i < values.size(); ++i) {
         oss << " " << values[i];
         if (i < values.size() - 1) oss << ",";
@@ -63,7 +94,7 @@ std::string EnumTypeNode::to_string(int indent) const {
 }
 
 std::string FieldNode::to_string(int indent) const {
-    return name + ": " + type->to_string(0);
+    return annotations_str(annotations) + name + ": " + type->to_string(0);
 }
 
 std::string AlternativeNode::to_string(int indent) const {
@@ -76,7 +107,9 @@ std::string AlternativeNode::to_string(int indent) const {
 
 std::string PrimitiveTypeNode::to_string(int indent) const {
     switch (primitive) {
-        case PrimitiveType::STR: return "str";
+        case PrimitiveType::STR:
+            return length > 0 ? "str<" + std::to_string(length) + ">" : "str";
+        case PrimitiveType::ISTR: return "istr";
         case PrimitiveType::INT: return "int";
         case PrimitiveType::BOOL: return "bool";
         case PrimitiveType::UNIT: return "unit";
@@ -90,14 +123,32 @@ std::string PrimitiveTypeNode::to_string(int indent) const {
         case PrimitiveType::I64: return "i64";
         case PrimitiveType::F32: return "f32";
         case PrimitiveType::F64: return "f64";
+        case PrimitiveType::VEC2: return "vec2";
+        case PrimitiveType::VEC3: return "vec3";
+        case PrimitiveType::VEC4: return "vec4";
+        case PrimitiveType::QUAT: return "quat";
+        case PrimitiveType::IVEC2: return "ivec2";
+        case PrimitiveType::IVEC3: return "ivec3";
+        case PrimitiveType::IVEC4: return "ivec4";
+        case PrimitiveType::F16: return "f16";
+        case PrimitiveType::UNORM8: return "unorm8";
+        case PrimitiveType::UNORM16: return "unorm16";
+        case PrimitiveType::SNORM8: return "snorm8";
+        case PrimitiveType::SNORM16: return "snorm16";
+        case PrimitiveType::QUANT:
+            return "quant<" + quant_min + ", " + quant_max + ", " + std::to_string(length) + ">";
         default: return "unknown";
     }
 }
 
 std::string ContainerTypeNode::to_string(int indent) const {
     std::ostringstream oss;
-    if (kind == ContainerKind::ARRAY) {
-        oss << "array<" << element_type->to_string(0) << ">";
+    if (kind == ContainerKind::ARRAY || kind == ContainerKind::SMALL_ARRAY) {
+        oss << (kind == ContainerKind::ARRAY ? "array<" : "small_array<") << element_type->to_string(0);
+        if (length > 0) {
+            oss << ", " << length;
+        }
+        oss << ">";
     } else if (kind == ContainerKind::MAP) {
         oss << "map<" << key_type->to_string(0) << ", " << value_type->to_string(0) << ">";
     } else if (kind == ContainerKind::OPTIONAL) {
@@ -40,6 +40,19 @@ public:
     virtual void visit(IdentifierTypeNode* node) = 0;
 };
 
+// Annotation on a definition or field: @name or @name(arg, ...)
+struct Annotation {
+    std::string name;
+    std::vector<std::string> arguments;
+    uint32_t line = 0;
+    uint32_t column = 0;
+    
+    std::string to_string() const;
+};
+
+// First annotation with the given name, or nullptr
+const Annotation* find_annotation(const std::vector<Annotation>& annotations, const std::string& name);
+
 // Base AST node
 class ASTNode {
 public:
@@ -67,6 +80,7 @@ class TypeDefinitionNode : public ASTNode {
 public:
     std::string name;
     std::unique_ptr<TypeExprNode> type;
+    std::vector<Annotation> annotations;
     
     TypeDefinitionNode(const std::string& n, uint32_t ln, uint32_t col)
         : ASTNode(ln, col), name(n) {}
@@ -101,9 +115,11 @@ public:
 };
 
 // Enum type
+// enum { ... }, or flags { ... } for a set of the values rather than one
 class EnumTypeNode : public TypeExprNode {
 public:
     std::vector<std::string> values;
+    bool flags = false;
     
     EnumTypeNode(uint32_t ln, uint32_t col) : TypeExprNode(ln, col) {}
     void accept(ASTVisitor* visitor) override { visitor->visit(this); }
@@ -115,6 +131,7 @@ class FieldNode : public ASTNode {
 public:
     std::string name;
     std::unique_ptr<TypeExprNode> type;
+    std::vector<Annotation> annotations;
     
     FieldNode(const std::string& n, uint32_t ln, uint32_t col)
         : ASTNode(ln, col), name(n) {}
@@ -136,15 +153,24 @@ public:
 
 // Primitive type
 enum class PrimitiveType {
-    STR, INT, BOOL, UNIT,
+    STR, ISTR, INT, BOOL, UNIT,
     U8, U16, U32, U64,
     I8, I16, I32, I64,
-    F32, F64
+    F32, F64,
+    VEC2, VEC3, VEC4, QUAT,     // f32 lanes
+    IVEC2, IVEC3, IVEC4,        // i32 lanes
+    F16,
+    UNORM8, UNORM16,            // [0, 1] in 8 or 16 bits
+    SNORM8, SNORM16,            // [-1, 1] in 8 or 16 bits
+    QUANT                       // quant<min, max, bits>
 };
 
 class PrimitiveTypeNode : public TypeExprNode {
 public:
     PrimitiveType primitive;
+    uint32_t length = 0;    // str<N> inline capacity in bytes (0 for heap-backed str), quant bits
+    std::string quant_min;  // quant<min, max, bits> bounds as written
+    std::string quant_max;
     
     PrimitiveTypeNode(PrimitiveType p, uint32_t ln, uint32_t col)
         : TypeExprNode(ln, col), primitive(p) {}
@@ -152,9 +178,10 @@ public:
     std::string to_string(int indent = 0) const override;
 };
 
-// Container type (array, map, optional)
+// Container type (array, small_array, map, optional)
 enum class ContainerKind {
     ARRAY,
+    SMALL_ARRAY,
     MAP,
     OPTIONAL
 };
@@ -162,9 +189,10 @@ enum class ContainerKind {
 class ContainerTypeNode : public TypeExprNode {
 public:
     ContainerKind kind;
-    std::unique_ptr<TypeExprNode> element_type;  // For array and optional
+    std::unique_ptr<TypeExprNode> element_type;  // For array, small_array and optional
     std::unique_ptr<TypeExprNode> key_type;      // For map
     std::unique_ptr<TypeExprNode> value_type;    // For map
+    uint32_t length = 0;    // array<T, N> length or small_array<T, N> inline capacity; 0 if not given
     
     ContainerTypeNode(ContainerKind k, uint32_t ln, uint32_t col)
         : TypeExprNode(ln, col), kind(k) {}
@@ -59,7 +59,7 @@ void Parser::synchronize() {
             return;
         }
         
-        if (check(lexer::TokenType::IDENTIFIER)) {
+        if (check(lexer::TokenType::IDENTIFIER) || check(lexer::TokenType::AT)) {
             return;
         }
         
@@ -86,6 +86,8 @@ std::unique_ptr<SchemaNode> Parser::parse_schema() {
 }
 
 std::unique_ptr<TypeDefinitionNode> Parser::parse_type_definition() {
+    auto annotations = parse_annotations();
+    
     if (!check(lexer::TokenType::IDENTIFIER)) {
         report_error("Expected type name");
         return nullptr;
@@ -103,6 +105,7 @@ std::unique_ptr<TypeDefinitionNode> Parser::parse_type_definition() {
     
     auto def = std::make_unique<TypeDefinitionNode>(name_token.lexeme, name_token.line, name_token.column);
     def->type = std::move(type_expr);
+    def->annotations = std::move(annotations);
     
     return def;
 }
@@ -114,16 +117,24 @@ std::unique_ptr<TypeExprNode> Parser::parse_type_expr() {
         return parse_variant_type();
     } else if (check(lexer::TokenType::ENUM)) {
         return parse_enum_type();
-    } else if (check(lexer::TokenType::ARRAY) || check(lexer::TokenType::MAP) || check(lexer::TokenType::OPTIONAL)) {
+    } else if (check(lexer::TokenType::ARRAY) || check(lexer::TokenType::SMALL_ARRAY) ||
+               check(lexer::TokenType::MAP) || check(lexer::TokenType::OPTIONAL)) {
         return parse_container_type();
     } else if (check(lexer::TokenType::REF)) {
         return parse_ref_type();
     } else if (is_primitive_type()) {
         return parse_primitive_type();
     } else if (check(lexer::TokenType::IDENTIFIER)) {
-        auto node = std::make_unique<IdentifierTypeNode>(current_token_.lexeme, current_token_.line, current_token_.column);
+        lexer::Token name = current_token_;
         advance();
-        return node;
+        // 'flags' is only a keyword in front of a brace, so it stays usable as a name
+        if (name.lexeme == "flags" && check(lexer::TokenType::LBRACE)) {
+            auto flags_node = std::make_unique<EnumTypeNode>(name.line, name.column);
+            flags_node->flags = true;
+            parse_enum_values(flags_node.get(), "flags");
+            return flags_node;
+        }
+        return std::make_unique<IdentifierTypeNode>(name.lexeme, name.line, name.column);
     }
     
     report_error("Expected type expression");
@@ -196,20 +207,25 @@ std::unique_ptr<VariantTypeNode> Parser::parse_variant_type() {
 std::unique_ptr<EnumTypeNode> Parser::parse_enum_type() {
     lexer::Token start = current_token_;
     expect(lexer::TokenType::ENUM, "Expected 'enum'");
-    expect(lexer::TokenType::LBRACE, "Expected '{' after 'enum'");
     
     auto enum_node = std::make_unique<EnumTypeNode>(start.line, start.column);
+    parse_enum_values(enum_node.get(), "enum");
+    
+    return enum_node;
+}
+
+void Parser::parse_enum_values(EnumTypeNode* node, const std::string& keyword) {
+    expect(lexer::TokenType::LBRACE, "Expected '{' after '" + keyword + "'");
     
     skip_newlines();
     
-    // Parse enum values
     while (!check(lexer::TokenType::RBRACE) && !check(lexer::TokenType::END_OF_FILE)) {
         if (!check(lexer::TokenType::IDENTIFIER)) {
-            report_error("Expected enum value");
+            report_error("Expected " + keyword + " value");
             break;
         }
         
-        enum_node->values.push_back(current_token_.lexeme);
+        node->values.push_back(current_token_.lexeme);
         advance();
         
         skip_newlines();
@@ -221,12 +237,12 @@ std::unique_ptr<EnumTypeNode> Parser::parse_enum_type() {
         }
     }
     
-    expect(lexer::TokenType::RBRACE, "Expected '}' after enum values");
-    
-    return enum_node;
+    expect(lexer::TokenType::RBRACE, "Expected '}' after " + keyword + " values");
 }
 
 std::unique_ptr<FieldNode> Parser::parse_field() {
+    auto annotations = parse_annotations();
+    
     if (!check(lexer::TokenType::IDENTIFIER)) {
         report_error("Expected field name");
         return nullptr;
@@ -244,6 +260,7 @@ std::unique_ptr<FieldNode> Parser::parse_field() {
     
     auto field = std::make_unique<FieldNode>(name_token.lexeme, name_token.line, name_token.column);
     field->type = std::move(type_expr);
+    field->annotations = std::move(annotations);
     
     return field;
 }
@@ -278,6 +295,23 @@ std::unique_ptr<TypeExprNode> Parser::parse_primitive_type() {
     auto node = std::make_unique<PrimitiveTypeNode>(prim, current_token_.line, current_token_.column);
     advance();
     
+    // str<N> stores up to N bytes inline
+    if (prim == PrimitiveType::STR && match(lexer::TokenType::LANGLE)) {
+        node->length = parse_length();
+        expect(lexer::TokenType::RANGLE, "Expected '>' after str capacity");
+    }
+    
+    // quant<min, max, bits>; the checker validates the bounds
+    if (prim == PrimitiveType::QUANT) {
+        expect(lexer::TokenType::LANGLE, "Expected '<' after 'quant'");
+        node->quant_min = parse_number("quant minimum");
+        expect(lexer::TokenType::COMMA, "Expected ',' after quant minimum");
+        node->quant_max = parse_number("quant maximum");
+        expect(lexer::TokenType::COMMA, "Expected ',' after quant maximum");
+        node->length = parse_length();
+        expect(lexer::TokenType::RANGLE, "Expected '>' after quant bits");
+    }
+    
     return node;
 }
 
@@ -287,6 +321,8 @@ std::unique_ptr<TypeExprNode> Parser::parse_container_type() {
     
     if (match(lexer::TokenType::ARRAY)) {
         kind = ContainerKind::ARRAY;
+    } else if (match(lexer::TokenType::SMALL_ARRAY)) {
+        kind = ContainerKind::SMALL_ARRAY;
     } else if (match(lexer::TokenType::MAP)) {
         kind = ContainerKind::MAP;
     } else if (match(lexer::TokenType::OPTIONAL)) {
@@ -308,11 +344,57 @@ std::unique_ptr<TypeExprNode> Parser::parse_container_type() {
         container->element_type = parse_type_expr();
     }
     
+    // array<T, N> has a fixed length; small_array<T, N> always needs its capacity
+    if (kind == ContainerKind::SMALL_ARRAY) {
+        expect(lexer::TokenType::COMMA, "Expected ',' and inline capacity in small_array");
+        container->length = parse_length();
+    } else if (kind == ContainerKind::ARRAY && match(lexer::TokenType::COMMA)) {
+        container->length = parse_length();
+    }
+    
     expect(lexer::TokenType::RANGLE, "Expected '>' after container type parameter");
     
     return container;
 }
 
+uint32_t Parser::parse_length() {
+    if (!check(lexer::TokenType::NUMBER_LITERAL)) {
+        report_error("Expected a length");
+        return 0;
+    }
+    
+    const std::string& digits = current_token_.lexeme;
+    uint64_t value = 0;
+    bool valid = !digits.empty();
+    for (char c : digits) {
+        if (c < '0' || c > '9') {
+            valid = false;
+            break;
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+        if (value > UINT32_MAX) {
+            valid = false;
+            break;
+        }
+    }
+    if (!valid || value == 0) {
+        report_error("Length must be a positive decimal integer, got '" + digits + "'");
+        value = 0;
+    }
+    advance();
+    return static_cast<uint32_t>(value);
+}
+
+std::string Parser::parse_number(const std::string& what) {
+    if (!check(lexer::TokenType::NUMBER_LITERAL)) {
+        report_error("Expected " + what);
+        return "";
+    }
+    std::string text = current_token_.lexeme;
+    advance();
+    return text;
+}
+
 std::unique_ptr<TypeExprNode> Parser::parse_ref_type() {
     lexer::Token start = current_token_;
     expect(lexer::TokenType::REF, "Expected 'ref'");
@@ -323,11 +405,54 @@ std::unique_ptr<TypeExprNode> Parser::parse_ref_type() {
     return std::make_unique<RefTypeNode>(start.line, start.column);
 }
 
+std::vector<Annotation> Parser::parse_annotations() {
+    std::vector<Annotation> annotations;
+    
+    while (check(lexer::TokenType::AT)) {
+        Annotation annotation;
+        annotation.line = current_token_.line;
+        annotation.column = current_token_.column;
+        advance();
+        
+        // Names may be keywords, as in @map(flat)
+        if (!check(lexer::TokenType::IDENTIFIER) && !current_token_.is_keyword() &&
+            !current_token_.is_primitive_type()) {
+            report_error("Expected annotation name after '@'");
+            return annotations;
+        }
+        annotation.name = current_token_.lexeme;
+        advance();
+        
+        if (match(lexer::TokenType::LPAREN)) {
+            while (!check(lexer::TokenType::RPAREN) && !check(lexer::TokenType::END_OF_FILE)) {
+                if (!check(lexer::TokenType::IDENTIFIER) && !current_token_.is_literal() &&
+                    !current_token_.is_keyword() && !current_token_.is_primitive_type()) {
+                    report_error("Expected annotation argument");
+                    break;
+                }
+                annotation.arguments.push_back(current_token_.lexeme);
+                advance();
+                
+                if (!match(lexer::TokenType::COMMA)) {
+                    break;
+                }
+            }
+            expect(lexer::TokenType::RPAREN, "Expected ')' after annotation arguments");
+        }
+        
+        annotations.push_back(std::move(annotation));
+        skip_newlines();
+    }
+    
+    return annotations;
+}
+
 bool Parser::is_type_start() const {
     return check(lexer::TokenType::STRUCT) ||
            check(lexer::TokenType::VARIANT) ||
            check(lexer::TokenType::ENUM) ||
            check(lexer::TokenType::ARRAY) ||
+           check(lexer::TokenType::SMALL_ARRAY) ||
            check(lexer::TokenType::MAP) ||
            check(lexer::TokenType::OPTIONAL) ||
            check(lexer::TokenType::REF) ||
@@ -337,6 +462,7 @@ bool Parser::is_type_start() const {
 
 bool Parser::is_primitive_type() const {
     return check(lexer::TokenType::STR) ||
+           check(lexer::TokenType::ISTR) ||
            check(lexer::TokenType::INT) ||
            check(lexer::TokenType::BOOL) ||
            check(lexer::TokenType::UNIT) ||
@@ -344,12 +470,21 @@ bool Parser::is_primitive_type() const {
            check(lexer::TokenType::U32) || check(lexer::TokenType::U64) ||
            check(lexer::TokenType::I8) || check(lexer::TokenType::I16) ||
            check(lexer::TokenType::I32) || check(lexer::TokenType::I64) ||
-           check(lexer::TokenType::F32) || check(lexer::TokenType::F64);
+           check(lexer::TokenType::F32) || check(lexer::TokenType::F64) ||
+           check(lexer::TokenType::VEC2) || check(lexer::TokenType::VEC3) ||
+           check(lexer::TokenType::VEC4) || check(lexer::TokenType::QUAT) ||
+           check(lexer::TokenType::IVEC2) || check(lexer::TokenType::IVEC3) ||
+           check(lexer::TokenType::IVEC4) ||
+           check(lexer::TokenType::F16) ||
+           check(lexer::TokenType::UNORM8) || check(lexer::TokenType::UNORM16) ||
+           check(lexer::TokenType::SNORM8) || check(lexer::TokenType::SNORM16) ||
+           check(lexer::TokenType::QUANT);
 }
 
 PrimitiveType Parser::token_to_primitive_type(lexer::TokenType type) const {
     switch (type) {
         case lexer::TokenType::STR: return PrimitiveType::STR;
+        case lexer::TokenType::ISTR: return PrimitiveType::ISTR;
         case lexer::TokenType::INT: return PrimitiveType::INT;
         case lexer::TokenType::BOOL: return PrimitiveType::BOOL;
         case lexer::TokenType::UNIT: return PrimitiveType::UNIT;
@@ -363,6 +498,19 @@ PrimitiveType Parser::token_to_primitive_type(lexer::TokenType type) const {
         case lexer::TokenType::I64: return PrimitiveType::I64;
         case lexer::TokenType::F32: return PrimitiveType::F32;
         case lexer::TokenType::F64: return PrimitiveType::F64;
+        case lexer::TokenType::VEC2: return PrimitiveType::VEC2;
+        case lexer::TokenType::VEC3: return PrimitiveType::VEC3;
+        case lexer::TokenType::VEC4: return PrimitiveType::VEC4;
+        case lexer::TokenType::QUAT: return PrimitiveType::QUAT;
+        case lexer::TokenType::IVEC2: return PrimitiveType::IVEC2;
+        case lexer::TokenType::IVEC3: return PrimitiveType::IVEC3;
+        case lexer::TokenType::IVEC4: return PrimitiveType::IVEC4;
+        case lexer::TokenType::F16: return PrimitiveType::F16;
+        case lexer::TokenType::UNORM8: return PrimitiveType::UNORM8;
+        case lexer::TokenType::UNORM16: return PrimitiveType::UNORM16;
+        case lexer::TokenType::SNORM8: return PrimitiveType::SNORM8;
+        case lexer::TokenType::SNORM16: return PrimitiveType::SNORM16;
+        case lexer::TokenType::QUANT: return PrimitiveType::QUANT;
         default: return PrimitiveType::INT;
     }
 }
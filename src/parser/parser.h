@@ -40,11 +40,15 @@ private:
     std::unique_ptr<StructTypeNode> parse_struct_type();
     std::unique_ptr<VariantTypeNode> parse_variant_type();
     std::unique_ptr<EnumTypeNode> parse_enum_type();
+    void parse_enum_values(EnumTypeNode* node, const std::string& keyword);
     std::unique_ptr<FieldNode> parse_field();
     std::unique_ptr<AlternativeNode> parse_alternative();
     std::unique_ptr<TypeExprNode> parse_primitive_type();
     std::unique_ptr<TypeExprNode> parse_container_type();
     std::unique_ptr<TypeExprNode> parse_ref_type();
+    std::vector<Annotation> parse_annotations();
+    uint32_t parse_length();
+    std::string parse_number(const std::string& what);
     
     // Helper methods
     bool is_type_start() const;
@@ -0,0 +1,363 @@
+#include "layout.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace carch {
+namespace semantic {
+
+namespace {
+
+uint32_t align_to(uint32_t offset, uint32_t align) {
+    return (offset + align - 1) / align * align;
+}
+
+uint32_t saturate(uint64_t value) {
+    return value > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(value);
+}
+
+std::string json_escape(const std::string& text) {
+    std::string result;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+} // namespace
+
+TargetAbi TargetAbi::x86_64_sysv() {
+    TargetAbi abi;
+    abi.name = "x86-64 System V (libstdc++)";
+    return abi;
+}
+
+LayoutEngine::LayoutEngine(const SchemaIR& ir, const TargetAbi& abi, bool reorder_fields, MapBackend default_map,
+                           OptionalBackend default_optional)
+    : ir_(ir), abi_(abi), reorder_fields_(reorder_fields), default_map_(default_map),
+      default_optional_(default_optional) {
+    layouts_.resize(ir_.types.size());
+    field_orders_.resize(ir_.types.size());
+    cold_layouts_.resize(ir_.types.size(), TypeLayout{0, 1, 0, 0});
+    cold_field_orders_.resize(ir_.types.size());
+    field_offsets_.resize(ir_.fields.size(), 0);
+    state_.assign(ir_.types.size(), 0);
+    for (TypeId id = 0; id < ir_.types.size(); ++id) {
+        compute(id);
+    }
+}
+
+bool LayoutEngine::is_reordered(TypeId id) const {
+    // @cold fields leave gaps, so compare neighbours rather than positions
+    const auto& order = field_orders_[id];
+    for (uint32_t i = 1; i < order.size(); ++i) {
+        if (order[i] < order[i - 1]) return true;
+    }
+    return false;
+}
+
+uint32_t LayoutEngine::cache_lines(const TypeLayout& layout) const {
+    uint32_t size = std::max<uint32_t>(layout.size, 1);
+    return (size + abi_.cache_line_size - 1) / abi_.cache_line_size;
+}
+
+uint32_t LayoutEngine::field_align(uint32_t field) const {
+    const LayoutAttributes& attributes = ir_.fields[field].layout;
+    TypeId type = ir_.fields[field].type;
+    uint32_t align = std::max(type != INVALID_ID ? layouts_[type].align : 1, attributes.align);
+    if (attributes.cacheline) {
+        align = std::max(align, abi_.cache_line_size);
+    }
+    return align;
+}
+
+uint32_t LayoutEngine::field_storage(uint32_t field) const {
+    TypeId type = ir_.fields[field].type;
+    uint32_t size = type != INVALID_ID ? layouts_[type].size : 0;
+    if (ir_.fields[field].layout.cacheline) {
+        size = align_to(size, abi_.cache_line_size);
+    }
+    return size;
+}
+
+uint32_t LayoutEngine::member_align(uint32_t field, bool packed) {
+    compute(ir_.fields[field].type);
+    return packed ? 1 : field_align(field);
+}
+
+TypeLayout LayoutEngine::lay_out_fields(const Type& type, std::vector<uint32_t>& order, bool packed) {
+    if (reorder_fields_) {
+        // Descending alignment leaves padding only at the tail
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return member_align(type.first + a, packed) > member_align(type.first + b, packed);
+        });
+    }
+
+    TypeLayout result;
+    uint32_t offset = 0;
+    uint32_t field_bytes = 0;
+    for (uint32_t index : order) {
+        uint32_t field = type.first + index;
+        const TypeLayout& member = compute(ir_.fields[field].type);
+        uint32_t align = member_align(field, packed);
+        offset = align_to(offset, align);
+        field_offsets_[field] = offset;
+        offset += field_storage(field);
+        field_bytes += member.size;
+        result.align = std::max(result.align, align);
+        result.padding += member.padding;
+        result.heap_members += member.heap_members;
+    }
+    result.size = align_to(std::max<uint32_t>(offset, 1), result.align);
+    result.padding += result.size - field_bytes;
+    return result;
+}
+
+TypeLayout LayoutEngine::primitive_layout(parser::PrimitiveType primitive, uint32_t length) const {
+    switch (primitive) {
+        case parser::PrimitiveType::STR: {
+            if (length == 0) {
+                return {abi_.string_size, abi_.pointer_size, 0, 1};
+            }
+            // carch::FixedString<N>: the smallest length integer, then N bytes
+            uint32_t length_size = length <= UINT8_MAX ? 1 : length <= UINT16_MAX ? 2 : 4;
+            uint32_t size = align_to(length_size + length, length_size);
+            return {size, length_size, size - length_size - length};
+        }
+        case parser::PrimitiveType::ISTR: return {abi_.pointer_size, abi_.pointer_size, 0};
+        // carch::Vec2T is 8-byte aligned, the 3- and 4-lane types 16; vec3 pads a fourth lane
+        case parser::PrimitiveType::VEC2:
+        case parser::PrimitiveType::IVEC2: return {8, 8, 0};
+        case parser::PrimitiveType::VEC3:
+        case parser::PrimitiveType::IVEC3: return {16, 16, 4};
+        case parser::PrimitiveType::VEC4:
+        case parser::PrimitiveType::QUAT:
+        case parser::PrimitiveType::IVEC4: return {16, 16, 0};
+        // Reduced-precision numbers are as large as their stored bits
+        case parser::PrimitiveType::F16:
+        case parser::PrimitiveType::UNORM16:
+        case parser::PrimitiveType::SNORM16: return {2, 2, 0};
+        case parser::PrimitiveType::UNORM8:
+        case parser::PrimitiveType::SNORM8: return {1, 1, 0};
+        case parser::PrimitiveType::QUANT: {
+            uint32_t size = length <= 8 ? 1 : length <= 16 ? 2 : 4;
+            return {size, size, 0};
+        }
+        case parser::PrimitiveType::BOOL:
+        case parser::PrimitiveType::UNIT:
+        case parser::PrimitiveType::U8:
+        case parser::PrimitiveType::I8: return {1, 1, 0};
+        case parser::PrimitiveType::U16:
+        case parser::PrimitiveType::I16: return {2, 2, 0};
+        case parser::PrimitiveType::U64:
+        case parser::PrimitiveType::I64:
+        case parser::PrimitiveType::F64: return {8, 8, 0};
+        default: return {4, 4, 0};
+    }
+}
+
+const TypeLayout& LayoutEngine::compute(TypeId id) {
+    static const TypeLayout unknown{};
+    if (id == INVALID_ID) {
+        return unknown;
+    }
+    if (state_[id] != 0) {
+        return layouts_[id];    // Done, or a cycle in a schema that failed checking
+    }
+    state_[id] = 1;
+
+    const Type& type = ir_.type(id);
+    TypeLayout result;
+    switch (type.kind) {
+        case TypeKind::PRIMITIVE:
+            result = primitive_layout(type.primitive, type.count);
+            break;
+        case TypeKind::ENUM: {
+            uint32_t size = enum_storage_size(type.count);
+            result = {size, size, 0};
+            break;
+        }
+        case TypeKind::FLAGS: {
+            uint32_t size = flags_storage_size(type.count);
+            result = {size, std::min(size, 8u), 0};
+            break;
+        }
+        case TypeKind::REF:
+            result = {abi_.entity_id_size, abi_.entity_id_size, 0};
+            break;
+        case TypeKind::ARRAY:
+            // carch::PoolSpan: 32-bit offset and length
+            result = type.pooled ? TypeLayout{8, 4, 0, 0} : TypeLayout{abi_.vector_size, abi_.pointer_size, 0, 1};
+            break;
+        case TypeKind::MAP: {
+            MapBackend backend = type.map_backend != MapBackend::DEFAULT ? type.map_backend : default_map_;
+            if (backend == MapBackend::FLAT) {
+                // carch::FlatHashMap: entry and control arrays, then 32-bit
+                // size, capacity and growth counters
+                result.align = abi_.pointer_size;
+                result.size = align_to(2 * abi_.pointer_size + 12, abi_.pointer_size);
+                result.padding = result.size - 2 * abi_.pointer_size - 12;
+                result.heap_members = 1;
+            } else if (backend == MapBackend::SORTED) {
+                result = {abi_.vector_size, abi_.pointer_size, 0, 1};
+            } else {
+                result = {abi_.unordered_map_size, abi_.pointer_size, 0, 1};
+            }
+            break;
+        }
+        case TypeKind::FIXED_ARRAY: {
+            const TypeLayout& element = compute(type.element);
+            result.align = element.align;
+            result.size = saturate(uint64_t{element.size} * type.count);
+            result.padding = saturate(uint64_t{element.padding} * type.count);
+            result.heap_members = saturate(uint64_t{element.heap_members} * type.count);
+            break;
+        }
+        case TypeKind::SMALL_ARRAY: {
+            // carch::SmallArray: 32-bit size and capacity, then a union of
+            // the heap pointer and the inline buffer
+            const TypeLayout& element = compute(type.element);
+            uint32_t header = 8;
+            result.align = std::max(element.align, abi_.pointer_size);
+            uint32_t buffer = saturate(uint64_t{element.size} * type.count);
+            uint32_t storage = align_to(std::max(buffer, abi_.pointer_size), result.align);
+            result.size = align_to(header, result.align) + storage;
+            result.padding = result.size - header - buffer +
+                             saturate(uint64_t{element.padding} * type.count);
+            result.heap_members = 1 + saturate(uint64_t{element.heap_members} * type.count);
+            break;
+        }
+        case TypeKind::OPTIONAL: {
+            const TypeLayout& element = compute(type.element);
+            if (ir_.is_compact_optional(id, default_optional_)) {
+                // None is a spare value of the payload itself
+                result = element;
+                break;
+            }
+            // Payload followed by the engaged flag
+            result.align = element.align;
+            result.size = align_to(element.size + 1, element.align);
+            result.padding = result.size - element.size - 1 + element.padding;
+            result.heap_members = element.heap_members;
+            break;
+        }
+        case TypeKind::STRUCT: {
+            // @packed drops member alignment to 1; @align and @cacheline
+            // raise the alignment of a field or of the whole struct
+            LayoutAttributes attributes = ir_.layout_of(id);
+            // @cold fields form a side-table struct of their own, with
+            // offsets relative to it
+            auto& order = field_orders_[id];
+            auto& cold_order = cold_field_orders_[id];
+            for (uint32_t i = 0; i < type.count; ++i) {
+                (ir_.fields[type.first + i].cold ? cold_order : order).push_back(i);
+            }
+            if (!cold_order.empty()) {
+                cold_layouts_[id] = lay_out_fields(type, cold_order, false);
+            }
+
+            result = lay_out_fields(type, order, attributes.packed);
+            uint32_t natural = result.align;
+            result.align = std::max(result.align, attributes.align);
+            if (attributes.cacheline) {
+                result.align = std::max(result.align, abi_.cache_line_size);
+            }
+            if (result.align != natural) {
+                uint32_t size = align_to(result.size, result.align);
+                result.padding += size - result.size;
+                result.size = size;
+            }
+            break;
+        }
+        case TypeKind::VARIANT: {
+            // Storage for the largest alternative followed by the index;
+            // unit alternatives are std::monostate
+            uint32_t storage = 1;
+            for (uint32_t i = 0; i < type.count; ++i) {
+                const TypeLayout& alternative = compute(ir_.fields[type.first + i].type);
+                storage = std::max(storage, alternative.size);
+                result.align = std::max(result.align, alternative.align);
+                result.heap_members += alternative.heap_members;
+            }
+            uint32_t index_size = type.count < 255 ? 1 : 2;
+            storage = align_to(storage, result.align);
+            result.align = std::max(result.align, index_size);
+            result.size = align_to(storage + index_size, result.align);
+            result.padding = result.size - storage - index_size;
+            break;
+        }
+    }
+
+    layouts_[id] = result;
+    state_[id] = 2;
+    return layouts_[id];
+}
+
+std::string format_layout_report(const SchemaIR& ir, const LayoutEngine& engine,
+                                 const std::string& source_name, ReportFormat format) {
+    std::ostringstream oss;
+    
+    if (format == ReportFormat::JSON) {
+        oss << "{\n";
+        oss << "  \"file\": \"" << json_escape(source_name) << "\",\n";
+        oss << "  \"abi\": \"" << json_escape(engine.abi().name) << "\",\n";
+        oss << "  \"cache_line_size\": " << engine.abi().cache_line_size << ",\n";
+        oss << "  \"definitions\": [";
+        for (size_t i = 0; i < ir.definitions.size(); ++i) {
+            const Definition& def = ir.definitions[i];
+            const TypeLayout& layout = engine.layout(def.type);
+            oss << (i == 0 ? "\n" : ",\n");
+            oss << "    {\"name\": \"" << json_escape(def.name) << "\""
+                << ", \"size\": " << layout.size
+                << ", \"align\": " << layout.align
+                << ", \"padding\": " << layout.padding
+                << ", \"cache_lines\": " << engine.cache_lines(def.type)
+                << ", \"heap_members\": " << layout.heap_members;
+            if (ir.has_cold_fields(def.type)) {
+                const TypeLayout& cold = engine.cold_layout(def.type);
+                oss << ", \"cold\": {\"size\": " << cold.size
+                    << ", \"align\": " << cold.align
+                    << ", \"padding\": " << cold.padding
+                    << ", \"cache_lines\": " << engine.cache_lines(cold)
+                    << ", \"heap_members\": " << cold.heap_members << "}";
+            }
+            oss << "}";
+        }
+        oss << (ir.definitions.empty() ? "]\n" : "\n  ]\n");
+        oss << "}";
+        return oss.str();
+    }
+    
+    // The side table of @cold fields gets a row of its own
+    const std::string cold_suffix = " (cold)";
+    size_t name_width = 4;
+    for (const auto& def : ir.definitions) {
+        name_width = std::max(name_width, def.name.size() + (ir.has_cold_fields(def.type) ? cold_suffix.size() : 0));
+    }
+    
+    oss << "Layout of " << source_name << " for " << engine.abi().name << "\n\n";
+    oss << std::left << std::setw(static_cast<int>(name_width)) << "Type" << std::right
+        << std::setw(8) << "Size" << std::setw(7) << "Align" << std::setw(9) << "Padding"
+        << std::setw(13) << "Cache lines" << std::setw(14) << "Heap members" << "\n";
+    for (const auto& def : ir.definitions) {
+        const TypeLayout& layout = engine.layout(def.type);
+        oss << std::left << std::setw(static_cast<int>(name_width)) << def.name << std::right
+            << std::setw(8) << layout.size << std::setw(7) << layout.align
+            << std::setw(9) << layout.padding << std::setw(13) << engine.cache_lines(def.type)
+            << std::setw(14) << layout.heap_members << "\n";
+        if (ir.has_cold_fields(def.type)) {
+            const TypeLayout& cold = engine.cold_layout(def.type);
+            oss << std::left << std::setw(static_cast<int>(name_width)) << def.name + cold_suffix << std::right
+                << std::setw(8) << cold.size << std::setw(7) << cold.align
+                << std::setw(9) << cold.padding << std::setw(13) << engine.cache_lines(cold)
+                << std::setw(14) << cold.heap_members << "\n";
+        }
+    }
+    return oss.str();
+}
+
+} // namespace semantic
+} // namespace carch
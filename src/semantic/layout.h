@@ -0,0 +1,99 @@
+#pragma once
+
+#include "schema_ir.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace carch {
+namespace semantic {
+
+// Sizes of the C++ types generated code uses, for one target ABI
+struct TargetAbi {
+    std::string name;
+    uint32_t pointer_size = 8;
+    uint32_t string_size = 32;          // std::string
+    uint32_t vector_size = 24;          // std::vector<T>
+    uint32_t unordered_map_size = 56;   // std::unordered_map<K, V>
+    uint32_t entity_id_size = 8;        // ref<entity>
+    uint32_t cache_line_size = 64;
+
+    // x86-64 System V with libstdc++
+    static TargetAbi x86_64_sysv();
+};
+
+struct TypeLayout {
+    uint32_t size = 0;
+    uint32_t align = 1;
+    uint32_t padding = 0;       // Padding bytes anywhere in the inline storage
+    uint32_t heap_members = 0;  // str, array and map members, including nested ones
+};
+
+enum class ReportFormat {
+    TABLE,
+    JSON
+};
+
+// Computes the size and alignment of every IR type as the generated C++
+// lays it out, and optionally the padding-minimizing order of struct fields.
+// Maps and optionals without an annotation use the default backends.
+class LayoutEngine {
+public:
+    LayoutEngine(const SchemaIR& ir, const TargetAbi& abi, bool reorder_fields = false,
+                 MapBackend default_map = MapBackend::STD,
+                 OptionalBackend default_optional = OptionalBackend::STD);
+
+    const TypeLayout& layout(TypeId id) const { return layouts_[id]; }
+
+    // Storage order of a struct's fields, as indices in declaration order;
+    // @cold fields are left out
+    const std::vector<uint32_t>& field_order(TypeId id) const { return field_orders_[id]; }
+
+    // Layout and storage order of the side table holding a struct's @cold
+    // fields, a plain struct of them; empty without @cold fields
+    const TypeLayout& cold_layout(TypeId id) const { return cold_layouts_[id]; }
+    const std::vector<uint32_t>& cold_field_order(TypeId id) const { return cold_field_orders_[id]; }
+
+    // Offset of a field (an index into SchemaIR::fields) within its struct
+    uint32_t field_offset(uint32_t field) const { return field_offsets_[field]; }
+
+    // Whether a struct is stored in an order other than its declaration order
+    bool is_reordered(TypeId id) const;
+
+    const TargetAbi& abi() const { return abi_; }
+
+    // Cache lines one instance spans when it starts on a line boundary
+    uint32_t cache_lines(TypeId id) const { return cache_lines(layouts_[id]); }
+    uint32_t cache_lines(const TypeLayout& layout) const;
+
+    // Alignment and storage of a field once its attributes are applied;
+    // a @cacheline field is padded out to a whole number of lines
+    uint32_t field_align(uint32_t field) const;
+    uint32_t field_storage(uint32_t field) const;
+
+private:
+    const SchemaIR& ir_;
+    TargetAbi abi_;
+    bool reorder_fields_;
+    MapBackend default_map_;
+    OptionalBackend default_optional_;
+    std::vector<TypeLayout> layouts_;
+    std::vector<std::vector<uint32_t>> field_orders_;
+    std::vector<TypeLayout> cold_layouts_;
+    std::vector<std::vector<uint32_t>> cold_field_orders_;
+    std::vector<uint32_t> field_offsets_;
+    std::vector<uint8_t> state_;    // 0 = pending, 1 = in progress, 2 = done
+
+    const TypeLayout& compute(TypeId id);
+    uint32_t member_align(uint32_t field, bool packed);
+    TypeLayout lay_out_fields(const Type& type, std::vector<uint32_t>& order, bool packed);
+    TypeLayout primitive_layout(parser::PrimitiveType primitive, uint32_t length) const;
+};
+
+// Size, alignment, padding, cache lines and heap members of every
+// definition; JSON output is one object for the whole schema
+std::string format_layout_report(const SchemaIR& ir, const LayoutEngine& engine,
+                                 const std::string& source_name, ReportFormat format);
+
+} // namespace semantic
+} // namespace carch
@@ -0,0 +1,594 @@
+#include "schema_ir.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace carch {
+namespace semantic {
+
+LayoutAttributes layout_attributes(const std::vector<parser::Annotation>& annotations) {
+    LayoutAttributes attributes;
+    for (const auto& annotation : annotations) {
+        if (annotation.name == "align" && annotation.arguments.size() == 1) {
+            attributes.align = static_cast<uint32_t>(std::strtoul(annotation.arguments[0].c_str(), nullptr, 10));
+        } else if (annotation.name == "cacheline") {
+            attributes.cacheline = true;
+        } else if (annotation.name == "packed") {
+            attributes.packed = true;
+        }
+    }
+    return attributes;
+}
+
+uint32_t enum_storage_size(uint32_t count) {
+    return count < UINT8_MAX ? 1 : count < UINT16_MAX ? 2 : 4;
+}
+
+uint32_t flags_storage_size(uint32_t count) {
+    return count <= 8 ? 1 : count <= 16 ? 2 : count <= 32 ? 4 : 8 * ((count + 63) / 64);
+}
+
+uint32_t vector_lanes(parser::PrimitiveType primitive) {
+    switch (primitive) {
+        case parser::PrimitiveType::VEC2:
+        case parser::PrimitiveType::IVEC2: return 2;
+        case parser::PrimitiveType::VEC3:
+        case parser::PrimitiveType::IVEC3: return 3;
+        case parser::PrimitiveType::VEC4:
+        case parser::PrimitiveType::QUAT:
+        case parser::PrimitiveType::IVEC4: return 4;
+        default: return 0;
+    }
+}
+
+parser::PrimitiveType vector_lane_type(parser::PrimitiveType primitive) {
+    switch (primitive) {
+        case parser::PrimitiveType::IVEC2:
+        case parser::PrimitiveType::IVEC3:
+        case parser::PrimitiveType::IVEC4: return parser::PrimitiveType::I32;
+        case parser::PrimitiveType::VEC2:
+        case parser::PrimitiveType::VEC3:
+        case parser::PrimitiveType::VEC4:
+        case parser::PrimitiveType::QUAT: return parser::PrimitiveType::F32;
+        default: return primitive;
+    }
+}
+
+namespace {
+
+// Digits of [-]int[.frac] as one integer, with the count of fractional digits
+bool parse_decimal(const std::string& text, int64_t& value, uint32_t& decimals) {
+    size_t i = text[0] == '-' ? 1 : 0;
+    bool digits = false;
+    bool point = false;
+    value = 0;
+    decimals = 0;
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (c < '0' || c > '9' || decimals == 9 || value > (int64_t(1) << 53)) {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+        digits = true;
+        decimals += point ? 1 : 0;
+    }
+    if (text[0] == '-') {
+        value = -value;
+    }
+    return digits;
+}
+
+} // namespace
+
+bool parse_quant_range(const std::string& min, const std::string& max, QuantRange& range) {
+    uint32_t min_decimals = 0;
+    uint32_t max_decimals = 0;
+    if (min.empty() || max.empty() || !parse_decimal(min, range.min, min_decimals) ||
+        !parse_decimal(max, range.max, max_decimals)) {
+        return false;
+    }
+    range.decimals = std::max(min_decimals, max_decimals);
+    for (; min_decimals < range.decimals; ++min_decimals) range.min *= 10;
+    for (; max_decimals < range.decimals; ++max_decimals) range.max *= 10;
+    const int64_t limit = int64_t(1) << 53;
+    return range.min > -limit && range.min < limit && range.max > -limit && range.max < limit;
+}
+
+parser::PrimitiveType storage_primitive(parser::PrimitiveType primitive, uint32_t bits) {
+    switch (primitive) {
+        case parser::PrimitiveType::F16:
+        case parser::PrimitiveType::UNORM16: return parser::PrimitiveType::U16;
+        case parser::PrimitiveType::UNORM8: return parser::PrimitiveType::U8;
+        case parser::PrimitiveType::SNORM8: return parser::PrimitiveType::I8;
+        case parser::PrimitiveType::SNORM16: return parser::PrimitiveType::I16;
+        case parser::PrimitiveType::QUANT:
+            return bits <= 8 ? parser::PrimitiveType::U8 : bits <= 16 ? parser::PrimitiveType::U16
+                                                                      : parser::PrimitiveType::U32;
+        default: return primitive;
+    }
+}
+
+bool parse_map_backend(const std::string& name, MapBackend& backend) {
+    if (name == "std") {
+        backend = MapBackend::STD;
+    } else if (name == "flat") {
+        backend = MapBackend::FLAT;
+    } else if (name == "sorted") {
+        backend = MapBackend::SORTED;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+MapBackend map_backend(const std::vector<parser::Annotation>& annotations) {
+    MapBackend backend = MapBackend::DEFAULT;
+    const parser::Annotation* annotation = parser::find_annotation(annotations, "map");
+    if (annotation && annotation->arguments.size() == 1) {
+        parse_map_backend(annotation->arguments[0], backend);
+    }
+    return backend;
+}
+
+bool parse_optional_backend(const std::string& name, OptionalBackend& backend) {
+    if (name == "std") {
+        backend = OptionalBackend::STD;
+    } else if (name == "compact") {
+        backend = OptionalBackend::COMPACT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+OptionalBackend optional_backend(const std::vector<parser::Annotation>& annotations) {
+    OptionalBackend backend = OptionalBackend::DEFAULT;
+    const parser::Annotation* annotation = parser::find_annotation(annotations, "optional");
+    if (annotation && annotation->arguments.size() == 1) {
+        parse_optional_backend(annotation->arguments[0], backend);
+    }
+    return backend;
+}
+
+bool parse_variant_backend(const std::string& name, VariantBackend& backend) {
+    if (name == "std") {
+        backend = VariantBackend::STD;
+    } else if (name == "tagged") {
+        backend = VariantBackend::TAGGED;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+VariantBackend variant_backend(const std::vector<parser::Annotation>& annotations) {
+    VariantBackend backend = VariantBackend::DEFAULT;
+    const parser::Annotation* annotation = parser::find_annotation(annotations, "variant");
+    if (annotation && annotation->arguments.size() == 1) {
+        parse_variant_backend(annotation->arguments[0], backend);
+    }
+    return backend;
+}
+
+Niche SchemaIR::niche_of(TypeId id) const {
+    const Type& t = types[id];
+    switch (t.kind) {
+        case TypeKind::REF: return Niche::REF;
+        case TypeKind::ENUM: return Niche::ENUM;
+        case TypeKind::PRIMITIVE:
+            // Vectors and reduced-precision numbers use every bit pattern
+            if (vector_lanes(t.primitive) > 0 || storage_primitive(t.primitive, t.count) != t.primitive) {
+                return Niche::NONE;
+            }
+            switch (t.primitive) {
+                case parser::PrimitiveType::F32:
+                case parser::PrimitiveType::F64: return Niche::FLOAT;
+                case parser::PrimitiveType::STR:
+                case parser::PrimitiveType::ISTR: return Niche::STRING;
+                case parser::PrimitiveType::BOOL:
+                case parser::PrimitiveType::UNIT: return Niche::NONE;
+                default: return Niche::INTEGER;
+            }
+        default: return Niche::NONE;
+    }
+}
+
+bool SchemaIR::is_compact_optional(TypeId id, OptionalBackend default_backend) const {
+    const Type& t = types[id];
+    if (t.kind != TypeKind::OPTIONAL || t.element == INVALID_ID) {
+        return false;
+    }
+    OptionalBackend backend = t.optional_backend != OptionalBackend::DEFAULT ? t.optional_backend : default_backend;
+    if (backend != OptionalBackend::COMPACT) {
+        return false;
+    }
+    Niche niche = niche_of(t.element);
+    if (t.optional_backend == OptionalBackend::COMPACT) {
+        return niche != Niche::NONE;
+    }
+    return niche == Niche::REF || niche == Niche::FLOAT || niche == Niche::ENUM;
+}
+
+LayoutAttributes SchemaIR::layout_of(TypeId id) const {
+    DefinitionId def = types[id].definition;
+    return def != INVALID_ID ? definitions[def].layout : LayoutAttributes{};
+}
+
+bool SchemaIR::has_cold_fields(TypeId id) const {
+    const Type& type = types[id];
+    if (type.kind != TypeKind::STRUCT) {
+        return false;
+    }
+    for (uint32_t i = 0; i < type.count; ++i) {
+        if (fields[type.first + i].cold) return true;
+    }
+    return false;
+}
+
+uint8_t SchemaIR::cold_flags(TypeId id) const {
+    const Type& type = types[id];
+    uint8_t flags = TYPE_TRIVIALLY_COPYABLE | TYPE_FIXED_SIZE | TYPE_TRIVIALLY_RELOCATABLE | TYPE_WIRE_SAFE;
+    for (uint32_t i = 0; i < type.count; ++i) {
+        const Field& field = fields[type.first + i];
+        if (field.cold && field.type != INVALID_ID) {
+            flags &= types[field.type].flags;
+        }
+    }
+    return flags;
+}
+
+TypeId SchemaIR::type_of(const parser::TypeExprNode* node) const {
+    auto it = node_types_.find(node);
+    return it != node_types_.end() ? it->second : INVALID_ID;
+}
+
+DefinitionId SchemaIR::find_definition(const std::string& name) const {
+    auto it = definition_index_.find(name);
+    return it != definition_index_.end() ? it->second : INVALID_ID;
+}
+
+void SchemaIR::collect_dependencies(TypeId id, std::set<DefinitionId>& deps) const {
+    const Type& t = types[id];
+    auto visit = [&](TypeId child) {
+        if (child == INVALID_ID) return;
+        if (types[child].definition != INVALID_ID) {
+            deps.insert(types[child].definition);
+        } else {
+            collect_dependencies(child, deps);
+        }
+    };
+
+    if (t.kind == TypeKind::STRUCT || t.kind == TypeKind::VARIANT) {
+        for (uint32_t i = 0; i < t.count; ++i) {
+            visit(fields[t.first + i].type);
+        }
+    } else {
+        visit(t.key);
+        visit(t.element);
+    }
+}
+
+class SchemaIRBuilder {
+public:
+    explicit SchemaIRBuilder(const parser::SchemaNode& schema) : schema_(schema) {}
+
+    SchemaIR build();
+
+private:
+    // A type with its children lowered, before it is given an ID
+    struct Lowered {
+        Type type;
+        std::string key;                    // Structural key over child IDs
+        std::vector<Field> fields;
+        std::vector<std::string> values;
+        QuantRange range;                   // quant only
+    };
+
+    const parser::SchemaNode& schema_;
+    SchemaIR ir_;
+    std::unordered_map<std::string, TypeId> interned_;
+    std::set<DefinitionId> current_dependencies_;
+    std::vector<uint8_t> flag_state_;       // 0 = pending, 1 = in progress, 2 = done
+
+    // annotations are those of the field typed expr; their backends apply
+    // to expr itself, not to containers nested inside it
+    TypeId lower(const parser::TypeExprNode* expr, bool top_level,
+                 const std::vector<parser::Annotation>* annotations = nullptr);
+    Lowered lower_parts(const parser::TypeExprNode* expr, bool top_level,
+                        const std::vector<parser::Annotation>* annotations);
+    void store(TypeId id, Lowered&& lowered);
+    uint8_t compute_flags(TypeId id);
+};
+
+SchemaIR SchemaIRBuilder::build() {
+    // Reserve one type per definition first, so names resolve regardless
+    // of the order they are lowered in
+    for (auto& def : schema_.definitions) {
+        if (ir_.definition_index_.count(def->name) > 0) {
+            continue;
+        }
+        DefinitionId id = static_cast<DefinitionId>(ir_.definitions.size());
+        Definition definition;
+        definition.name = def->name;
+        definition.type = static_cast<TypeId>(ir_.types.size());
+        definition.line = def->line;
+        definition.column = def->column;
+        definition.layout = layout_attributes(def->annotations);
+        definition.variant_backend = variant_backend(def->annotations);
+        definition.partitioned = parser::find_annotation(def->annotations, "partitioned") != nullptr;
+        definition.pod = parser::find_annotation(def->annotations, "pod") != nullptr;
+        definition.double_buffered = parser::find_annotation(def->annotations, "double_buffered") != nullptr;
+        ir_.definitions.push_back(definition);
+        ir_.definition_index_[def->name] = id;
+
+        Type body;
+        body.definition = id;
+        body.node = def->type.get();
+        ir_.types.push_back(body);
+    }
+
+    for (auto& def : schema_.definitions) {
+        DefinitionId id = ir_.definition_index_[def->name];
+        Definition& definition = ir_.definitions[id];
+        if (ir_.types[definition.type].node != def->type.get() || !def->type) {
+            continue;   // Duplicate definition name
+        }
+
+        current_dependencies_.clear();
+        Lowered lowered = lower_parts(def->type.get(), true, nullptr);
+        lowered.type.definition = id;
+        TypeId type_id = definition.type;
+        store(type_id, std::move(lowered));
+        ir_.node_types_[def->type.get()] = type_id;
+
+        current_dependencies_.erase(id);
+        definition.dependencies.assign(current_dependencies_.begin(), current_dependencies_.end());
+    }
+
+    flag_state_.assign(ir_.types.size(), 0);
+    for (TypeId id = 0; id < ir_.types.size(); ++id) {
+        compute_flags(id);
+    }
+
+    return std::move(ir_);
+}
+
+TypeId SchemaIRBuilder::lower(const parser::TypeExprNode* expr, bool top_level,
+                              const std::vector<parser::Annotation>* annotations) {
+    if (!expr) {
+        return INVALID_ID;
+    }
+
+    // Names resolve to the body of the definition they refer to
+    if (auto* id = dynamic_cast<const parser::IdentifierTypeNode*>(expr)) {
+        DefinitionId def = ir_.find_definition(id->name);
+        TypeId type_id = INVALID_ID;
+        if (def != INVALID_ID) {
+            type_id = ir_.definitions[def].type;
+            ir_.definitions[def].references++;
+            current_dependencies_.insert(def);
+        }
+        ir_.node_types_[expr] = type_id;
+        return type_id;
+    }
+
+    Lowered lowered = lower_parts(expr, top_level, annotations);
+    TypeId type_id;
+    auto known = interned_.find(lowered.key);
+    if (known != interned_.end()) {
+        type_id = known->second;
+    } else {
+        type_id = static_cast<TypeId>(ir_.types.size());
+        ir_.types.emplace_back();
+        interned_[lowered.key] = type_id;
+        store(type_id, std::move(lowered));
+    }
+
+    if (!top_level) {
+        ir_.types[type_id].uses++;
+    }
+    ir_.node_types_[expr] = type_id;
+    return type_id;
+}
+
+SchemaIRBuilder::Lowered SchemaIRBuilder::lower_parts(const parser::TypeExprNode* expr, bool top_level,
+                                                      const std::vector<parser::Annotation>* annotations) {
+    Lowered result;
+    result.type.node = expr;
+
+    if (auto* prim = dynamic_cast<const parser::PrimitiveTypeNode*>(expr)) {
+        result.type.kind = TypeKind::PRIMITIVE;
+        result.type.primitive = prim->primitive;
+        result.type.count = prim->length;
+        result.key = "p" + std::to_string(static_cast<int>(prim->primitive));
+        if (prim->length > 0) {
+            result.key += ":" + std::to_string(prim->length);
+        }
+        if (prim->primitive == parser::PrimitiveType::QUANT &&
+            parse_quant_range(prim->quant_min, prim->quant_max, result.range)) {
+            result.key += ":" + std::to_string(result.range.min) + ":" + std::to_string(result.range.max) +
+                          ":" + std::to_string(result.range.decimals);
+        }
+    } else if (dynamic_cast<const parser::RefTypeNode*>(expr)) {
+        result.type.kind = TypeKind::REF;
+        result.key = "r";
+    } else if (auto* container = dynamic_cast<const parser::ContainerTypeNode*>(expr)) {
+        if (container->kind == parser::ContainerKind::MAP) {
+            result.type.kind = TypeKind::MAP;
+            result.type.key = lower(container->key_type.get(), false);
+            result.type.element = lower(container->value_type.get(), false);
+            result.type.map_backend = annotations ? map_backend(*annotations) : MapBackend::DEFAULT;
+            result.key = "m<" + std::to_string(result.type.key) + "," + std::to_string(result.type.element) + ">";
+            if (result.type.map_backend != MapBackend::DEFAULT) {
+                result.key += ":" + std::to_string(static_cast<int>(result.type.map_backend));
+            }
+        } else if (container->kind == parser::ContainerKind::OPTIONAL) {
+            result.type.kind = TypeKind::OPTIONAL;
+            result.type.element = lower(container->element_type.get(), false);
+            result.type.optional_backend = annotations ? optional_backend(*annotations) : OptionalBackend::DEFAULT;
+            result.key = "o<" + std::to_string(result.type.element) + ">";
+            if (result.type.optional_backend != OptionalBackend::DEFAULT) {
+                result.key += ":" + std::to_string(static_cast<int>(result.type.optional_backend));
+            }
+        } else {
+            bool small = container->kind == parser::ContainerKind::SMALL_ARRAY;
+            result.type.kind = small ? TypeKind::SMALL_ARRAY
+                                     : container->length > 0 ? TypeKind::FIXED_ARRAY : TypeKind::ARRAY;
+            result.type.element = lower(container->element_type.get(), false);
+            result.type.count = container->length;
+            result.type.pooled = result.type.kind == TypeKind::ARRAY && annotations &&
+                                 parser::find_annotation(*annotations, "pooled");
+            result.key = (small ? "sa<" : "a<") + std::to_string(result.type.element) + "," +
+                         std::to_string(container->length) + ">";
+            if (result.type.pooled) {
+                result.key += ":p";
+            }
+        }
+    } else if (auto* struct_type = dynamic_cast<const parser::StructTypeNode*>(expr)) {
+        result.type.kind = TypeKind::STRUCT;
+        result.key = "s{";
+        for (auto& field : struct_type->fields) {
+            Field lowered_field{field->name, lower(field->type.get(), false, &field->annotations),
+                                field->line, field->column, layout_attributes(field->annotations)};
+            lowered_field.cold = parser::find_annotation(field->annotations, "cold") != nullptr;
+            result.key += field->name + ":" + std::to_string(lowered_field.type);
+            if (!lowered_field.layout.empty()) {
+                // Differently aligned fields make a different shape
+                result.key += "@" + std::to_string(lowered_field.layout.align) +
+                              (lowered_field.layout.cacheline ? "c" : "");
+            }
+            if (lowered_field.cold) {
+                result.key += "!cold";
+            }
+            result.key += ",";
+            result.fields.push_back(std::move(lowered_field));
+        }
+        result.key += "}";
+    } else if (auto* variant_type = dynamic_cast<const parser::VariantTypeNode*>(expr)) {
+        // Alternatives of a top-level variant are named after it, so they
+        // are not anonymous uses
+        result.type.kind = TypeKind::VARIANT;
+        result.key = "v{";
+        for (auto& alt : variant_type->alternatives) {
+            Field lowered_alt{alt->name, lower(alt->type.get(), top_level), alt->line, alt->column, {}};
+            result.key += alt->name + ":" + std::to_string(lowered_alt.type) + ",";
+            result.fields.push_back(std::move(lowered_alt));
+        }
+        result.key += "}";
+    } else if (auto* enum_type = dynamic_cast<const parser::EnumTypeNode*>(expr)) {
+        result.type.kind = enum_type->flags ? TypeKind::FLAGS : TypeKind::ENUM;
+        result.key = enum_type->flags ? "f{" : "e{";
+        for (const auto& value : enum_type->values) {
+            result.key += value + ",";
+        }
+        result.key += "}";
+        result.values = enum_type->values;
+    }
+
+    return result;
+}
+
+void SchemaIRBuilder::store(TypeId id, Lowered&& lowered) {
+    Type& type = lowered.type;
+    if (type.kind == TypeKind::STRUCT || type.kind == TypeKind::VARIANT) {
+        type.first = static_cast<uint32_t>(ir_.fields.size());
+        type.count = static_cast<uint32_t>(lowered.fields.size());
+        for (auto& field : lowered.fields) {
+            ir_.fields.push_back(std::move(field));
+        }
+    } else if (type.kind == TypeKind::ENUM || type.kind == TypeKind::FLAGS) {
+        type.first = static_cast<uint32_t>(ir_.enum_values.size());
+        type.count = static_cast<uint32_t>(lowered.values.size());
+        for (auto& value : lowered.values) {
+            ir_.enum_values.push_back(std::move(value));
+        }
+    } else if (type.kind == TypeKind::PRIMITIVE && type.primitive == parser::PrimitiveType::QUANT) {
+        type.first = static_cast<uint32_t>(ir_.quant_ranges.size());
+        ir_.quant_ranges.push_back(lowered.range);
+    }
+    ir_.types[id] = type;
+}
+
+uint8_t SchemaIRBuilder::compute_flags(TypeId id) {
+    if (id == INVALID_ID) {
+        return 0;
+    }
+    Type& type = ir_.types[id];
+    if (flag_state_[id] == 2) {
+        return type.flags;
+    }
+    if (flag_state_[id] == 1) {
+        return 0;   // Cycle through an invalid schema
+    }
+    flag_state_[id] = 1;
+
+    const uint8_t all = TYPE_TRIVIALLY_COPYABLE | TYPE_FIXED_SIZE | TYPE_TRIVIALLY_RELOCATABLE | TYPE_WIRE_SAFE;
+    // Handles into storage outside the value copy as bytes but mean nothing
+    // without it
+    const uint8_t handle = all & ~TYPE_WIRE_SAFE;
+    uint8_t flags = 0;
+    switch (type.kind) {
+        case TypeKind::PRIMITIVE:
+            // Only heap-backed str owns memory, and its short-string buffer
+            // lives inside the object; str<N> is inline and istr is a handle
+            // into the global string table
+            if (type.primitive == parser::PrimitiveType::STR && type.count == 0) {
+                flags = 0;
+            } else {
+                flags = type.primitive == parser::PrimitiveType::ISTR ? handle : all;
+            }
+            break;
+        case TypeKind::ENUM:
+        case TypeKind::FLAGS:
+        case TypeKind::REF:
+            flags = all;
+            break;
+        case TypeKind::ARRAY:
+            // A pooled span is two integers; its elements live in the arena
+            flags = type.pooled ? handle : static_cast<uint8_t>(TYPE_TRIVIALLY_RELOCATABLE);
+            break;
+        case TypeKind::SMALL_ARRAY:
+            flags = compute_flags(type.element) & TYPE_TRIVIALLY_RELOCATABLE;
+            break;
+        case TypeKind::MAP:
+            // std::unordered_map may point back into itself; the default
+            // backend is only known to the generator
+            if (type.map_backend == MapBackend::FLAT || type.map_backend == MapBackend::SORTED) {
+                flags = TYPE_TRIVIALLY_RELOCATABLE;
+            }
+            break;
+        case TypeKind::FIXED_ARRAY:
+        case TypeKind::OPTIONAL:
+            flags = compute_flags(type.element);
+            break;
+        case TypeKind::STRUCT:
+        case TypeKind::VARIANT:
+            flags = all;
+            // Unit alternatives have no type and never add heap state, and
+            // @cold fields live in the side table
+            for (uint32_t i = 0; i < type.count; ++i) {
+                const Field& field = ir_.fields[type.first + i];
+                if (field.type != INVALID_ID) {
+                    uint8_t field_flags = compute_flags(field.type);
+                    if (!field.cold) {
+                        flags &= field_flags;
+                    }
+                }
+            }
+            break;
+    }
+
+    type.flags = flags;
+    flag_state_[id] = 2;
+    return flags;
+}
+
+SchemaIR build_schema_ir(const parser::SchemaNode& schema) {
+    return SchemaIRBuilder(schema).build();
+}
+
+} // namespace semantic
+} // namespace carch
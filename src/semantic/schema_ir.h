@@ -0,0 +1,231 @@
+#pragma once
+
+#include "../parser/ast.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace carch {
+namespace semantic {
+
+// Indices into the flat arrays of a SchemaIR
+using TypeId = uint32_t;
+using DefinitionId = uint32_t;
+constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+enum class TypeKind : uint8_t {
+    PRIMITIVE,
+    STRUCT,
+    VARIANT,
+    ENUM,
+    FLAGS,          // flags { ... }: a bit set of the values
+    ARRAY,
+    FIXED_ARRAY,    // array<T, N>
+    SMALL_ARRAY,    // small_array<T, N>
+    MAP,
+    OPTIONAL,
+    REF
+};
+
+// Container generated for map<K, V>
+enum class MapBackend : uint8_t {
+    DEFAULT,    // No @map annotation: the generator's default backend
+    STD,        // std::unordered_map
+    FLAT,       // carch::FlatHashMap: open addressing in one array
+    SORTED      // carch::SortedFlatMap: entries in a vector sorted by key
+};
+
+// Container generated for optional<T>
+enum class OptionalBackend : uint8_t {
+    DEFAULT,    // No @optional annotation: the generator's default backend
+    STD,        // std::optional: the value followed by an engaged flag
+    COMPACT     // carch::CompactOptional: a spare value of T means "none"
+};
+
+// Spare value of a type that a compact optional can store as "none"
+enum class Niche : uint8_t {
+    NONE,       // Every value is meaningful
+    REF,        // Maximum entity id, never handed out
+    FLOAT,      // One NaN bit pattern
+    ENUM,       // Maximum of the underlying type, past every declared value
+    INTEGER,    // Maximum (unsigned) or minimum (signed) value; on request only
+    STRING      // The empty string; on request only
+};
+
+// Type generated for a variant definition
+enum class VariantBackend : uint8_t {
+    DEFAULT,    // No @variant annotation: the generator's default backend
+    STD,        // std::variant over the alternative structs
+    TAGGED      // Class with a tag and a union, visited with a switch
+};
+
+// Facts about the generated C++ type, computed once when the IR is built
+enum TypeFlags : uint8_t {
+    TYPE_TRIVIALLY_COPYABLE = 1 << 0,   // Copyable with memcpy
+    TYPE_FIXED_SIZE = 1 << 1,           // No heap-owning member anywhere inside
+    TYPE_TRIVIALLY_RELOCATABLE = 1 << 2,    // Movable with memcpy: heap memory, if any, is owned through
+                                            // pointers that do not point back into the value (on
+                                            // libstdc++ and libc++, where std::vector is three pointers)
+    TYPE_WIRE_SAFE = 1 << 3             // Trivially copyable and self-contained: no istr or @pooled span
+};
+
+struct Type {
+    TypeKind kind = TypeKind::PRIMITIVE;
+    parser::PrimitiveType primitive = parser::PrimitiveType::UNIT;  // PRIMITIVE only
+    DefinitionId definition = INVALID_ID;   // Definition this type is the body of
+    uint32_t first = 0;                     // STRUCT/VARIANT: into fields, ENUM/FLAGS: into enum_values,
+                                            // quant: into quant_ranges
+    uint32_t count = 0;                     // FIXED_ARRAY length, SMALL_ARRAY inline capacity, str<N> bytes,
+                                            // quant bits
+    TypeId element = INVALID_ID;            // Array/OPTIONAL element, MAP value
+    TypeId key = INVALID_ID;                // MAP key
+    MapBackend map_backend = MapBackend::DEFAULT;   // MAP only
+    OptionalBackend optional_backend = OptionalBackend::DEFAULT;    // OPTIONAL only
+    bool pooled = false;                    // ARRAY only: @pooled, a {offset, length} span into an arena
+    uint32_t uses = 0;                      // Anonymous types: occurrences below a definition's top level
+    uint8_t flags = 0;
+    const parser::TypeExprNode* node = nullptr;  // First occurrence in the AST
+};
+
+// Storage requested with @align, @cacheline and @packed
+struct LayoutAttributes {
+    uint32_t align = 0;         // @align(N), 0 when not given
+    bool cacheline = false;     // @cacheline: aligned to, and alone on, a cache line
+    bool packed = false;        // @packed: members at alignment 1 (definitions only)
+    
+    bool empty() const { return align == 0 && !cacheline && !packed; }
+};
+
+// Reads layout attributes from annotations; malformed ones are ignored
+LayoutAttributes layout_attributes(const std::vector<parser::Annotation>& annotations);
+
+// Bytes of the smallest unsigned type that holds every value of an enum
+// with count values and still leaves one spare for compact optionals
+uint32_t enum_storage_size(uint32_t count);
+
+// Bytes of the bit set for flags with count values: the smallest unsigned
+// type with a bit per value, or 64-bit words past 64 values
+uint32_t flags_storage_size(uint32_t count);
+
+// Lanes of vec2..vec4, quat and ivec2..ivec4, 0 for scalar primitives.
+// SoA and serialization backends split vectors into lanes of vector_lane_type
+uint32_t vector_lanes(parser::PrimitiveType primitive);
+parser::PrimitiveType vector_lane_type(parser::PrimitiveType primitive);
+
+// Bounds of quant<min, max, bits> as integers over 10^decimals, sharing
+// one scale, so 0.5 and 2 are {5, 20, 1}
+struct QuantRange {
+    int64_t min = 0;
+    int64_t max = 0;
+    uint32_t decimals = 0;
+};
+
+// Reads quant bounds written as decimal literals with at most 9 fractional
+// digits and scaled magnitudes below 2^53; false for anything else
+bool parse_quant_range(const std::string& min, const std::string& max, QuantRange& range);
+
+// Integer primitive holding the stored bits of f16, unorm, snorm and quant
+// with the given bits, for serializers that write the encoded form; the
+// primitive itself for every other type
+parser::PrimitiveType storage_primitive(parser::PrimitiveType primitive, uint32_t bits);
+
+// Backend named by "std", "flat" or "sorted"; false for anything else
+bool parse_map_backend(const std::string& name, MapBackend& backend);
+
+// Backend requested with @map(...); DEFAULT when absent or malformed
+MapBackend map_backend(const std::vector<parser::Annotation>& annotations);
+
+// Backend named by "std" or "compact"; false for anything else
+bool parse_optional_backend(const std::string& name, OptionalBackend& backend);
+
+// Backend requested with @optional(...); DEFAULT when absent or malformed
+OptionalBackend optional_backend(const std::vector<parser::Annotation>& annotations);
+
+// Backend named by "std" or "tagged"; false for anything else
+bool parse_variant_backend(const std::string& name, VariantBackend& backend);
+
+// Backend requested with @variant(...); DEFAULT when absent or malformed
+VariantBackend variant_backend(const std::vector<parser::Annotation>& annotations);
+
+// A struct field or variant alternative; unit alternatives have no type
+struct Field {
+    std::string name;
+    TypeId type = INVALID_ID;
+    uint32_t line = 0;
+    uint32_t column = 0;
+    LayoutAttributes layout;
+    bool cold = false;          // @cold: stored in the struct's side table, not in the struct itself
+};
+
+struct Definition {
+    std::string name;
+    TypeId type = INVALID_ID;
+    uint32_t line = 0;
+    uint32_t column = 0;
+    std::vector<DefinitionId> dependencies;     // Definitions named by the body, sorted
+    uint32_t references = 0;                    // How many times other definitions name it
+    LayoutAttributes layout;
+    VariantBackend variant_backend = VariantBackend::DEFAULT;   // Variant bodies only
+    bool partitioned = false;                   // @partitioned: per-alternative storage (variant bodies only)
+    bool pod = false;                           // @pod: only wire-safe fields (struct and variant bodies)
+    bool double_buffered = false;               // @double_buffered: front and back storage (struct and variant bodies)
+};
+
+// Resolved, index-based form of a schema. Type references are integer IDs,
+// structurally identical anonymous types share one entry, and every
+// IdentifierTypeNode resolves to the body of the definition it names.
+class SchemaIR {
+public:
+    std::vector<Definition> definitions;
+    std::vector<Type> types;
+    std::vector<Field> fields;
+    std::vector<std::string> enum_values;
+    std::vector<QuantRange> quant_ranges;
+
+    const Type& type(TypeId id) const { return types[id]; }
+    const Field* fields_of(TypeId id) const { return fields.data() + types[id].first; }
+
+    // Type an AST type expression resolved to, or INVALID_ID
+    TypeId type_of(const parser::TypeExprNode* node) const;
+
+    // Definition with the given schema name, or INVALID_ID
+    DefinitionId find_definition(const std::string& name) const;
+
+    bool is_trivially_copyable(TypeId id) const { return (types[id].flags & TYPE_TRIVIALLY_COPYABLE) != 0; }
+    bool is_fixed_size(TypeId id) const { return (types[id].flags & TYPE_FIXED_SIZE) != 0; }
+    bool is_trivially_relocatable(TypeId id) const { return (types[id].flags & TYPE_TRIVIALLY_RELOCATABLE) != 0; }
+    bool is_wire_safe(TypeId id) const { return (types[id].flags & TYPE_WIRE_SAFE) != 0; }
+
+    // Spare value a compact optional of this type can use, if any
+    Niche niche_of(TypeId id) const;
+
+    // Whether an OPTIONAL type is a carch::CompactOptional: when annotated
+    // compact, or, without an annotation, when the default is compact and
+    // the niche takes no value away from the element (REF, FLOAT, ENUM)
+    bool is_compact_optional(TypeId id, OptionalBackend default_backend) const;
+
+    // Attributes of the definition a type is the body of; none for anonymous types
+    LayoutAttributes layout_of(TypeId id) const;
+
+    // Whether a STRUCT has @cold fields, and the TypeFlags of its side
+    // table of them; the type's own flags cover only the other fields
+    bool has_cold_fields(TypeId id) const;
+    uint8_t cold_flags(TypeId id) const;
+
+    // Definitions named anywhere inside a type, not looking past them
+    void collect_dependencies(TypeId id, std::set<DefinitionId>& deps) const;
+
+private:
+    friend class SchemaIRBuilder;
+    std::unordered_map<const parser::TypeExprNode*, TypeId> node_types_;
+    std::unordered_map<std::string, DefinitionId> definition_index_;
+};
+
+// Lowers a parsed schema to a SchemaIR. Names that do not resolve map to
+// INVALID_ID, so this also works on schemas that failed checking.
+SchemaIR build_schema_ir(const parser::SchemaNode& schema);
+
+} // namespace semantic
+} // namespace carch
@@ -1,4 +1,6 @@
 #include "type_checker.h"
+#include "layout.h"
+#include <algorithm>
 #include <sstream>
 
 namespace carch {
@@ -12,6 +14,9 @@ bool TypeChecker::check() {
     symbol_table_.clear();
     visiting_.clear();
     visited_.clear();
+    checked_shapes_.clear();
+    terminated_shapes_.clear();
+    ir_ = SchemaIR{};
     
     // Phase 1: Build symbol table
     build_symbol_table();
@@ -23,7 +28,29 @@ bool TypeChecker::check() {
     // Phase 2: Check type definitions
     check_type_definitions();
     
-    return !has_errors();
+    if (has_errors()) {
+        return false;
+    }
+    
+    // Phase 3: Lower to the resolved IR consumed by the backends
+    ir_ = build_schema_ir(*schema_);
+    
+    // Phase 4: Check layout attributes against the computed layout, and
+    // compact optionals against the values their elements leave spare
+    check_layout_attributes();
+    check_compact_optionals();
+    check_pooled_arrays();
+    check_pod_definitions();
+    check_cold_fields();
+    check_component_only_fields();
+    check_double_buffered_definitions();
+    
+    if (has_errors()) {
+        ir_ = SchemaIR{};
+        return false;
+    }
+    
+    return true;
 }
 
 void TypeChecker::build_symbol_table() {
@@ -55,7 +82,20 @@ void TypeChecker::check_type_definitions() {
 }
 
 void TypeChecker::check_type_definition(parser::TypeDefinitionNode* def) {
+    check_annotations(def->annotations, def->type.get(), true, def->name);
+    auto* struct_type = dynamic_cast<parser::StructTypeNode*>(def->type.get());
+    if (struct_type && parser::find_annotation(def->annotations, "packed")) {
+        for (auto& field : struct_type->fields) {
+            if (parser::find_annotation(field->annotations, "align") ||
+                parser::find_annotation(field->annotations, "cacheline")) {
+                report_error("Field '" + field->name + "' of packed struct '" + def->name + "' cannot be aligned",
+                             field.get());
+            }
+        }
+    }
     check_type_expr(def->type.get(), def->name);
+    check_field_paths(def->type.get(), def->name, true,
+                      struct_type && parser::find_annotation(def->annotations, "packed"));
     // Check that all paths terminate at leaf types
     check_leaf_nodes(def->type.get(), def->name, false);
 }
@@ -75,6 +115,7 @@ void TypeChecker::check_struct_type(parser::StructTypeNode* node, const std::str
         }
         
         // Check field type
+        check_annotations(field->annotations, field->type.get(), false, context + "." + field->name);
         check_type_expr(field->type.get(), context + "." + field->name);
     }
 }
@@ -101,23 +142,41 @@ void TypeChecker::check_variant_type(parser::VariantTypeNode* node, const std::s
 }
 
 void TypeChecker::check_enum_type(parser::EnumTypeNode* node, const std::string& context) {
+    const std::string kind = node->flags ? "flags" : "enum";
     if (node->values.empty()) {
-        report_error("Enum must have at least one value in type '" + context + "'", node);
+        report_error(std::string(node->flags ? "Flags" : "Enum") + " must have at least one value in type '" +
+                     context + "'", node);
     }
     
     // Check value uniqueness
     std::unordered_set<std::string> value_set;
     for (const auto& value : node->values) {
         if (value_set.count(value) > 0) {
-            report_error("Duplicate enum value '" + value + "' in type '" + context + "'", node);
+            report_error("Duplicate " + kind + " value '" + value + "' in type '" + context + "'", node);
         } else {
             value_set.insert(value);
         }
     }
 }
 
+void TypeChecker::check_quant_type(parser::PrimitiveTypeNode* node, const std::string& context) {
+    if (node->length > 32) {
+        report_error("Quantized type in '" + context + "' has " + std::to_string(node->length) +
+                     " bits; the maximum is 32", node);
+    }
+    QuantRange range;
+    if (!parse_quant_range(node->quant_min, node->quant_max, range)) {
+        report_error("Quantized range in '" + context + "' must be written as decimal numbers with at most "
+                     "9 fractional digits, got '" + node->quant_min + "' and '" + node->quant_max + "'", node);
+    } else if (range.min >= range.max) {
+        report_error("Quantized range in '" + context + "' is empty: minimum " + node->quant_min +
+                     " is not below maximum " + node->quant_max, node);
+    }
+}
+
 void TypeChecker::check_container_type(parser::ContainerTypeNode* node, const std::string& context) {
-    if (node->kind == parser::ContainerKind::ARRAY || node->kind == parser::ContainerKind::OPTIONAL) {
+    if (node->kind == parser::ContainerKind::ARRAY || node->kind == parser::ContainerKind::SMALL_ARRAY ||
+        node->kind == parser::ContainerKind::OPTIONAL) {
         if (!node->element_type) {
             report_error("Container type missing element type in '" + context + "'", node);
             return;
@@ -143,13 +202,30 @@ void TypeChecker::check_container_type(parser::ContainerTypeNode* node, const st
 
 void TypeChecker::check_type_expr(parser::TypeExprNode* expr, const std::string& context) {
     if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(expr)) {
+        std::string shape = struct_type->to_string();
+        if (checked_shapes_.count(shape) > 0) {
+            return;
+        }
+        size_t error_count = errors_.size();
         check_struct_type(struct_type, context);
+        if (errors_.size() == error_count) {
+            checked_shapes_.insert(shape);
+        }
     } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(expr)) {
         check_variant_type(variant_type, context);
     } else if (auto* enum_type = dynamic_cast<parser::EnumTypeNode*>(expr)) {
         check_enum_type(enum_type, context);
     } else if (auto* container_type = dynamic_cast<parser::ContainerTypeNode*>(expr)) {
         check_container_type(container_type, context);
+    } else if (auto* prim = dynamic_cast<parser::PrimitiveTypeNode*>(expr)) {
+        // str<N> lives inside every instance; longer text belongs in str
+        if (prim->primitive == parser::PrimitiveType::STR && prim->length > 65535) {
+            report_error("Inline string capacity " + std::to_string(prim->length) + " in '" + context +
+                         "' exceeds the maximum of 65535 bytes; use str", expr);
+        }
+        if (prim->primitive == parser::PrimitiveType::QUANT) {
+            check_quant_type(prim, context);
+        }
     } else if (auto* id_type = dynamic_cast<parser::IdentifierTypeNode*>(expr)) {
         if (!is_type_defined(id_type->name)) {
             report_error("Undefined type '" + id_type->name + "' referenced in '" + context + "'", expr);
@@ -162,7 +238,360 @@ void TypeChecker::check_type_expr(parser::TypeExprNode* expr, const std::string&
             }
         }
     }
-    // Primitive and ref types are always valid
+    // Ref types are always valid
+}
+
+void TypeChecker::check_annotations(const std::vector<parser::Annotation>& annotations, parser::TypeExprNode* target,
+                                    bool on_definition, const std::string& context) {
+    std::unordered_set<std::string> seen;
+    for (const auto& annotation : annotations) {
+        const std::string& name = annotation.name;
+        if (seen.count(name) > 0) {
+            report_error("Duplicate annotation '@" + name + "' on '" + context + "'", annotation.line, annotation.column);
+            continue;
+        }
+        seen.insert(name);
+        
+        if (name == "align") {
+            bool valid = annotation.arguments.size() == 1 && !annotation.arguments[0].empty();
+            unsigned long value = 0;
+            for (char c : valid ? annotation.arguments[0] : std::string()) {
+                if (c < '0' || c > '9' || value > 4096) {
+                    valid = false;
+                    break;
+                }
+                value = value * 10 + static_cast<unsigned long>(c - '0');
+            }
+            if (!valid || value == 0 || value > 4096 || (value & (value - 1)) != 0) {
+                report_error("Annotation '@align' on '" + context + "' needs a power of two between 1 and 4096",
+                             annotation.line, annotation.column);
+            }
+        } else if (name == "packed" || name == "cacheline") {
+            if (!annotation.arguments.empty()) {
+                report_error("Annotation '@" + name + "' on '" + context + "' takes no arguments",
+                             annotation.line, annotation.column);
+            }
+            if (name == "packed" && !on_definition) {
+                report_error("Annotation '@packed' applies to struct definitions, not to field '" + context + "'",
+                             annotation.line, annotation.column);
+            }
+        } else if (name == "map") {
+            MapBackend backend;
+            if (annotation.arguments.size() != 1 || !parse_map_backend(annotation.arguments[0], backend)) {
+                report_error("Annotation '@map' on '" + context + "' needs one of std, flat or sorted",
+                             annotation.line, annotation.column);
+            }
+            auto* container = dynamic_cast<parser::ContainerTypeNode*>(target);
+            if (on_definition) {
+                report_error("Annotation '@map' applies to map fields, not to definition '" + context + "'",
+                             annotation.line, annotation.column);
+            } else if (!container || container->kind != parser::ContainerKind::MAP) {
+                report_error("Annotation '@map' requires a map type, but field '" + context + "' is not one",
+                             annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "optional") {
+            OptionalBackend backend;
+            if (annotation.arguments.size() != 1 || !parse_optional_backend(annotation.arguments[0], backend)) {
+                report_error("Annotation '@optional' on '" + context + "' needs one of std or compact",
+                             annotation.line, annotation.column);
+            }
+            auto* container = dynamic_cast<parser::ContainerTypeNode*>(target);
+            if (on_definition) {
+                report_error("Annotation '@optional' applies to optional fields, not to definition '" + context + "'",
+                             annotation.line, annotation.column);
+            } else if (!container || container->kind != parser::ContainerKind::OPTIONAL) {
+                report_error("Annotation '@optional' requires an optional type, but field '" + context +
+                             "' is not one", annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "indexed") {
+            if (!annotation.arguments.empty()) {
+                report_error("Annotation '@indexed' on '" + context + "' takes no arguments",
+                             annotation.line, annotation.column);
+            }
+            if (on_definition) {
+                report_error("Annotation '@indexed' applies to ref<entity> fields, not to definition '" + context + "'",
+                             annotation.line, annotation.column);
+            } else if (!dynamic_cast<parser::RefTypeNode*>(target)) {
+                report_error("Annotation '@indexed' requires a ref<entity> type, but field '" + context +
+                             "' is not one", annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "pooled") {
+            if (!annotation.arguments.empty()) {
+                report_error("Annotation '@pooled' on '" + context + "' takes no arguments",
+                             annotation.line, annotation.column);
+            }
+            auto* container = dynamic_cast<parser::ContainerTypeNode*>(target);
+            if (on_definition) {
+                report_error("Annotation '@pooled' applies to array<T> fields, not to definition '" + context + "'",
+                             annotation.line, annotation.column);
+            } else if (!container || container->kind != parser::ContainerKind::ARRAY || container->length > 0) {
+                report_error("Annotation '@pooled' requires a variable-length array<T>, but field '" + context +
+                             "' is not one", annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "variant") {
+            VariantBackend backend;
+            if (annotation.arguments.size() != 1 || !parse_variant_backend(annotation.arguments[0], backend)) {
+                report_error("Annotation '@variant' on '" + context + "' needs one of std or tagged",
+                             annotation.line, annotation.column);
+            }
+            if (!on_definition) {
+                report_error("Annotation '@variant' applies to variant definitions, not to field '" + context + "'",
+                             annotation.line, annotation.column);
+            } else if (!dynamic_cast<parser::VariantTypeNode*>(target)) {
+                report_error("Annotation '@variant' requires a variant, but '" + context + "' is not one",
+                             annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "partitioned") {
+            if (!annotation.arguments.empty()) {
+                report_error("Annotation '@partitioned' on '" + context + "' takes no arguments",
+                             annotation.line, annotation.column);
+            }
+            if (!on_definition) {
+                report_error("Annotation '@partitioned' applies to variant definitions, not to field '" + context + "'",
+                             annotation.line, annotation.column);
+            } else if (!dynamic_cast<parser::VariantTypeNode*>(target)) {
+                report_error("Annotation '@partitioned' requires a variant, but '" + context + "' is not one",
+                             annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "pod") {
+            if (!annotation.arguments.empty()) {
+                report_error("Annotation '@pod' on '" + context + "' takes no arguments",
+                             annotation.line, annotation.column);
+            }
+            if (!on_definition) {
+                report_error("Annotation '@pod' applies to struct and variant definitions, not to field '" +
+                             context + "'", annotation.line, annotation.column);
+            } else if (!dynamic_cast<parser::StructTypeNode*>(target) &&
+                       !dynamic_cast<parser::VariantTypeNode*>(target)) {
+                report_error("Annotation '@pod' requires a struct or variant, but '" + context + "' is neither",
+                             annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "double_buffered") {
+            if (!annotation.arguments.empty()) {
+                report_error("Annotation '@double_buffered' on '" + context + "' takes no arguments",
+                             annotation.line, annotation.column);
+            }
+            if (!on_definition) {
+                report_error("Annotation '@double_buffered' applies to struct and variant definitions, not to field '" +
+                             context + "'", annotation.line, annotation.column);
+            } else if (!dynamic_cast<parser::StructTypeNode*>(target) &&
+                       !dynamic_cast<parser::VariantTypeNode*>(target)) {
+                report_error("Annotation '@double_buffered' requires a struct or variant, but '" + context +
+                             "' is neither", annotation.line, annotation.column);
+            }
+            continue;
+        } else if (name == "cold") {
+            if (!annotation.arguments.empty()) {
+                report_error("Annotation '@cold' on '" + context + "' takes no arguments",
+                             annotation.line, annotation.column);
+            }
+            if (on_definition) {
+                report_error("Annotation '@cold' applies to struct fields, not to definition '" + context + "'",
+                             annotation.line, annotation.column);
+            } else if (parser::find_annotation(annotations, "indexed") ||
+                       parser::find_annotation(annotations, "pooled")) {
+                // The reference and span visitors reach fields through the struct
+                report_error("Field '" + context + "' cannot be both '@cold' and '@indexed' or '@pooled'",
+                             annotation.line, annotation.column);
+            }
+            continue;
+        } else {
+            report_error("Unknown annotation '@" + name + "' on '" + context + "'", annotation.line, annotation.column);
+            continue;
+        }
+        
+        // alignas can only be applied to a class the generator defines
+        if (on_definition && !dynamic_cast<parser::StructTypeNode*>(target)) {
+            report_error("Annotation '@" + name + "' requires a struct, but '" + context + "' is not one",
+                         annotation.line, annotation.column);
+        }
+    }
+    
+    if (seen.count("packed") > 0 && (seen.count("align") > 0 || seen.count("cacheline") > 0)) {
+        report_error("'" + context + "' cannot be both packed and aligned", annotations.front().line,
+                     annotations.front().column);
+    }
+    if (seen.count("align") > 0 && seen.count("cacheline") > 0) {
+        report_error("'" + context + "' cannot have both '@align' and '@cacheline'", annotations.front().line,
+                     annotations.front().column);
+    }
+}
+
+void TypeChecker::check_layout_attributes() {
+    // C++ rejects alignas weaker than the natural alignment, and packing
+    // members that own heap memory would misalign their internal pointers
+    LayoutEngine engine(ir_, TargetAbi::x86_64_sysv());
+    for (const auto& type : ir_.types) {
+        if (type.kind != TypeKind::STRUCT) continue;
+        for (uint32_t i = 0; i < type.count; ++i) {
+            const Field& field = ir_.fields[type.first + i];
+            uint32_t natural = engine.layout(field.type).align;
+            if (field.layout.align != 0 && field.layout.align < natural) {
+                report_error("Alignment " + std::to_string(field.layout.align) + " of field '" + field.name +
+                             "' is less than its natural alignment " + std::to_string(natural),
+                             field.line, field.column);
+            }
+        }
+    }
+    
+    for (const auto& def : ir_.definitions) {
+        const Type& type = ir_.type(def.type);
+        if (type.kind != TypeKind::STRUCT) continue;
+        if (def.layout.align != 0) {
+            uint32_t natural = 1;
+            for (uint32_t i = 0; i < type.count; ++i) {
+                natural = std::max(natural, engine.field_align(type.first + i));
+            }
+            if (def.layout.align < natural) {
+                report_error("Alignment " + std::to_string(def.layout.align) + " of '" + def.name +
+                             "' is less than its natural alignment " + std::to_string(natural),
+                             def.line, def.column);
+            }
+        }
+        if (def.layout.packed) {
+            for (uint32_t i = 0; i < type.count; ++i) {
+                const Field& field = ir_.fields[type.first + i];
+                if (!ir_.is_trivially_copyable(field.type)) {
+                    report_error("Packed struct '" + def.name + "' cannot hold field '" + field.name +
+                                 "', which owns heap memory", field.line, field.column);
+                }
+            }
+        }
+    }
+}
+
+void TypeChecker::check_compact_optionals() {
+    // A compact optional stores "none" as a value its element never holds
+    for (const auto& type : ir_.types) {
+        if (type.kind != TypeKind::STRUCT) continue;
+        for (uint32_t i = 0; i < type.count; ++i) {
+            const Field& field = ir_.fields[type.first + i];
+            const Type& field_type = ir_.type(field.type);
+            if (field_type.kind == TypeKind::OPTIONAL && field_type.optional_backend == OptionalBackend::COMPACT &&
+                ir_.niche_of(field_type.element) == Niche::NONE) {
+                report_error("Optional field '" + field.name + "' cannot be compact: its element has no spare "
+                             "value to mean none (use a ref, float, enum, integer or string)",
+                             field.line, field.column);
+            }
+        }
+    }
+}
+
+void TypeChecker::check_pooled_arrays() {
+    // Arenas move and snapshot their elements with memcpy
+    for (const auto& type : ir_.types) {
+        if (type.kind != TypeKind::STRUCT) continue;
+        for (uint32_t i = 0; i < type.count; ++i) {
+            const Field& field = ir_.fields[type.first + i];
+            const Type& field_type = ir_.type(field.type);
+            if (field_type.kind == TypeKind::ARRAY && field_type.pooled &&
+                !ir_.is_trivially_copyable(field_type.element)) {
+                report_error("Array field '" + field.name + "' cannot be pooled: its elements own heap memory",
+                             field.line, field.column);
+            }
+        }
+    }
+}
+
+void TypeChecker::check_pod_definitions() {
+    // A @pod value is all of its bytes, so it can be written out with memcpy
+    for (const auto& def : ir_.definitions) {
+        if (!def.pod || def.type == INVALID_ID) continue;
+        const Type& type = ir_.type(def.type);
+        for (uint32_t i = 0; i < type.count; ++i) {
+            const Field& field = ir_.fields[type.first + i];
+            if (field.type == INVALID_ID || ir_.is_wire_safe(field.type)) continue;
+            std::string reason = ir_.is_trivially_copyable(field.type)
+                                     ? "', which refers to storage outside the value (an istr or @pooled array)"
+                                     : "', which owns heap memory";
+            report_error("@pod type '" + def.name + "' cannot hold field '" + field.name + reason,
+                         field.line, field.column);
+        }
+    }
+}
+
+void TypeChecker::check_cold_fields() {
+    // @cold fields move to a side table that only component pools link to
+    // the struct, so the struct must be a definition stored on its own
+    for (TypeId id = 0; id < ir_.types.size(); ++id) {
+        const Type& type = ir_.type(id);
+        if (!ir_.has_cold_fields(id)) continue;
+        const Field* fields = ir_.fields_of(id);
+        if (type.definition == INVALID_ID) {
+            for (uint32_t i = 0; i < type.count; ++i) {
+                if (fields[i].cold) {
+                    report_error("Field '" + fields[i].name + "' cannot be @cold: only fields of struct "
+                                 "definitions are split into a side table", fields[i].line, fields[i].column);
+                }
+            }
+            continue;
+        }
+        const Definition& def = ir_.definitions[type.definition];
+        uint32_t hot = 0;
+        for (uint32_t i = 0; i < type.count; ++i) {
+            hot += fields[i].cold ? 0 : 1;
+        }
+        if (hot == 0) {
+            report_error("Struct '" + def.name + "' needs at least one field that is not @cold", def.line, def.column);
+        }
+        if (def.layout.packed) {
+            report_error("Packed struct '" + def.name + "' cannot have @cold fields", def.line, def.column);
+        }
+        if (def.references > 0) {
+            report_error("Struct '" + def.name + "' has @cold fields, so it can only be a component, not part of "
+                         "another type", def.line, def.column);
+        }
+    }
+}
+
+void TypeChecker::check_double_buffered_definitions() {
+    // Both buffers are plain copies of the components; references linked
+    // into a reverse index, spans into a shared arena and cold side tables
+    // live in a component pool instead
+    for (auto& def : schema_->definitions) {
+        if (!parser::find_annotation(def->annotations, "double_buffered")) continue;
+        if (const parser::FieldNode* field = find_storage_field(def->type.get())) {
+            report_error("@double_buffered type '" + def->name + "' cannot hold field '" + field->name +
+                         "', which is @indexed, @pooled or @cold", field->line, field->column);
+        }
+    }
+}
+
+const parser::FieldNode* TypeChecker::find_storage_field(parser::TypeExprNode* expr) const {
+    // Containers are not searched: none of the three annotations may apply
+    // to what they hold
+    if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(expr)) {
+        for (auto& field : struct_type->fields) {
+            for (const char* name : {"indexed", "pooled", "cold"}) {
+                if (parser::find_annotation(field->annotations, name)) {
+                    return field.get();
+                }
+            }
+            if (const parser::FieldNode* found = find_storage_field(field->type.get())) {
+                return found;
+            }
+        }
+    } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(expr)) {
+        for (auto& alt : variant_type->alternatives) {
+            const parser::FieldNode* found = alt->type ? find_storage_field(alt->type.get()) : nullptr;
+            if (found) {
+                return found;
+            }
+        }
+    } else if (auto* identifier = dynamic_cast<parser::IdentifierTypeNode*>(expr)) {
+        auto it = symbol_table_.find(identifier->name);
+        if (it != symbol_table_.end()) {
+            return find_storage_field(it->second->type.get());
+        }
+    }
+    return nullptr;
 }
 
 bool TypeChecker::has_circular_dependency(const std::string& type_name) {
@@ -249,11 +678,94 @@ bool TypeChecker::is_leaf_type(parser::TypeExprNode* expr) const {
            dynamic_cast<parser::EnumTypeNode*>(expr) != nullptr;
 }
 
+void TypeChecker::check_component_only_fields() {
+    // A component pool links the @indexed references and releases the
+    // @pooled spans of its own component type only, so a definition holding
+    // either cannot be named inside another type
+    for (auto& def : schema_->definitions) {
+        DefinitionId id = ir_.find_definition(def->name);
+        if (id == INVALID_ID || ir_.definitions[id].references == 0) continue;
+        for (const char* name : {"indexed", "pooled"}) {
+            if (const parser::FieldNode* field = find_annotated_field(def->type.get(), name)) {
+                report_error("Type '" + def->name + "' has @" + name + " field '" + field->name +
+                             "', so it can only be a component, not part of another type", def.get());
+            }
+        }
+    }
+}
+
+const parser::FieldNode* TypeChecker::find_annotated_field(parser::TypeExprNode* expr,
+                                                           const char* annotation) const {
+    // The paths check_field_paths allows: inline structs and alternatives
+    if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(expr)) {
+        for (auto& field : struct_type->fields) {
+            if (parser::find_annotation(field->annotations, annotation)) {
+                return field.get();
+            }
+            if (const parser::FieldNode* found = find_annotated_field(field->type.get(), annotation)) {
+                return found;
+            }
+        }
+    } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(expr)) {
+        for (auto& alt : variant_type->alternatives) {
+            const parser::FieldNode* found = alt->type ? find_annotated_field(alt->type.get(), annotation) : nullptr;
+            if (found) {
+                return found;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void TypeChecker::check_field_paths(parser::TypeExprNode* expr, const std::string& context, bool reachable,
+                                    bool packed) {
+    // The generated carch_visit_refs and carch_visit_spans reach a field by
+    // member access through inline structs and the alternatives of a variant
+    // definition; fields inside containers or inline variants have no fixed path
+    if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(expr)) {
+        for (auto& field : struct_type->fields) {
+            std::string field_context = context + "." + field->name;
+            for (const char* name : {"indexed", "pooled"}) {
+                if (parser::find_annotation(field->annotations, name) && !reachable) {
+                    report_error("Field '" + field_context + "' cannot be '@" + name +
+                                 "' inside a container or inline variant", field.get());
+                }
+            }
+            if (parser::find_annotation(field->annotations, "indexed") && reachable && packed) {
+                report_error("Field '" + field_context + "' of a packed struct cannot be '@indexed'", field.get());
+            }
+            bool inline_variant = dynamic_cast<parser::VariantTypeNode*>(field->type.get()) != nullptr;
+            check_field_paths(field->type.get(), field_context, reachable && !inline_variant, false);
+        }
+    } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(expr)) {
+        for (auto& alt : variant_type->alternatives) {
+            if (alt->type) {
+                check_field_paths(alt->type.get(), context + "." + alt->name, reachable, false);
+            }
+        }
+    } else if (auto* container_type = dynamic_cast<parser::ContainerTypeNode*>(expr)) {
+        for (auto* element : {container_type->element_type.get(), container_type->key_type.get(),
+                              container_type->value_type.get()}) {
+            if (element) {
+                check_field_paths(element, context, false, false);
+            }
+        }
+    }
+}
+
 void TypeChecker::check_leaf_nodes(parser::TypeExprNode* expr, const std::string& context, bool must_terminate) {
     if (auto* struct_type = dynamic_cast<parser::StructTypeNode*>(expr)) {
+        std::string shape = struct_type->to_string();
+        if (terminated_shapes_.count(shape) > 0) {
+            return;
+        }
+        size_t error_count = errors_.size();
         for (auto& field : struct_type->fields) {
             check_leaf_nodes(field->type.get(), context + "." + field->name, true);
         }
+        if (errors_.size() == error_count) {
+            terminated_shapes_.insert(shape);
+        }
     } else if (auto* variant_type = dynamic_cast<parser::VariantTypeNode*>(expr)) {
         for (auto& alt : variant_type->alternatives) {
             if (alt->type) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../parser/ast.h"
+#include "schema_ir.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -20,10 +21,14 @@ public:
     // Error reporting
     const std::vector<std::string>& errors() const { return errors_; }
     bool has_errors() const { return !errors_.empty(); }
+    
+    // Resolved IR of the schema; only populated when check() succeeds
+    const SchemaIR& ir() const { return ir_; }
 
 private:
     parser::SchemaNode* schema_;
     std::vector<std::string> errors_;
+    SchemaIR ir_;
     
     // Symbol table: type name -> type definition
     std::unordered_map<std::string, parser::TypeDefinitionNode*> symbol_table_;
@@ -36,6 +41,12 @@ private:
     std::unordered_set<std::string> visiting_;
     std::unordered_set<std::string> visited_;
     
+    // Struct shapes (keyed by structure) that already passed each check.
+    // Definitions are checked in order, so a shape that was valid once stays
+    // valid for every later occurrence and is not walked again.
+    std::unordered_set<std::string> checked_shapes_;
+    std::unordered_set<std::string> terminated_shapes_;
+    
     // Validation methods
     void build_symbol_table();
     void check_type_definitions();
@@ -43,8 +54,21 @@ private:
     void check_struct_type(parser::StructTypeNode* node, const std::string& context);
     void check_variant_type(parser::VariantTypeNode* node, const std::string& context);
     void check_enum_type(parser::EnumTypeNode* node, const std::string& context);
+    void check_quant_type(parser::PrimitiveTypeNode* node, const std::string& context);
     void check_container_type(parser::ContainerTypeNode* node, const std::string& context);
     void check_type_expr(parser::TypeExprNode* expr, const std::string& context);
+    void check_annotations(const std::vector<parser::Annotation>& annotations, parser::TypeExprNode* target,
+                           bool on_definition, const std::string& context);
+    void check_layout_attributes();
+    void check_compact_optionals();
+    void check_pooled_arrays();
+    void check_pod_definitions();
+    void check_cold_fields();
+    void check_component_only_fields();
+    const parser::FieldNode* find_annotated_field(parser::TypeExprNode* expr, const char* annotation) const;
+    void check_double_buffered_definitions();
+    const parser::FieldNode* find_storage_field(parser::TypeExprNode* expr) const;
+    void check_field_paths(parser::TypeExprNode* expr, const std::string& context, bool reachable, bool packed);
     
     // Check for circular dependencies
     bool has_circular_dependency(const std::string& type_name);
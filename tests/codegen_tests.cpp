@@ -129,12 +129,53 @@ void test_includes() {
     std::string header = generator.generate_header();
     
     assert(header.find("#include <cstdint>") != std::string::npos);
-    assert(header.find("#include <string>") != std::string::npos);
-    assert(header.find("#include <vector>") != std::string::npos);
+    
+    // Only the headers the schema actually needs are included
+    assert(header.find("#include <string>") == std::string::npos);
+    assert(header.find("#include <vector>") == std::string::npos);
+    assert(header.find("#include <variant>") == std::string::npos);
+    
+    std::string container_source = "Bag : struct { items: array<str>, owner: optional<u32> }";
+    auto container_schema = parse(container_source);
+    CppGenerator container_generator(container_schema.get());
+    std::string container_header = container_generator.generate_header();
+    
+    assert(container_header.find("#include <string>") != std::string::npos);
+    assert(container_header.find("#include <vector>") != std::string::npos);
+    assert(container_header.find("#include <optional>") != std::string::npos);
+    assert(container_header.find("#include <unordered_map>") == std::string::npos);
     
     std::cout << "  ✓ Includes generated correctly\n";
 }
 
+void test_forward_header() {
+    std::cout << "Testing forward declaration header...\n";
+    
+    std::string source = R"(
+        Team : enum { red, blue }
+        Health : struct { current: u32 }
+        State : variant { idle, moving: struct { speed: f32 } }
+    )";
+    auto schema = parse(source);
+    
+    GenerationOptions options;
+    options.output_basename = "components";
+    CppGenerator generator(schema.get(), options);
+    std::string fwd = generator.generate_forward_header();
+    
+    assert(fwd.find("CARCH_GAME_COMPONENTS_FWD_H") != std::string::npos);
+    assert(fwd.find("struct Health;") != std::string::npos);
+    assert(fwd.find("enum class Team : uint8_t;") != std::string::npos);
+    assert(fwd.find("struct State_Moving;") != std::string::npos);
+    assert(fwd.find("using State = std::variant<std::monostate, State_Moving>;") != std::string::npos);
+    
+    // No full definitions and no heavy standard headers
+    assert(fwd.find("struct Health {") == std::string::npos);
+    assert(fwd.find("#include <string>") == std::string::npos);
+    
+    std::cout << "  ✓ Forward header generated correctly\n";
+}
+
 void test_header_guard() {
     std::cout << "Testing header guard generation...\n";
     
@@ -185,6 +226,788 @@ void test_pascal_case_conversion() {
     std::cout << "  ✓ PascalCase conversion correct\n";
 }
 
+void test_split_output() {
+    std::cout << "Testing split header generation...\n";
+    
+    std::string source = R"(
+        Health : struct { current: u32, max: u32 }
+        Team : enum { red, blue }
+        Player : struct { health: Health, team: Team, target: ref<entity> }
+    )";
+    auto schema = parse(source);
+    
+    GenerationOptions options;
+    options.output_basename = "components";
+    options.split_output = true;
+    CppGenerator generator(schema.get(), options);
+    
+    auto files = generator.generate_split_headers();
+    
+    // fwd header, one header per definition, umbrella header
+    assert(files.size() == 5);
+    assert(files[0].path == "components_fwd.h");
+    assert(files[1].path == "components/Health.h");
+    assert(files[4].path == "components.h");
+    
+    const std::string& fwd = files[0].content;
+    assert(fwd.find("struct Health;") != std::string::npos);
+    assert(fwd.find("enum class Team : uint8_t;") != std::string::npos);
+    assert(fwd.find("using entity_id") != std::string::npos);
+    
+    // Health does not depend on any other definition
+    const std::string& health = files[1].content;
+    assert(health.find("struct Health {") != std::string::npos);
+    assert(health.find("#include \"components/") == std::string::npos);
+    
+    // Player only includes the definitions it names
+    const std::string& player = files[3].content;
+    assert(player.find("#include \"components/Health.h\"") != std::string::npos);
+    assert(player.find("#include \"components/Team.h\"") != std::string::npos);
+    assert(player.find("#include \"components/Player.h\"") == std::string::npos);
+    assert(player.find("struct Player {") != std::string::npos);
+    
+    const std::string& umbrella = files[4].content;
+    assert(umbrella.find("#include \"components_fwd.h\"") != std::string::npos);
+    assert(umbrella.find("#include \"components/Player.h\"") != std::string::npos);
+    
+    std::cout << "  ✓ Split headers generated correctly\n";
+}
+
+void test_module_generation() {
+    std::cout << "Testing module interface generation...\n";
+    
+    std::string source = R"(
+        Health : struct { current: u32, max: u32 }
+        Player : struct { health: Health, name: str }
+    )";
+    auto schema = parse(source);
+    
+    GenerationOptions options;
+    options.output_basename = "components";
+    options.output_kind = OutputKind::MODULE;
+    CppGenerator generator(schema.get(), options);
+    
+    std::string module = generator.generate_module();
+    
+    // Standard headers belong to the global module fragment
+    size_t fragment = module.find("module;");
+    size_t include = module.find("#include <string>");
+    size_t declaration = module.find("export module game.components;");
+    assert(fragment == 0);
+    assert(include != std::string::npos && include > fragment);
+    assert(declaration != std::string::npos && declaration > include);
+    assert(module.find("export namespace game {") != std::string::npos);
+    assert(module.find("struct Player {") != std::string::npos);
+    assert(module.find("#pragma once") == std::string::npos);
+    
+    CppGenerator split_generator(schema.get(), options);
+    auto files = split_generator.generate_split_modules();
+    
+    // base module, one module per definition, umbrella module
+    assert(files.size() == 4);
+    assert(files[0].path == "components/base.cppm");
+    assert(files[2].path == "components/Player.cppm");
+    assert(files[3].path == "components.cppm");
+    
+    const std::string& player = files[2].content;
+    assert(player.find("export module game.components.Player;") != std::string::npos);
+    assert(player.find("export import game.components.Health;") != std::string::npos);
+    
+    const std::string& umbrella = files[3].content;
+    assert(umbrella.find("export import game.components.Player;") != std::string::npos);
+    
+    std::cout << "  ✓ Module interfaces generated correctly\n";
+}
+
+size_t count_occurrences(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void test_anonymous_struct_hash_consing() {
+    std::cout << "Testing anonymous struct hash-consing...\n";
+    
+    std::string source = R"(
+        Transform : struct { position: struct { x: f32, y: f32 }, scale: struct { x: f32, y: f32 } }
+        RigidBody : struct { velocity: struct { x: f32, y: f32 }, mass: f32 }
+        Path : struct { points: array<struct { x: f32, y: f32 }>, colour: struct { r: u8, g: u8, b: u8 } }
+        Loot : struct { drops: array<struct { item: u32, chance: f32 }> }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    
+    // The shared shape is emitted once and reused everywhere
+    assert(count_occurrences(header, "struct XY_Struct {") == 1);
+    assert(header.find("XY_Struct position;") != std::string::npos);
+    assert(header.find("XY_Struct velocity;") != std::string::npos);
+    assert(header.find("std::vector<XY_Struct> points;") != std::string::npos);
+    assert(header.find("struct XY_Struct {") < header.find("struct Transform {"));
+    
+    // A unique shape stays inline unless it appears in a template argument
+    assert(header.find("struct { uint8_t r; uint8_t g; uint8_t b; } colour;") != std::string::npos);
+    assert(header.find("std::vector<LootDrops_Struct> drops;") != std::string::npos);
+    assert(header.find("std::vector<struct") == std::string::npos);
+    
+    // Split output gives the shared shape a header of its own
+    GenerationOptions options;
+    options.output_basename = "components";
+    CppGenerator split_generator(schema.get(), options);
+    auto files = split_generator.generate_split_headers();
+    
+    bool found_shape = false;
+    for (const auto& file : files) {
+        if (file.path == "components/XY_Struct.h") {
+            found_shape = true;
+            assert(file.content.find("struct XY_Struct {") != std::string::npos);
+        }
+        if (file.path == "components/RigidBody.h") {
+            assert(file.content.find("#include \"components/XY_Struct.h\"") != std::string::npos);
+            assert(file.content.find("struct XY_Struct {") == std::string::npos);
+        }
+    }
+    assert(found_shape);
+    
+    std::cout << "  ✓ Anonymous structs hash-consed correctly\n";
+}
+
+void test_layout_optimization() {
+    std::cout << "Testing padding-minimizing field reordering...\n";
+    
+    std::string source = "Sprite : struct { visible: bool, id: u64, layer: i16, texture_id: u32 }";
+    auto schema = parse(source);
+    
+    // Declaration order by default: 1 + 7 + 8 + 2 + 2 + 4 = 24 bytes
+    CppGenerator default_generator(schema.get());
+    std::string plain = default_generator.generate_header();
+    assert(plain.find("bool visible;") < plain.find("uint64_t id;"));
+    assert(plain.find("static_assert(sizeof(Sprite) == 24") != std::string::npos);
+    assert(plain.find("static_assert(alignof(Sprite) == 8") != std::string::npos);
+    assert(plain.find("carch_visit_fields") == std::string::npos);
+    
+    // Sorted by alignment: 8 + 4 + 2 + 1 + 1 tail padding = 16 bytes
+    GenerationOptions options;
+    options.optimize_layout = true;
+    CppGenerator generator(schema.get(), options);
+    std::string header = generator.generate_header();
+    size_t id = header.find("uint64_t id;");
+    size_t texture_id = header.find("uint32_t texture_id;");
+    size_t layer = header.find("int16_t layer;");
+    size_t visible = header.find("bool visible;");
+    assert(id < texture_id && texture_id < layer && layer < visible);
+    assert(header.find("static_assert(sizeof(Sprite) == 16") != std::string::npos);
+    
+    // The visitor keeps the schema's declaration order
+    size_t visitor = header.find("carch_visit_fields");
+    assert(visitor != std::string::npos);
+    assert(header.find("visit(\"visible\"", visitor) < header.find("visit(\"id\"", visitor));
+    assert(header.find("visit(\"layer\"", visitor) < header.find("visit(\"texture_id\"", visitor));
+    
+    // Checks can be turned off
+    options.layout_asserts = false;
+    CppGenerator unchecked_generator(schema.get(), options);
+    assert(unchecked_generator.generate_header().find("static_assert") == std::string::npos);
+    
+    std::cout << "  ✓ Fields reordered with declaration-order visitor and layout checks\n";
+}
+
+void test_layout_annotations() {
+    std::cout << "Testing alignment, packing and cache-line annotations...\n";
+    
+    std::string source = R"(
+        @align(16) Vec : struct { x: f32, y: f32, z: f32 }
+        @packed Header : struct { tag: u8, length: u32 }
+        Queue : struct { @cacheline head: u64, @cacheline tail: u64, @align(8) mode: u8 }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("struct alignas(16) Vec {") != std::string::npos);
+    assert(header.find("#pragma pack(push, 1)\nstruct Header {") != std::string::npos);
+    assert(header.find("};\n#pragma pack(pop)") != std::string::npos);
+    assert(header.find("static_assert(sizeof(Header) == 5") != std::string::npos);
+    
+    // Cache-line fields are padded so the next field starts a new line
+    assert(header.find("alignas(64) uint64_t head;\n    char carch_padding_head[56];") != std::string::npos);
+    assert(header.find("char carch_padding_tail[56];") != std::string::npos);
+    assert(header.find("alignas(8) uint8_t mode;") != std::string::npos);
+    assert(header.find("carch_padding_mode") == std::string::npos);
+    assert(header.find("static_assert(sizeof(Queue) == 192") != std::string::npos);
+    assert(header.find("static_assert(alignof(Queue) == 64") != std::string::npos);
+    
+    std::cout << "  ✓ alignas, packing pragmas and padding members generated\n";
+}
+
+void test_sized_arrays() {
+    std::cout << "Testing fixed and small array generation...\n";
+    
+    std::string source = "Patrol : struct { waypoints: small_array<ref<entity>, 4>, color: array<u8, 4> }";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("carch::SmallArray<entity_id, 4> waypoints;") != std::string::npos);
+    assert(header.find("std::array<uint8_t, 4> color;") != std::string::npos);
+    assert(header.find("#include \"carch/small_array.h\"") != std::string::npos);
+    assert(header.find("#include <array>") != std::string::npos);
+    assert(header.find("static_assert(sizeof(Patrol) == 48") != std::string::npos);
+    
+    // The runtime header ships with the generated code, and the headers it includes
+    auto runtime = generator.generate_runtime_headers();
+    assert(runtime.size() == 3);
+    assert(runtime[0].path == "carch/entity.h");
+    assert(runtime[1].path == "carch/small_array.h");
+    assert(runtime[1].content.find("class SmallArray") != std::string::npos);
+    assert(runtime[2].path == "carch/traits.h");
+    
+    // Schemas that do not use it get no runtime headers
+    auto plain_schema = parse("Position : struct { x: f32, y: f32 }");
+    CppGenerator plain_generator(plain_schema.get());
+    plain_generator.generate_header();
+    assert(plain_generator.generate_runtime_headers().empty());
+    
+    std::cout << "  ✓ std::array and carch::SmallArray generated with runtime header\n";
+}
+
+void test_string_types() {
+    std::cout << "Testing inline and interned string generation...\n";
+    
+    std::string source = "Label : struct { text: str<24>, kind: istr, counts: map<istr, u32> }";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("carch::FixedString<24> text;") != std::string::npos);
+    assert(header.find("carch::InternedString kind;") != std::string::npos);
+    assert(header.find("std::unordered_map<carch::InternedString, uint32_t> counts;") != std::string::npos);
+    assert(header.find("#include \"carch/fixed_string.h\"") != std::string::npos);
+    assert(header.find("#include \"carch/interned_string.h\"") != std::string::npos);
+    assert(header.find("#include <string>") == std::string::npos);
+    
+    auto runtime = generator.generate_runtime_headers();
+    assert(runtime.size() == 2);
+    assert(runtime[0].path == "carch/fixed_string.h");
+    assert(runtime[1].path == "carch/interned_string.h");
+    
+    std::cout << "  ✓ carch::FixedString and carch::InternedString generated\n";
+}
+
+void test_vector_types() {
+    std::cout << "Testing vector and quaternion generation...\n";
+    
+    std::string source = "Transform : struct { position: vec3, rotation: quat, uv: vec2, cell: ivec2, cells: map<ivec3, u8> }";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("carch::Vec3 position;") != std::string::npos);
+    assert(header.find("carch::Quat rotation;") != std::string::npos);
+    assert(header.find("carch::Vec2 uv;") != std::string::npos);
+    assert(header.find("carch::IVec2 cell;") != std::string::npos);
+    assert(header.find("std::unordered_map<carch::IVec3, uint8_t> cells;") != std::string::npos);
+    assert(header.find("#include \"carch/vector.h\"") != std::string::npos);
+    // 16 + 16 + 8 + 8 + 56, aligned to the 16-byte vectors
+    assert(header.find("static_assert(sizeof(Transform) == 112") != std::string::npos);
+    assert(header.find("static_assert(alignof(Transform) == 16") != std::string::npos);
+    
+    auto runtime = generator.generate_runtime_headers();
+    assert(runtime.size() == 1);
+    assert(runtime[0].path == "carch/vector.h");
+    
+    std::cout << "  ✓ carch::Vec3, carch::Quat and integer vectors generated\n";
+}
+
+void test_reduced_precision_types() {
+    std::cout << "Testing reduced-precision generation...\n";
+    
+    std::string source = "Sprite : struct { alpha: unorm8, depth: f16, tilt: snorm16, "
+                         "angle: quant<-1.5, 1.5, 10>, health: quant<0, 100, 7> }";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("carch::Unorm8 alpha;") != std::string::npos);
+    assert(header.find("carch::Half depth;") != std::string::npos);
+    assert(header.find("carch::Snorm16 tilt;") != std::string::npos);
+    assert(header.find("carch::Quantized<-15, 15, 10, 1> angle;") != std::string::npos);
+    assert(header.find("carch::Quantized<0, 100, 7> health;") != std::string::npos);
+    assert(header.find("#include \"carch/quantized.h\"") != std::string::npos);
+    // 1 | 1 + 2 + 2 + 2 + 1 | 1
+    assert(header.find("static_assert(sizeof(Sprite) == 10") != std::string::npos);
+    
+    auto runtime = generator.generate_runtime_headers();
+    assert(runtime.size() == 1);
+    assert(runtime[0].path == "carch/quantized.h");
+    
+    std::cout << "  ✓ carch::Half, carch::Unorm8 and carch::Quantized generated\n";
+}
+
+void test_map_backends() {
+    std::cout << "Testing map backend generation...\n";
+    
+    std::string source = R"(
+        Stats : struct {
+            values: map<u32, f32>,
+            @map(sorted) modifiers: map<u8, f32>,
+            @map(std) names: map<str, u32>
+        }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("std::unordered_map<uint32_t, float> values;") != std::string::npos);
+    assert(header.find("carch::SortedFlatMap<uint8_t, float> modifiers;") != std::string::npos);
+    assert(header.find("#include \"carch/sorted_map.h\"") != std::string::npos);
+    assert(header.find("static_assert(sizeof(Stats) == 136") != std::string::npos);
+    
+    // A flat default applies to every map without an annotation
+    GenerationOptions options;
+    options.map_backend = carch::semantic::MapBackend::FLAT;
+    CppGenerator flat_generator(schema.get(), options);
+    std::string flat_header = flat_generator.generate_header();
+    assert(flat_header.find("carch::FlatHashMap<uint32_t, float> values;") != std::string::npos);
+    assert(flat_header.find("carch::SortedFlatMap<uint8_t, float> modifiers;") != std::string::npos);
+    assert(flat_header.find("std::unordered_map<std::string, uint32_t> names;") != std::string::npos);
+    assert(flat_header.find("static_assert(sizeof(Stats) == 112") != std::string::npos);
+    
+    auto runtime = flat_generator.generate_runtime_headers();
+    assert(runtime.size() == 3);
+    assert(runtime[0].path == "carch/flat_map.h");
+    assert(runtime[1].path == "carch/sorted_map.h");
+    assert(runtime[2].path == "carch/traits.h");
+    
+    std::cout << "  ✓ std::unordered_map, carch::FlatHashMap and carch::SortedFlatMap generated\n";
+}
+
+void test_tagged_variants() {
+    std::cout << "Testing tagged variant generation...\n";
+    
+    std::string source = R"(
+        @variant(tagged) Shape : variant { circle: struct { radius: f32 }, square: f32, empty }
+        Message : variant { text: str, ping }
+        Holder : struct { shape: Shape }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("class Shape {") != std::string::npos);
+    assert(header.find("enum class Tag : uint8_t {") != std::string::npos);
+    assert(header.find("struct Shape_Empty {};") != std::string::npos);
+    assert(header.find("case Tag::Circle: return std::forward<Visitor>(visitor)(storage_.circle);") != std::string::npos);
+    assert(header.find("#include \"carch/tagged_union.h\"") != std::string::npos);
+    assert(header.find("using Message = std::variant<") != std::string::npos);
+    
+    // Trivially copyable alternatives need no hand-written copy or destructor
+    assert(header.find("Shape(const Shape&) = default;") != std::string::npos);
+    assert(header.find("~Shape()") == std::string::npos);
+    assert(header.find("static_assert(sizeof(Shape) == 8") != std::string::npos);
+    
+    // The default backend applies to variants without an annotation
+    GenerationOptions options;
+    options.variant_backend = carch::semantic::VariantBackend::TAGGED;
+    CppGenerator tagged_generator(schema.get(), options);
+    std::string tagged_header = tagged_generator.generate_header();
+    assert(tagged_header.find("class Message {") != std::string::npos);
+    assert(tagged_header.find("~Message() { destroy(); }") != std::string::npos);
+    assert(tagged_header.find("std::is_nothrow_move_constructible_v<Message_Text>") != std::string::npos);
+    assert(tagged_header.find("std::variant") == std::string::npos);
+    assert(tagged_header.find("static_assert(sizeof(Message) == 40") != std::string::npos);
+    
+    std::string forward = tagged_generator.generate_forward_header();
+    assert(forward.find("class Shape;") != std::string::npos);
+    assert(forward.find("#include <variant>") == std::string::npos);
+    
+    std::cout << "  ✓ Tag enum, union storage and switch visitors generated\n";
+}
+
+void test_compact_optionals() {
+    std::cout << "Testing compact optional generation...\n";
+    
+    std::string source = R"(
+        Target : struct {
+            who: optional<ref<entity>>,
+            speed: optional<f32>,
+            @optional(compact) delta: optional<i16>,
+            @optional(compact) name: optional<str>
+        }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("std::optional<entity_id> who;") != std::string::npos);
+    assert(header.find("carch::CompactOptional<int16_t, carch::MinNiche<int16_t>> delta;") != std::string::npos);
+    assert(header.find("carch::CompactOptional<std::string, carch::EmptyNiche<std::string>> name;") !=
+           std::string::npos);
+    
+    GenerationOptions options;
+    options.optional_backend = carch::semantic::OptionalBackend::COMPACT;
+    CppGenerator compact_generator(schema.get(), options);
+    std::string compact_header = compact_generator.generate_header();
+    assert(compact_header.find("carch::CompactOptional<entity_id, carch::EntityNiche<entity_id>> who;") !=
+           std::string::npos);
+    assert(compact_header.find("carch::CompactOptional<float, carch::NanNiche<float>> speed;") != std::string::npos);
+    assert(compact_header.find("#include <optional>") == std::string::npos);
+    assert(compact_header.find("static_assert(sizeof(Target) == 48") != std::string::npos);
+    
+    auto runtime = compact_generator.generate_runtime_headers();
+    assert(runtime.size() == 2 && runtime[0].path == "carch/compact_optional.h");
+    
+    std::cout << "  ✓ carch::CompactOptional generated with a niche per element type\n";
+}
+
+void test_flags_generation() {
+    std::cout << "Testing enum and flags generation...\n";
+    
+    std::string source = R"(
+        Team : enum { red, blue }
+        Permissions : flags { read, write, exec }
+        Door : struct { access: Permissions, state: flags { open, locked }, team: Team }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("enum class Team : uint8_t {") != std::string::npos);
+    assert(header.find("constexpr uint32_t carch_enum_count(Team) noexcept { return 2; }") != std::string::npos);
+    assert(header.find("enum class Permissions_Flag : uint8_t {") != std::string::npos);
+    assert(header.find("using Permissions = carch::EnumSet<Permissions_Flag, 3>;") != std::string::npos);
+    assert(header.find("constexpr Permissions operator|(Permissions_Flag a, Permissions_Flag b)") != std::string::npos);
+    assert(header.find("using DoorState_Flags = carch::EnumSet<DoorState_Flag, 2>;") != std::string::npos);
+    assert(header.find("DoorState_Flags state;") != std::string::npos);
+    assert(header.find("#include \"carch/enum_containers.h\"") != std::string::npos);
+    assert(header.find("static_assert(sizeof(Door) == 3") != std::string::npos);
+    
+    std::string forward = generator.generate_forward_header();
+    assert(forward.find("enum class Permissions_Flag : uint8_t;") != std::string::npos);
+    assert(forward.find("using Permissions = carch::EnumSet<Permissions_Flag, 3>;") != std::string::npos);
+    
+    std::cout << "  ✓ Sized enum classes and carch::EnumSet flags generated\n";
+}
+
+void test_entity_handles() {
+    std::cout << "Testing entity handle generation...\n";
+    
+    std::string source = "Chase : struct { target: ref<entity>, speed: f32 }";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("using entity_id = carch::Entity64;") != std::string::npos);
+    assert(header.find("using entity_allocator = carch::EntityAllocator<entity_id>;") != std::string::npos);
+    assert(header.find("#include \"carch/entity.h\"") != std::string::npos);
+    assert(header.find("entity_id target;") != std::string::npos);
+    assert(header.find("static_assert(sizeof(Chase) == 16") != std::string::npos);
+    assert(generator.generate_forward_header().find("using entity_id = carch::Entity64;") != std::string::npos);
+    
+    auto runtime = generator.generate_runtime_headers();
+    assert(runtime.size() == 1 && runtime[0].path == "carch/entity.h");
+    assert(runtime[0].content.find("class EntityAllocator") != std::string::npos);
+    
+    // 32-bit handles halve the reference
+    GenerationOptions narrow;
+    narrow.entity_id_typedef = "carch::Entity32";
+    CppGenerator narrow_generator(schema.get(), narrow);
+    std::string narrow_header = narrow_generator.generate_header();
+    assert(narrow_header.find("using entity_id = carch::Entity32;") != std::string::npos);
+    assert(narrow_header.find("static_assert(sizeof(Chase) == 8") != std::string::npos);
+    
+    // Plain integer ids keep the old typedef and need no runtime
+    GenerationOptions plain;
+    plain.entity_id_typedef = "uint64_t";
+    CppGenerator plain_generator(schema.get(), plain);
+    std::string plain_header = plain_generator.generate_header();
+    assert(plain_header.find("using entity_id = uint64_t;") != std::string::npos);
+    assert(plain_header.find("entity_allocator") == std::string::npos);
+    assert(plain_generator.generate_runtime_headers().empty());
+    
+    // Schemas without references get no handle
+    auto position = parse("Position : struct { x: f32, y: f32 }");
+    CppGenerator position_generator(position.get());
+    assert(position_generator.generate_header().find("entity_id") == std::string::npos);
+    
+    std::cout << "  ✓ carch::Entity64, carch::Entity32 and the entity allocator generated\n";
+}
+
+void test_indexed_refs() {
+    std::cout << "Testing @indexed reference generation...\n";
+    
+    std::string source = R"(
+        AIState : variant {
+            idle,
+            chase: struct { @indexed target: ref<entity>, speed: f32 },
+            flee: struct { from: ref<entity> }
+        }
+        Follower : struct { @indexed leader: ref<entity>, combat: struct { @indexed target: ref<entity> } }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("using reverse_index = carch::ReverseIndex<entity_id>;") != std::string::npos);
+    assert(header.find("using component_pool = carch::ComponentPool<T, entity_id>;") != std::string::npos);
+    assert(header.find("#include \"carch/component_pool.h\"") != std::string::npos);
+    assert(header.find("enum class AIState_Ref : uint32_t {\n    chase_target,\n};") != std::string::npos);
+    assert(header.find("void carch_visit_refs(AIState& value, Visitor&& visit) {\n"
+                       "    if (auto* alt = std::get_if<AIState_Chase>(&value)) {\n"
+                       "        visit(AIState_Ref::chase_target, alt->target);") != std::string::npos);
+    assert(header.find("visit(Follower_Ref::leader, value.leader);") != std::string::npos);
+    assert(header.find("visit(Follower_Ref::combat_target, value.combat.target);") != std::string::npos);
+    assert(header.find("flee_from") == std::string::npos);
+    
+    auto runtime = generator.generate_runtime_headers();
+    assert(runtime.size() == 4);
+    assert(runtime[0].path == "carch/component_pool.h");
+    assert(runtime[1].path == "carch/entity.h");
+    assert(runtime[2].path == "carch/reverse_index.h");
+    assert(runtime[3].path == "carch/traits.h");
+    
+    // Tagged variants are read through get_if
+    GenerationOptions tagged;
+    tagged.variant_backend = carch::semantic::VariantBackend::TAGGED;
+    CppGenerator tagged_generator(schema.get(), tagged);
+    assert(tagged_generator.generate_header().find("if (auto* alt = value.get_if<AIState_Chase>()) {") !=
+           std::string::npos);
+    
+    // Without @indexed nothing is generated
+    auto plain = parse("Chase : struct { target: ref<entity> }");
+    CppGenerator plain_generator(plain.get());
+    std::string plain_header = plain_generator.generate_header();
+    assert(plain_header.find("carch_visit_refs") == std::string::npos);
+    assert(plain_header.find("component_pool") == std::string::npos);
+    
+    std::cout << "  ✓ carch_visit_refs and the component pool aliases generated\n";
+}
+
+void test_partitioned_variants() {
+    std::cout << "Testing @partitioned variant storage generation...\n";
+    
+    std::string source = R"(
+        @partitioned Collider : variant {
+            circle: struct { radius: f32 },
+            box: struct { half_extents: vec3 },
+            none
+        }
+        @partitioned @variant(tagged) Shape : variant { circle: struct { radius: f32 }, point }
+        Plain : variant { a: u32, b }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("using Collider_Storage = carch::VariantStorage<Collider_Circle, Collider_Box, "
+                       "std::monostate>;") != std::string::npos);
+    // Tagged variants name their unit alternatives
+    assert(header.find("using Shape_Storage = carch::VariantStorage<Shape_Circle, Shape_Point>;") != std::string::npos);
+    assert(header.find("Plain_Storage") == std::string::npos);
+    assert(header.find("#include \"carch/variant_storage.h\"") != std::string::npos);
+    
+    auto runtime = generator.generate_runtime_headers();
+    assert(runtime.size() == 4);
+    assert(runtime[1].path == "carch/type_list.h");
+    assert(runtime[2].path == "carch/variant_storage.h");
+    
+    std::cout << "  ✓ Storage aliases generated for @partitioned variants only\n";
+}
+
+void test_archetypes() {
+    std::cout << "Testing archetype storage generation...\n";
+    
+    std::string source = R"(
+        Team : enum { red, blue }
+        Transform : struct { position: vec3, rotation: quat }
+        RigidBody : struct { velocity: vec3, mass: f32 }
+        Shape : variant { circle: struct { radius: f32 }, point }
+    )";
+    auto schema = parse(source);
+    
+    GenerationOptions options;
+    options.archetypes = true;
+    CppGenerator generator(schema.get(), options);
+    std::string header = generator.generate_header();
+    
+    // Structs and variants are components; enums are not
+    assert(header.find("enum class component_id : uint32_t {\n"
+                       "    Transform,\n"
+                       "    RigidBody,\n"
+                       "    Shape,\n"
+                       "};") != std::string::npos);
+    assert(header.find("using component_set = carch::EnumSet<component_id, 3>;") != std::string::npos);
+    assert(header.find("using archetype_world = carch::ArchetypeWorld<entity_id, component_id, Transform, RigidBody, "
+                       "Shape>;") != std::string::npos);
+    assert(header.find("#include \"carch/archetype.h\"") != std::string::npos);
+    // The world hands out generational handles even without ref<entity>
+    assert(header.find("using entity_id = carch::Entity64;") != std::string::npos);
+    
+    // Split headers declare the world once every component is complete
+    GenerationOptions split = options;
+    split.split_output = true;
+    CppGenerator split_generator(schema.get(), split);
+    auto files = split_generator.generate_split_headers();
+    const std::string& umbrella = files.back().content;
+    assert(umbrella.find("using archetype_world") != std::string::npos);
+    assert(umbrella.find("#include \"carch/archetype.h\"") != std::string::npos);
+    for (size_t i = 0; i + 1 < files.size(); ++i) {
+        assert(files[i].content.find("archetype_world") == std::string::npos);
+    }
+    
+    // Reverse index links and spans need a pool, so @indexed and @pooled
+    // types stay out of the world
+    auto pooled = parse("Patrol : struct { @pooled path: array<u32> }\n"
+                        "Follower : struct { @indexed leader: ref<entity> }\n"
+                        "Transform : struct { position: vec3 }");
+    CppGenerator pooled_generator(pooled.get(), options);
+    std::string pooled_header = pooled_generator.generate_header();
+    assert(pooled_header.find("carch::ArchetypeWorld<entity_id, component_id, Transform>;") != std::string::npos);
+    assert(pooled_header.find("using component_pool = carch::ComponentPool<T, entity_id>;") != std::string::npos);
+    
+    // Without the option nothing is generated
+    CppGenerator plain_generator(schema.get());
+    std::string plain_header = plain_generator.generate_header();
+    assert(plain_header.find("component_id") == std::string::npos);
+    assert(plain_header.find("entity_id") == std::string::npos);
+    
+    std::cout << "  ✓ Component ids and the archetype world alias generated\n";
+}
+
+void test_pooled_arrays() {
+    std::cout << "Testing @pooled array generation...\n";
+    
+    std::string source = R"(
+        Patrol : struct { @pooled waypoints: array<vec3>, route: struct { @pooled stops: array<u32> } }
+        Collider : variant { circle: f32, polygon: struct { @pooled vertices: array<vec2> } }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("carch::PoolSpan<carch::Vec3> waypoints;") != std::string::npos);
+    assert(header.find("std::vector") == std::string::npos);
+    assert(header.find("struct Patrol_Arenas {\n"
+                       "    carch::SpanArenaOf<decltype(Patrol::waypoints)> waypoints;\n"
+                       "    carch::SpanArenaOf<decltype(Patrol::route.stops)> route_stops;\n") != std::string::npos);
+    assert(header.find("Patrol_Arenas carch_span_arenas(Patrol*);") != std::string::npos);
+    assert(header.find("visit(value.route.stops, arenas.route_stops);") != std::string::npos);
+    assert(header.find("    if (auto* alt = std::get_if<Collider_Polygon>(&value)) {\n"
+                       "        visit(alt->vertices, arenas.polygon_vertices);") != std::string::npos);
+    
+    // The pools own the arenas; without @indexed there is no reverse index
+    assert(header.find("using component_pool = carch::ComponentPool<T, entity_id>;") != std::string::npos);
+    assert(header.find("using entity_id = carch::Entity64;") != std::string::npos);
+    assert(header.find("reverse_index") == std::string::npos);
+    assert(header.find("#include \"carch/span_arena.h\"") != std::string::npos);
+    
+    std::cout << "  ✓ Pool spans, arenas and carch_visit_spans generated\n";
+}
+
+void test_copy_traits() {
+    std::cout << "Testing copy trait generation...\n";
+    
+    std::string source = R"(
+        Transform : struct { position: vec3, target: ref<entity> }
+        Named : struct { name: istr }
+        Inventory : struct { items: array<u32> }
+        Profile : struct { name: str }
+        Signal : variant { on, off }
+        @pod Packet : struct { id: u32 }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("static_assert(std::is_trivially_copyable_v<Transform>, "
+                       "\"Transform: no longer trivially copyable\");") != std::string::npos);
+    assert(header.find("constexpr bool carch_pod_wire_safe(const Transform*) noexcept { return true; }") !=
+           std::string::npos);
+    assert(header.find("static_assert(std::is_trivially_copyable_v<Named>") != std::string::npos);
+    assert(header.find("carch_pod_wire_safe(const Named*)") == std::string::npos);
+    // Relocation of a vector holds on the standard libraries we know
+    assert(header.find("#if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)\n"
+                       "constexpr bool carch_trivially_relocatable(const Inventory*) noexcept { return true; }\n"
+                       "#endif") != std::string::npos);
+    assert(header.find("(const Profile*)") == std::string::npos);
+    // A std::variant of units is not a type of this namespace
+    assert(header.find("carch_pod_wire_safe(const Signal*)") == std::string::npos);
+    assert(header.find("#include <type_traits>") != std::string::npos);
+    
+    // Without layout asserts the hooks remain, and @pod types keep their check
+    GenerationOptions options;
+    options.layout_asserts = false;
+    CppGenerator unchecked_generator(schema.get(), options);
+    std::string unchecked = unchecked_generator.generate_header();
+    assert(unchecked.find("static_assert(std::is_trivially_copyable_v<Transform>") == std::string::npos);
+    assert(unchecked.find("static_assert(std::is_trivially_copyable_v<Packet>") != std::string::npos);
+    assert(unchecked.find("carch_pod_wire_safe(const Transform*)") != std::string::npos);
+    
+    std::cout << "  ✓ Trait hooks and trivially copyable checks generated\n";
+}
+
+void test_cold_fields() {
+    std::cout << "Testing @cold field generation...\n";
+    
+    std::string source = R"(
+        Player : struct { position: vec3, @cold score: i32, @cold name: str, input: u8 }
+    )";
+    auto schema = parse(source);
+    
+    GenerationOptions options;
+    options.archetypes = true;
+    CppGenerator generator(schema.get(), options);
+    std::string header = generator.generate_header();
+    assert(header.find("struct Player {\n"
+                       "    carch::Vec3 position;\n"
+                       "    uint8_t input;\n"
+                       "};") != std::string::npos);
+    assert(header.find("struct Player_Cold {\n"
+                       "    int32_t score;\n"
+                       "    std::string name;\n"
+                       "};\n"
+                       "Player_Cold carch_cold_fields(Player*);") != std::string::npos);
+    // One accessor per field, in declaration order, whichever part holds it
+    assert(header.find("    auto& position() const noexcept { return carch_hot->position; }\n"
+                       "    auto& score() const noexcept { return carch_cold->score; }\n") != std::string::npos);
+    assert(header.find("inline Player_View carch_cold_view(Player* hot, Player_Cold* cold) noexcept") !=
+           std::string::npos);
+    
+    // Layout checks and traits cover both parts; the side table is a component
+    assert(header.find("static_assert(sizeof(Player) == 32") != std::string::npos);
+    assert(header.find("static_assert(sizeof(Player_Cold) == 40") != std::string::npos);
+    assert(header.find("carch_pod_wire_safe(const Player*)") != std::string::npos);
+    assert(header.find("carch_pod_wire_safe(const Player_Cold*)") == std::string::npos);
+    assert(header.find("using component_pool = carch::ComponentPool<T, entity_id>;") != std::string::npos);
+    assert(header.find("carch::ArchetypeWorld<entity_id, component_id, Player, Player_Cold>") != std::string::npos);
+    
+    std::cout << "  ✓ Side table, accessor view and layout checks generated\n";
+}
+
+void test_double_buffered() {
+    std::cout << "Testing @double_buffered generation...\n";
+    
+    std::string source = R"(
+        @double_buffered Transform : struct { position: vec3, rotation: quat }
+        Velocity : struct { linear: vec3 }
+    )";
+    auto schema = parse(source);
+    
+    CppGenerator generator(schema.get());
+    std::string header = generator.generate_header();
+    assert(header.find("#include \"carch/double_buffer.h\"") != std::string::npos);
+    assert(header.find("using Transform_Buffers = carch::DoubleBufferedPool<Transform, entity_id>;") !=
+           std::string::npos);
+    assert(header.find("Velocity_Buffers") == std::string::npos);
+    // The buffers key by entity handle even though no field is a ref<entity>
+    assert(header.find("using entity_id = carch::Entity64;") != std::string::npos);
+    
+    std::cout << "  ✓ Buffer alias and entity handle generated\n";
+}
+
 int main() {
     std::cout << "Running Code Generation Tests\n";
     std::cout << "==============================\n\n";
@@ -198,6 +1021,28 @@ int main() {
     test_header_guard();
     test_namespace_wrapping();
     test_pascal_case_conversion();
+    test_split_output();
+    test_forward_header();
+    test_module_generation();
+    test_anonymous_struct_hash_consing();
+    test_layout_optimization();
+    test_layout_annotations();
+    test_sized_arrays();
+    test_string_types();
+    test_vector_types();
+    test_reduced_precision_types();
+    test_map_backends();
+    test_tagged_variants();
+    test_compact_optionals();
+    test_flags_generation();
+    test_entity_handles();
+    test_indexed_refs();
+    test_partitioned_variants();
+    test_archetypes();
+    test_pooled_arrays();
+    test_copy_traits();
+    test_cold_fields();
+    test_double_buffered();
     
     std::cout << "\n✓ All code generation tests passed!\n";
     return 0;
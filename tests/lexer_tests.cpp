@@ -12,7 +12,7 @@ using namespace carch::lexer;
 void test_keyword_recognition() {
     std::cout << "Testing keyword recognition...\n";
     
-    Lexer lexer("struct variant enum unit array map optional ref entity");
+    Lexer lexer("struct variant enum unit array map optional ref entity small_array");
     
     assert(lexer.next_token().type == TokenType::STRUCT);
     assert(lexer.next_token().type == TokenType::VARIANT);
@@ -23,6 +23,7 @@ void test_keyword_recognition() {
     assert(lexer.next_token().type == TokenType::OPTIONAL);
     assert(lexer.next_token().type == TokenType::REF);
     assert(lexer.next_token().type == TokenType::ENTITY);
+    assert(lexer.next_token().type == TokenType::SMALL_ARRAY);
     
     std::cout << "  ✓ Keywords recognized correctly\n";
 }
@@ -30,9 +31,10 @@ void test_keyword_recognition() {
 void test_primitive_types() {
     std::cout << "Testing primitive type recognition...\n";
     
-    Lexer lexer("str int bool u8 u16 u32 u64 i8 i16 i32 i64 f32 f64");
+    Lexer lexer("str istr int bool u8 u16 u32 u64 i8 i16 i32 i64 f32 f64 vec2 vec3 vec4 quat ivec2 ivec3 ivec4 f16 unorm8 unorm16 snorm8 snorm16 quant");
     
     assert(lexer.next_token().type == TokenType::STR);
+    assert(lexer.next_token().type == TokenType::ISTR);
     assert(lexer.next_token().type == TokenType::INT);
     assert(lexer.next_token().type == TokenType::BOOL);
     assert(lexer.next_token().type == TokenType::U8);
@@ -45,6 +47,19 @@ void test_primitive_types() {
     assert(lexer.next_token().type == TokenType::I64);
     assert(lexer.next_token().type == TokenType::F32);
     assert(lexer.next_token().type == TokenType::F64);
+    assert(lexer.next_token().type == TokenType::VEC2);
+    assert(lexer.next_token().type == TokenType::VEC3);
+    assert(lexer.next_token().type == TokenType::VEC4);
+    assert(lexer.next_token().type == TokenType::QUAT);
+    assert(lexer.next_token().type == TokenType::IVEC2);
+    assert(lexer.next_token().type == TokenType::IVEC3);
+    assert(lexer.next_token().type == TokenType::IVEC4);
+    assert(lexer.next_token().type == TokenType::F16);
+    assert(lexer.next_token().type == TokenType::UNORM8);
+    assert(lexer.next_token().type == TokenType::UNORM16);
+    assert(lexer.next_token().type == TokenType::SNORM8);
+    assert(lexer.next_token().type == TokenType::SNORM16);
+    assert(lexer.next_token().type == TokenType::QUANT);
     
     std::cout << "  ✓ Primitive types recognized correctly\n";
 }
@@ -76,7 +91,7 @@ void test_identifiers() {
 void test_symbols() {
     std::cout << "Testing symbol recognition...\n";
     
-    Lexer lexer(": , { } < > ( )");
+    Lexer lexer(": , { } < > ( ) @");
     
     assert(lexer.next_token().type == TokenType::COLON);
     assert(lexer.next_token().type == TokenType::COMMA);
@@ -86,6 +101,7 @@ void test_symbols() {
     assert(lexer.next_token().type == TokenType::RANGLE);
     assert(lexer.next_token().type == TokenType::LPAREN);
     assert(lexer.next_token().type == TokenType::RPAREN);
+    assert(lexer.next_token().type == TokenType::AT);
     
     std::cout << "  ✓ Symbols recognized correctly\n";
 }
@@ -153,6 +153,162 @@ void test_container_types() {
     std::cout << "  ✓ Container types parsed correctly\n";
 }
 
+void test_sized_array_types() {
+    std::cout << "Testing fixed and small array parsing...\n";
+    
+    std::string source = R"(
+        Polygon : struct {
+            corners: array<f32, 8>,
+            vertices: small_array<u32, 6>
+        }
+    )";
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    
+    auto schema = parser.parse();
+    
+    assert(!parser.has_errors());
+    auto* struct_type = dynamic_cast<StructTypeNode*>(schema->definitions[0]->type.get());
+    
+    auto* fixed = dynamic_cast<ContainerTypeNode*>(struct_type->fields[0]->type.get());
+    assert(fixed->kind == ContainerKind::ARRAY);
+    assert(fixed->length == 8);
+    assert(fixed->to_string() == "array<f32, 8>");
+    
+    auto* small = dynamic_cast<ContainerTypeNode*>(struct_type->fields[1]->type.get());
+    assert(small->kind == ContainerKind::SMALL_ARRAY);
+    assert(small->length == 6);
+    assert(small->to_string() == "small_array<u32, 6>");
+    
+    // small_array needs a capacity, and lengths are positive integers
+    const char* invalid[] = {
+        "A : struct { x: small_array<u32> }",
+        "A : struct { x: array<u32, 0> }",
+        "A : struct { x: array<u32, -2> }",
+        "A : struct { x: array<u32, 1.5> }",
+        "A : struct { x: array<u32, 4294967296> }",
+    };
+    for (const char* text : invalid) {
+        Lexer bad_lexer(text);
+        Parser bad_parser(bad_lexer);
+        bad_parser.parse();
+        assert(bad_parser.has_errors());
+    }
+    
+    std::cout << "  ✓ Fixed and small arrays parsed correctly\n";
+}
+
+void test_string_types() {
+    std::cout << "Testing inline and interned string parsing...\n";
+    
+    std::string source = "Label : struct { text: str<24>, kind: istr, body: str }";
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    
+    auto schema = parser.parse();
+    
+    assert(!parser.has_errors());
+    auto* struct_type = dynamic_cast<StructTypeNode*>(schema->definitions[0]->type.get());
+    
+    auto* text = dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[0]->type.get());
+    assert(text->primitive == PrimitiveType::STR);
+    assert(text->length == 24);
+    assert(text->to_string() == "str<24>");
+    
+    auto* kind = dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[1]->type.get());
+    assert(kind->primitive == PrimitiveType::ISTR);
+    assert(kind->to_string() == "istr");
+    
+    auto* body = dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[2]->type.get());
+    assert(body->length == 0);
+    
+    const char* invalid[] = {
+        "A : struct { x: str<0> }",
+        "A : struct { x: str<> }",
+        "A : struct { x: str<8 }",
+    };
+    for (const char* text_source : invalid) {
+        Lexer bad_lexer(text_source);
+        Parser bad_parser(bad_lexer);
+        bad_parser.parse();
+        assert(bad_parser.has_errors());
+    }
+    
+    std::cout << "  ✓ str<N> and istr parsed correctly\n";
+}
+
+void test_vector_types() {
+    std::cout << "Testing vector and quaternion parsing...\n";
+    
+    std::string source = "Transform : struct { position: vec3, rotation: quat, cell: ivec2, path: array<vec4> }";
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    
+    auto schema = parser.parse();
+    
+    assert(!parser.has_errors());
+    auto* struct_type = dynamic_cast<StructTypeNode*>(schema->definitions[0]->type.get());
+    
+    auto* position = dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[0]->type.get());
+    assert(position->primitive == PrimitiveType::VEC3);
+    assert(position->to_string() == "vec3");
+    
+    auto* rotation = dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[1]->type.get());
+    assert(rotation->primitive == PrimitiveType::QUAT);
+    
+    auto* cell = dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[2]->type.get());
+    assert(cell->primitive == PrimitiveType::IVEC2);
+    
+    auto* path = dynamic_cast<ContainerTypeNode*>(struct_type->fields[3]->type.get());
+    auto* element = dynamic_cast<PrimitiveTypeNode*>(path->element_type.get());
+    assert(element->primitive == PrimitiveType::VEC4);
+    
+    std::cout << "  ✓ vec2..vec4, quat and ivec2..ivec4 parsed correctly\n";
+}
+
+void test_reduced_precision_types() {
+    std::cout << "Testing reduced-precision type parsing...\n";
+    
+    std::string source = "Sprite : struct { depth: f16, alpha: unorm8, normal: snorm16, angle: quant<-3.5, 3.5, 12> }";
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    
+    auto schema = parser.parse();
+    
+    assert(!parser.has_errors());
+    auto* struct_type = dynamic_cast<StructTypeNode*>(schema->definitions[0]->type.get());
+    
+    assert(dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[0]->type.get())->primitive == PrimitiveType::F16);
+    assert(dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[1]->type.get())->primitive == PrimitiveType::UNORM8);
+    assert(dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[2]->type.get())->primitive == PrimitiveType::SNORM16);
+    
+    auto* angle = dynamic_cast<PrimitiveTypeNode*>(struct_type->fields[3]->type.get());
+    assert(angle->primitive == PrimitiveType::QUANT);
+    assert(angle->quant_min == "-3.5");
+    assert(angle->quant_max == "3.5");
+    assert(angle->length == 12);
+    assert(angle->to_string() == "quant<-3.5, 3.5, 12>");
+    
+    const char* invalid[] = {
+        "A : struct { x: quant }",
+        "A : struct { x: quant<0, 1> }",
+        "A : struct { x: quant<0, 1, 0> }",
+        "A : struct { x: quant<lo, 1, 8> }",
+    };
+    for (const char* text_source : invalid) {
+        Lexer bad_lexer(text_source);
+        Parser bad_parser(bad_lexer);
+        bad_parser.parse();
+        assert(bad_parser.has_errors());
+    }
+    
+    std::cout << "  ✓ f16, unorm, snorm and quant<min, max, bits> parsed correctly\n";
+}
+
 void test_ref_type() {
     std::cout << "Testing ref type parsing...\n";
     
@@ -214,6 +370,88 @@ void test_multiple_definitions() {
     std::cout << "  ✓ Multiple definitions parsed correctly\n";
 }
 
+void test_annotations() {
+    std::cout << "Testing annotation parsing...\n";
+    
+    std::string source = R"(
+        @align(16)
+        Particle : struct {
+            @cacheline counter: u64,
+            @align(8) @map(flat) id: u32
+        }
+        @packed Header : struct { tag: u8 }
+    )";
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    
+    auto schema = parser.parse();
+    
+    assert(!parser.has_errors());
+    assert(schema->definitions.size() == 2);
+    
+    auto& particle = schema->definitions[0];
+    assert(particle->annotations.size() == 1);
+    assert(particle->annotations[0].name == "align");
+    assert(particle->annotations[0].arguments.size() == 1);
+    assert(particle->annotations[0].arguments[0] == "16");
+    assert(particle->annotations[0].line == 2);
+    
+    auto* struct_type = dynamic_cast<StructTypeNode*>(particle->type.get());
+    assert(struct_type != nullptr);
+    assert(struct_type->fields[0]->annotations.size() == 1);
+    assert(struct_type->fields[0]->annotations[0].name == "cacheline");
+    assert(struct_type->fields[0]->annotations[0].arguments.empty());
+    
+    // Keywords are valid annotation names
+    assert(struct_type->fields[1]->annotations.size() == 2);
+    assert(struct_type->fields[1]->annotations[1].name == "map");
+    assert(struct_type->fields[1]->annotations[1].arguments[0] == "flat");
+    assert(find_annotation(struct_type->fields[1]->annotations, "align") != nullptr);
+    assert(struct_type->to_string() == "struct { @cacheline counter: u64, @align(8) @map(flat) id: u32 }");
+    
+    assert(schema->definitions[1]->name == "Header");
+    assert(schema->definitions[1]->annotations[0].name == "packed");
+    
+    // A missing name is a parse error
+    Lexer bad_lexer("@ Position : struct { x: f32 }");
+    Parser bad_parser(bad_lexer);
+    bad_parser.parse();
+    assert(bad_parser.has_errors());
+    
+    std::cout << "  ✓ Annotations parsed correctly\n";
+}
+
+void test_flags_type() {
+    std::cout << "Testing flags parsing...\n";
+    
+    // 'flags' is a keyword only in front of a brace, so it still names fields and types
+    std::string source = R"(
+        Permissions : flags { read, write, exec }
+        flags : struct { flags: u16, mask: flags { a, b } }
+    )";
+    
+    Lexer lexer(source);
+    Parser parser(lexer);
+    
+    auto schema = parser.parse();
+    
+    assert(!parser.has_errors());
+    assert(schema->definitions.size() == 2);
+    auto* permissions = dynamic_cast<EnumTypeNode*>(schema->definitions[0]->type.get());
+    assert(permissions && permissions->flags);
+    assert(permissions->values.size() == 3);
+    assert(permissions->to_string() == "flags { read, write, exec }");
+    
+    auto* struct_type = dynamic_cast<StructTypeNode*>(schema->definitions[1]->type.get());
+    assert(schema->definitions[1]->name == "flags");
+    assert(struct_type->fields[0]->name == "flags");
+    auto* mask = dynamic_cast<EnumTypeNode*>(struct_type->fields[1]->type.get());
+    assert(mask && mask->flags);
+    
+    std::cout << "  ✓ flags { ... } parsed as a flags enum\n";
+}
+
 int main() {
     std::cout << "Running Parser Tests\n";
     std::cout << "====================\n\n";
@@ -223,9 +461,15 @@ int main() {
     test_variant_parsing();
     test_enum_parsing();
     test_container_types();
+    test_sized_array_types();
+    test_string_types();
+    test_vector_types();
+    test_reduced_precision_types();
     test_ref_type();
     test_compact_syntax();
     test_multiple_definitions();
+    test_annotations();
+    test_flags_type();
     
     std::cout << "\n✓ All parser tests passed!\n";
     return 0;
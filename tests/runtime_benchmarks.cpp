@@ -0,0 +1,232 @@
+// Runtime Benchmarks
+// Compares the containers generated code can use against the standard library
+
+#include "carch/fixed_string.h"
+#include "carch/flat_map.h"
+#include "carch/interned_string.h"
+#include "carch/sorted_map.h"
+#include "shapes.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+using namespace std::chrono;
+
+// Keeps the optimizer from discarding benchmarked work
+volatile uint64_t sink = 0;
+
+void print_row(const std::string& name, double insert_ns, double lookup_ns, double iterate_ns) {
+    std::cout << "  " << std::setw(34) << std::left << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << insert_ns << std::setw(10) << lookup_ns << std::setw(10) << iterate_ns << "\n";
+}
+
+template <typename Function>
+double nanoseconds_per_op(size_t operations, Function&& function) {
+    auto start = steady_clock::now();
+    function();
+    auto end = steady_clock::now();
+    return static_cast<double>(duration_cast<nanoseconds>(end - start).count()) / static_cast<double>(operations);
+}
+
+// Averages over `rounds` fresh maps: insert every key, look each one up in
+// shuffled order, then iterate; prints nanoseconds per operation
+template <typename Map, typename Key>
+void benchmark_map(const std::string& name, const std::vector<Key>& keys, int rounds) {
+    std::vector<Key> probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937(7));
+
+    double insert_ns = 0;
+    double lookup_ns = 0;
+    double iterate_ns = 0;
+    for (int round = 0; round < rounds; ++round) {
+        Map map;
+        insert_ns += nanoseconds_per_op(keys.size(), [&] {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                map[keys[i]] = static_cast<uint32_t>(i);
+            }
+        });
+        lookup_ns += nanoseconds_per_op(probes.size(), [&] {
+            uint64_t sum = 0;
+            for (const Key& key : probes) {
+                sum += map.find(key)->second;
+            }
+            sink = sink + sum;
+        });
+        iterate_ns += nanoseconds_per_op(map.size(), [&] {
+            uint64_t sum = 0;
+            for (const auto& entry : map) {
+                sum += entry.second;
+            }
+            sink = sink + sum;
+        });
+    }
+    print_row(name, insert_ns / rounds, lookup_ns / rounds, iterate_ns / rounds);
+}
+
+template <typename Key>
+void benchmark_key_type(const std::string& key_name, const std::vector<Key>& keys, int rounds, bool sorted) {
+    std::cout << "\n" << key_name << " keys, " << keys.size() << " entries (ns per insert / lookup / visit)\n";
+    benchmark_map<std::unordered_map<Key, uint32_t>>("std::unordered_map", keys, rounds);
+    benchmark_map<carch::FlatHashMap<Key, uint32_t>>("carch::FlatHashMap", keys, rounds);
+    if (sorted) {
+        benchmark_map<carch::SortedFlatMap<Key, uint32_t>>("carch::SortedFlatMap", keys, rounds);
+    }
+}
+
+std::vector<uint64_t> integer_keys(size_t count) {
+    std::mt19937_64 random(1);
+    std::vector<uint64_t> keys;
+    std::unordered_map<uint64_t, bool> seen;
+    while (keys.size() < count) {
+        uint64_t key = random();
+        if (seen.emplace(key, true).second) {
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+std::vector<std::string> string_keys(size_t count) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back("item_" + std::to_string(i * 7919));
+    }
+    return keys;
+}
+
+template <typename Key>
+std::vector<Key> convert_keys(const std::vector<std::string>& strings) {
+    return std::vector<Key>(strings.begin(), strings.end());
+}
+
+void benchmark_maps() {
+    std::cout << "=== map<K, V> backends ===\n";
+
+    // Small maps, as in per-entity inventories and stats, where the sorted
+    // backend is an option
+    auto small_strings = string_keys(32);
+    benchmark_key_type("u64", integer_keys(32), 20000, true);
+    benchmark_key_type("str", small_strings, 20000, true);
+    benchmark_key_type("str<24>", convert_keys<carch::FixedString<24>>(small_strings), 20000, true);
+    benchmark_key_type("istr", convert_keys<carch::InternedString>(small_strings), 20000, true);
+
+    // Large maps, as in lookup tables shared across systems
+    auto large_strings = string_keys(200000);
+    benchmark_key_type("u64", integer_keys(200000), 5, false);
+    benchmark_key_type("str", large_strings, 5, false);
+    benchmark_key_type("str<24>", convert_keys<carch::FixedString<24>>(large_strings), 5, false);
+    benchmark_key_type("istr", convert_keys<carch::InternedString>(large_strings), 5, false);
+}
+
+// Builds the same random mix of alternatives for both backends
+template <typename Shape, typename Circle, typename Rect, typename Triangle, typename Point>
+std::vector<Shape> random_shapes(size_t count) {
+    std::mt19937 random(3);
+    std::vector<Shape> shapes;
+    shapes.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        float size = static_cast<float>(random() % 100) * 0.5f;
+        switch (random() % 4) {
+            case 0: shapes.push_back(Circle{size}); break;
+            case 1: shapes.push_back(Rect{size, size + 1}); break;
+            case 2: shapes.push_back(Triangle{size, size + 2}); break;
+            default: shapes.push_back(Point{}); break;
+        }
+    }
+    return shapes;
+}
+
+template <typename Shapes, typename Visit>
+void benchmark_visit(const std::string& name, const Shapes& shapes, int rounds, Visit&& visit) {
+    double visit_ns = 0;
+    for (int round = 0; round < rounds; ++round) {
+        visit_ns += nanoseconds_per_op(shapes.size(), [&] {
+            double sum = 0;
+            for (const auto& shape : shapes) {
+                sum += visit(shape);
+            }
+            sink = sink + static_cast<uint64_t>(sum);
+        });
+    }
+    std::cout << "  " << std::setw(34) << std::left << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << visit_ns / rounds << std::setw(10) << sizeof(typename Shapes::value_type) << "\n";
+}
+
+void benchmark_variants() {
+    using namespace bench;
+    std::cout << "\n=== variant backends ===\n";
+    std::cout << "\n1000000 shapes, area of each (ns per visit / bytes per shape)\n";
+    
+    auto std_shapes = random_shapes<StdShape, StdShape_Circle, StdShape_Rect, StdShape_Triangle, std::monostate>(1000000);
+    auto tagged_shapes = random_shapes<TaggedShape, TaggedShape_Circle, TaggedShape_Rect, TaggedShape_Triangle,
+                                       TaggedShape_Point>(1000000);
+    
+    benchmark_visit("std::visit", std_shapes, 20, [](const StdShape& shape) {
+        return std::visit(carch::Overloaded{
+            [](const StdShape_Circle& c) { return 3.14159f * c.radius * c.radius; },
+            [](const StdShape_Rect& r) { return r.width * r.height; },
+            [](const StdShape_Triangle& t) { return 0.5f * t.base * t.height; },
+            [](std::monostate) { return 0.0f; },
+        }, shape);
+    });
+    benchmark_visit("tagged match", tagged_shapes, 20, [](const TaggedShape& shape) {
+        return shape.match(
+            [](const TaggedShape_Circle& c) { return 3.14159f * c.radius * c.radius; },
+            [](const TaggedShape_Rect& r) { return r.width * r.height; },
+            [](const TaggedShape_Triangle& t) { return 0.5f * t.base * t.height; },
+            [](const TaggedShape_Point&) { return 0.0f; });
+    });
+    benchmark_visit("tagged switch on tag()", tagged_shapes, 20, [](const TaggedShape& shape) {
+        switch (shape.tag()) {
+            case TaggedShape::Tag::Circle: {
+                const auto& c = shape.get<TaggedShape_Circle>();
+                return 3.14159f * c.radius * c.radius;
+            }
+            case TaggedShape::Tag::Rect: {
+                const auto& r = shape.get<TaggedShape_Rect>();
+                return r.width * r.height;
+            }
+            case TaggedShape::Tag::Triangle: {
+                const auto& t = shape.get<TaggedShape_Triangle>();
+                return 0.5f * t.base * t.height;
+            }
+            default: return 0.0f;
+        }
+    });
+    
+    // The same shapes split by alternative: one branch-free loop per alternative
+    StdShape_Storage storage;
+    for (const StdShape& shape : std_shapes) {
+        storage.insert(shape);
+    }
+    double storage_ns = 0;
+    for (int round = 0; round < 20; ++round) {
+        storage_ns += nanoseconds_per_op(storage.size(), [&] {
+            double sum = 0;
+            storage.each<StdShape_Circle>([&](const StdShape_Circle& c) { sum += 3.14159f * c.radius * c.radius; });
+            storage.each<StdShape_Rect>([&](const StdShape_Rect& r) { sum += r.width * r.height; });
+            storage.each<StdShape_Triangle>([&](const StdShape_Triangle& t) { sum += 0.5f * t.base * t.height; });
+            sink = sink + static_cast<uint64_t>(sum);
+        });
+    }
+    std::cout << "  " << std::setw(34) << std::left << "partitioned, per alternative" << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << storage_ns / 20 << std::setw(10) << "-" << "\n";
+}
+
+int main() {
+    std::cout << "Running Runtime Benchmarks\n";
+    std::cout << "==========================\n\n";
+
+    benchmark_maps();
+    benchmark_variants();
+
+    std::cout << "\n✓ Benchmarks completed\n";
+    return 0;
+}
@@ -0,0 +1,1297 @@
+// Runtime Tests
+// Tests for the header-only runtime shipped with generated code
+
+#include "carch/archetype.h"
+#include "carch/compact_optional.h"
+#include "carch/component_pool.h"
+#include "carch/double_buffer.h"
+#include "carch/entity.h"
+#include "carch/enum_containers.h"
+#include "carch/fixed_string.h"
+#include "carch/flat_map.h"
+#include "carch/interned_string.h"
+#include "carch/quantized.h"
+#include "carch/small_array.h"
+#include "carch/sorted_map.h"
+#include "carch/span_arena.h"
+#include "carch/tagged_union.h"
+#include "carch/traits.h"
+#include "carch/variant_storage.h"
+#include "carch/vector.h"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace carch;
+
+namespace pooled {
+
+// What the generator emits for Chase : struct { @indexed target: ref<entity>, @indexed backup: ref<entity> }
+struct Chase {
+    Entity32 target;
+    Entity32 backup;
+    float speed = 0.0f;
+};
+
+enum class Chase_Ref : uint32_t {
+    target,
+    backup,
+};
+
+template <typename Visitor>
+void carch_visit_refs(Chase& value, Visitor&& visit) {
+    visit(Chase_Ref::target, value.target);
+    visit(Chase_Ref::backup, value.backup);
+}
+
+} // namespace pooled
+
+namespace chunked {
+
+struct Position {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Velocity {
+    float dx = 0.0f;
+    float dy = 0.0f;
+};
+
+struct Name {
+    std::string value;
+};
+
+// What the generator emits with --archetypes for the three structs above
+enum class component_id : uint32_t { Position, Velocity, Name };
+using archetype_world = ArchetypeWorld<Entity32, component_id, Position, Velocity, Name>;
+
+} // namespace chunked
+
+namespace spans {
+
+// What the generator emits for Patrol : struct { @pooled waypoints: array<u32>, @pooled marks: array<u16> }
+struct Patrol {
+    PoolSpan<uint32_t> waypoints;
+    PoolSpan<uint16_t> marks;
+    float speed = 0.0f;
+};
+
+struct Patrol_Arenas {
+    SpanArenaOf<decltype(Patrol::waypoints)> waypoints;
+    SpanArenaOf<decltype(Patrol::marks)> marks;
+
+    template <typename F>
+    void each(F&& f) {
+        f(waypoints);
+        f(marks);
+    }
+};
+Patrol_Arenas carch_span_arenas(Patrol*);
+
+template <typename Visitor>
+void carch_visit_spans(Patrol& value, Patrol_Arenas& arenas, Visitor&& visit) {
+    visit(value.waypoints, arenas.waypoints);
+    visit(value.marks, arenas.marks);
+}
+
+} // namespace spans
+
+namespace relocation {
+
+struct Packet {
+    uint32_t id = 0;
+    float value = 0.0f;
+};
+
+struct Bag {
+    std::vector<int> items;
+};
+
+struct Label {
+    std::string text;
+};
+
+// What the generator emits for the structs above: Packet is POD wire-safe,
+// Bag relocatable, Label neither
+constexpr bool carch_pod_wire_safe(const Packet*) noexcept { return true; }
+constexpr bool carch_trivially_relocatable(const Bag*) noexcept { return true; }
+
+enum class component_id : uint32_t { Packet, Bag, Label };
+using archetype_world = ArchetypeWorld<Entity32, component_id, Packet, Bag, Label>;
+
+} // namespace relocation
+
+namespace split {
+
+// What the generator emits for
+// Player : struct { position: vec3, @cold score: i32, @cold name: str }
+struct Player {
+    Vec3 position;
+};
+
+struct Player_Cold {
+    int32_t score;
+    std::string name;
+};
+Player_Cold carch_cold_fields(Player*);
+
+struct Player_View {
+    Player* carch_hot = nullptr;
+    Player_Cold* carch_cold = nullptr;
+
+    explicit operator bool() const noexcept { return carch_hot != nullptr; }
+    auto& position() const noexcept { return carch_hot->position; }
+    auto& score() const noexcept { return carch_cold->score; }
+    auto& name() const noexcept { return carch_cold->name; }
+};
+inline Player_View carch_cold_view(Player* hot, Player_Cold* cold) noexcept { return {hot, cold}; }
+
+} // namespace split
+
+// Counts live instances to catch leaked or double-destroyed elements
+struct Tracked {
+    static int live;
+    int value;
+
+    Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value) { ++live; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { --live; }
+
+    bool operator==(const Tracked& other) const { return value == other.value; }
+};
+int Tracked::live = 0;
+
+void test_small_array_inline_storage() {
+    std::cout << "Testing SmallArray inline storage...\n";
+
+    SmallArray<uint32_t, 4> values;
+    assert(values.empty());
+    assert(values.capacity() == 4);
+    for (uint32_t i = 0; i < 4; ++i) {
+        values.push_back(i * 10);
+    }
+
+    // Elements live inside the object until the inline capacity is exceeded
+    auto* object = reinterpret_cast<const unsigned char*>(&values);
+    auto* first = reinterpret_cast<const unsigned char*>(values.data());
+    assert(first >= object && first < object + sizeof(values));
+    assert(values.is_inline());
+    assert(values.size() == 4);
+    assert(values[3] == 30);
+
+    // Header plus a union of the heap pointer and the inline buffer
+    static_assert(sizeof(SmallArray<uint32_t, 4>) == 24, "SmallArray<u32, 4> layout");
+    static_assert(sizeof(SmallArray<uint8_t, 6>) == 16, "SmallArray<u8, 6> layout");
+    static_assert(alignof(SmallArray<uint8_t, 6>) == alignof(void*), "SmallArray alignment");
+
+    std::cout << "  ✓ Elements stored inline up to the capacity\n";
+}
+
+void test_small_array_spill() {
+    std::cout << "Testing SmallArray heap spill...\n";
+
+    SmallArray<std::string, 2> names = {"a", "b"};
+    assert(names.is_inline());
+    names.push_back("a string long enough to need its own heap allocation");
+    assert(!names.is_inline());
+    assert(names.capacity() == 4);
+    assert(names.size() == 3);
+    assert(names[0] == "a" && names[1] == "b");
+
+    // Emplacing a copy of an element survives the reallocation it triggers
+    names.push_back(names[2]);
+    names.emplace_back(names[0]);
+    assert(names.size() == 5);
+    assert(names[4] == "a");
+    assert(names[3] == names[2]);
+
+    names.erase(names.begin() + 1);
+    assert(names.size() == 4);
+    assert(names[1] == names[2]);
+
+    names.resize(1);
+    assert(names.size() == 1 && names.front() == "a");
+    names.clear();
+    assert(names.empty());
+
+    std::cout << "  ✓ Elements move to the heap past the inline capacity\n";
+}
+
+void test_small_array_copy_and_move() {
+    std::cout << "Testing SmallArray copy and move...\n";
+
+    {
+        SmallArray<Tracked, 3> inline_array = {1, 2};
+        SmallArray<Tracked, 3> heap_array = {1, 2, 3, 4, 5};
+        assert(Tracked::live == 7);
+
+        SmallArray<Tracked, 3> copy = heap_array;
+        assert(copy == heap_array);
+        assert(copy != inline_array);
+
+        // Moving a spilled array hands over its buffer
+        const Tracked* buffer = heap_array.data();
+        SmallArray<Tracked, 3> moved = std::move(heap_array);
+        assert(moved.data() == buffer);
+        assert(heap_array.empty() && heap_array.is_inline());
+
+        // Moving an inline array moves each element
+        SmallArray<Tracked, 3> moved_inline = std::move(inline_array);
+        assert(moved_inline.is_inline());
+        assert(moved_inline.size() == 2 && moved_inline[1].value == 2);
+        assert(inline_array.empty());
+
+        copy = moved_inline;
+        assert(copy.size() == 2);
+        moved = std::move(copy);
+        assert(moved.size() == 2);
+        assert(Tracked::live == 4);
+    }
+    assert(Tracked::live == 0);
+
+    std::cout << "  ✓ Copies, moves and destruction balanced\n";
+}
+
+void test_fixed_string() {
+    std::cout << "Testing FixedString...\n";
+    
+    FixedString<8> name = "knight";
+    assert(name.size() == 6);
+    assert(name == "knight");
+    assert(name != std::string("rogue"));
+    assert(name.view() == std::string_view("knight"));
+    
+    // Text past the capacity is cut, never in the middle of a code point
+    FixedString<8> cut;
+    assert(!cut.assign("abcdefghij"));
+    assert(cut == "abcdefgh");
+    assert(!cut.assign("abcdef\xC3\xA9\xC3\xA9"));   // "abcdefée"
+    assert(cut.size() == 8);
+    assert(!cut.assign("abcdefg\xC3\xA9"));            // "abcdefgé"
+    assert(cut == "abcdefg");
+    
+    FixedString<8> copy = name;
+    assert(copy == name);
+    assert(std::hash<FixedString<8>>()(copy) == std::hash<std::string_view>()("knight"));
+    
+    static_assert(std::is_trivially_copyable<FixedString<8>>::value, "FixedString is trivially copyable");
+    static_assert(sizeof(FixedString<15>) == 16, "FixedString<15> layout");
+    static_assert(sizeof(FixedString<300>) == 302, "FixedString<300> layout");
+    
+    std::cout << "  ✓ Inline text stored and truncated on UTF-8 boundaries\n";
+}
+
+void test_interned_string() {
+    std::cout << "Testing InternedString...\n";
+    
+    InternedString a = "fire";
+    InternedString b = std::string("fi") + "re";
+    InternedString c = "water";
+    assert(a == b);
+    assert(a != c);
+    assert(a.view().data() == b.view().data());
+    assert(a.hash() == std::hash<std::string_view>()("fire"));
+    assert(c < InternedString("zinc") && a < c);
+    
+    InternedString empty;
+    assert(empty.empty());
+    assert(empty == InternedString(""));
+    
+    static_assert(std::is_trivially_copyable<InternedString>::value, "InternedString is trivially copyable");
+    static_assert(sizeof(InternedString) == sizeof(void*), "InternedString is one pointer");
+    
+    // Threads interning the same strings all get the same entries
+    std::vector<std::vector<InternedString>> results(4);
+    std::vector<std::thread> threads;
+    for (auto& result : results) {
+        threads.emplace_back([&result] {
+            for (int i = 0; i < 1000; ++i) {
+                result.push_back(InternedString("key" + std::to_string(i % 100)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::unordered_set<InternedString> unique(results[0].begin(), results[0].end());
+    assert(unique.size() == 100);
+    for (const auto& result : results) {
+        for (size_t i = 0; i < result.size(); ++i) {
+            assert(result[i] == results[0][i]);
+        }
+    }
+    
+    std::cout << "  ✓ Equal strings share one entry across threads\n";
+}
+
+void test_flat_hash_map() {
+    std::cout << "Testing FlatHashMap...\n";
+    
+    FlatHashMap<std::string, int> scores = {{"ann", 1}, {"bob", 2}};
+    assert(scores.size() == 2);
+    assert(scores.at("ann") == 1);
+    assert(scores.find("carl") == scores.end());
+    assert(!scores.try_emplace("bob", 5).second);
+    scores["carl"] = 3;
+    assert(scores.contains("carl") && scores.count("dora") == 0);
+    
+    int total = 0;
+    for (const auto& entry : scores) {
+        total += entry.second;
+    }
+    assert(total == 6);
+    
+    // Random inserts and erases, checked against std::unordered_map
+    FlatHashMap<uint64_t, uint64_t> table;
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 random(42);
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t key = random() % 2048;
+        if (random() % 3 == 0) {
+            assert(table.erase(key) == expected.erase(key));
+        } else {
+            table[key] = i;
+            expected[key] = i;
+        }
+    }
+    assert(table.size() == expected.size());
+    for (const auto& entry : expected) {
+        assert(table.at(entry.first) == entry.second);
+    }
+    uint32_t visited = 0;
+    for (auto it = table.begin(); it != table.end(); ++it) {
+        assert(expected.at(it->first) == it->second);
+        ++visited;
+    }
+    assert(visited == table.size());
+    // Load stays at or below 7/8 of the slots
+    assert(table.size() <= table.capacity() - table.capacity() / 8);
+    
+    // Erasing while iterating returns the next entry
+    for (auto it = table.begin(); it != table.end();) {
+        it = it->first % 2 == 0 ? table.erase(it) : std::next(it);
+    }
+    for (const auto& entry : table) {
+        assert(entry.first % 2 == 1);
+    }
+    
+    static_assert(sizeof(FlatHashMap<uint32_t, uint32_t>) == 32, "FlatHashMap layout");
+    
+    std::cout << "  ✓ Lookups, inserts and erases match std::unordered_map\n";
+}
+
+void test_flat_hash_map_ownership() {
+    std::cout << "Testing FlatHashMap copy and move...\n";
+    
+    {
+        FlatHashMap<int, Tracked> map;
+        for (int i = 0; i < 100; ++i) {
+            map.try_emplace(i, i);
+        }
+        assert(Tracked::live == 100);
+        
+        FlatHashMap<int, Tracked> copy = map;
+        assert(copy == map);
+        copy[7].value = -1;
+        assert(copy != map);
+        
+        FlatHashMap<int, Tracked> moved = std::move(map);
+        assert(map.empty() && moved.size() == 100);
+        moved.erase(3);
+        copy = moved;
+        assert(copy.size() == 99);
+        copy.clear();
+        assert(copy.empty() && copy.find(5) == copy.end());
+        assert(Tracked::live == 99);
+    }
+    assert(Tracked::live == 0);
+    
+    std::cout << "  ✓ Copies, moves and destruction balanced\n";
+}
+
+void test_sorted_flat_map() {
+    std::cout << "Testing SortedFlatMap...\n";
+    
+    SortedFlatMap<uint32_t, std::string> names = {{30, "c"}, {10, "a"}, {20, "b"}, {10, "duplicate"}};
+    assert(names.size() == 3);
+    assert(names.at(10) == "a");
+    
+    // Iteration is in key order
+    std::vector<uint32_t> keys;
+    for (const auto& entry : names) {
+        keys.push_back(entry.first);
+    }
+    assert((keys == std::vector<uint32_t>{10, 20, 30}));
+    
+    names[15] = "between";
+    assert(std::next(names.begin())->second == "between");
+    assert(!names.insert({20, "again"}).second);
+    assert(names.erase(10) == 1 && names.erase(10) == 0);
+    assert(names.begin()->first == 15);
+    assert(names.find(99) == names.end());
+    
+    SortedFlatMap<uint32_t, std::string> copy = names;
+    assert(copy == names);
+    
+    std::cout << "  ✓ Entries kept sorted by key\n";
+}
+
+void test_compact_optional() {
+    std::cout << "Testing CompactOptional...\n";
+    
+    // No engaged flag: each optional is as large as its value
+    using EntityOptional = CompactOptional<uint64_t, MaxNiche<uint64_t>>;
+    using FloatOptional = CompactOptional<float, NanNiche<float>>;
+    static_assert(sizeof(EntityOptional) == sizeof(uint64_t));
+    static_assert(sizeof(FloatOptional) == sizeof(float));
+    static_assert(std::is_trivially_copyable_v<EntityOptional>);
+    
+    EntityOptional target;
+    assert(!target.has_value() && target == std::nullopt);
+    target = 0;
+    assert(target && *target == 0 && target == uint64_t{0});
+    target.reset();
+    assert(target.value_or(7) == 7);
+    bool threw = false;
+    try {
+        target.value();
+    } catch (const std::bad_optional_access&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Only the niche's own bit pattern is none, not every NaN
+    FloatOptional speed = std::nanf("");
+    assert(speed.has_value() && std::isnan(*speed));
+    speed = std::nullopt;
+    assert(!speed.has_value() && std::isnan(NanNiche<float>::none()));
+    assert((!CompactOptional<double, NanNiche<double>>().has_value()));
+    
+    enum class Mode { off, on };
+    CompactOptional<Mode, EnumNiche<Mode>> mode;
+    assert(!mode);
+    mode = Mode::on;
+    assert(mode == Mode::on && mode != Mode::off);
+    
+    CompactOptional<int16_t, MinNiche<int16_t>> delta(std::optional<int16_t>(-3));
+    assert(delta.to_optional() == std::optional<int16_t>(-3));
+    
+    CompactOptional<std::string, EmptyNiche<std::string>> name;
+    name.emplace(3, 'x');
+    CompactOptional<std::string, EmptyNiche<std::string>> other = name;
+    assert(other == name && other->size() == 3);
+    other.reset();
+    swap(name, other);
+    assert(!name && other.value() == "xxx");
+    
+    std::cout << "  ✓ None stored as the niche value, std::optional API kept\n";
+}
+
+enum class Element { fire, ice, lightning, poison };
+constexpr uint32_t carch_enum_count(Element) noexcept { return 4; }
+
+// Sum of the values in a set, by iteration, for use in constant expressions
+constexpr uint32_t sum_of(EnumSet<Element> set) noexcept {
+    uint32_t sum = 0;
+    for (Element value : set) {
+        sum += static_cast<uint32_t>(value);
+    }
+    return sum;
+}
+
+void test_enum_set() {
+    std::cout << "Testing EnumSet...\n";
+    
+    using Elements = EnumSet<Element>;
+    static_assert(sizeof(Elements) == 1 && std::is_trivially_copyable_v<Elements>);
+    
+    // Every operation is usable in constant expressions
+    constexpr Elements elemental = Elements{Element::fire, Element::ice} | Element::lightning;
+    static_assert(elemental.count() == 3);
+    static_assert((~elemental) == Elements(Element::poison));
+    static_assert(Elements::full().all() && Elements().none());
+    static_assert(elemental.bits() == 0x7);
+    static_assert(Elements::from_bits(0xff).bits() == 0xf);
+    static_assert(sum_of(elemental) == 3 && sum_of(Elements::full()) == 6);
+    
+    Elements resist = elemental;
+    resist.reset(Element::ice).flip(Element::poison);
+    std::vector<Element> values(resist.begin(), resist.end());
+    assert((values == std::vector<Element>{Element::fire, Element::lightning, Element::poison}));
+    assert((resist & elemental).count() == 2);
+    assert((resist ^ resist).none());
+    
+    // Past 64 values the set is a run of 64-bit words
+    enum class Wide : uint8_t { first, last = 99 };
+    EnumSet<Wide, 100> wide;
+    static_assert(sizeof(wide) == 16);
+    wide.set(Wide::last);
+    assert(wide.count() == 1 && *wide.begin() == Wide::last);
+    assert((~wide).count() == 99);
+    
+    std::cout << "  ✓ Bit set with constexpr operators, popcount and iteration\n";
+}
+
+void test_enum_array() {
+    std::cout << "Testing EnumArray...\n";
+    
+    EnumArray<Element, float> resistance{};
+    static_assert(EnumArray<Element, float>::size() == 4);
+    resistance[Element::ice] = 0.5f;
+    assert(resistance[Element::fire] == 0.0f);
+    assert(resistance.at(Element::ice) == 0.5f);
+    assert((EnumArray<Element, float>::key(2) == Element::lightning));
+    
+    EnumArray<Element, float> copy = resistance;
+    assert(copy == resistance);
+    copy.fill(1.0f);
+    assert(copy != resistance);
+    
+    std::cout << "  ✓ Dense array indexed by enum value\n";
+}
+
+void test_vectors() {
+    std::cout << "Testing vectors and quaternions...\n";
+
+    static_assert(sizeof(Vec3) == 16 && alignof(Vec3) == 16, "vec3 fills one 16-byte register");
+    static_assert(sizeof(Vec2) == 8 && alignof(Vec2) == 8, "vec2 is not padded to 16");
+    static_assert(sizeof(IVec4) == 16 && sizeof(Quat) == 16, "4-lane types fill one register");
+    static_assert(std::is_trivially_copyable_v<Vec4> && std::is_aggregate_v<Vec4>, "plain data");
+    static_assert(vector_traits<IVec3>::lanes == 3, "lane count");
+    static_assert(std::is_same_v<vector_traits<IVec3>::component_type, int32_t>, "lane type");
+    static_assert(is_vector_v<Quat> && !is_vector_v<float>, "quaternions are vectors for SoA");
+
+    // Arithmetic is constexpr
+    constexpr Vec3 doubled = Vec3{1.0f, 2.0f, 3.0f} * 2.0f + Vec3{1.0f, 1.0f, 1.0f};
+    static_assert(doubled == Vec3{3.0f, 5.0f, 7.0f}, "constexpr arithmetic");
+
+    Vec4 v{1.0f, 2.0f, 3.0f, 4.0f};
+    v -= Vec4{1.0f, 1.0f, 1.0f, 1.0f};
+    v = -v;
+    assert((v == Vec4{0.0f, -1.0f, -2.0f, -3.0f}));
+    assert(dot(IVec2{1, 2}, IVec2{3, 4}) == 11);
+    assert((cross(Vec3{1.0f, 0.0f, 0.0f}, Vec3{0.0f, 1.0f, 0.0f}) == Vec3{0.0f, 0.0f, 1.0f}));
+    assert(std::fabs(length(normalize(Vec2{3.0f, 4.0f})) - 1.0f) < 1e-6f);
+    assert((normalize(Vec3{}) == Vec3{}));
+    assert((lerp(Vec3{}, Vec3{2.0f, 4.0f, 6.0f}, 0.5f) == Vec3{1.0f, 2.0f, 3.0f}));
+    assert((min(IVec2{1, 5}, IVec2{3, 2}) == IVec2{1, 2}));
+    assert((max(IVec2{1, 5}, IVec2{3, 2}) == IVec2{3, 5}));
+    IVec3 cell{4, 6, 8};
+    cell /= 2;
+    assert((cell == IVec3{2, 3, 4}));
+    assert(cell[2] == 4);
+
+    // A quarter turn about z takes x to y, and q * conjugate(q) is the identity
+    Quat q = Quat::from_axis_angle(Vec3{0.0f, 0.0f, 1.0f}, 1.5707963f);
+    Vec3 turned = rotate(q, Vec3{1.0f, 0.0f, 0.0f});
+    assert(std::fabs(turned.x) < 1e-6f && std::fabs(turned.y - 1.0f) < 1e-6f);
+    Quat identity = q * conjugate(q);
+    assert(std::fabs(identity.w - 1.0f) < 1e-6f);
+    assert((Quat{} == Quat::identity()));
+
+    std::unordered_map<IVec2, int> grid;
+    grid[{1, 2}] = 3;
+    grid[{2, 1}] = 4;
+    assert(grid.size() == 2);
+    assert((grid.at(IVec2{1, 2}) == 3));
+
+    std::cout << "  ✓ Vector arithmetic, quaternion rotation and hashing\n";
+}
+
+void test_reduced_precision() {
+    std::cout << "Testing reduced-precision numbers...\n";
+
+    static_assert(sizeof(Half) == 2 && sizeof(Unorm8) == 1 && sizeof(Snorm16) == 2, "stored bits only");
+    static_assert(sizeof(Quantized<0, 100, 7>) == 1 && sizeof(Quantized<-1, 1, 20>) == 4, "smallest storage");
+    static_assert(std::is_trivially_copyable_v<Half> && std::is_trivially_copyable_v<Quantized<0, 1, 8>>,
+                  "copyable with memcpy");
+
+    // Half: exact for small integers and powers of two, rounds to nearest even
+    assert(static_cast<float>(Half(1.5f)) == 1.5f);
+    assert(static_cast<float>(Half(-2048.0f)) == -2048.0f);
+    assert(Half(1.0f).bits() == 0x3C00);
+    assert(Half(65504.0f).bits() == 0x7BFF);
+    assert(Half(65520.0f).bits() == 0x7C00);                // Rounds up to infinity
+    assert(Half(1.0f + 1.0f / 4096).bits() == 0x3C00);      // Halfway, to even
+    assert(Half(std::ldexp(1.0f, -24)).bits() == 0x0001);   // Smallest subnormal
+    assert(static_cast<float>(Half::from_bits(0x0001)) == std::ldexp(1.0f, -24));
+    assert(std::isnan(static_cast<float>(Half(std::nanf("")))));
+    assert(std::isinf(static_cast<float>(Half::from_bits(0xFC00))));
+    // Every finite half survives a round trip through float
+    for (uint32_t bits = 0; bits < 0x10000; ++bits) {
+        if ((bits & 0x7C00) != 0x7C00) {
+            Half half = Half::from_bits(static_cast<uint16_t>(bits));
+            assert(Half(static_cast<float>(half)).bits() == bits);
+        }
+    }
+
+    // Normalized integers clamp to their range and round to the nearest code
+    assert(Unorm8(1.0f).bits() == 255 && Unorm8(2.0f).bits() == 255);
+    assert(Unorm8(-1.0f).bits() == 0 && Unorm8(std::nanf("")).bits() == 0);
+    assert(Unorm8(0.5f).bits() == 128);
+    assert(static_cast<float>(Unorm8::from_bits(255)) == 1.0f);
+    assert(std::fabs(static_cast<float>(Unorm8::from_bits(51)) - 0.2f) < 1e-6f);
+    assert(Snorm8(-1.0f).bits() == -127 && Snorm8(1.0f).bits() == 127);
+    assert(Snorm16(-0.5f).bits() == -16384);
+    assert(static_cast<float>(Snorm8::from_bits(-128)) == -1.0f);
+    for (uint32_t code = 0; code <= 255; ++code) {
+        assert(Unorm8(static_cast<float>(Unorm8::from_bits(static_cast<uint8_t>(code)))).bits() == code);
+    }
+
+    // Quantized: the minimum and maximum are exact, steps are (max - min) / (2^bits - 1)
+    using Angle = Quantized<-15, 15, 10, 1>;
+    assert(Angle::min_value == -1.5f && Angle::max_value == 1.5f);
+    assert(static_cast<float>(Angle(-1.5f)) == -1.5f);
+    assert(static_cast<float>(Angle(1.5f)) == 1.5f);
+    assert(Angle(9.0f).bits() == Angle::max_code);
+    assert(std::fabs(static_cast<float>(Angle(0.25f)) - 0.25f) <= Angle::step / 2);
+    assert(Angle().bits() == 0);
+    using Health = Quantized<0, 100, 7>;
+    assert(Health(50.0f).bits() == 64);
+    assert(Health::from_bits(200).bits() == Health::max_code);
+    using Wide = Quantized<0, 1, 32>;
+    assert(static_cast<double>(Wide(1.0)) == 1.0);
+    assert(std::fabs(static_cast<double>(Wide(0.3)) - 0.3) < 1e-9);
+
+    std::cout << "  ✓ Half, Unorm, Snorm and Quantized round-trip and clamp\n";
+}
+
+void test_entities() {
+    std::cout << "Testing entity handles and allocator...\n";
+
+    static_assert(sizeof(Entity64) == 8 && sizeof(Entity32) == 4, "one word per handle");
+    static_assert(std::is_trivially_copyable_v<Entity64>, "copyable with memcpy");
+    static_assert(sizeof(CompactOptional<Entity32, EntityNiche<Entity32>>) == 4, "null is the niche");
+
+    Entity64 null;
+    assert(null.is_null() && !null && null == Entity64::null());
+    Entity64 packed(7, 3);
+    assert(packed.index() == 7 && packed.version() == 3 && packed.bits() == ((uint64_t(3) << 32) | 7));
+    assert(Entity64::from_bits(packed.bits()) == packed);
+    Entity32 narrow(5, Entity32::version_mask + 2);
+    assert(narrow.index() == 5 && narrow.version() == 1);
+
+    EntityAllocator<Entity32> allocator;
+    Entity32 a = allocator.create();
+    Entity32 b = allocator.create();
+    Entity32 c = allocator.create();
+    assert(a.index() == 0 && b.index() == 1 && c.index() == 2 && a.version() == 0);
+    assert(allocator.size() == 3 && allocator.alive(b));
+    assert(!allocator.alive(Entity32::null()));
+
+    // Destroying bumps the version; the freelist hands the index out again
+    assert(allocator.destroy(b));
+    assert(!allocator.alive(b) && !allocator.destroy(b));
+    assert(allocator.current(1).is_null());
+    Entity32 d = allocator.create();
+    assert(d.index() == 1 && d.version() == 1);
+    assert(allocator.alive(d) && !allocator.alive(b) && allocator.current(1) == d);
+    assert(allocator.capacity() == 3);
+
+    // Freed indices come back most recent first
+    allocator.destroy(a);
+    allocator.destroy(c);
+    assert(allocator.create().index() == 2);
+    assert(allocator.create().index() == 0);
+    assert(allocator.create().index() == 3);
+
+    std::vector<Entity32> live;
+    allocator.each([&](Entity32 entity) { live.push_back(entity); });
+    assert(live.size() == 4 && live[1] == d);
+
+    allocator.clear();
+    assert(allocator.empty() && !allocator.alive(d));
+    assert(allocator.create() == Entity32(0, 2));
+
+    // Versions wrap after 2^version_bits reuses of one index
+    EntityAllocator<BasicEntity<uint8_t, 6>> tiny;
+    auto first = tiny.create();
+    for (int i = 0; i < 4; ++i) {
+        tiny.destroy(tiny.current(0));
+        tiny.create();
+    }
+    assert(tiny.alive(first));
+
+    // Every index but the null one can be live at once
+    EntityAllocator<BasicEntity<uint8_t, 3>> full;
+    for (int i = 0; i < 7; ++i) {
+        full.create();
+    }
+    bool threw = false;
+    try {
+        full.create();
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::unordered_set<Entity64> set{Entity64(1, 0), Entity64(1, 1)};
+    assert(set.size() == 2);
+
+    std::cout << "  ✓ Handles pack index and version; stale handles fail alive()\n";
+}
+
+void test_component_pools() {
+    std::cout << "Testing component pools and the reverse index...\n";
+
+    static_assert(detail::has_indexed_refs<pooled::Chase>::value, "found by ADL");
+    static_assert(!detail::has_indexed_refs<float>::value, "no references");
+
+    EntityAllocator<Entity32> entities;
+    ReverseIndex<Entity32> index;
+    ComponentPool<pooled::Chase, Entity32> chases(index);
+    ComponentPool<float, Entity32> speeds;
+
+    Entity32 boss = entities.create();
+    Entity32 a = entities.create();
+    Entity32 b = entities.create();
+    speeds.set(boss, 2.0f);
+    chases.set(a, {boss, boss, 1.0f});
+    chases.set(b, {boss, Entity32::null(), 1.0f});
+    assert(index.referrer_count(boss) == 3);
+    assert(index.referrers(a).empty());
+
+    // Replacing and modifying components relinks their references
+    chases.set(b, {a, Entity32::null(), 1.0f});
+    assert(index.referrer_count(boss) == 2 && index.referrer_count(a) == 1);
+    chases.modify(a, [&](pooled::Chase& chase) { chase.backup = b; });
+    assert(index.referrer_count(boss) == 1 && index.referrer_count(b) == 1);
+    assert(index.referrers(boss)[0].entity == a);
+    assert(index.referrers(boss)[0].field == static_cast<uint32_t>(pooled::Chase_Ref::target));
+
+    // Destroying the target nulls exactly the fields that held it
+    assert(index.release(boss) == 1);
+    entities.destroy(boss);
+    assert(chases.get(a)->target.is_null() && chases.get(a)->backup == b);
+    assert(index.referrer_count(boss) == 0 && index.release(boss) == 0);
+
+    // Removing a component unlinks it; stale handles find nothing
+    assert(chases.remove(a) && !chases.contains(a));
+    assert(index.referrer_count(b) == 0 && index.referrer_count(a) == 1);
+    entities.destroy(a);
+    Entity32 reused = entities.create();
+    assert(reused.index() == a.index() && !chases.contains(reused) && chases.get(a) == nullptr);
+
+    // Sparse set: dense arrays stay packed across removals
+    assert(speeds.size() == 1 && *speeds.get(boss) == 2.0f);
+    for (int i = 0; i < 8; ++i) {
+        speeds.set(entities.create(), static_cast<float>(i));
+    }
+    speeds.remove(boss);
+    float total = 0.0f;
+    speeds.each([&](Entity32 entity, float& speed) {
+        assert(speeds.get(entity) == &speed);
+        total += speed;
+    });
+    assert(speeds.size() == 8 && total == 28.0f);
+
+    std::cout << "  ✓ Pools keep the reverse index current; release() nulls referrers\n";
+}
+
+void test_archetypes() {
+    std::cout << "Testing archetype chunk storage...\n";
+
+    using namespace chunked;
+    static_assert(archetype_world::id_of<Name> == component_id::Name, "ids follow the component order");
+    static_assert(archetype_world::signature<Velocity, Position>.count() == 2, "signatures are constexpr");
+
+    archetype_world world;
+    std::vector<Entity32> entities;
+    for (int i = 0; i < 600; ++i) {
+        if (i % 2 == 0) {
+            entities.push_back(world.create(Position{float(i), 0.0f}, Velocity{1.0f, 2.0f}));
+        } else {
+            entities.push_back(world.create(Position{float(i), 0.0f}, Name{"entity " + std::to_string(i)}));
+        }
+    }
+    assert(world.size() == 600 && world.archetype_count() == 3);
+    assert((world.count<Position>() == 600 && world.count<Position, Velocity>() == 300));
+    assert((world.count<Velocity, Name>() == 0));
+    assert((world.chunk_capacity<Position, Velocity>() * (sizeof(Entity32) + 16) <= archetype_world::chunk_bytes));
+
+    // Queries stream whole chunks; each() and each_chunk() see the same rows
+    world.each<Position, Velocity>([](Position& position, Velocity& velocity) {
+        position.x += velocity.dx;
+        position.y += velocity.dy;
+    });
+    size_t rows = 0;
+    float total = 0.0f;
+    world.each_chunk<Position>([&](size_t count, const Entity32* handles, Position* positions) {
+        for (size_t i = 0; i < count; ++i) {
+            assert(world.get<Position>(handles[i]) == &positions[i]);
+            total += positions[i].y;
+        }
+        rows += count;
+    });
+    assert(rows == 600 && total == 600.0f);
+
+    // Adding and removing components moves the row, keeping every value
+    Entity32 named = entities[1];
+    world.add(named, Velocity{0.0f, 5.0f});
+    assert(world.has<Velocity>(named) && world.get<Name>(named)->value == "entity 1");
+    world.remove<Name>(named);
+    assert(!world.has<Name>(named) && world.get<Position>(named)->x == 1.0f);
+    assert((world.count<Position, Velocity>() == 301 && world.count<Name>() == 299));
+    world.add(named, Velocity{0.0f, 6.0f});
+    assert(world.get<Velocity>(named)->dy == 6.0f && world.archetype_count() == 4);
+
+    // Destroying entities keeps the chunks dense; stale handles find nothing
+    for (size_t i = 0; i < entities.size(); i += 3) {
+        assert(world.destroy(entities[i]));
+    }
+    assert(!world.alive(entities[0]) && world.get<Position>(entities[0]) == nullptr && !world.destroy(entities[0]));
+    // A stale handle must not reach the entity that reuses its index
+    Entity32 reused = world.create(Position{-1.0f, 0.0f});
+    assert(reused.index() == entities[entities.size() - 3].index() && !world.alive(entities[entities.size() - 3]));
+    bool rejected = false;
+    try {
+        world.add(entities[entities.size() - 3], Velocity{});
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    assert(rejected && !world.has<Velocity>(reused));
+    rejected = false;
+    try {
+        world.add(Entity32(5000, 0), Velocity{});
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    assert(rejected);
+    world.destroy(reused);
+    size_t named_rows = 0;
+    world.each<Name>([&](Entity32 entity, Name& name) {
+        assert(world.alive(entity) && name.value.compare(0, 7, "entity ") == 0);
+        ++named_rows;
+    });
+    assert(world.size() == 400 && named_rows == world.count<Name>());
+
+    std::cout << "  ✓ Queries stream chunks; rows move between archetypes intact\n";
+}
+
+void test_change_ticks() {
+    std::cout << "Testing change ticks and Changed/Added queries...\n";
+
+    using namespace chunked;
+    archetype_world world;
+    std::vector<Entity32> entities;
+    for (int i = 0; i < 2000; ++i) {
+        entities.push_back(world.create(Position{float(i), 0.0f}, Velocity{1.0f, 0.0f}));
+    }
+    size_t capacity = world.chunk_capacity<Position, Velocity>();
+    assert(capacity < 1000);
+    uint32_t since = world.advance_tick();
+    assert(world.added_tick<Position>(entities[0]) == since && world.tick() == since + 1);
+
+    // Nothing written since: every chunk is skipped
+    size_t chunks = 0;
+    world.each_chunk<Changed<const Position>>(since, [&](size_t, const Entity32*, const Position*) { ++chunks; });
+    assert(chunks == 0);
+
+    // Writes in the first chunk only; const reads do not count
+    for (size_t i = 0; i < 10; ++i) {
+        world.get<Position>(entities[i * 7])->y = 1.0f;
+    }
+    assert(std::as_const(world).get<Velocity>(entities[0])->dx == 1.0f);
+    size_t changed = 0;
+    world.each_chunk<Changed<const Position>, const Velocity>(
+        since, [&](size_t, const Entity32*, const Position*, const Velocity*) { ++chunks; });
+    world.each<Changed<const Position>>(since, [&](Entity32 entity, const Position& position) {
+        assert(position.y == 1.0f && world.changed_tick<Position>(entity) == since + 1);
+        ++changed;
+    });
+    assert(chunks == 1 && changed == 10);
+    changed = 0;
+    world.each<Changed<const Velocity>>(since, [&](const Velocity&) { ++changed; });
+    assert(changed == 0);
+
+    // A query over a mutable term stamps the rows it hands out
+    since = world.advance_tick();
+    Entity32 late = world.create(Position{}, Velocity{});
+    changed = 0;
+    world.each<Added<Velocity>>(since, [&](Entity32 entity, Velocity& velocity) {
+        assert(entity == late);
+        velocity.dx = 3.0f;
+        ++changed;
+    });
+    assert(changed == 1 && world.changed_tick<Velocity>(late) == world.tick());
+    assert(world.changed_tick<Position>(late) == world.tick() && world.changed_tick<Velocity>(entities[0]) < since);
+
+    // Ticks move with the row: between archetypes, and into holes
+    world.add(entities[7], Name{"moved"});
+    world.destroy(entities[0]);
+    assert(world.changed_tick<Position>(entities[7]) == since && world.added_tick<Name>(entities[7]) == world.tick());
+    assert(world.changed_tick<Position>(late) == world.tick());
+    changed = 0;
+    world.each<Changed<const Position>>(since - 1, [&](const Position&) { ++changed; });
+    assert(changed == 10);
+
+    std::cout << "  ✓ Filtered queries skip unchanged chunks and rows\n";
+}
+
+void test_variant_storage() {
+    std::cout << "Testing per-alternative variant storage...\n";
+
+    struct Circle {
+        float radius;
+    };
+    struct Polygon {
+        std::vector<Tracked> points;
+    };
+    // What @partitioned generates for a variant { circle, polygon, none, empty }
+    using Collider = std::variant<Circle, Polygon, std::monostate, std::monostate>;
+    using Storage = VariantStorage<Circle, Polygon, std::monostate, std::monostate>;
+    static_assert(sizeof(Storage::handle) == 4, "handles are compact");
+    static_assert(Storage::index_of<Polygon> == 1, "alternatives keep their order");
+
+    Tracked::live = 0;
+    {
+        Storage storage;
+        std::vector<Storage::handle> handles;
+        for (int i = 0; i < 90; ++i) {
+            if (i % 3 == 0) {
+                handles.push_back(storage.insert(Collider(Circle{float(i)})));
+            } else if (i % 3 == 1) {
+                handles.push_back(storage.insert(Polygon{std::vector<Tracked>(3, Tracked(i))}));
+            } else {
+                handles.push_back(storage.insert(Collider(std::in_place_index<3>)));
+            }
+        }
+        assert(storage.size() == 90 && storage.size<Circle>() == 30 && storage.size<Polygon>() == 30);
+        assert(Tracked::live == 90);
+        // Unit alternatives sharing std::monostate keep their own index
+        assert(handles[2].alternative() == 3 && storage.get<3>(handles[2]) && !storage.get<2>(handles[2]));
+
+        // Each alternative is one dense array
+        float radii = 0.0f;
+        storage.each<Circle>([&](Circle& circle) { radii += circle.radius; });
+        assert(radii == 1305.0f);
+        assert(storage.data<Circle>()[1].radius == 3.0f);
+
+        // Removal keeps the arrays dense and the other handles valid
+        for (size_t i = 0; i < handles.size(); i += 2) {
+            assert(storage.remove(handles[i]));
+        }
+        assert(!storage.contains(handles[0]) && !storage.remove(handles[0]) && !storage.get<Circle>(handles[0]));
+        assert(Tracked::live == 45);
+        for (size_t i = 1; i < handles.size(); i += 2) {
+            int value = storage.visit(handles[i], Overloaded{
+                [](Circle& circle) { return static_cast<int>(circle.radius); },
+                [](Polygon& polygon) { return polygon.points[0].value; },
+                [](std::monostate&) { return -1; },
+            });
+            assert(value == (i % 3 == 2 ? -1 : static_cast<int>(i)));
+        }
+        for (size_t i = 0; i < storage.size<Polygon>(); ++i) {
+            assert(storage.get<Polygon>(storage.handle_at<Polygon>(i)) == storage.data<Polygon>() + i);
+        }
+        size_t visited = 0;
+        storage.each_alternative([&](Storage::handle handle, auto&) {
+            assert(storage.contains(handle));
+            ++visited;
+        });
+        assert(visited == storage.size());
+
+        // Freed slots are reused
+        Storage::handle reused = storage.insert(Circle{1.0f});
+        assert(reused.alternative() == 0 && reused.slot() < 30 && storage.get<Circle>(reused)->radius == 1.0f);
+    }
+    assert(Tracked::live == 0);
+
+    std::cout << "  ✓ Alternatives stored apart and addressed by 32-bit handles\n";
+}
+
+void test_span_arenas() {
+    std::cout << "Testing pooled spans and their arenas...\n";
+
+    // Spans at the end grow in place; others move and leave garbage
+    SpanArena<uint32_t> arena;
+    PoolSpan<uint32_t> a = arena.assign({1, 2, 3});
+    PoolSpan<uint32_t> b = arena.allocate(2);
+    arena.push_back(b, 7);
+    assert(b.offset == 3 && b.length == 3 && arena.size() == 6 && arena.view(b)[2] == 7);
+    arena.push_back(a, 4);
+    assert(a.offset == 6 && arena.garbage() == 3 && arena.view(a)[3] == 4);
+    PoolSpan<uint32_t> c = arena.clone(a);
+    arena.view(c)[0] = 10;
+    assert(arena.view(a)[0] == 1 && arena.view(c).size() == 4);
+    arena.release(c);
+    assert(arena.size() == 10 && c.empty());
+    uint32_t replacement[] = {5, 6};
+    arena.assign(a, replacement, 2);
+    assert(a.length == 2 && arena.view(a)[1] == 6 && arena.size() == 8);
+
+    // Compaction keeps only the spans it is shown, in that order
+    arena.compact([&](auto keep) {
+        keep(a);
+        keep(b);
+    });
+    assert(arena.size() == 5 && arena.garbage() == 0 && a.offset == 0 && b.offset == 2);
+    assert(arena.view(a)[0] == 5 && arena.view(b)[2] == 7);
+
+    // Pools own the arenas and release the spans of removed components
+    static_assert(detail::span_arenas<spans::Patrol>::value, "found by ADL");
+    static_assert(std::is_trivially_copyable_v<spans::Patrol>, "spans own nothing");
+    EntityAllocator<Entity32> entities;
+    ComponentPool<spans::Patrol, Entity32> patrols;
+    std::vector<Entity32> handles;
+    for (uint32_t i = 0; i < 16; ++i) {
+        spans::Patrol patrol;
+        patrol.waypoints = patrols.arenas().waypoints.assign({i, i + 1, i + 2});
+        patrol.marks = patrols.arenas().marks.allocate(i % 4);
+        handles.push_back(entities.create());
+        patrols.set(handles.back(), patrol);
+    }
+    for (size_t i = 0; i < handles.size(); i += 2) {
+        patrols.remove(handles[i]);
+    }
+    assert(patrols.arenas().waypoints.garbage() > 0);
+    // Replacing a component keeps the spans it still names
+    spans::Patrol faster = *patrols.get(handles[1]);
+    faster.speed = 2.0f;
+    patrols.set(handles[1], faster);
+    patrols.arenas().waypoints.push_back(patrols.get(handles[1])->waypoints, 99);
+
+    patrols.compact();
+    assert(patrols.arenas().waypoints.garbage() == 0 && patrols.arenas().waypoints.size() == 25);
+    patrols.each([&](Entity32 entity, spans::Patrol& patrol) {
+        auto waypoints = patrols.arenas().waypoints.view(patrol.waypoints);
+        assert(waypoints[0] == entity.index() && waypoints[2] == entity.index() + 2);
+        assert(patrol.marks.length == entity.index() % 4);
+    });
+    assert(patrols.arenas().waypoints.view(patrols.get(handles[1])->waypoints)[3] == 99);
+
+    // Spans stay valid against an arena buffer restored with load()
+    std::vector<spans::Patrol> components(patrols.data(), patrols.data() + patrols.size());
+    SpanArena<uint32_t> restored;
+    restored.load(patrols.arenas().waypoints.data(), patrols.arenas().waypoints.size());
+    assert(restored.view(components[0].waypoints)[0] == patrols.arenas().waypoints.view(patrols.data()[0].waypoints)[0]);
+
+    // Replacing a component whose span was grown or shrunk on a copy
+    // never frees elements another span still uses
+    ComponentPool<spans::Patrol, Entity32> routes;
+    SpanArena<uint32_t>& route_arena = routes.arenas().waypoints;
+    Entity32 first = entities.create();
+    Entity32 second = entities.create();
+    spans::Patrol route;
+    route.waypoints = route_arena.assign({1, 2, 3});
+    routes.set(first, route);
+    for (uint32_t i = 0; i < 3; ++i) {
+        spans::Patrol longer = *routes.get(first);
+        route_arena.push_back(longer.waypoints, 4 + i);
+        routes.set(first, longer);
+    }
+    assert(route_arena.size() == 6 && route_arena.garbage() == 0);
+    assert(route_arena.view(routes.get(first)->waypoints)[5] == 6);
+    spans::Patrol emptied = *routes.get(first);
+    route_arena.resize(emptied.waypoints, 0);
+    spans::Patrol other;
+    other.waypoints = route_arena.assign({7, 8, 9, 10, 11, 12});
+    routes.set(second, other);
+    routes.set(first, emptied);
+    assert(route_arena.size() == 6 && route_arena.garbage() <= route_arena.size());
+    assert(route_arena.view(routes.get(second)->waypoints)[0] == 7);
+    routes.compact();
+    assert(route_arena.size() == 6 && route_arena.garbage() == 0 && routes.get(first)->waypoints.empty());
+    assert(route_arena.view(routes.get(second)->waypoints)[5] == 12);
+
+    std::cout << "  ✓ Spans grow, move and compact; pools release them with their components\n";
+}
+
+void test_copy_traits() {
+    std::cout << "Testing copy traits and memcpy paths...\n";
+
+    using namespace relocation;
+    static_assert(is_pod_wire_safe_v<Packet> && is_pod_wire_safe_v<float> && !is_pod_wire_safe_v<Bag>,
+                  "wire safety is declared or arithmetic");
+    static_assert(is_trivially_relocatable_v<Packet> && is_trivially_relocatable_v<Bag>, "relocatable");
+    static_assert(!is_trivially_relocatable_v<Label>, "std::string is not relocatable");
+    static_assert(is_trivially_relocatable_v<SmallArray<Bag, 2>> && !is_trivially_relocatable_v<SmallArray<Label, 2>>,
+                  "small arrays relocate with their elements");
+    static_assert(is_trivially_relocatable_v<FlatHashMap<int, Label>>, "flat maps relocate whatever they hold");
+
+    // Relocatable elements move to the heap, and out of inline storage, as bytes
+    SmallArray<Bag, 2> bags;
+    for (int i = 0; i < 9; ++i) {
+        bags.push_back(Bag{std::vector<int>(size_t(i), i)});
+    }
+    assert(bags.size() == 9 && bags[8].items.size() == 8 && bags[8].items[7] == 8);
+    SmallArray<Bag, 2> inline_bags{Bag{{1, 2}}, Bag{{3}}};
+    SmallArray<Bag, 2> moved(std::move(inline_bags));
+    assert(inline_bags.empty() && moved.size() == 2 && moved[0].items[1] == 2 && moved[1].items[0] == 3);
+
+    // Archetype rows of relocatable components move with memcpy
+    archetype_world world;
+    std::vector<Entity32> entities;
+    for (int i = 0; i < 300; ++i) {
+        entities.push_back(world.create(Bag{{i, i + 1}}, Label{"label " + std::to_string(i)}));
+    }
+    for (size_t i = 0; i < entities.size(); i += 2) {
+        world.add(entities[i], Packet{uint32_t(i), 1.0f});
+    }
+    for (size_t i = 0; i < entities.size(); i += 3) {
+        world.remove<Label>(entities[i]);
+    }
+    for (size_t i = 0; i < entities.size(); ++i) {
+        const Bag* bag = world.get<Bag>(entities[i]);
+        assert(bag && bag->items.size() == 2 && bag->items[1] == int(i) + 1);
+        assert(world.has<Packet>(entities[i]) == (i % 2 == 0) && world.has<Label>(entities[i]) == (i % 3 != 0));
+    }
+
+    // POD wire-safe components load back from their bytes
+    ComponentPool<Packet, Entity32> packets;
+    for (size_t i = 0; i < 5; ++i) {
+        packets.set(entities[i], Packet{uint32_t(i), float(i) / 2});
+    }
+    std::vector<unsigned char> bytes(packets.size() * sizeof(Packet));
+    std::memcpy(bytes.data(), packets.data(), bytes.size());
+    ComponentPool<Packet, Entity32> loaded;
+    loaded.set(entities[9], Packet{});
+    loaded.load(packets.entities().data(), bytes.data(), packets.size());
+    assert(loaded.size() == 5 && !loaded.contains(entities[9]));
+    assert(loaded.get(entities[3])->id == 3 && loaded.get(entities[4])->value == 2.0f);
+
+    std::cout << "  ✓ Relocatable values move as bytes; wire-safe pools load from bytes\n";
+}
+
+void test_cold_fields() {
+    std::cout << "Testing @cold side tables in component pools...\n";
+
+    using namespace split;
+    static_assert(std::is_same_v<ComponentPool<Player, Entity32>::cold_type, Player_Cold>, "side table found");
+    static_assert(std::is_same_v<ComponentPool<chunked::Position, Entity32>::cold_type, detail::NoColdFields>,
+                  "no side table without @cold fields");
+
+    EntityAllocator<Entity32> entities;
+    std::vector<Entity32> handles;
+    ComponentPool<Player, Entity32> players;
+    for (int i = 0; i < 8; ++i) {
+        handles.push_back(entities.create());
+        players.set(handles.back(), Player{Vec3{float(i), 0.0f, 0.0f}},
+                    Player_Cold{i * 10, "player " + std::to_string(i)});
+    }
+    // A new component starts with value-initialized cold fields; replacing
+    // the hot part keeps them
+    Entity32 late = entities.create();
+    players.set(late, Player{});
+    assert(players.cold(late)->score == 0 && players.cold(late)->name.empty());
+    players.set(handles[2], Player{Vec3{9.0f, 0.0f, 0.0f}});
+    assert(players.cold(handles[2])->name == "player 2");
+
+    // The view reads both parts with one accessor per field
+    if (auto player = players.view(handles[3])) {
+        player.score() += 1;
+        player.position().y = 2.0f;
+    }
+    assert(players.view(handles[3]).score() == 31 && players.get(handles[3])->position.y == 2.0f);
+    assert(!players.view(entities.create()));
+
+    // Removal swaps both arrays, keeping them parallel
+    players.remove(handles[0]);
+    players.remove(handles[5]);
+    for (size_t i = 0; i < players.size(); ++i) {
+        Entity32 entity = players.entities()[i];
+        assert(&players.cold_data()[i] == players.cold(entity));
+    }
+    assert(players.view(handles[7]).name() == "player 7" && players.view(handles[7]).position().x == 7.0f);
+    players.clear();
+    assert(players.empty() && players.cold(handles[7]) == nullptr);
+
+    std::cout << "  ✓ Cold fields live in a parallel array behind the generated view\n";
+}
+
+void test_double_buffered() {
+    std::cout << "Testing double-buffered component pools...\n";
+
+    EntityAllocator<Entity32> entities;
+    std::vector<Entity32> handles;
+    DoubleBufferedPool<Vec3, Entity32> positions;
+    for (int i = 0; i < 64; ++i) {
+        handles.push_back(entities.create());
+        positions.set(handles.back(), Vec3{float(i), 0.0f, 0.0f});
+    }
+    // Writes stay in the back buffer until the swap
+    assert(positions.front().empty() && positions.size() == 64 && positions.pending() == 64);
+    positions.swap();
+    assert(positions.front().size() == 64 && positions.pending() == 0);
+    assert(positions.front().get(handles[5])->x == 5.0f);
+
+    // A reader thread iterates the front buffer while the writer changes
+    // the back one
+    float published = 0.0f;
+    std::thread reader([&positions, &published] {
+        positions.front().each([&published](Entity32, const Vec3& position) { published += position.x; });
+    });
+    for (int i = 0; i < 64; ++i) {
+        positions.modify(handles[i], [](Vec3& position) { position.x += 100.0f; });
+    }
+    reader.join();
+    assert(published == 63.0f * 64.0f / 2.0f);
+    assert(positions.front().get(handles[5])->x == 5.0f && positions.get(handles[5])->x == 105.0f);
+
+    // After each swap the new back buffer catches up with only the
+    // entities written that frame, including removals and reused indices
+    positions.swap();
+    assert(positions.front().get(handles[5])->x == 105.0f);
+    positions.remove(handles[7]);
+    entities.destroy(handles[7]);
+    Entity32 reused = entities.create();
+    positions.set(reused, Vec3{-1.0f, 0.0f, 0.0f});
+    positions.modify(handles[9], [](Vec3& position) { position.y = 1.0f; });
+    assert(positions.pending() == 2);
+    positions.swap();
+    for (int frame = 0; frame < 2; ++frame) {
+        const auto& front = frame == 0 ? positions.front() : positions.back();
+        assert(front.size() == 64 && !front.contains(handles[7]) && front.get(reused)->x == -1.0f);
+        assert(front.get(handles[9])->y == 1.0f && front.get(handles[5])->x == 105.0f);
+    }
+    positions.swap();
+    assert(positions.front().get(handles[9])->y == 1.0f && !positions.front().contains(handles[7]));
+
+    std::cout << "  ✓ Readers see whole frames; swaps copy only what was written\n";
+}
+
+int main() {
+    std::cout << "Running Runtime Tests\n";
+    std::cout << "=====================\n\n";
+
+    test_small_array_inline_storage();
+    test_small_array_spill();
+    test_small_array_copy_and_move();
+    test_fixed_string();
+    test_interned_string();
+    test_flat_hash_map();
+    test_flat_hash_map_ownership();
+    test_sorted_flat_map();
+    test_compact_optional();
+    test_enum_set();
+    test_enum_array();
+    test_vectors();
+    test_reduced_precision();
+    test_entities();
+    test_component_pools();
+    test_archetypes();
+    test_change_ticks();
+    test_variant_storage();
+    test_span_arenas();
+    test_copy_traits();
+    test_cold_fields();
+    test_double_buffered();
+
+    std::cout << "\n✓ All runtime tests passed!\n";
+    return 0;
+}
@@ -2,6 +2,7 @@
 // Tests for the Carch type checker component
 
 #include "../src/semantic/type_checker.h"
+#include "../src/semantic/layout.h"
 #include "../src/parser/parser.h"
 #include "../src/lexer/lexer.h"
 #include <cassert>
@@ -197,6 +198,855 @@ void test_non_leaf_termination() {
     std::cout << "  ✓ Leaf node validation works\n";
 }
 
+void test_repeated_anonymous_shapes() {
+    std::cout << "Testing repeated anonymous struct shapes...\n";
+    
+    std::string valid_source = R"(
+        Transform : struct { position: struct { x: f32, y: f32 }, scale: struct { x: f32, y: f32 } }
+        RigidBody : struct { velocity: struct { x: f32, y: f32 }, mass: f32 }
+    )";
+    Lexer valid_lexer(valid_source);
+    Parser valid_parser(valid_lexer);
+    auto valid_schema = valid_parser.parse();
+    TypeChecker valid_checker(valid_schema.get());
+    assert(valid_checker.check());
+    
+    // Invalid shapes are never cached, so every copy reports its own error
+    std::string invalid_source = R"(
+        A : struct { p: struct { x: f32, x: f32 } }
+        B : struct { q: struct { x: f32, x: f32 } }
+    )";
+    Lexer invalid_lexer(invalid_source);
+    Parser invalid_parser(invalid_lexer);
+    auto invalid_schema = invalid_parser.parse();
+    TypeChecker invalid_checker(invalid_schema.get());
+    assert(!invalid_checker.check());
+    
+    size_t duplicate_errors = 0;
+    for (const auto& error : invalid_checker.errors()) {
+        if (error.find("Duplicate field name 'x'") != std::string::npos) {
+            duplicate_errors++;
+        }
+    }
+    assert(duplicate_errors == 2);
+    
+    std::cout << "  ✓ Repeated shapes checked correctly\n";
+}
+
+void test_schema_ir() {
+    std::cout << "Testing resolved schema IR...\n";
+    
+    std::string source = R"(
+        Position : struct { x: f32, y: f32 }
+        Player : struct {
+            name: str,
+            position: Position,
+            home: struct { x: f32, y: f32 },
+            spawn: struct { x: f32, y: f32 },
+            target: optional<ref<entity>>
+        }
+        State : variant { idle, moving: struct { speed: f32 } }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    
+    assert(ir.definitions.size() == 3);
+    DefinitionId position = ir.find_definition("Position");
+    DefinitionId player = ir.find_definition("Player");
+    assert(position != INVALID_ID && player != INVALID_ID);
+    assert(ir.find_definition("Missing") == INVALID_ID);
+    
+    // Names resolve to the referenced definition's type
+    const Type& player_type = ir.type(ir.definitions[player].type);
+    assert(player_type.kind == TypeKind::STRUCT && player_type.count == 5);
+    const Field* fields = ir.fields_of(ir.definitions[player].type);
+    assert(fields[1].name == "position");
+    assert(fields[1].type == ir.definitions[position].type);
+    assert(ir.definitions[player].dependencies.size() == 1);
+    assert(ir.definitions[player].dependencies[0] == position);
+    assert(ir.definitions[position].references == 1);
+    
+    // Identical anonymous shapes share one type, distinct from the named one
+    assert(fields[2].type == fields[3].type);
+    assert(fields[2].type != ir.definitions[position].type);
+    assert(ir.type(fields[2].type).uses == 2);
+    assert(ir.type(fields[2].type).definition == INVALID_ID);
+    
+    // Layout facts
+    assert(ir.is_trivially_copyable(ir.definitions[position].type));
+    assert(ir.is_fixed_size(ir.definitions[position].type));
+    assert(!ir.is_fixed_size(fields[0].type));
+    assert(!ir.is_trivially_copyable(ir.definitions[player].type));
+    assert(ir.is_trivially_copyable(fields[4].type));
+    
+    // Unit alternatives have no type
+    DefinitionId state = ir.find_definition("State");
+    const Field* alternatives = ir.fields_of(ir.definitions[state].type);
+    assert(alternatives[0].type == INVALID_ID);
+    assert(ir.type(alternatives[1].type).kind == TypeKind::STRUCT);
+    assert(ir.is_trivially_copyable(ir.definitions[state].type));
+    
+    // Failed checks leave the IR empty
+    auto invalid_schema = parse("A : struct { b: Missing }");
+    TypeChecker invalid_checker(invalid_schema.get());
+    assert(!invalid_checker.check());
+    assert(invalid_checker.ir().definitions.empty());
+    
+    std::cout << "  ✓ IR resolves names, shares shapes and records layout facts\n";
+}
+
+void test_layout_engine() {
+    std::cout << "Testing layout computation...\n";
+    
+    std::string source = R"(
+        Mixed : struct {
+            flag: bool,
+            name: str,
+            count: u16,
+            items: array<u32>,
+            lookup: map<u32, u32>,
+            target: optional<ref<entity>>,
+            team: enum { red, blue }
+        }
+        State : variant { idle, moving: struct { speed: f64 } }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    TypeId mixed = ir.definitions[ir.find_definition("Mixed")].type;
+    TypeId state = ir.definitions[ir.find_definition("State")].type;
+    
+    // x86-64 System V, libstdc++: 1+7 | 32 | 2+6 | 24 | 56 | 8+1+7 | 1+7
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(mixed).size == 152);
+    assert(engine.layout(mixed).align == 8);
+    assert(engine.layout(mixed).padding == 27);
+    assert(engine.layout(mixed).heap_members == 3);
+    assert(engine.cache_lines(mixed) == 3);
+    assert(!engine.is_reordered(mixed));
+    assert(engine.field_offset(ir.type(mixed).first + 1) == 8);
+    
+    // std::variant: largest alternative then a one-byte index
+    assert(engine.layout(state).size == 16);
+    assert(engine.layout(state).align == 8);
+    
+    // Reordering by alignment leaves only tail padding
+    LayoutEngine reordered(ir, TargetAbi::x86_64_sysv(), true);
+    assert(reordered.is_reordered(mixed));
+    assert(reordered.layout(mixed).size == 136);
+    assert(reordered.layout(mixed).padding == 11);
+    assert(reordered.field_order(mixed).back() == 6);
+    
+    std::string table = format_layout_report(ir, engine, "mixed.carch", ReportFormat::TABLE);
+    assert(table.find("x86-64 System V") != std::string::npos);
+    assert(table.find("Mixed") != std::string::npos);
+    std::string json = format_layout_report(ir, engine, "mixed.carch", ReportFormat::JSON);
+    assert(json.find("{\"name\": \"Mixed\", \"size\": 152, \"align\": 8, \"padding\": 27, "
+                     "\"cache_lines\": 3, \"heap_members\": 3}") != std::string::npos);
+    
+    std::cout << "  ✓ Sizes, alignment, padding and field order computed\n";
+}
+
+void test_layout_annotations() {
+    std::cout << "Testing alignment, packing and cache-line annotations...\n";
+    
+    std::string source = R"(
+        @cacheline
+        Counters : struct { @cacheline produced: u64, @cacheline consumed: u64, total: u32 }
+        @packed
+        Header : struct { tag: u8, length: u32, flags: u16 }
+        @align(16)
+        Vec : struct { x: f32, y: f32, z: f32 }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    TypeId counters = ir.definitions[ir.find_definition("Counters")].type;
+    TypeId header = ir.definitions[ir.find_definition("Header")].type;
+    TypeId vec = ir.definitions[ir.find_definition("Vec")].type;
+    assert(ir.layout_of(header).packed);
+    assert(ir.fields[ir.type(counters).first].layout.cacheline);
+    
+    // Each @cacheline field owns a whole line
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(counters).size == 192);
+    assert(engine.layout(counters).align == 64);
+    assert(engine.field_offset(ir.type(counters).first + 1) == 64);
+    assert(engine.field_offset(ir.type(counters).first + 2) == 128);
+    assert(engine.layout(header).size == 7);
+    assert(engine.layout(header).align == 1);
+    assert(engine.layout(vec).size == 16);
+    assert(engine.layout(vec).align == 16);
+    
+    // Invalid combinations and arguments
+    const char* invalid[] = {
+        "A : struct { @align(3) x: u32 }",
+        "A : struct { @align x: u32 }",
+        "A : struct { @packed x: u32 }",
+        "A : struct { @cacheline(2) x: u32 }",
+        "A : struct { @unknown x: u32 }",
+        "A : struct { @align(8) @align(8) x: u32 }",
+        "@cacheline A : enum { red, blue }",
+        "@packed A : struct { @align(8) x: u32 }",
+        "@packed @align(8) A : struct { x: u32 }",
+        // Weaker than the natural alignment
+        "A : struct { @align(2) x: u64 }",
+        "@align(4) A : struct { x: u64 }",
+        // Packed members that own heap memory
+        "@packed A : struct { name: str }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+        assert(bad_checker.ir().definitions.empty());
+    }
+    
+    std::cout << "  ✓ Annotations validated and applied to the layout\n";
+}
+
+void test_sized_array_layout() {
+    std::cout << "Testing fixed and small array layout...\n";
+    
+    std::string source = R"(
+        Path : struct {
+            color: array<u8, 4>,
+            points: small_array<struct { x: f32, y: f32 }, 4>,
+            names: array<str, 2>
+        }
+        Grid : struct { cells: array<array<u16, 3>, 3> }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    const Field* path = ir.fields_of(ir.definitions[ir.find_definition("Path")].type);
+    TypeId grid = ir.definitions[ir.find_definition("Grid")].type;
+    
+    assert(ir.type(path[0].type).kind == TypeKind::FIXED_ARRAY);
+    assert(ir.type(path[0].type).count == 4);
+    assert(ir.type(path[1].type).kind == TypeKind::SMALL_ARRAY);
+    
+    // Fixed arrays are as trivial as their elements; small arrays may own heap memory
+    assert(ir.is_trivially_copyable(path[0].type));
+    assert(!ir.is_trivially_copyable(path[1].type));
+    assert(!ir.is_trivially_copyable(path[2].type));
+    assert(ir.is_trivially_copyable(grid));
+    
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(path[0].type).size == 4);
+    assert(engine.layout(path[0].type).align == 1);
+    // 8-byte size/capacity header, then 4 * 8 bytes of inline storage
+    assert(engine.layout(path[1].type).size == 40);
+    assert(engine.layout(path[1].type).align == 8);
+    assert(engine.layout(path[2].type).size == 64);
+    assert(engine.layout(path[2].type).heap_members == 2);
+    assert(engine.layout(grid).size == 18);
+    assert(engine.layout(grid).align == 2);
+    
+    std::cout << "  ✓ Array lengths lowered and laid out\n";
+}
+
+void test_string_layout() {
+    std::cout << "Testing inline and interned string layout...\n";
+    
+    std::string source = R"(
+        Label : struct {
+            short_text: str<15>,
+            long_text: str<300>,
+            kind: istr,
+            body: str
+        }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    const Field* label = ir.fields_of(ir.definitions[ir.find_definition("Label")].type);
+    
+    assert(ir.type(label[0].type).count == 15);
+    assert(label[0].type != label[1].type);
+    
+    // Inline and interned strings own no heap memory of their own
+    assert(ir.is_trivially_copyable(label[0].type));
+    assert(ir.is_trivially_copyable(label[2].type));
+    assert(!ir.is_trivially_copyable(label[3].type));
+    
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    // One length byte, then the buffer
+    assert(engine.layout(label[0].type).size == 16);
+    assert(engine.layout(label[0].type).align == 1);
+    // Two length bytes past 255, rounded to their alignment
+    assert(engine.layout(label[1].type).size == 302);
+    assert(engine.layout(label[1].type).align == 2);
+    assert(engine.layout(label[2].type).size == 8);
+    assert(engine.layout(label[2].type).heap_members == 0);
+    
+    auto too_long = parse("A : struct { x: str<70000> }");
+    TypeChecker bad_checker(too_long.get());
+    assert(!bad_checker.check());
+    
+    std::cout << "  ✓ str<N> and istr lowered and laid out\n";
+}
+
+void test_map_backends() {
+    std::cout << "Testing map backend selection...\n";
+    
+    std::string source = R"(
+        Inventory : struct {
+            counts: map<u32, u32>,
+            @map(flat) fast: map<u32, u32>,
+            @map(sorted) small: map<u32, u32>,
+            @map(std) nodes: map<u32, u32>
+        }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    TypeId inventory = ir.definitions[ir.find_definition("Inventory")].type;
+    const Field* fields = ir.fields_of(inventory);
+    
+    // The same map with different backends is a different type
+    assert(ir.type(fields[0].type).map_backend == MapBackend::DEFAULT);
+    assert(ir.type(fields[1].type).map_backend == MapBackend::FLAT);
+    assert(ir.type(fields[2].type).map_backend == MapBackend::SORTED);
+    assert(fields[0].type != fields[1].type && fields[1].type != fields[2].type);
+    
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(fields[0].type).size == 56);
+    assert(engine.layout(fields[1].type).size == 32);
+    assert(engine.layout(fields[1].type).padding == 4);
+    assert(engine.layout(fields[2].type).size == 24);
+    assert(engine.layout(fields[3].type).size == 56);
+    assert(engine.layout(inventory).size == 168);
+    
+    // The default backend only changes maps without an annotation
+    LayoutEngine flat_engine(ir, TargetAbi::x86_64_sysv(), false, MapBackend::FLAT);
+    assert(flat_engine.layout(fields[0].type).size == 32);
+    assert(flat_engine.layout(fields[3].type).size == 56);
+    
+    const char* invalid[] = {
+        "A : struct { @map(fast) x: map<u32, u32> }",
+        "A : struct { @map x: map<u32, u32> }",
+        "A : struct { @map(flat) x: array<u32> }",
+        "A : struct { @map(flat) x: optional<map<u32, u32>> }",
+        "@map(flat) A : struct { x: map<u32, u32> }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    std::cout << "  ✓ @map backends lowered and laid out\n";
+}
+
+void test_variant_backends() {
+    std::cout << "Testing variant backend selection...\n";
+    
+    std::string source = R"(
+        @partitioned Shape : variant { circle: f32, square: f32, empty }
+        @variant(tagged) Command : variant { move: struct { x: f32, y: f32 }, stop }
+        @variant(std) Message : variant { text: str, ping }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    assert(ir.definitions[ir.find_definition("Shape")].variant_backend == VariantBackend::DEFAULT);
+    assert(ir.definitions[ir.find_definition("Command")].variant_backend == VariantBackend::TAGGED);
+    assert(ir.definitions[ir.find_definition("Message")].variant_backend == VariantBackend::STD);
+    assert(ir.definitions[ir.find_definition("Shape")].partitioned);
+    assert(!ir.definitions[ir.find_definition("Command")].partitioned);
+    
+    // Both backends store the largest alternative followed by the tag
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(ir.definitions[ir.find_definition("Command")].type).size == 12);
+    assert(ir.is_trivially_copyable(ir.definitions[ir.find_definition("Command")].type));
+    
+    const char* invalid[] = {
+        "@variant(compact) A : variant { a: u32, b }",
+        "@variant A : variant { a: u32, b }",
+        "@variant(tagged) A : struct { x: u32 }",
+        "A : struct { @variant(tagged) x: variant { a: u32, b } }",
+        "@partitioned(std) A : variant { a: u32, b }",
+        "@partitioned A : struct { x: u32 }",
+        "A : struct { @partitioned x: variant { a: u32, b } }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    std::cout << "  ✓ @variant backends and @partitioned recorded on definitions\n";
+}
+
+void test_optional_backends() {
+    std::cout << "Testing compact optional selection...\n";
+    
+    std::string source = R"(
+        Team : enum { red, blue }
+        Target : struct {
+            who: optional<ref<entity>>,
+            speed: optional<f64>,
+            team: optional<Team>,
+            count: optional<u32>,
+            @optional(compact) slot: optional<u32>,
+            @optional(std) kept: optional<ref<entity>>
+        }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    TypeId target = ir.definitions[ir.find_definition("Target")].type;
+    const Field* fields = ir.fields_of(target);
+    
+    // Without an annotation only niches that cost no value are used
+    const OptionalBackend compact = OptionalBackend::COMPACT;
+    assert(ir.is_compact_optional(fields[0].type, compact));
+    assert(ir.is_compact_optional(fields[1].type, compact));
+    assert(ir.is_compact_optional(fields[2].type, compact));
+    assert(!ir.is_compact_optional(fields[3].type, compact));
+    assert(ir.is_compact_optional(fields[4].type, OptionalBackend::STD));
+    assert(!ir.is_compact_optional(fields[5].type, compact));
+    assert(!ir.is_compact_optional(fields[0].type, OptionalBackend::STD));
+    
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(fields[0].type).size == 16);
+    assert(engine.layout(fields[4].type).size == 4);
+    assert(engine.layout(target).size == 64);
+    LayoutEngine compact_engine(ir, TargetAbi::x86_64_sysv(), false, MapBackend::STD, compact);
+    assert(compact_engine.layout(fields[0].type).size == 8);
+    assert(compact_engine.layout(fields[2].type).size == 1);
+    assert(compact_engine.layout(target).size == 48);
+    
+    const char* invalid[] = {
+        "A : struct { @optional(small) x: optional<u32> }",
+        "A : struct { @optional(compact) x: u32 }",
+        "A : struct { @optional(compact) x: optional<bool> }",
+        "A : struct { @optional(compact) x: optional<struct { y: u32 }> }",
+        "@optional(compact) A : struct { x: optional<u32> }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    std::cout << "  ✓ Compact optionals resolved from annotations and niches\n";
+}
+
+void test_enum_and_flags_layout() {
+    std::cout << "Testing enum and flags sizes...\n";
+    
+    std::string many = "Many : enum { v0";
+    for (int i = 1; i < 300; ++i) {
+        many += ", v" + std::to_string(i);
+    }
+    many += " }";
+    std::string wide = "Wide : flags { w0";
+    for (int i = 1; i < 70; ++i) {
+        wide += ", w" + std::to_string(i);
+    }
+    wide += " }";
+    std::string source = "Team : enum { red, blue }\n" + many + "\n" + wide + "\n" +
+                         "Permissions : flags { read, write, exec }\n"
+                         "Mask : flags { b0, b1, b2, b3, b4, b5, b6, b7, b8 }\n";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    auto layout_of = [&](const char* name) { return engine.layout(ir.definitions[ir.find_definition(name)].type); };
+    
+    // Enums keep a spare value for compact optionals
+    assert(layout_of("Team").size == 1);
+    assert(layout_of("Many").size == 2 && layout_of("Many").align == 2);
+    assert(enum_storage_size(254) == 1 && enum_storage_size(255) == 2);
+    
+    // Flags take one bit per value
+    assert(ir.type(ir.definitions[ir.find_definition("Permissions")].type).kind == TypeKind::FLAGS);
+    assert(layout_of("Permissions").size == 1);
+    assert(layout_of("Mask").size == 2);
+    assert(layout_of("Wide").size == 16 && layout_of("Wide").align == 8);
+    assert(ir.is_trivially_copyable(ir.definitions[ir.find_definition("Wide")].type));
+    
+    auto bad = parse("F : flags { a, b, a }");
+    TypeChecker bad_checker(bad.get());
+    assert(!bad_checker.check());
+    
+    std::cout << "  ✓ Smallest underlying types and bit sets sized\n";
+}
+
+void test_vector_layout() {
+    std::cout << "Testing vector and quaternion layout...\n";
+    
+    std::string source = R"(
+        Body : struct {
+            mass: f32,
+            velocity: vec3,
+            orientation: quat,
+            uv: vec2,
+            cell: ivec2,
+            target: optional<vec3>
+        }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    const Field* body = ir.fields_of(ir.definitions[ir.find_definition("Body")].type);
+    
+    assert(vector_lanes(ir.type(body[1].type).primitive) == 3);
+    assert(vector_lanes(ir.type(body[2].type).primitive) == 4);
+    assert(vector_lane_type(ir.type(body[4].type).primitive) == PrimitiveType::I32);
+    assert(vector_lanes(ir.type(body[0].type).primitive) == 0);
+    assert(ir.is_trivially_copyable(body[1].type));
+    // Every bit pattern is a value, so there is no niche for compact optionals
+    assert(ir.niche_of(body[1].type) == Niche::NONE);
+    
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(body[1].type).size == 16);
+    assert(engine.layout(body[1].type).align == 16);
+    assert(engine.layout(body[1].type).padding == 4);
+    assert(engine.layout(body[2].type).size == 16);
+    assert(engine.layout(body[3].type).size == 8);
+    assert(engine.layout(body[3].type).align == 8);
+    // mass | 12 | velocity | orientation | uv | cell | target (16 + 16)
+    const TypeLayout& layout = engine.layout(ir.definitions[ir.find_definition("Body")].type);
+    assert(layout.size == 96);
+    assert(layout.align == 16);
+    
+    auto compact = parse("A : struct { @optional(compact) v: optional<vec2> }");
+    TypeChecker compact_checker(compact.get());
+    assert(!compact_checker.check());
+    
+    std::cout << "  ✓ Vectors are 16-byte aligned, 2-lane vectors 8\n";
+}
+
+void test_reduced_precision_layout() {
+    std::cout << "Testing reduced-precision layout...\n";
+    
+    std::string source = R"(
+        Sprite : struct {
+            color: array<unorm8, 4>,
+            depth: f16,
+            normal: array<snorm16, 3>,
+            angle: quant<-3.14, 3.14, 12>,
+            health: quant<0, 100, 7>,
+            seed: quant<0, 1, 20>
+        }
+    )";
+    
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    DefinitionId sprite_id = ir.find_definition("Sprite");
+    const Field* sprite = ir.fields_of(ir.definitions[sprite_id].type);
+    
+    // Bounds share one decimal scale
+    const Type& angle = ir.type(sprite[3].type);
+    assert(angle.count == 12);
+    const QuantRange& range = ir.quant_ranges[angle.first];
+    assert(range.min == -314 && range.max == 314 && range.decimals == 2);
+    assert(storage_primitive(angle.primitive, angle.count) == PrimitiveType::U16);
+    assert(storage_primitive(PrimitiveType::SNORM8, 0) == PrimitiveType::I8);
+    assert(storage_primitive(PrimitiveType::F32, 0) == PrimitiveType::F32);
+    assert(ir.niche_of(sprite[1].type) == Niche::NONE);
+    
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(sprite[0].type).size == 4);
+    assert(engine.layout(sprite[1].type).size == 2);
+    assert(engine.layout(sprite[3].type).size == 2);
+    assert(engine.layout(sprite[4].type).size == 1);
+    assert(engine.layout(sprite[5].type).size == 4);
+    // 4 + 2 + 6 + 2 + 1 | 1 + 4
+    assert(engine.layout(ir.definitions[sprite_id].type).size == 20);
+    
+    QuantRange parsed;
+    assert(parse_quant_range("0.5", "2", parsed));
+    assert(parsed.min == 5 && parsed.max == 20 && parsed.decimals == 1);
+    assert(!parse_quant_range("0x10", "20", parsed));
+    assert(!parse_quant_range("1e3", "2e3", parsed));
+    
+    const char* invalid[] = {
+        "A : struct { x: quant<1, 1, 8> }",
+        "A : struct { x: quant<2, -2, 8> }",
+        "A : struct { x: quant<0, 1, 33> }",
+        "A : struct { x: quant<0, 1e2, 8> }",
+        "A : struct { @optional(compact) x: optional<f16> }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    std::cout << "  ✓ f16, unorm, snorm and quant sized by their stored bits\n";
+}
+
+void test_indexed_refs() {
+    std::cout << "Testing @indexed reference fields...\n";
+    
+    std::string source = R"(
+        AIState : variant {
+            idle,
+            chase: struct { @indexed target: ref<entity>, speed: f32 }
+        }
+        Follower : struct { @indexed leader: ref<entity>, combat: struct { @indexed target: ref<entity> } }
+    )";
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    
+    const char* invalid[] = {
+        "A : struct { @indexed x: u32 }",
+        "A : struct { @indexed x: optional<ref<entity>> }",
+        "A : struct { @indexed(all) x: ref<entity> }",
+        "@indexed A : struct { x: ref<entity> }",
+        "A : struct { xs: array<struct { @indexed x: ref<entity> }> }",
+        "A : struct { s: variant { on: struct { @indexed x: ref<entity> } } }",
+        "@packed A : struct { @indexed x: ref<entity> }",
+        "Route : struct { @indexed owner: ref<entity> }\nUnit : struct { route: Route }",
+        "Route : struct { @indexed owner: ref<entity> }\nConvoy : struct { routes: array<Route> }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    auto nested = parse("A : struct { xs: array<struct { @indexed x: ref<entity> }> }");
+    TypeChecker nested_checker(nested.get());
+    nested_checker.check();
+    assert(nested_checker.errors()[0].find("'A.xs.x' cannot be '@indexed' inside a container") != std::string::npos);
+    
+    // Only the pool of Route itself would link the references
+    auto named = parse("Route : struct { @indexed owner: ref<entity> }\nUnit : struct { route: Route }");
+    TypeChecker named_checker(named.get());
+    named_checker.check();
+    assert(named_checker.errors()[0].find("Type 'Route' has @indexed field 'owner', so it can only be a component") !=
+           std::string::npos);
+    
+    std::cout << "  ✓ @indexed accepted on ref<entity> fields with a fixed path\n";
+}
+
+void test_pooled_arrays() {
+    std::cout << "Testing @pooled array fields...\n";
+    
+    std::string source = R"(
+        Patrol : struct { @pooled waypoints: array<vec3>, route: struct { @pooled stops: array<u32> }, speed: f32 }
+        Collider : variant { circle: f32, polygon: struct { @pooled vertices: array<vec2> } }
+        Path : struct { points: array<vec3> }
+    )";
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    
+    // A pooled array is a 32-bit offset and length, and owns no heap memory
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    TypeId patrol = ir.definitions[ir.find_definition("Patrol")].type;
+    assert(engine.layout(patrol).size == 20 && engine.layout(patrol).heap_members == 0);
+    assert(ir.is_trivially_copyable(patrol));
+    assert(ir.type(ir.fields_of(patrol)[0].type).pooled);
+    // The plain array<vec3> is a different type
+    TypeId path = ir.definitions[ir.find_definition("Path")].type;
+    assert(!ir.type(ir.fields_of(path)[0].type).pooled && !ir.is_trivially_copyable(path));
+    
+    const char* invalid[] = {
+        "A : struct { @pooled x: u32 }",
+        "A : struct { @pooled xs: array<u32, 4> }",
+        "A : struct { @pooled xs: small_array<u32, 4> }",
+        "A : struct { @pooled(shared) xs: array<u32> }",
+        "@pooled A : struct { xs: array<u32> }",
+        "A : struct { xs: array<struct { @pooled ys: array<u32> }> }",
+        "A : struct { s: variant { on: struct { @pooled ys: array<u32> } } }",
+        "A : struct { @pooled names: array<str> }",
+        "Route : struct { @pooled points: array<vec3> }\nUnit : struct { route: Route }",
+        "Route : variant { path: struct { @pooled points: array<vec3> }, none }\n"
+        "Unit : struct { route: optional<Route> }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    auto owning = parse("A : struct { @pooled names: array<str> }");
+    TypeChecker owning_checker(owning.get());
+    owning_checker.check();
+    assert(owning_checker.errors()[0].find("'names' cannot be pooled: its elements own heap memory") !=
+           std::string::npos);
+    
+    std::cout << "  ✓ @pooled arrays lowered to spans of trivially copyable elements\n";
+}
+
+void test_copy_traits() {
+    std::cout << "Testing copy and relocation traits...\n";
+    
+    std::string source = R"(
+        Transform : struct { position: vec3, target: ref<entity>, label: str<16> }
+        Named : struct { name: istr, position: vec3 }
+        Inventory : struct { items: array<u32>, slots: small_array<u32, 4>, @map(flat) counts: map<u32, u32> }
+        Tagged : struct { tags: small_array<str, 2> }
+        Lookup : struct { @map(std) names: map<u32, u32> }
+        @pod Command : variant { move: vec3, stop }
+    )";
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    auto type_of = [&](const char* name) { return ir.definitions[ir.find_definition(name)].type; };
+    
+    // Plain values are all four
+    assert(ir.is_trivially_copyable(type_of("Transform")) && ir.is_wire_safe(type_of("Transform")));
+    assert(ir.is_trivially_relocatable(type_of("Transform")));
+    assert(ir.definitions[ir.find_definition("Command")].pod && ir.is_wire_safe(type_of("Command")));
+    // istr copies as bytes but points into the process's string table
+    assert(ir.is_trivially_copyable(type_of("Named")) && !ir.is_wire_safe(type_of("Named")));
+    // Vectors, small arrays of relocatable elements and flat maps relocate
+    assert(!ir.is_trivially_copyable(type_of("Inventory")) && ir.is_trivially_relocatable(type_of("Inventory")));
+    // std::string and std::unordered_map may point into themselves
+    assert(!ir.is_trivially_relocatable(type_of("Tagged")));
+    assert(!ir.is_trivially_relocatable(type_of("Lookup")));
+    
+    const char* invalid[] = {
+        "@pod A : struct { name: str }",
+        "@pod A : struct { xs: array<u32> }",
+        "@pod A : struct { inner: struct { xs: small_array<u32, 2> } }",
+        "@pod A : struct { name: istr }",
+        "@pod A : struct { @pooled xs: array<u32> }",
+        "@pod A : variant { named: str, none }",
+        "@pod A : enum { a, b }",
+        "A : struct { @pod x: u32 }",
+        "@pod(wire) A : struct { x: u32 }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    auto owning = parse("@pod Packet : struct { id: u32, payload: array<u8> }");
+    TypeChecker owning_checker(owning.get());
+    owning_checker.check();
+    assert(owning_checker.errors()[0].find("@pod type 'Packet' cannot hold field 'payload', which owns heap memory") !=
+           std::string::npos);
+    
+    std::cout << "  ✓ Trivially copyable, relocatable and wire-safe types told apart; @pod enforced\n";
+}
+
+void test_cold_fields() {
+    std::cout << "Testing @cold fields...\n";
+    
+    std::string source = R"(
+        Player : struct { position: vec3, @cold score: i32, @cold name: str, input: u8 }
+    )";
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    TypeId player = ir.definitions[ir.find_definition("Player")].type;
+    assert(ir.has_cold_fields(player) && ir.fields_of(player)[1].cold && !ir.fields_of(player)[0].cold);
+    
+    // The struct keeps the hot fields; the side table is laid out on its own
+    LayoutEngine engine(ir, TargetAbi::x86_64_sysv());
+    assert(engine.layout(player).size == 32 && engine.layout(player).heap_members == 0);
+    assert(engine.field_order(player).size() == 2 && engine.field_order(player)[1] == 3);
+    assert(!engine.is_reordered(player));
+    assert(engine.cold_layout(player).size == 40 && engine.cold_layout(player).heap_members == 1);
+    assert(engine.field_offset(ir.type(player).first + 2) == 8);
+    // Flags describe the hot struct, cold_flags() the side table
+    assert(ir.is_trivially_copyable(player) && ir.is_wire_safe(player));
+    assert((ir.cold_flags(player) & TYPE_TRIVIALLY_COPYABLE) == 0);
+    
+    std::string report = format_layout_report(ir, engine, "cold.carch", ReportFormat::TABLE);
+    assert(report.find("Player (cold)") != std::string::npos);
+    
+    const char* invalid[] = {
+        "A : struct { @cold x: u32 }",
+        "@cold A : struct { x: u32 }",
+        "A : struct { x: u32, @cold(rarely) y: u32 }",
+        "A : struct { x: u32, inner: struct { y: u32, @cold z: u32 } }",
+        "A : variant { on: struct { y: u32, @cold z: u32 }, off }",
+        "A : struct { x: u32, @cold y: u32 } B : struct { a: A }",
+        "@packed A : struct { x: u32, @cold y: u32 }",
+        "A : struct { x: u32, @cold @indexed who: ref<entity> }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    auto nested = parse("Stats : struct { kills: u32, @cold deaths: u32 } Player : struct { stats: Stats }");
+    TypeChecker nested_checker(nested.get());
+    nested_checker.check();
+    assert(nested_checker.errors()[0].find("'Stats' has @cold fields, so it can only be a component") !=
+           std::string::npos);
+    
+    std::cout << "  ✓ @cold fields split into a side table with its own layout\n";
+}
+
+void test_double_buffered() {
+    std::cout << "Testing @double_buffered definitions...\n";
+    
+    std::string source = R"(
+        @double_buffered Transform : struct { position: vec3, rotation: quat, parent: ref<entity> }
+        @double_buffered Shape : variant { circle: f32, box: vec2, none }
+        Tag : struct { name: str }
+    )";
+    auto schema = parse(source);
+    TypeChecker checker(schema.get());
+    assert(checker.check());
+    const SchemaIR& ir = checker.ir();
+    assert(ir.definitions[ir.find_definition("Transform")].double_buffered);
+    assert(ir.definitions[ir.find_definition("Shape")].double_buffered);
+    assert(!ir.definitions[ir.find_definition("Tag")].double_buffered);
+    
+    const char* invalid[] = {
+        "@double_buffered A : enum { a, b }",
+        "A : struct { @double_buffered x: u32 }",
+        "@double_buffered(2) A : struct { x: u32 }",
+        "@double_buffered A : struct { @indexed target: ref<entity> }",
+        "@double_buffered A : struct { @pooled xs: array<u32> }",
+        "@double_buffered A : struct { x: u32, @cold name: str }",
+        "B : struct { @pooled xs: array<u32> }\n@double_buffered A : variant { b: B, none }",
+    };
+    for (const char* text : invalid) {
+        auto bad = parse(text);
+        TypeChecker bad_checker(bad.get());
+        assert(!bad_checker.check());
+    }
+    
+    auto nested = parse("@double_buffered Unit : struct { link: struct { @indexed owner: ref<entity> } }");
+    TypeChecker nested_checker(nested.get());
+    nested_checker.check();
+    assert(nested_checker.errors()[0].find("@double_buffered type 'Unit' cannot hold field 'owner'") !=
+           std::string::npos);
+    
+    std::cout << "  ✓ Structs and variants double-buffered; pool-linked fields rejected\n";
+}
+
 int main() {
     std::cout << "Running Semantic Analysis Tests\n";
     std::cout << "================================\n\n";
@@ -212,6 +1062,23 @@ int main() {
     test_nested_optional_detection();
     test_forward_reference_detection();
     test_non_leaf_termination();
+    test_repeated_anonymous_shapes();
+    test_schema_ir();
+    test_layout_engine();
+    test_layout_annotations();
+    test_sized_array_layout();
+    test_string_layout();
+    test_vector_layout();
+    test_reduced_precision_layout();
+    test_map_backends();
+    test_variant_backends();
+    test_optional_backends();
+    test_enum_and_flags_layout();
+    test_indexed_refs();
+    test_pooled_arrays();
+    test_copy_traits();
+    test_cold_fields();
+    test_double_buffered();
     
     std::cout << "\n✓ All semantic analysis tests passed!\n";
     return 0;
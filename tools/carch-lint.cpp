@@ -4,6 +4,7 @@
 #include "../src/lexer/lexer.h"
 #include "../src/parser/parser.h"
 #include "../src/parser/ast.h"
+#include "../src/semantic/schema_ir.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -39,10 +40,12 @@ public:
             return issues_;
         }
         
-        // Run lint checks
-        check_naming_conventions(schema.get());
-        check_complexity(schema.get());
-        check_best_practices(schema.get());
+        // Run lint checks on the resolved IR; it does not require the
+        // schema to type-check
+        carch::semantic::SchemaIR ir = carch::semantic::build_schema_ir(*schema);
+        check_naming_conventions(ir);
+        check_complexity(ir);
+        check_best_practices(ir);
         
         return issues_;
     }
@@ -75,78 +78,99 @@ private:
         return true;
     }
     
-    void check_naming_conventions(carch::parser::SchemaNode* schema) {
-        if (!schema) return;
-        
-        for (const auto& type_def : schema->definitions) {
-            const std::string& type_name = type_def->name;
-            
+    void check_naming_conventions(const carch::semantic::SchemaIR& ir) {
+        for (const auto& def : ir.definitions) {
             // Type names should be PascalCase
-            if (!is_pascal_case(type_name)) {
-                add_warning(type_def->line, type_def->column,
-                    "Type name '" + type_name + "' should be PascalCase",
+            if (!is_pascal_case(def.name)) {
+                add_warning(def.line, def.column,
+                    "Type name '" + def.name + "' should be PascalCase",
                     "naming-convention");
             }
-            
-            // Check field naming in structs
-            if (auto* struct_type = dynamic_cast<carch::parser::StructTypeNode*>(type_def->type.get())) {
-                for (const auto& field : struct_type->fields) {
-                    if (!is_snake_case(field->name)) {
-                        add_warning(type_def->line, type_def->column,
-                            "Field name '" + field->name + "' should be snake_case",
-                            "naming-convention");
-                    }
+        }
+        
+        // Check field naming in every struct, named or inline. Identical
+        // inline shapes share one IR type, so each is reported once.
+        for (const auto& type : ir.types) {
+            if (type.kind != carch::semantic::TypeKind::STRUCT) continue;
+            for (uint32_t i = 0; i < type.count; ++i) {
+                const auto& field = ir.fields[type.first + i];
+                if (!is_snake_case(field.name)) {
+                    add_warning(field.line, field.column,
+                        "Field name '" + field.name + "' should be snake_case",
+                        "naming-convention");
                 }
             }
         }
     }
     
-    void check_complexity(carch::parser::SchemaNode* schema) {
-        if (!schema) return;
-        
-        for (const auto& type_def : schema->definitions) {
+    void check_complexity(const carch::semantic::SchemaIR& ir) {
+        for (const auto& def : ir.definitions) {
+            const auto& type = ir.type(def.type);
+            
             // Check for overly complex structs
-            if (auto* struct_type = dynamic_cast<carch::parser::StructTypeNode*>(type_def->type.get())) {
-                if (struct_type->fields.size() > 50) {
-                    add_warning(type_def->line, type_def->column,
-                        "Struct '" + type_def->name + "' has " + std::to_string(struct_type->fields.size()) +
-                        " fields. Consider breaking it into smaller structs.",
-                        "complexity");
-                }
+            if (type.kind == carch::semantic::TypeKind::STRUCT && type.count > 50) {
+                add_warning(def.line, def.column,
+                    "Struct '" + def.name + "' has " + std::to_string(type.count) +
+                    " fields. Consider breaking it into smaller structs.",
+                    "complexity");
             }
             
             // Check for overly complex variants
-            if (auto* variant_type = dynamic_cast<carch::parser::VariantTypeNode*>(type_def->type.get())) {
-                if (variant_type->alternatives.size() > 20) {
-                    add_warning(type_def->line, type_def->column,
-                        "Variant '" + type_def->name + "' has " + std::to_string(variant_type->alternatives.size()) +
-                        " alternatives. Consider restructuring.",
-                        "complexity");
-                }
+            if (type.kind == carch::semantic::TypeKind::VARIANT && type.count > 20) {
+                add_warning(def.line, def.column,
+                    "Variant '" + def.name + "' has " + std::to_string(type.count) +
+                    " alternatives. Consider restructuring.",
+                    "complexity");
             }
             
             // Check for overly large enums
-            if (auto* enum_type = dynamic_cast<carch::parser::EnumTypeNode*>(type_def->type.get())) {
-                if (enum_type->values.size() > 100) {
-                    add_warning(type_def->line, type_def->column,
-                        "Enum '" + type_def->name + "' has " + std::to_string(enum_type->values.size()) +
-                        " values. Consider using a different representation.",
-                        "complexity");
-                }
+            if (type.kind == carch::semantic::TypeKind::ENUM && type.count > 100) {
+                add_warning(def.line, def.column,
+                    "Enum '" + def.name + "' has " + std::to_string(type.count) +
+                    " values. Consider using a different representation.",
+                    "complexity");
             }
         }
     }
     
-    void check_best_practices(carch::parser::SchemaNode* schema) {
-        if (!schema) return;
-        
-        // Check for unused types (types that are never referenced)
-        // This would require more sophisticated analysis
-        
+    void check_best_practices(const carch::semantic::SchemaIR& ir) {
         // Check for overly nested inline types
-        // This would require AST traversal depth checking
+        std::vector<int> depths(ir.types.size(), -1);
+        for (const auto& def : ir.definitions) {
+            int depth = inline_depth(ir, def.type, depths, true);
+            if (depth > MAX_INLINE_DEPTH) {
+                add_warning(def.line, def.column,
+                    "Type '" + def.name + "' nests inline types " + std::to_string(depth) +
+                    " levels deep. Consider extracting named types.",
+                    "nesting-depth");
+            }
+        }
+    }
+    
+    static constexpr int MAX_INLINE_DEPTH = 4;
+    
+    // Levels of inline structs and variants below a type; named types
+    // referenced from it do not count
+    int inline_depth(const carch::semantic::SchemaIR& ir, carch::semantic::TypeId id,
+                     std::vector<int>& depths, bool root) {
+        if (id == carch::semantic::INVALID_ID) return 0;
+        const auto& type = ir.type(id);
+        if (!root && type.definition != carch::semantic::INVALID_ID) return 0;
+        if (!root && depths[id] >= 0) return depths[id];
+        depths[id] = 0;  // Guards against cycles in schemas that do not type-check
         
-        // For now, just add placeholder logic
+        int depth = 0;
+        if (type.kind == carch::semantic::TypeKind::STRUCT || type.kind == carch::semantic::TypeKind::VARIANT) {
+            for (uint32_t i = 0; i < type.count; ++i) {
+                depth = std::max(depth, inline_depth(ir, ir.fields[type.first + i].type, depths, false));
+            }
+            depth += 1;
+        } else {
+            depth = std::max(inline_depth(ir, type.key, depths, false),
+                             inline_depth(ir, type.element, depths, false));
+        }
+        depths[id] = depth;
+        return depth;
     }
 };
 